@@ -83,11 +83,11 @@ module.exports =
             "partial": "prism_test",
             "main": `${ PRISM_SRC_DIR }/test`,
         },
-        "simd":
+        "bench":
         {
             "partial": "prism_test",
-            "main": `${ PRISM_SRC_DIR }/simd`,
-            "compiler_options": [ "mavx2", "O3" ],
+            "main": `${ PRISM_SRC_DIR }/bench`,
+            "compiler_options": [ "O3" ],
         },
         "sandbox":
         {
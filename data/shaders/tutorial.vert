@@ -1,6 +1,14 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// Per-vertex attributes (binding 0).
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+// Per-instance attributes (binding 1).
+layout(location = 2) in vec2 instanceOffset;
+layout(location = 3) in float instanceScale;
+
 layout(location = 0) out vec3 fragColor;
 
 out gl_PerVertex
@@ -8,23 +16,9 @@ out gl_PerVertex
     vec4 gl_Position;
 };
 
-vec2 POSITIONS[3] = vec2[]
-(
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
-
-vec3 COLORS[3] = vec3[]
-(
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
-
 void
 main()
 {
-    gl_Position = vec4(POSITIONS[gl_VertexIndex], 0.0, 1.0);
-    fragColor = COLORS[gl_VertexIndex];
+    gl_Position = vec4(position * instanceScale + instanceOffset, 0.0, 1.0);
+    fragColor = color;
 }
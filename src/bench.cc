@@ -0,0 +1,308 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <immintrin.h>
+#include "prism/bench.h"
+#include "prism/cpu.h"
+#include "prism/soa.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Kernels are compiled per function for their ISA level rather than building the whole translation unit with -mavx2,
+// so the binary runs on any x86-64 CPU.
+#define TARGET_SSE2 __attribute__ ((target ("sse2")))
+#define TARGET_AVX2 __attribute__ ((target ("avx2")))
+#define TARGET_AVX512 __attribute__ ((target ("avx512f")))
+
+// Keeps the compiler from auto-vectorizing the scalar reference kernel.
+#define NO_VECTORIZE __attribute__ ((optimize ("no-tree-vectorize")))
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Constants
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+typedef int32_t elem_t;
+
+// Working-set sweep from a few KiB (fits in L1) to hundreds of MiB (DRAM); sizes are multiples of every kernel's
+// vector count.
+static const size_t MIN_ENTITY_COUNT = 1024;
+static const size_t MAX_ENTITY_COUNT = 16 * 1024 * 1024;
+static const size_t ENTITY_COUNT_STEP = 4;
+
+// Each element reads vs, ws, xs and ys and writes zs.
+static const size_t BYTES_PER_ELEMENT = 5 * sizeof(elem_t);
+
+static const prism::BENCHConfig BENCH_CONFIG =
+{
+    3,     // warmupCount
+    31,    // repeatCount
+    0.001, // minSampleTime
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Typedefs
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+using DATA = prism::SOATable<elem_t, elem_t, elem_t, elem_t, elem_t>;
+
+// Computes zs = vs + ws + xs + ys for count elements; columns are SOA_COLUMN_ALIGNMENT-aligned and count is a multiple
+// of every kernel's vector count.
+using sum_kernel_t = void (*)(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                              size_t count);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct SUM_ARGS
+{
+    sum_kernel_t kernel;
+    DATA * data;
+    size_t count;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+NO_VECTORIZE void sum_scalar(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                             size_t count);
+
+TARGET_SSE2 void sum_sse2(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                          size_t count);
+
+TARGET_AVX2 void sum_avx2(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                          size_t count);
+
+TARGET_AVX512 void sum_avx512(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                              size_t count);
+
+void run_sum(void * data);
+
+bool verify_kernels(DATA * data, const sum_kernel_t * kernels, prism::CPUISA isa);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Main
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Usage: bench [results.json]; JSON results go to the given path or stdout, and a summary to stderr.
+int main(int argc, char ** argv)
+{
+    static const sum_kernel_t SUM_KERNELS[(size_t)prism::CPUISA::COUNT]
+    {
+        sum_scalar,
+        sum_sse2,
+        sum_avx2,
+        sum_avx512,
+    };
+
+    FILE * output = stdout;
+
+    if(argc > 1 && (output = fopen(argv[1], "w")) == nullptr)
+    {
+        fprintf(stderr, "failed to open '%s' for writing\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    DATA data;
+    prism::soaCreate(&data, MAX_ENTITY_COUNT);
+    srand(1);
+
+    for(size_t i = 0; i < MAX_ENTITY_COUNT; i++)
+    {
+        uint32_t row = prism::soaGetRow(&data, prism::soaAdd(&data));
+        prism::soaGetColumn<0>(&data)[row] = rand() % 1000;
+        prism::soaGetColumn<1>(&data)[row] = rand() % 1000;
+        prism::soaGetColumn<2>(&data)[row] = rand() % 1000;
+        prism::soaGetColumn<3>(&data)[row] = rand() % 1000;
+    }
+
+    // The dispatched kernel is the one the engine would run; every narrower ISA level is measured against it.
+    prism::CPUISA isa = prism::CPUISA::SCALAR;
+    sum_kernel_t dispatched_kernel = prism::cpuSelectKernel(SUM_KERNELS, &isa);
+    size_t vector_count = prism::cpuGetVectorSize(isa) / sizeof(elem_t);
+
+    // Kernels step through the columns a whole vector at a time.
+    if(MIN_ENTITY_COUNT % vector_count != 0)
+    {
+        fprintf(stderr, "entity counts must be multiples of the %s kernel's %zu-element vectors\n",
+                prism::cpuGetISAName(isa), vector_count);
+
+        return EXIT_FAILURE;
+    }
+
+    if(!verify_kernels(&data, SUM_KERNELS, isa))
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Measure every ISA level up to the dispatched one at every working-set size.
+    size_t max_result_count = 0;
+
+    for(size_t count = MIN_ENTITY_COUNT; count <= MAX_ENTITY_COUNT; count *= ENTITY_COUNT_STEP)
+    {
+        max_result_count += (size_t)isa + 1;
+    }
+
+    auto results = (prism::BENCHResult *)calloc(max_result_count, sizeof(prism::BENCHResult));
+    size_t result_count = 0;
+    fprintf(stderr, "widest supported ISA: %s; dispatching the %s sum kernel (%u-byte vectors)\n",
+            prism::cpuGetISAName(prism::cpuGetISA()), prism::cpuGetISAName(isa), prism::cpuGetVectorSize(isa));
+
+    for(size_t count = MIN_ENTITY_COUNT; count <= MAX_ENTITY_COUNT; count *= ENTITY_COUNT_STEP)
+    {
+        const prism::BENCHResult * scalar_result = results + result_count;
+
+        for(size_t kernel_isa = 0; kernel_isa <= (size_t)isa; kernel_isa++)
+        {
+            sum_kernel_t kernel = kernel_isa == (size_t)isa ? dispatched_kernel : SUM_KERNELS[kernel_isa];
+            SUM_ARGS args = { kernel, &data, count };
+            prism::BENCHResult * result = results + result_count++;
+
+            prism::benchRun(&BENCH_CONFIG, "sum", prism::cpuGetISAName((prism::CPUISA)kernel_isa), run_sum, &args,
+                            count, count * BYTES_PER_ELEMENT, result);
+
+            prism::benchPrintResult(stderr, result);
+        }
+
+        const prism::BENCHResult * dispatched_result = results + result_count - 1;
+
+        fprintf(stderr, "dispatched %s kernel: %.2fx scalar at %zu elements\n", prism::cpuGetISAName(isa),
+                scalar_result->medianTime / dispatched_result->medianTime, count);
+    }
+
+    prism::benchWriteJSON(output, results, result_count);
+
+    // Cleanup
+    if(output != stdout)
+    {
+        fclose(output);
+    }
+
+    free(results);
+    prism::soaDestroy(&data);
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+NO_VECTORIZE void sum_scalar(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                             size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        zs[i] = vs[i] + ws[i] + xs[i] + ys[i];
+    }
+}
+
+TARGET_SSE2 void sum_sse2(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                          size_t count)
+{
+    for(size_t i = 0; i < count; i += sizeof(__m128i) / sizeof(elem_t))
+    {
+        __m128i vs_vector = _mm_load_si128((__m128i const *)(vs + i));
+        __m128i ws_vector = _mm_load_si128((__m128i const *)(ws + i));
+        __m128i xs_vector = _mm_load_si128((__m128i const *)(xs + i));
+        __m128i ys_vector = _mm_load_si128((__m128i const *)(ys + i));
+
+        _mm_store_si128(
+            (__m128i *)(zs + i),
+            _mm_add_epi32(
+                _mm_add_epi32(vs_vector, ws_vector),
+                _mm_add_epi32(xs_vector, ys_vector)));
+    }
+}
+
+TARGET_AVX2 void sum_avx2(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                          size_t count)
+{
+    for(size_t i = 0; i < count; i += sizeof(__m256i) / sizeof(elem_t))
+    {
+        __m256i vs_vector = _mm256_load_si256((__m256i const *)(vs + i));
+        __m256i ws_vector = _mm256_load_si256((__m256i const *)(ws + i));
+        __m256i xs_vector = _mm256_load_si256((__m256i const *)(xs + i));
+        __m256i ys_vector = _mm256_load_si256((__m256i const *)(ys + i));
+
+        _mm256_store_si256(
+            (__m256i *)(zs + i),
+            _mm256_add_epi32(
+                _mm256_add_epi32(vs_vector, ws_vector),
+                _mm256_add_epi32(xs_vector, ys_vector)));
+    }
+}
+
+TARGET_AVX512 void sum_avx512(const elem_t * vs, const elem_t * ws, const elem_t * xs, const elem_t * ys, elem_t * zs,
+                              size_t count)
+{
+    for(size_t i = 0; i < count; i += sizeof(__m512i) / sizeof(elem_t))
+    {
+        __m512i vs_vector = _mm512_load_si512((void const *)(vs + i));
+        __m512i ws_vector = _mm512_load_si512((void const *)(ws + i));
+        __m512i xs_vector = _mm512_load_si512((void const *)(xs + i));
+        __m512i ys_vector = _mm512_load_si512((void const *)(ys + i));
+
+        _mm512_store_si512(
+            (void *)(zs + i),
+            _mm512_add_epi32(
+                _mm512_add_epi32(vs_vector, ws_vector),
+                _mm512_add_epi32(xs_vector, ys_vector)));
+    }
+}
+
+// BENCHFn wrapper for the sum kernels.
+void run_sum(void * data)
+{
+    auto args = (SUM_ARGS *)data;
+
+    args->kernel(
+        prism::soaGetColumn<0>(args->data),
+        prism::soaGetColumn<1>(args->data),
+        prism::soaGetColumn<2>(args->data),
+        prism::soaGetColumn<3>(args->data),
+        prism::soaGetColumn<4>(args->data),
+        args->count);
+}
+
+// Checks every kernel up to ISA level isa computes the same sums as the scalar kernel, so the comparison is like for
+// like.
+bool verify_kernels(DATA * data, const sum_kernel_t * kernels, prism::CPUISA isa)
+{
+    elem_t * zs = prism::soaGetColumn<4>(data);
+    size_t size = data->count * sizeof(elem_t);
+    auto expected = (elem_t *)malloc(size);
+    SUM_ARGS args = { kernels[(size_t)prism::CPUISA::SCALAR], data, data->count };
+    run_sum(&args);
+    memcpy(expected, zs, size);
+    bool verified = true;
+
+    for(size_t kernel_isa = (size_t)prism::CPUISA::SCALAR + 1; kernel_isa <= (size_t)isa; kernel_isa++)
+    {
+        memset(zs, 0, size);
+        args.kernel = kernels[kernel_isa];
+        run_sum(&args);
+
+        if(memcmp(zs, expected, size) != 0)
+        {
+            const char * isa_name = prism::cpuGetISAName((prism::CPUISA)kernel_isa);
+            fprintf(stderr, "%s sum kernel doesn't match the scalar kernel\n", isa_name);
+            verified = false;
+        }
+    }
+
+    free(expected);
+    return verified;
+}
@@ -0,0 +1,381 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "prism/assets.h"
+#include "prism/graphics.h"
+#include "prism/draw.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static uint64_t
+alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static int
+compareEntryNames(const void * a, const void * b)
+{
+    return strncmp((const char *)a, (const char *)b, ASSET_MAX_NAME_SIZE);
+}
+
+static int
+compareSourceNames(const void * a, const void * b)
+{
+    return strcmp((*(const ASSETSource * const *)a)->name, (*(const ASSETSource * const *)b)->name);
+}
+
+static bool
+payloadInFile(const ASSETPayload * payload, uint64_t fileSize)
+{
+    return payload->offset % ASSET_PAYLOAD_ALIGNMENT == 0 && payload->offset <= fileSize &&
+           payload->size <= fileSize - payload->offset;
+}
+
+// Returns why mapping isn't a valid asset file, or null if it is. Only the header and entry table are read, so
+// checking a file costs the same however large its payloads are.
+static const char *
+validateFile(const UTILMappedFile * mapping)
+{
+    if(mapping->size < sizeof(ASSETHeader))
+    {
+        return "file is smaller than its header";
+    }
+
+    auto header = (const ASSETHeader *)mapping->data;
+
+    if(memcmp(header->magic, ASSET_MAGIC, sizeof(header->magic)) != 0)
+    {
+        return "bad magic";
+    }
+
+    if(header->version != ASSET_VERSION)
+    {
+        return "unsupported version";
+    }
+
+    if(header->fileSize != mapping->size)
+    {
+        return "file size doesn't match header";
+    }
+
+    if(header->entryTableOffset % ASSET_PAYLOAD_ALIGNMENT != 0 || header->entryTableOffset > mapping->size ||
+       header->entryCount > (mapping->size - header->entryTableOffset) / sizeof(ASSETEntry))
+    {
+        return "entry table is out of bounds";
+    }
+
+    auto entries = (const ASSETEntry *)(mapping->data + header->entryTableOffset);
+
+    for(uint32_t entryIndex = 0; entryIndex < header->entryCount; entryIndex++)
+    {
+        const ASSETEntry * entry = entries + entryIndex;
+
+        if(memchr(entry->name, '\0', ASSET_MAX_NAME_SIZE) == nullptr)
+        {
+            return "entry name isn't terminated";
+        }
+
+        if(entryIndex > 0 && compareEntryNames(entries[entryIndex - 1].name, entry->name) >= 0)
+        {
+            return "entries aren't sorted by unique names";
+        }
+
+        if(entry->type >= ASSETType::COUNT || entry->payloadCount > ASSET_MAX_PAYLOADS)
+        {
+            return "bad entry type or payload count";
+        }
+
+        for(uint32_t i = 0; i < entry->payloadCount; i++)
+        {
+            if(entry->payloads[i].size == 0 || !payloadInFile(entry->payloads + i, mapping->size))
+            {
+                return "payload is empty, misaligned or out of bounds";
+            }
+        }
+
+        if(entry->type == ASSETType::MESH &&
+           (entry->payloadCount != 2 || entry->payloads[0].size % sizeof(GFXVertex) != 0 ||
+            entry->payloads[1].size % sizeof(uint32_t) != 0))
+        {
+            return "mesh entry needs vertex and index payloads";
+        }
+
+        if(entry->type != ASSETType::TEXTURE)
+        {
+            continue;
+        }
+
+        if(entry->payloadCount == 0 || entry->width == 0 || entry->height == 0)
+        {
+            return "texture entry needs an extent and at least one mip level";
+        }
+
+        uint64_t texelSize = gfxGetTexelSize(entry->format);
+
+        if(texelSize == 0)
+        {
+            return "texture entry has an unsupported format";
+        }
+
+        // Mips are tightly packed, so each payload holds exactly its mip's texels.
+        for(uint32_t mip = 0; mip < entry->payloadCount; mip++)
+        {
+            uint64_t mipWidth = entry->width >> mip > 0 ? entry->width >> mip : 1;
+            uint64_t mipHeight = entry->height >> mip > 0 ? entry->height >> mip : 1;
+
+            if(entry->payloads[mip].size != mipWidth * mipHeight * texelSize)
+            {
+                return "texture mip payload size doesn't match its extent";
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+// Starts reading payload's pages from disk in the background, so the copy into staging memory overlaps I/O instead of
+// faulting each page in as it's reached.
+static void
+prefetchPayload(const ASSETFile * file, const ASSETPayload * payload)
+{
+    static const uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t begin = payload->offset / pageSize * pageSize;
+    madvise((void *)(file->mapping.data + begin), payload->offset + payload->size - begin, MADV_WILLNEED);
+}
+
+static bool
+writePadding(FILE * file, uint64_t size)
+{
+    static const uint8_t ZEROS[ASSET_PAYLOAD_ALIGNMENT] = {};
+    return size == 0 || fwrite(ZEROS, size, 1, file) == 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool
+assetOpen(const char * path, ASSETFile * file)
+{
+    PRISM_ASSERT(path != nullptr);
+    PRISM_ASSERT(file != nullptr);
+
+    if(!utilMapFile(path, &file->mapping))
+    {
+        utilWarning("ASSETS", "failed to map '%s'\n", path);
+        return false;
+    }
+
+    const char * error = validateFile(&file->mapping);
+
+    if(error != nullptr)
+    {
+        utilWarning("ASSETS", "'%s' isn't a valid asset file: %s\n", path, error);
+        utilUnmapFile(&file->mapping);
+        return false;
+    }
+
+    file->header = (const ASSETHeader *)file->mapping.data;
+    file->entries = (const ASSETEntry *)(file->mapping.data + file->header->entryTableOffset);
+
+    return true;
+}
+
+const ASSETEntry *
+assetFind(const ASSETFile * file, const char * name)
+{
+    PRISM_ASSERT(file != nullptr);
+    PRISM_ASSERT(name != nullptr);
+
+    // ASSETEntry starts with its name, so names used as search keys compare the same as entries.
+    return (const ASSETEntry *)bsearch(name, file->entries, file->header->entryCount, sizeof(ASSETEntry),
+                                       compareEntryNames);
+}
+
+const void *
+assetGetPayload(const ASSETFile * file, const ASSETEntry * entry, uint32_t index)
+{
+    PRISM_ASSERT(file != nullptr);
+    PRISM_ASSERT(entry != nullptr);
+    PRISM_ASSERT(index < entry->payloadCount);
+    return file->mapping.data + entry->payloads[index].offset;
+}
+
+bool
+assetUploadMesh(const ASSETFile * file, const ASSETEntry * entry, DRAWBatcher * batcher, uint32_t * mesh)
+{
+    PRISM_ASSERT(file != nullptr);
+    PRISM_ASSERT(entry != nullptr && entry->type == ASSETType::MESH);
+    prefetchPayload(file, entry->payloads + 0);
+    prefetchPayload(file, entry->payloads + 1);
+
+    return drawCreateMesh(batcher, (const GFXVertex *)assetGetPayload(file, entry, 0),
+                          (uint32_t)(entry->payloads[0].size / sizeof(GFXVertex)),
+                          (const uint32_t *)assetGetPayload(file, entry, 1),
+                          (uint32_t)(entry->payloads[1].size / sizeof(uint32_t)), mesh);
+}
+
+bool
+assetUploadTextureMip(GFXContext * context, const ASSETFile * file, const ASSETEntry * entry, uint32_t mipLevel,
+                      VkImage image)
+{
+    PRISM_ASSERT(file != nullptr);
+    PRISM_ASSERT(entry != nullptr && entry->type == ASSETType::TEXTURE);
+    PRISM_ASSERT(mipLevel < entry->payloadCount);
+    const ASSETPayload * payload = entry->payloads + mipLevel;
+    prefetchPayload(file, payload);
+
+    VkExtent3D extent =
+    {
+        entry->width >> mipLevel > 0 ? entry->width >> mipLevel : 1,
+        entry->height >> mipLevel > 0 ? entry->height >> mipLevel : 1,
+        1,
+    };
+
+    return gfxUploadImage(context, image, entry->format, mipLevel, extent, assetGetPayload(file, entry, mipLevel),
+                          payload->size);
+}
+
+void
+assetClose(ASSETFile * file)
+{
+    PRISM_ASSERT(file != nullptr);
+    utilUnmapFile(&file->mapping);
+    file->header = nullptr;
+    file->entries = nullptr;
+}
+
+bool
+assetWriteFile(const char * path, const ASSETSource * sources, uint32_t sourceCount)
+{
+    PRISM_ASSERT(path != nullptr);
+    PRISM_ASSERT(sources != nullptr || sourceCount == 0);
+    auto sortedSources = bufferCreate<const ASSETSource *>(sourceCount);
+
+    for(uint32_t i = 0; i < sourceCount; i++)
+    {
+        const ASSETSource * source = sources + i;
+        sortedSources.data[i] = source;
+
+        bool emptyPayload = false;
+
+        for(uint32_t payloadIndex = 0; payloadIndex < source->payloadCount && payloadIndex < ASSET_MAX_PAYLOADS;
+            payloadIndex++)
+        {
+            emptyPayload = emptyPayload || source->payloadSizes[payloadIndex] == 0;
+        }
+
+        if(strlen(source->name) >= ASSET_MAX_NAME_SIZE || source->payloadCount > ASSET_MAX_PAYLOADS || emptyPayload)
+        {
+            utilWarning("ASSETS", "entry \"%s\" of '%s' has too long a name, too many payloads or an empty payload\n",
+                        source->name, path);
+
+            bufferFree(&sortedSources);
+            return false;
+        }
+    }
+
+    qsort(sortedSources.data, sourceCount, sizeof(const ASSETSource *), compareSourceNames);
+
+    // Build the entry table, with payloads laid out after it in table order.
+    auto entries = bufferCreate<ASSETEntry>(sourceCount);
+    uint64_t entryTableOffset = alignUp(sizeof(ASSETHeader), ASSET_PAYLOAD_ALIGNMENT);
+    uint64_t offset = entryTableOffset + sourceCount * sizeof(ASSETEntry);
+
+    for(uint32_t i = 0; i < sourceCount; i++)
+    {
+        const ASSETSource * source = sortedSources.data[i];
+        ASSETEntry * entry = entries.data + i;
+
+        if(i > 0 && strcmp(sortedSources.data[i - 1]->name, source->name) == 0)
+        {
+            utilWarning("ASSETS", "duplicate entry \"%s\" for '%s'\n", source->name, path);
+            bufferFree(&entries);
+            bufferFree(&sortedSources);
+            return false;
+        }
+
+        strncpy(entry->name, source->name, ASSET_MAX_NAME_SIZE);
+        entry->type = source->type;
+        entry->payloadCount = source->payloadCount;
+        entry->format = source->format;
+        entry->width = source->width;
+        entry->height = source->height;
+
+        for(uint32_t payloadIndex = 0; payloadIndex < source->payloadCount; payloadIndex++)
+        {
+            offset = alignUp(offset, ASSET_PAYLOAD_ALIGNMENT);
+            entry->payloads[payloadIndex] = { offset, source->payloadSizes[payloadIndex] };
+            offset += source->payloadSizes[payloadIndex];
+        }
+    }
+
+    ASSETHeader header = {};
+    memcpy(header.magic, ASSET_MAGIC, sizeof(header.magic));
+    header.version = ASSET_VERSION;
+    header.entryCount = sourceCount;
+    header.entryTableOffset = entryTableOffset;
+    header.fileSize = offset;
+
+    // Payloads are written in file order, each preceded by the padding that aligns it.
+    FILE * file = fopen(path, "wb");
+    bool written = false;
+
+    if(file != nullptr)
+    {
+        written = fwrite(&header, sizeof(ASSETHeader), 1, file) == 1
+                  && writePadding(file, entryTableOffset - sizeof(ASSETHeader))
+                  && (sourceCount == 0 || fwrite(entries.data, sizeof(ASSETEntry), sourceCount, file) == sourceCount);
+
+        uint64_t position = entryTableOffset + sourceCount * sizeof(ASSETEntry);
+
+        for(uint32_t i = 0; i < sourceCount && written; i++)
+        {
+            const ASSETEntry * entry = entries.data + i;
+
+            for(uint32_t payloadIndex = 0; payloadIndex < entry->payloadCount && written; payloadIndex++)
+            {
+                const ASSETPayload * payload = entry->payloads + payloadIndex;
+                const void * data = sortedSources.data[i]->payloads[payloadIndex];
+
+                written = writePadding(file, payload->offset - position) && fwrite(data, payload->size, 1, file) == 1;
+
+                position = payload->offset + payload->size;
+            }
+        }
+
+        written = fclose(file) == 0 && written;
+
+        if(!written)
+        {
+            remove(path);
+        }
+    }
+
+    if(!written)
+    {
+        utilWarning("ASSETS", "failed to write '%s'\n", path);
+    }
+
+    // Cleanup
+    bufferFree(&entries);
+    bufferFree(&sortedSources);
+
+    return written;
+}
+
+} // namespace prism
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.h"
+#include "prism/utilities.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define ASSET_MAGIC "PRSA"
+#define ASSET_VERSION 1
+#define ASSET_MAX_NAME_SIZE 48
+
+// Meshes have a vertex and an index payload; textures have one payload per mip level.
+#define ASSET_MAX_PAYLOADS 16
+
+// Alignment of the entry table and every payload within the file; files are mapped page-aligned, so payloads are too.
+#define ASSET_PAYLOAD_ALIGNMENT 256
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GFXContext;
+struct DRAWBatcher;
+
+enum class ASSETType : uint32_t
+{
+    // Payload 0 is an array of GFXVertex, payload 1 an array of uint32_t indices.
+    MESH = 0,
+
+    // Payload i is mip level i of a 2D image of format, tightly packed.
+    TEXTURE = 1,
+
+    COUNT = 2,
+};
+
+// Location of a payload; offset is from the start of the file.
+struct ASSETPayload
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+// The file starts with an ASSETHeader; the entry table it points to is sorted by name, and entries point to payloads
+// stored after it. Everything is little-endian and read in place from the mapping.
+struct ASSETHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t entryTableOffset;
+    uint64_t fileSize;
+};
+
+struct ASSETEntry
+{
+    char name[ASSET_MAX_NAME_SIZE];
+    ASSETType type;
+    uint32_t payloadCount;
+
+    // Textures only; the extent of mip level 0.
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+
+    ASSETPayload payloads[ASSET_MAX_PAYLOADS];
+};
+
+static_assert(sizeof(ASSETHeader) == 32, "ASSETHeader layout is part of the file format");
+static_assert(sizeof(ASSETEntry) == 328, "ASSETEntry layout is part of the file format");
+
+struct ASSETFile
+{
+    UTILMappedFile mapping;
+    const ASSETHeader * header;
+    const ASSETEntry * entries;
+};
+
+// An entry to write with assetWriteFile(); payloads point to the data to write.
+struct ASSETSource
+{
+    const char * name;
+    ASSETType type;
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t payloadCount;
+    const void * payloads[ASSET_MAX_PAYLOADS];
+    uint64_t payloadSizes[ASSET_MAX_PAYLOADS];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maps the asset file at path and checks its header and entry table; payloads are only read when uploaded. Returns
+// false with a warning if the file can't be mapped or isn't a valid asset file.
+bool
+assetOpen(const char * path, ASSETFile * file);
+
+// Returns the entry named name, or null if there is none.
+const ASSETEntry *
+assetFind(const ASSETFile * file, const char * name);
+
+// Returns a pointer to payload index of entry within the mapping, valid until assetClose().
+const void *
+assetGetPayload(const ASSETFile * file, const ASSETEntry * entry, uint32_t index);
+
+// Adds a mesh entry to batcher, copying its payloads straight from the mapping into staging memory. Like
+// drawCreateMesh(), must be called before the first gfxEndFrame(); returns false if drawCreateMesh() does.
+bool
+assetUploadMesh(const ASSETFile * file, const ASSETEntry * entry, DRAWBatcher * batcher, uint32_t * mesh);
+
+// Uploads mip level mipLevel of a texture entry into image with gfxUploadImage(), copying it straight from the mapping
+// into staging memory. Returns false if gfxUploadImage() does, in which case the upload can be retried next frame.
+bool
+assetUploadTextureMip(GFXContext * context, const ASSETFile * file, const ASSETEntry * entry, uint32_t mipLevel,
+                      VkImage image);
+
+void
+assetClose(ASSETFile * file);
+
+// Writes sources to a new asset file at path, sorting entries by name; for asset-building tools. Returns false with a
+// warning if the file can't be written.
+bool
+assetWriteFile(const char * path, const ASSETSource * sources, uint32_t sourceCount);
+
+} // namespace prism
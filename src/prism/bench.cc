@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "prism/bench.h"
+#include "prism/defines.h"
+#include "prism/utilities.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define NANOSECONDS_PER_SECOND 1000000000.0
+#define MAX_ITERATIONS_PER_SAMPLE (1u << 24)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static int
+compareTimes(const void * a, const void * b)
+{
+    double timeA = *(const double *)a;
+    double timeB = *(const double *)b;
+
+    return (timeA > timeB) - (timeA < timeB);
+}
+
+// Nearest-rank percentile of sorted times.
+static double
+getPercentile(const double * sortedTimes, uint32_t count, double percentile)
+{
+    uint32_t rank = (uint32_t)(percentile / 100.0 * count + 0.999999);
+
+    return sortedTimes[(rank > 0 ? rank : 1) - 1];
+}
+
+// Returns the seconds per iteration of a sample of iterationCount iterations.
+static double
+runSample(BENCHFn fn, void * data, uint32_t iterationCount)
+{
+    uint64_t start = benchGetTimeNs();
+
+    for(uint32_t i = 0; i < iterationCount; i++)
+    {
+        fn(data);
+        benchClobberMemory();
+    }
+
+    uint64_t end = benchGetTimeNs();
+
+    return (end - start) / NANOSECONDS_PER_SECOND / iterationCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint64_t
+benchGetTimeNs()
+{
+    timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+void
+benchRun(const BENCHConfig * config, const char * name, const char * variant, BENCHFn fn, void * data,
+         uint64_t elementCount, uint64_t byteCount, BENCHResult * result)
+{
+    PRISM_ASSERT(config->repeatCount > 0 && config->repeatCount <= BENCH_MAX_REPEATS);
+    PRISM_ASSERT(strlen(name) < BENCH_MAX_NAME_SIZE && strlen(variant) < BENCH_MAX_NAME_SIZE);
+
+    // Double the iterations per sample until a sample takes minSampleTime; this also serves as the first warmup.
+    uint32_t iterationsPerSample = 1;
+
+    while(iterationsPerSample < MAX_ITERATIONS_PER_SAMPLE &&
+          runSample(fn, data, iterationsPerSample) * iterationsPerSample < config->minSampleTime)
+    {
+        iterationsPerSample *= 2;
+    }
+
+    for(uint32_t i = 0; i < config->warmupCount; i++)
+    {
+        runSample(fn, data, iterationsPerSample);
+    }
+
+    double times[BENCH_MAX_REPEATS] = {};
+
+    for(uint32_t i = 0; i < config->repeatCount; i++)
+    {
+        times[i] = runSample(fn, data, iterationsPerSample);
+    }
+
+    qsort(times, config->repeatCount, sizeof(double), compareTimes);
+    *result = {};
+    strcpy(result->name, name);
+    strcpy(result->variant, variant);
+    result->elementCount = elementCount;
+    result->byteCount = byteCount;
+    result->iterationsPerSample = iterationsPerSample;
+    result->repeatCount = config->repeatCount;
+    result->minTime = times[0];
+    result->medianTime = getPercentile(times, config->repeatCount, 50.0);
+    result->p99Time = getPercentile(times, config->repeatCount, 99.0);
+    result->elementsPerSecond = elementCount / result->medianTime;
+    result->bytesPerSecond = byteCount / result->medianTime;
+}
+
+void
+benchPrintResult(FILE * file, const BENCHResult * result)
+{
+    fprintf(file,
+            "%-16s %-8s %10llu elements  min %10.1fns  median %10.1fns  p99 %10.1fns  %8.3f Gelem/s  %8.3f GB/s\n",
+            result->name, result->variant, (unsigned long long)result->elementCount,
+            result->minTime * NANOSECONDS_PER_SECOND, result->medianTime * NANOSECONDS_PER_SECOND,
+            result->p99Time * NANOSECONDS_PER_SECOND, result->elementsPerSecond / 1e9, result->bytesPerSecond / 1e9);
+}
+
+void
+benchWriteJSON(FILE * file, const BENCHResult * results, size_t resultCount)
+{
+    fprintf(file, "[\n");
+
+    for(size_t i = 0; i < resultCount; i++)
+    {
+        const BENCHResult * result = results + i;
+        fprintf(file, "    {\n");
+        fprintf(file, "        \"name\": \"%s\",\n", result->name);
+        fprintf(file, "        \"variant\": \"%s\",\n", result->variant);
+        fprintf(file, "        \"elements\": %llu,\n", (unsigned long long)result->elementCount);
+        fprintf(file, "        \"bytes\": %llu,\n", (unsigned long long)result->byteCount);
+        fprintf(file, "        \"iterations_per_sample\": %u,\n", result->iterationsPerSample);
+        fprintf(file, "        \"repeats\": %u,\n", result->repeatCount);
+        fprintf(file, "        \"min_ns\": %.1f,\n", result->minTime * NANOSECONDS_PER_SECOND);
+        fprintf(file, "        \"median_ns\": %.1f,\n", result->medianTime * NANOSECONDS_PER_SECOND);
+        fprintf(file, "        \"p99_ns\": %.1f,\n", result->p99Time * NANOSECONDS_PER_SECOND);
+        fprintf(file, "        \"elements_per_second\": %.0f,\n", result->elementsPerSecond);
+        fprintf(file, "        \"gigabytes_per_second\": %.3f\n", result->bytesPerSecond / 1e9);
+        fprintf(file, "    }%s\n", i + 1 < resultCount ? "," : "");
+    }
+
+    fprintf(file, "]\n");
+}
+
+} // namespace prism
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define BENCH_MAX_NAME_SIZE 64
+
+// Maximum number of timed samples per benchmark.
+#define BENCH_MAX_REPEATS 1024
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Typedefs
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Runs one iteration of the code being measured.
+using BENCHFn = void (*)(void * data);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct BENCHConfig
+{
+    // Untimed samples run first to warm caches, TLBs and branch predictors, and timed samples.
+    uint32_t warmupCount;
+    uint32_t repeatCount;
+
+    // Each sample runs enough iterations to take at least this long, so clock resolution and overhead don't dominate
+    // small working sets.
+    double minSampleTime;
+};
+
+struct BENCHResult
+{
+    // What was measured (e.g. the kernel) and how (e.g. its ISA level).
+    char name[BENCH_MAX_NAME_SIZE];
+    char variant[BENCH_MAX_NAME_SIZE];
+
+    // Work done by one iteration: elements processed and bytes read plus written.
+    uint64_t elementCount;
+    uint64_t byteCount;
+
+    uint32_t iterationsPerSample;
+    uint32_t repeatCount;
+
+    // Seconds per iteration over the timed samples.
+    double minTime;
+    double medianTime;
+    double p99Time;
+
+    // Throughput at the median time.
+    double elementsPerSecond;
+    double bytesPerSecond;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Nanoseconds from an arbitrary fixed point on a monotonic clock that isn't slewed by NTP.
+uint64_t
+benchGetTimeNs();
+
+// Keeps the compiler from eliminating or reordering memory writes across the call, e.g. stores to results nothing
+// reads back.
+inline void
+benchClobberMemory()
+{
+    __asm__ volatile("" : : : "memory");
+}
+
+// Measures fn after config->warmupCount untimed samples; elementCount and byteCount describe one call to fn.
+void
+benchRun(const BENCHConfig * config, const char * name, const char * variant, BENCHFn fn, void * data,
+         uint64_t elementCount, uint64_t byteCount, BENCHResult * result);
+
+// Prints result as one human-readable line.
+void
+benchPrintResult(FILE * file, const BENCHResult * result);
+
+// Writes results as a JSON array with one object per result and one line per field, so output from different commits
+// can be diffed; times are in nanoseconds.
+void
+benchWriteJSON(FILE * file, const BENCHResult * results, size_t resultCount);
+
+} // namespace prism
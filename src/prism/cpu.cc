@@ -0,0 +1,132 @@
+#include "prism/cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// cpuid leaf 1 feature bits.
+#define CPUID_1_EDX_SSE2 (1u << 26)
+#define CPUID_1_ECX_OSXSAVE (1u << 27)
+#define CPUID_1_ECX_AVX (1u << 28)
+
+// cpuid leaf 7 (subleaf 0) feature bits.
+#define CPUID_7_EBX_AVX2 (1u << 5)
+#define CPUID_7_EBX_AVX512F (1u << 16)
+
+// XCR0 bits for register state the OS saves on context switches: SSE (XMM), AVX (upper YMM) and AVX-512 (opmask,
+// upper ZMM0-15, ZMM16-31).
+#define XCR0_AVX_STATE 0x06u
+#define XCR0_AVX512_STATE 0xE6u
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(__x86_64__) || defined(__i386__)
+// xgetbv is only valid once cpuid reports OSXSAVE; inline asm avoids needing -mxsave for the _xgetbv() intrinsic.
+static uint64_t
+readXCR0()
+{
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static CPUISA
+detectISA()
+{
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (edx & CPUID_1_EDX_SSE2) == 0)
+    {
+        return CPUISA::SCALAR;
+    }
+
+    // AVX registers are only usable if the OS saves their upper halves.
+    if((ecx & CPUID_1_ECX_OSXSAVE) == 0 || (ecx & CPUID_1_ECX_AVX) == 0)
+    {
+        return CPUISA::SSE2;
+    }
+
+    uint64_t xcr0 = readXCR0();
+
+    if((xcr0 & XCR0_AVX_STATE) != XCR0_AVX_STATE || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) ||
+       (ebx & CPUID_7_EBX_AVX2) == 0)
+    {
+        return CPUISA::SSE2;
+    }
+
+    if((xcr0 & XCR0_AVX512_STATE) != XCR0_AVX512_STATE || (ebx & CPUID_7_EBX_AVX512F) == 0)
+    {
+        return CPUISA::AVX2;
+    }
+
+    return CPUISA::AVX512;
+}
+#else
+static CPUISA
+detectISA()
+{
+    return CPUISA::SCALAR;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CPUISA
+cpuGetISA()
+{
+    // Function-local statics are initialized once, even when first called from several threads.
+    static const CPUISA ISA = detectISA();
+
+    return ISA;
+}
+
+const char *
+cpuGetISAName(CPUISA isa)
+{
+    static const char * ISA_NAMES[]
+    {
+        "scalar",
+        "sse2",
+        "avx2",
+        "avx512",
+    };
+
+    return ISA_NAMES[(size_t)isa];
+}
+
+uint32_t
+cpuGetVectorSize(CPUISA isa)
+{
+    // Scalar kernels work in general-purpose registers.
+    static const uint32_t VECTOR_SIZES[]
+    {
+        sizeof(uint64_t),
+        16,
+        32,
+        64,
+    };
+
+    return VECTOR_SIZES[(size_t)isa];
+}
+
+} // namespace prism
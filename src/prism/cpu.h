@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Instruction set levels SIMD kernels are compiled for, from narrowest to widest vectors.
+enum class CPUISA
+{
+    SCALAR = 0,
+    SSE2 = 1,
+    AVX2 = 2,
+    AVX512 = 3,
+    COUNT = 4,
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the widest ISA level both the CPU (from cpuid) and the OS (from the register state it saves) support.
+// Detected on first call.
+CPUISA
+cpuGetISA();
+
+const char *
+cpuGetISAName(CPUISA isa);
+
+// Size in bytes of the vector registers used by kernels compiled for isa.
+uint32_t
+cpuGetVectorSize(CPUISA isa);
+
+// Returns the kernel for the widest ISA level that is supported and has a kernel in kernels, which is indexed by
+// CPUISA; kernels[CPUISA::SCALAR] must be set. The kernel's ISA level is written to selectedISA if it isn't null, so
+// callers can size their loops with cpuGetVectorSize(). Call once at startup and keep the result.
+template<typename Fn>
+Fn
+cpuSelectKernel(const Fn * kernels, CPUISA * selectedISA)
+{
+    int isa = (int)cpuGetISA();
+
+    while(isa > (int)CPUISA::SCALAR && kernels[isa] == nullptr)
+    {
+        isa--;
+    }
+
+    if(selectedISA != nullptr)
+    {
+        *selectedISA = (CPUISA)isa;
+    }
+
+    return kernels[isa];
+}
+
+} // namespace prism
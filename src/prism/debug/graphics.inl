@@ -1,3 +1,19 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Debug Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Validation messages are aggregated by layer prefix and message code; kinds past the limit are only counted in total.
+#define DEBUG_MAX_MESSAGE_KINDS 256
+#define DEBUG_MAX_LAYER_PREFIX_SIZE 32
+
+// Occurrences of each message kind logged in full; later repeats are only counted.
+#define DEBUG_MESSAGE_LOG_LIMIT 3
+
+// Minimum seconds between frame-end summaries of repeated messages.
+#define DEBUG_MESSAGE_SUMMARY_INTERVAL 5.0
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Debug Typedefs
@@ -7,6 +23,32 @@ using DebugFlagName = Pair<VkDebugReportFlagBitsEXT, const char *>;
 using QueueFlagName = Pair<VkQueueFlagBits, const char *>;
 using SurfaceFormatName = Pair<VkFormat, const char *>;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Debug Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct DebugMessageKind
+{
+    int32_t messageCode;
+    char layerPrefix[DEBUG_MAX_LAYER_PREFIX_SIZE];
+    VkDebugReportFlagsEXT flags;
+    uint64_t count;
+
+    // Count at the last summary, so summaries only list kinds that repeated since.
+    uint64_t summarizedCount;
+};
+
+// Validation layers call debugCallback() from whichever thread made the call being validated.
+struct GFXDebugMessageLog
+{
+    std::mutex mutex;
+    DebugMessageKind kinds[DEBUG_MAX_MESSAGE_KINDS];
+    uint32_t kindCount;
+    uint64_t unaggregatedCount;
+    double lastSummaryTime;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Debug Callbacks
@@ -20,6 +62,84 @@ logDivider()
     utilLog("VULKAN", "\n");
 }
 
+// Returns null if DEBUG_MAX_MESSAGE_KINDS kinds are already aggregated; messageLog->mutex must be held.
+static DebugMessageKind *
+getDebugMessageKind(GFXDebugMessageLog * messageLog, int32_t messageCode, const char * layerPrefix,
+                    VkDebugReportFlagsEXT flags)
+{
+    for(uint32_t i = 0; i < messageLog->kindCount; i++)
+    {
+        DebugMessageKind * kind = messageLog->kinds + i;
+
+        if(kind->messageCode == messageCode &&
+           strncmp(kind->layerPrefix, layerPrefix, DEBUG_MAX_LAYER_PREFIX_SIZE - 1) == 0)
+        {
+            kind->flags |= flags;
+            return kind;
+        }
+    }
+
+    if(messageLog->kindCount == DEBUG_MAX_MESSAGE_KINDS)
+    {
+        return nullptr;
+    }
+
+    DebugMessageKind * kind = messageLog->kinds + messageLog->kindCount++;
+    kind->messageCode = messageCode;
+    strncpy(kind->layerPrefix, layerPrefix, DEBUG_MAX_LAYER_PREFIX_SIZE - 1);
+    kind->layerPrefix[DEBUG_MAX_LAYER_PREFIX_SIZE - 1] = '\0';
+    kind->flags = flags;
+    kind->count = 0;
+    kind->summarizedCount = 0;
+
+    return kind;
+}
+
+// Logs how often each message kind repeated since the last summary. Frame-end summaries are skipped until
+// DEBUG_MESSAGE_SUMMARY_INTERVAL has passed; the final summary lists every kind's total.
+static void
+logDebugMessageSummary(GFXDebugMessageLog * messageLog, bool final)
+{
+    double time = utilGetTime();
+
+    if(!final && time - messageLog->lastSummaryTime < DEBUG_MESSAGE_SUMMARY_INTERVAL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(messageLog->mutex);
+    messageLog->lastSummaryTime = time;
+
+    if(final && messageLog->kindCount > 0)
+    {
+        utilLog("VULKAN", "validation message totals:\n");
+    }
+
+    for(uint32_t i = 0; i < messageLog->kindCount; i++)
+    {
+        DebugMessageKind * kind = messageLog->kinds + i;
+
+        if(final)
+        {
+            utilLog("VULKAN", "    %s %i: %llu\n", kind->layerPrefix, kind->messageCode,
+                    (unsigned long long)kind->count);
+        }
+        else if(kind->count > kind->summarizedCount && kind->count > DEBUG_MESSAGE_LOG_LIMIT)
+        {
+            utilLog("VULKAN", "validation layer: %s message %i repeated %llu times (%llu total)\n", kind->layerPrefix,
+                    kind->messageCode, (unsigned long long)(kind->count - kind->summarizedCount),
+                    (unsigned long long)kind->count);
+        }
+
+        kind->summarizedCount = kind->count;
+    }
+
+    if(final && messageLog->unaggregatedCount > 0)
+    {
+        utilLog("VULKAN", "    other: %llu\n", (unsigned long long)messageLog->unaggregatedCount);
+    }
+}
+
 static VKAPI_ATTR VkBool32 VKAPI_CALL
 debugCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objectType, uint64_t object, size_t location,
               int32_t messageCode, const char * layerPrefix, const char * message, void * userData)
@@ -61,7 +181,36 @@ debugCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objectType
     utilLog("VULKAN", "    message:     \"%s\"\n", message);
     utilLog("VULKAN", "    userData:    %p\n", userData);
 #else
-    utilLog("VULKAN", "validation layer: %s: %s\n", layerPrefix, message);
+    // Only the first few occurrences of each kind of message are logged, so a message fired every draw doesn't flood
+    // the log; repeats are counted for the summaries.
+    auto messageLog = (GFXDebugMessageLog *)userData;
+    std::lock_guard<std::mutex> lock(messageLog->mutex);
+    DebugMessageKind * kind = getDebugMessageKind(messageLog, messageCode, layerPrefix, flags);
+
+    if(kind == nullptr)
+    {
+        messageLog->unaggregatedCount++;
+        return VK_FALSE;
+    }
+
+    if(++kind->count > DEBUG_MESSAGE_LOG_LIMIT)
+    {
+        return VK_FALSE;
+    }
+
+    if(flags & (VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT))
+    {
+        utilWarning("VULKAN", "validation layer: %s %i: %s\n", layerPrefix, messageCode, message);
+    }
+    else
+    {
+        utilLog("VULKAN", "validation layer: %s %i: %s\n", layerPrefix, messageCode, message);
+    }
+
+    if(kind->count == DEBUG_MESSAGE_LOG_LIMIT)
+    {
+        utilLog("VULKAN", "validation layer: further %s %i messages are only counted\n", layerPrefix, messageCode);
+    }
 #endif
 
     // Should the call being validated be aborted?
@@ -106,9 +255,17 @@ logInstanceComponentNames(const InstanceComponentInfo<ComponentProps> * componen
     }
 }
 
-static VkDebugReportCallbackEXT
-createDebugCallback(VkInstance instance)
+static void
+createDebugCallback(GFXContext * context)
 {
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(context->instance != VK_NULL_HANDLE);
+    VkInstance instance = context->instance;
+    context->debugMessageLog = new GFXDebugMessageLog;
+    context->debugMessageLog->kindCount = 0;
+    context->debugMessageLog->unaggregatedCount = 0;
+    context->debugMessageLog->lastSummaryTime = utilGetTime();
+
     // Ensure debug callback creation function exists.
     auto createDebugCallback =
         (PFN_vkCreateDebugReportCallbackEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugReportCallbackEXT");
@@ -142,41 +299,44 @@ createDebugCallback(VkInstance instance)
         VK_DEBUG_REPORT_DEBUG_BIT_EXT;
 
     debugCallbackCreateInfo.pfnCallback = debugCallback;
-    debugCallbackCreateInfo.pUserData = nullptr;
+    debugCallbackCreateInfo.pUserData = context->debugMessageLog;
 
     // Create debug callback.
-    VkDebugReportCallbackEXT debugCallbackHandle;
-    VkResult result = createDebugCallback(instance, &debugCallbackCreateInfo, nullptr, &debugCallbackHandle);
+    VkResult result = createDebugCallback(instance, &debugCallbackCreateInfo, nullptr, &context->debugCallback);
 
     if(result != VK_SUCCESS)
     {
         utilErrorExit("VULKAN", getVkResultName(result), "failed to create debug callback");
     }
-
-    return debugCallbackHandle;
 }
 
-// static void destroyDebugCallback(GFXContext * context)
-// {
-//     PRISM_ASSERT(context != nullptr);
-//     PRISM_ASSERT(context->instance != VK_NULL_HANDLE);
-//     PRISM_ASSERT(context->debugCallback != VK_NULL_HANDLE);
-//     VkInstance instance = context->instance;
+static void
+destroyDebugCallback(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(context->instance != VK_NULL_HANDLE);
+    PRISM_ASSERT(context->debugCallback != VK_NULL_HANDLE);
+    VkInstance instance = context->instance;
 
-//     // Destroy debug callback.
-//     auto destroyDebugCallback =
-//         (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugReportCallbackEXT");
+    // Destroy debug callback.
+    auto destroyDebugCallback =
+        (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugReportCallbackEXT");
 
-//     if(destroyDebugCallback == nullptr)
-//     {
-//         utilErrorExit(
-//             "VULKAN",
-//             getVkResultName(VK_ERROR_EXTENSION_NOT_PRESENT),
-//             "extension for destroying debug callback is not available\n");
-//     }
+    if(destroyDebugCallback == nullptr)
+    {
+        utilErrorExit(
+            "VULKAN",
+            getVkResultName(VK_ERROR_EXTENSION_NOT_PRESENT),
+            "extension for destroying debug callback is not available\n");
+    }
 
-//     destroyDebugCallback(instance, context->debugCallback, nullptr);
-// }
+    destroyDebugCallback(instance, context->debugCallback, nullptr);
+
+    // No more messages can arrive, so the totals are final.
+    logDebugMessageSummary(context->debugMessageLog, true);
+    delete context->debugMessageLog;
+    context->debugMessageLog = nullptr;
+}
 
 static void
 logPhysicalDeviceSurfaceCapabilities(const VkSurfaceCapabilitiesKHR * surfaceCapabilities)
@@ -205,7 +365,8 @@ logPhysicalDeviceSurfaceCapabilities(const VkSurfaceCapabilitiesKHR * surfaceCap
 }
 
 static void
-logAvailablePhysicalDevices(const Buffer<VkPhysicalDevice> * availablePhysicalDevices)
+logAvailablePhysicalDevices(const Buffer<VkPhysicalDevice> * availablePhysicalDevices,
+                            const Buffer<PhysicalDeviceScore> * physicalDeviceScores)
 {
     static const char * PHYSICAL_DEVICE_TYPE_NAMES[]
     {
@@ -231,12 +392,40 @@ logAvailablePhysicalDevices(const Buffer<VkPhysicalDevice> * availablePhysicalDe
         utilLog("VULKAN", "    deviceType:    %s\n",
             PHYSICAL_DEVICE_TYPE_NAMES[(size_t)availablePhysicalDeviceProperties.deviceType]);
 
-        // utilLog("VULKAN", "    pipelineCacheUUID: %?\n", availablePhysicalDeviceProperties.pipelineCacheUUID);
+        char pipelineCacheUUID[VK_UUID_SIZE * 2 + 1] = {};
+
+        for(size_t uuidIndex = 0; uuidIndex < VK_UUID_SIZE; uuidIndex++)
+        {
+            sprintf(pipelineCacheUUID + uuidIndex * 2, "%02x",
+                availablePhysicalDeviceProperties.pipelineCacheUUID[uuidIndex]);
+        }
+
+        utilLog("VULKAN", "    pipelineCacheUUID: %s\n", pipelineCacheUUID);
+
         // utilLog("VULKAN", "    limits:            %?\n", availablePhysicalDeviceProperties.limits);
         // utilLog("VULKAN", "    sparseProperties:  %?\n", availablePhysicalDeviceProperties.sparseProperties);
+
+        const PhysicalDeviceScore * physicalDeviceScore = physicalDeviceScores->data + i;
+        utilLog("VULKAN", "    score:         %u%s\n", physicalDeviceScore->total,
+                physicalDeviceScore->eligible ? "" : " (ineligible)");
+
+        utilLog("VULKAN", "        type:       %u\n", physicalDeviceScore->typeScore);
+        utilLog("VULKAN", "        memory:     %u\n", physicalDeviceScore->memoryScore);
+        utilLog("VULKAN", "        limits:     %u\n", physicalDeviceScore->limitsScore);
+        utilLog("VULKAN", "        queues:     %u\n", physicalDeviceScore->queueScore);
+        utilLog("VULKAN", "        extensions: %u\n", physicalDeviceScore->extensionScore);
     }
 }
 
+static void
+logSelectedPhysicalDevice(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    logDivider();
+    utilLog("VULKAN", "selected physical-device: \"%s\"\n", physicalDeviceProperties.deviceName);
+}
+
 static void
 logQueueFamilies(const Buffer<VkQueueFamilyProperties> * queueFamilyPropsArray)
 {
@@ -280,17 +469,9 @@ logQueueFamilies(const Buffer<VkQueueFamilyProperties> * queueFamilyPropsArray)
     }
 }
 
-static void
-logSelectedSwapchainConfig(const SwapchainConfig * swapchainConfig, const SwapchainInfo * swapchainInfo)
+static const char *
+getSurfaceFormatName(VkFormat format)
 {
-    static const char * SURFACE_PRESENT_MODE_NAMES[]
-    {
-        "VK_PRESENT_MODE_IMMEDIATE_KHR",
-        "VK_PRESENT_MODE_MAILBOX_KHR",
-        "VK_PRESENT_MODE_FIFO_KHR",
-        "VK_PRESENT_MODE_FIFO_RELAXED_KHR",
-    };
-
     static const SurfaceFormatName SURFACE_FORMAT_NAMES[]
     {
         PRISM_ENUM_NAME_PAIR(VK_FORMAT_UNDEFINED),
@@ -558,33 +739,48 @@ logSelectedSwapchainConfig(const SwapchainConfig * swapchainConfig, const Swapch
 
     static const size_t SURFACE_FORMAT_NAME_COUNT = sizeof(SURFACE_FORMAT_NAMES) / sizeof(SurfaceFormatName);
 
-    static const char * SURFACE_FORMAT_COLOR_SPACE_NAMES[]
-    {
-        "VK_COLOR_SPACE_SRGB_NONLINEAR_KHR",
-    };
-
-    const VkSurfaceFormatKHR * surfaceFormat = &swapchainConfig->surfaceFormat;
-    VkFormat format = surfaceFormat->format;
-    const SurfaceFormatName * surfaceFormatName = nullptr;
-
     for(size_t i = 0; i < SURFACE_FORMAT_NAME_COUNT; i++)
     {
-        surfaceFormatName = SURFACE_FORMAT_NAMES + i;
+        const SurfaceFormatName * surfaceFormatName = SURFACE_FORMAT_NAMES + i;
 
         if(surfaceFormatName->key == format)
         {
-            break;
+            return surfaceFormatName->value;
         }
     }
 
-    if(surfaceFormatName == nullptr)
+    utilErrorExit("VULKAN", nullptr, "failed to find surface format name for VkFormat %i\n", format);
+    return nullptr;
+}
+
+static void
+logSelectedSwapchainConfig(const SwapchainConfig * swapchainConfig, const SwapchainInfo * swapchainInfo)
+{
+    static const char * SURFACE_PRESENT_MODE_NAMES[]
+    {
+        "VK_PRESENT_MODE_IMMEDIATE_KHR",
+        "VK_PRESENT_MODE_MAILBOX_KHR",
+        "VK_PRESENT_MODE_FIFO_KHR",
+        "VK_PRESENT_MODE_FIFO_RELAXED_KHR",
+    };
+
+    static const char * SURFACE_FORMAT_COLOR_SPACE_NAMES[]
     {
-        utilErrorExit("VULKAN", nullptr, "failed to find surface format name for VkFormat %i\n", format);
-    }
+        "VK_COLOR_SPACE_SRGB_NONLINEAR_KHR",
+    };
 
+    static const char * PRESENT_POLICY_NAMES[]
+    {
+        "low-latency",
+        "throughput",
+        "power-saving",
+    };
+
+    const VkSurfaceFormatKHR * surfaceFormat = &swapchainConfig->surfaceFormat;
     logDivider();
+    utilLog("VULKAN", "present policy: %s\n", PRESENT_POLICY_NAMES[(size_t)swapchainConfig->presentPolicy]);
     utilLog("VULKAN", "selected surface format:\n");
-    utilLog("VULKAN", "    format:     %s\n", surfaceFormatName->value);
+    utilLog("VULKAN", "    format:     %s\n", getSurfaceFormatName(surfaceFormat->format));
     utilLog("VULKAN", "    colorSpace: %s\n", SURFACE_FORMAT_COLOR_SPACE_NAMES[(size_t)surfaceFormat->colorSpace]);
     utilLog("VULKAN", "available surface present modes:\n");
     const Buffer<VkPresentModeKHR> * availableSurfacePresentModes = &swapchainInfo->availableSurfacePresentModes;
@@ -603,3 +799,33 @@ logSelectedSwapchainConfig(const SwapchainConfig * swapchainConfig, const Swapch
     utilLog("VULKAN", "    height: %i\n", extent->height);
     utilLog("VULKAN", "selected image count: %u\n", swapchainConfig->imageCount);
 }
+
+static void
+logPipelineCache(const char * path, size_t loadedDataSize)
+{
+    logDivider();
+
+    if(path == nullptr)
+    {
+        utilLog("VULKAN", "pipeline cache: not persisted\n");
+    }
+    else if(loadedDataSize == 0)
+    {
+        utilLog("VULKAN", "pipeline cache: cold start, will be saved to '%s'\n", path);
+    }
+    else
+    {
+        utilLog("VULKAN", "pipeline cache: warm start, loaded %zu bytes from '%s'\n", loadedDataSize, path);
+    }
+}
+
+static void
+logOffscreenConfig(const SwapchainConfig * swapchainConfig)
+{
+    const VkExtent2D * extent = &swapchainConfig->extent;
+    logDivider();
+    utilLog("VULKAN", "headless mode, rendering to offscreen images:\n");
+    utilLog("VULKAN", "    format:      %s\n", getSurfaceFormatName(swapchainConfig->surfaceFormat.format));
+    utilLog("VULKAN", "    extent:      %ux%u\n", extent->width, extent->height);
+    utilLog("VULKAN", "    image count: %u\n", swapchainConfig->imageCount);
+}
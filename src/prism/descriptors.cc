@@ -0,0 +1,475 @@
+#include <cstring>
+#include "prism/descriptors.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+#include "prism/vulkan.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define INITIAL_CACHE_CAPACITY 64
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static uint32_t
+maxU32(uint32_t a, uint32_t b)
+{
+    return a > b ? a : b;
+}
+
+static bool
+isBufferType(VkDescriptorType type)
+{
+    return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+           type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+           type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+           type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+}
+
+// FNV-1a over the bytes of value.
+static uint64_t
+hashValue(uint64_t hash, uint64_t value)
+{
+    for(uint32_t i = 0; i < sizeof(value); i++)
+    {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+// Hashes fields rather than bytes, so padding doesn't affect the hash.
+static uint64_t
+hashBindings(VkDescriptorSetLayout layout, const DESCBinding * bindings, uint32_t bindingCount)
+{
+    uint64_t hash = hashValue(FNV_OFFSET_BASIS, (uint64_t)layout);
+
+    for(uint32_t i = 0; i < bindingCount; i++)
+    {
+        const DESCBinding * binding = bindings + i;
+        hash = hashValue(hash, (uint64_t)binding->type);
+        hash = hashValue(hash, (uint64_t)binding->bufferInfo.buffer);
+        hash = hashValue(hash, binding->bufferInfo.offset);
+        hash = hashValue(hash, binding->bufferInfo.range);
+        hash = hashValue(hash, (uint64_t)binding->imageInfo.sampler);
+        hash = hashValue(hash, (uint64_t)binding->imageInfo.imageView);
+        hash = hashValue(hash, (uint64_t)binding->imageInfo.imageLayout);
+    }
+
+    return hash;
+}
+
+static bool
+bindingsEqual(const DESCBinding * a, const DESCBinding * b, uint32_t bindingCount)
+{
+    for(uint32_t i = 0; i < bindingCount; i++)
+    {
+        if(a[i].type != b[i].type ||
+           a[i].bufferInfo.buffer != b[i].bufferInfo.buffer ||
+           a[i].bufferInfo.offset != b[i].bufferInfo.offset ||
+           a[i].bufferInfo.range != b[i].bufferInfo.range ||
+           a[i].imageInfo.sampler != b[i].imageInfo.sampler ||
+           a[i].imageInfo.imageView != b[i].imageInfo.imageView ||
+           a[i].imageInfo.imageLayout != b[i].imageInfo.imageLayout)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+initChain(DESCPoolChain * chain)
+{
+    *chain = {};
+    chain->cache = bufferCreate<DESCCacheEntry>(INITIAL_CACHE_CAPACITY);
+
+    // Zeroed entries are from generation 0, so they start out empty.
+    chain->generation = 1;
+}
+
+// Returns the entry holding a set for layout and bindings, or the empty entry where it belongs.
+static DESCCacheEntry *
+findCacheEntry(DESCPoolChain * chain, uint64_t hash, VkDescriptorSetLayout layout, const DESCBinding * bindings,
+               uint32_t bindingCount)
+{
+    uint32_t mask = (uint32_t)chain->cache.count - 1;
+
+    for(uint32_t i = (uint32_t)hash & mask; ; i = (i + 1) & mask)
+    {
+        DESCCacheEntry * entry = chain->cache.data + i;
+
+        if(entry->generation != chain->generation)
+        {
+            return entry;
+        }
+
+        if(entry->hash == hash && entry->layout == layout && entry->bindingCount == bindingCount &&
+           bindingsEqual(entry->bindings, bindings, bindingCount))
+        {
+            return entry;
+        }
+    }
+}
+
+static void
+growCache(DESCPoolChain * chain)
+{
+    Buffer<DESCCacheEntry> oldCache = chain->cache;
+    chain->cache = bufferCreate<DESCCacheEntry>(oldCache.count * 2);
+
+    for(size_t i = 0; i < oldCache.count; i++)
+    {
+        const DESCCacheEntry * oldEntry = oldCache.data + i;
+
+        if(oldEntry->generation == chain->generation)
+        {
+            *findCacheEntry(chain, oldEntry->hash, oldEntry->layout, oldEntry->bindings, oldEntry->bindingCount) =
+                *oldEntry;
+        }
+    }
+
+    bufferFree(&oldCache);
+}
+
+// Appends a pool at least twice as large as the chain's last one, with descriptors of each type in the proportion
+// they've been allocated in so far, including the request that didn't fit.
+static void
+createPool(DESCAllocator * allocator, DESCPoolChain * chain, const uint32_t * requestCounts)
+{
+    if(chain->poolCount == DESC_MAX_POOLS)
+    {
+        utilErrorExit("DESCRIPTORS", nullptr, "descriptor pool chain is longer than %u pools\n", DESC_MAX_POOLS);
+    }
+
+    uint32_t setCount = maxU32(DESC_MIN_POOL_SETS, chain->peakSetCount);
+
+    if(chain->poolCount > 0)
+    {
+        setCount = maxU32(setCount, chain->poolSetCounts[chain->poolCount - 1] * 2);
+    }
+
+    uint32_t observedSetCount = maxU32(chain->peakSetCount, chain->setCount + 1);
+    VkDescriptorPoolSize poolSizes[DESC_TYPE_COUNT] = {};
+    uint32_t poolSizeCount = 0;
+
+    for(uint32_t type = 0; type < DESC_TYPE_COUNT; type++)
+    {
+        uint32_t observedCount = maxU32(chain->peakDescriptorCounts[type],
+                                        chain->descriptorCounts[type] + requestCounts[type]);
+
+        if(observedCount == 0)
+        {
+            continue;
+        }
+
+        VkDescriptorPoolSize * poolSize = poolSizes + poolSizeCount++;
+        poolSize->type = (VkDescriptorType)type;
+
+        poolSize->descriptorCount =
+            (uint32_t)(((uint64_t)observedCount * setCount + observedSetCount - 1) / observedSetCount);
+    }
+
+    // typedef struct VkDescriptorPoolCreateInfo {
+    //     VkStructureType                sType;
+    //     const void*                    pNext;
+    //     VkDescriptorPoolCreateFlags    flags;
+    //     uint32_t                       maxSets;
+    //     uint32_t                       poolSizeCount;
+    //     const VkDescriptorPoolSize*    pPoolSizes;
+    // } VkDescriptorPoolCreateInfo;
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.pNext = nullptr;
+    descriptorPoolCreateInfo.flags = 0;
+    descriptorPoolCreateInfo.maxSets = setCount;
+    descriptorPoolCreateInfo.poolSizeCount = poolSizeCount;
+    descriptorPoolCreateInfo.pPoolSizes = poolSizes;
+
+    VkResult result = vkCreateDescriptorPool(allocator->logicalDevice, &descriptorPoolCreateInfo, nullptr,
+                                             chain->pools + chain->poolCount);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create descriptor pool\n");
+    }
+
+    chain->poolSetCounts[chain->poolCount++] = setCount;
+    allocator->stats.poolCount++;
+}
+
+static VkDescriptorSet
+allocateSet(DESCAllocator * allocator, DESCPoolChain * chain, VkDescriptorSetLayout layout,
+            const DESCBinding * bindings, uint32_t bindingCount)
+{
+    uint32_t requestCounts[DESC_TYPE_COUNT] = {};
+
+    for(uint32_t i = 0; i < bindingCount; i++)
+    {
+        PRISM_ASSERT((uint32_t)bindings[i].type < DESC_TYPE_COUNT);
+        requestCounts[bindings[i].type]++;
+    }
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    // Move on to the next pool, or add one, whenever a pool is full.
+    for(;;)
+    {
+        if(chain->currentPool == chain->poolCount)
+        {
+            createPool(allocator, chain, requestCounts);
+        }
+
+        // typedef struct VkDescriptorSetAllocateInfo {
+        //     VkStructureType                 sType;
+        //     const void*                     pNext;
+        //     VkDescriptorPool                descriptorPool;
+        //     uint32_t                        descriptorSetCount;
+        //     const VkDescriptorSetLayout*    pSetLayouts;
+        // } VkDescriptorSetAllocateInfo;
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.pNext = nullptr;
+        descriptorSetAllocateInfo.descriptorPool = chain->pools[chain->currentPool];
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &layout;
+        VkResult result = vkAllocateDescriptorSets(allocator->logicalDevice, &descriptorSetAllocateInfo, &set);
+
+        if(result == VK_SUCCESS)
+        {
+            break;
+        }
+
+        if(result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to allocate descriptor set\n");
+        }
+
+        chain->currentPool++;
+    }
+
+    chain->setCount++;
+
+    for(uint32_t type = 0; type < DESC_TYPE_COUNT; type++)
+    {
+        chain->descriptorCounts[type] += requestCounts[type];
+    }
+
+    allocator->stats.setAllocationCount++;
+
+    return set;
+}
+
+static void
+writeSet(DESCAllocator * allocator, VkDescriptorSet set, const DESCBinding * bindings, uint32_t bindingCount)
+{
+    VkWriteDescriptorSet descriptorWrites[DESC_MAX_BINDINGS] = {};
+
+    for(uint32_t i = 0; i < bindingCount; i++)
+    {
+        const DESCBinding * binding = bindings + i;
+        PRISM_ASSERT(binding->type != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER);
+        PRISM_ASSERT(binding->type != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER);
+        bool bufferType = isBufferType(binding->type);
+
+        // typedef struct VkWriteDescriptorSet {
+        //     VkStructureType                  sType;
+        //     const void*                      pNext;
+        //     VkDescriptorSet                  dstSet;
+        //     uint32_t                         dstBinding;
+        //     uint32_t                         dstArrayElement;
+        //     uint32_t                         descriptorCount;
+        //     VkDescriptorType                 descriptorType;
+        //     const VkDescriptorImageInfo*     pImageInfo;
+        //     const VkDescriptorBufferInfo*    pBufferInfo;
+        //     const VkBufferView*              pTexelBufferView;
+        // } VkWriteDescriptorSet;
+        VkWriteDescriptorSet * descriptorWrite = descriptorWrites + i;
+        descriptorWrite->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite->pNext = nullptr;
+        descriptorWrite->dstSet = set;
+        descriptorWrite->dstBinding = i;
+        descriptorWrite->dstArrayElement = 0;
+        descriptorWrite->descriptorCount = 1;
+        descriptorWrite->descriptorType = binding->type;
+        descriptorWrite->pImageInfo = bufferType ? nullptr : &binding->imageInfo;
+        descriptorWrite->pBufferInfo = bufferType ? &binding->bufferInfo : nullptr;
+        descriptorWrite->pTexelBufferView = nullptr;
+    }
+
+    vkUpdateDescriptorSets(allocator->logicalDevice, bindingCount, descriptorWrites, 0, nullptr);
+}
+
+static VkDescriptorSet
+getSet(DESCAllocator * allocator, DESCPoolChain * chain, VkDescriptorSetLayout layout, const DESCBinding * bindings,
+       uint32_t bindingCount)
+{
+    PRISM_ASSERT(bindingCount <= DESC_MAX_BINDINGS);
+    PRISM_ASSERT(bindings != nullptr || bindingCount == 0);
+
+    // Keep the cache at most half full so probes stay short.
+    if((chain->cacheCount + 1) * 2 > chain->cache.count)
+    {
+        growCache(chain);
+    }
+
+    uint64_t hash = hashBindings(layout, bindings, bindingCount);
+    DESCCacheEntry * entry = findCacheEntry(chain, hash, layout, bindings, bindingCount);
+
+    if(entry->generation == chain->generation)
+    {
+        allocator->stats.cacheHitCount++;
+        return entry->set;
+    }
+
+    VkDescriptorSet set = allocateSet(allocator, chain, layout, bindings, bindingCount);
+    writeSet(allocator, set, bindings, bindingCount);
+    entry->generation = chain->generation;
+    entry->hash = hash;
+    entry->layout = layout;
+    entry->bindingCount = bindingCount;
+    memcpy(entry->bindings, bindings, sizeof(DESCBinding) * bindingCount);
+    entry->set = set;
+    chain->cacheCount++;
+
+    return set;
+}
+
+// Frees every set of the chain. A chain that needed several pools is replaced by a single pool sized for its peak
+// usage on its next allocation, so a steady workload settles on one pool reset per frame.
+static void
+resetChain(DESCAllocator * allocator, DESCPoolChain * chain)
+{
+    chain->peakSetCount = maxU32(chain->peakSetCount, chain->setCount);
+
+    for(uint32_t type = 0; type < DESC_TYPE_COUNT; type++)
+    {
+        chain->peakDescriptorCounts[type] = maxU32(chain->peakDescriptorCounts[type], chain->descriptorCounts[type]);
+        chain->descriptorCounts[type] = 0;
+    }
+
+    if(chain->poolCount > 1)
+    {
+        for(uint32_t i = 0; i < chain->poolCount; i++)
+        {
+            vkDestroyDescriptorPool(allocator->logicalDevice, chain->pools[i], nullptr);
+        }
+
+        allocator->stats.poolCount -= chain->poolCount;
+        chain->poolCount = 0;
+    }
+    else if(chain->poolCount == 1)
+    {
+        vkResetDescriptorPool(allocator->logicalDevice, chain->pools[0], 0);
+    }
+
+    chain->currentPool = 0;
+    chain->setCount = 0;
+    chain->cacheCount = 0;
+
+    // Clear the cache outright when the generation wraps, as entries from generation 0 would look current again.
+    if(++chain->generation == 0)
+    {
+        memset(chain->cache.data, 0, sizeof(DESCCacheEntry) * chain->cache.count);
+        chain->generation = 1;
+    }
+}
+
+static void
+destroyChain(DESCAllocator * allocator, DESCPoolChain * chain)
+{
+    for(uint32_t i = 0; i < chain->poolCount; i++)
+    {
+        vkDestroyDescriptorPool(allocator->logicalDevice, chain->pools[i], nullptr);
+    }
+
+    allocator->stats.poolCount -= chain->poolCount;
+    bufferFree(&chain->cache);
+    *chain = {};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+descInit(DESCAllocator * allocator, VkDevice logicalDevice, uint32_t frameCount)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(frameCount > 0);
+    allocator->logicalDevice = logicalDevice;
+    allocator->frameIndex = 0;
+    allocator->stats = {};
+    allocator->transientChains = bufferCreate<DESCPoolChain>(frameCount);
+
+    for(size_t i = 0; i < allocator->transientChains.count; i++)
+    {
+        initChain(allocator->transientChains.data + i);
+    }
+}
+
+VkDescriptorSet
+descGetTransientSet(DESCAllocator * allocator, VkDescriptorSetLayout layout, const DESCBinding * bindings,
+                    uint32_t bindingCount)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    DESCPoolChain * chain = allocator->transientChains.data + allocator->frameIndex;
+    return getSet(allocator, chain, layout, bindings, bindingCount);
+}
+
+void
+descBeginFrame(DESCAllocator * allocator, uint32_t frameIndex)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(frameIndex < allocator->transientChains.count);
+    allocator->frameIndex = frameIndex;
+    resetChain(allocator, allocator->transientChains.data + frameIndex);
+}
+
+const DESCStats *
+descGetStats(const DESCAllocator * allocator)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    return &allocator->stats;
+}
+
+void
+descLogStats(const DESCAllocator * allocator)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    const DESCStats * stats = &allocator->stats;
+    utilLog("DESCRIPTORS", "descriptor allocator stats:\n");
+    utilLog("DESCRIPTORS", "    pools:           %u\n", stats->poolCount);
+    utilLog("DESCRIPTORS", "    set allocations: %u\n", stats->setAllocationCount);
+    utilLog("DESCRIPTORS", "    cache hits:      %u\n", stats->cacheHitCount);
+}
+
+void
+descDestroy(DESCAllocator * allocator)
+{
+    PRISM_ASSERT(allocator != nullptr);
+
+    for(size_t i = 0; i < allocator->transientChains.count; i++)
+    {
+        destroyChain(allocator, allocator->transientChains.data + i);
+    }
+
+    bufferFree(&allocator->transientChains);
+}
+
+} // namespace prism
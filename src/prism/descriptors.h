@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.h"
+#include "ctk/memory.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maximum number of bindings of descriptor sets from the allocator.
+#define DESC_MAX_BINDINGS 8
+
+// Maximum number of pools per chain; each new pool is at least twice as large as the last, so this is never reached in
+// practice.
+#define DESC_MAX_POOLS 32
+
+// Descriptor types tracked for pool sizing; VK_DESCRIPTOR_TYPE_SAMPLER through VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT.
+#define DESC_TYPE_COUNT (VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1)
+
+// Minimum number of sets of a pool.
+#define DESC_MIN_POOL_SETS 64
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Descriptor written to one binding; the binding number is its index in the array of bindings passed to the allocator.
+// Buffer types use bufferInfo and image and sampler types use imageInfo; fields that aren't used must be zero.
+struct DESCBinding
+{
+    VkDescriptorType type;
+    VkDescriptorBufferInfo bufferInfo;
+    VkDescriptorImageInfo imageInfo;
+};
+
+struct DESCCacheEntry
+{
+    // Entries from an earlier generation of their chain are empty.
+    uint32_t generation;
+    uint64_t hash;
+    VkDescriptorSetLayout layout;
+    uint32_t bindingCount;
+    DESCBinding bindings[DESC_MAX_BINDINGS];
+    VkDescriptorSet set;
+};
+
+// Pools sets are allocated from in order; when the last one is full a larger one sized by observed usage is added.
+struct DESCPoolChain
+{
+    VkDescriptorPool pools[DESC_MAX_POOLS];
+    uint32_t poolSetCounts[DESC_MAX_POOLS];
+    uint32_t poolCount;
+    uint32_t currentPool;
+
+    // Sets and descriptors of each type allocated since the chain was last reset, and the most allocated between any
+    // two resets.
+    uint32_t setCount;
+    uint32_t descriptorCounts[DESC_TYPE_COUNT];
+    uint32_t peakSetCount;
+    uint32_t peakDescriptorCounts[DESC_TYPE_COUNT];
+
+    // Open-addressed hash table of the chain's sets by layout and bindings; its capacity is a power of two. Bumping
+    // the generation empties it.
+    ctk::Buffer<DESCCacheEntry> cache;
+    uint32_t cacheCount;
+    uint32_t generation;
+};
+
+struct DESCStats
+{
+    uint32_t poolCount;
+    uint32_t setAllocationCount;
+
+    // Requests served from the cache instead of allocating and writing a set.
+    uint32_t cacheHitCount;
+};
+
+struct DESCAllocator
+{
+    VkDevice logicalDevice;
+    uint32_t frameIndex;
+
+    // One chain per frame in flight, reset when the frame's resources are reused.
+    ctk::Buffer<DESCPoolChain> transientChains;
+
+    DESCStats stats;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+descInit(DESCAllocator * allocator, VkDevice logicalDevice, uint32_t frameCount);
+
+// Returns a set of layout with bindings written to it, for use by the current frame only; identical requests within
+// the frame return the same set. Sets are freed by descBeginFrame() when the frame's resources are reused.
+VkDescriptorSet
+descGetTransientSet(DESCAllocator * allocator, VkDescriptorSetLayout layout, const DESCBinding * bindings,
+                    uint32_t bindingCount);
+
+// Frees all transient sets from when frameIndex was last the current frame, and makes it the current frame. Call once
+// the GPU has finished with the frame's resources.
+void
+descBeginFrame(DESCAllocator * allocator, uint32_t frameIndex);
+
+const DESCStats *
+descGetStats(const DESCAllocator * allocator);
+
+void
+descLogStats(const DESCAllocator * allocator);
+
+void
+descDestroy(DESCAllocator * allocator);
+
+} // namespace prism
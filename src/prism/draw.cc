@@ -0,0 +1,292 @@
+#include <cstring>
+#include "prism/draw.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the current frame's draws, starting them if this is the first submission since the frame began.
+static DRAWFrame *
+getCurrentFrame(DRAWBatcher * batcher)
+{
+    const GFXContext * context = batcher->context;
+    DRAWFrame * frame = batcher->frames.data + context->frameIndex;
+
+    if(frame->frameCount != context->frameCount)
+    {
+        frame->instanceCount = 0;
+        frame->commandCount = 0;
+        frame->frameCount = context->frameCount;
+    }
+
+    return frame;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+drawInit(DRAWBatcher * batcher, GFXContext * context, const DRAWConfig * config)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(config != nullptr);
+    PRISM_ASSERT(config->maxVertexCount > 0 && config->maxIndexCount > 0);
+    PRISM_ASSERT(config->maxInstanceCount > 0 && config->maxCommandCount > 0 && config->maxCommandCount <= 65535);
+    batcher->context = context;
+    batcher->config = *config;
+    batcher->vertexCount = 0;
+    batcher->indexCount = 0;
+    batcher->meshCount = 0;
+
+    gfxCreateBuffer(context, config->maxVertexCount * sizeof(GFXVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &batcher->vertexBuffer);
+
+    gfxCreateBuffer(context, config->maxIndexCount * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &batcher->indexBuffer);
+
+    // Instances and commands are written by the CPU every frame, so they live in host-visible memory the GPU reads
+    // directly; each frame in flight has its own buffers, so a frame's writes never race the GPU reading another's.
+    static const VkMemoryPropertyFlags HOST_MEMORY_FLAGS =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    batcher->frames = bufferCreate<DRAWFrame>(context->frames.count);
+
+    for(uint32_t i = 0; i < batcher->frames.count; i++)
+    {
+        DRAWFrame * frame = batcher->frames.data + i;
+
+        gfxCreateBuffer(context, config->maxInstanceCount * sizeof(GFXInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                        HOST_MEMORY_FLAGS, false, &frame->instanceBuffer);
+
+        gfxCreateBuffer(context, config->maxCommandCount * sizeof(VkDrawIndexedIndirectCommand),
+                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, HOST_MEMORY_FLAGS, false, &frame->indirectBuffer);
+
+        PRISM_ASSERT(frame->instanceBuffer.memory.mapped != nullptr);
+        PRISM_ASSERT(frame->indirectBuffer.memory.mapped != nullptr);
+        frame->commands = bufferCreate<VkDrawIndexedIndirectCommand>(config->maxCommandCount);
+        frame->instanceCount = 0;
+        frame->commandCount = 0;
+        frame->frameCount = UINT64_MAX;
+    }
+
+    if(!context->enabledFeatures.multiDrawIndirect || !context->enabledFeatures.drawIndirectFirstInstance)
+    {
+        utilLog("DRAW", "multi-draw indirect is not supported; draws are recorded one command at a time\n");
+    }
+}
+
+bool
+drawCreateMesh(DRAWBatcher * batcher, const GFXVertex * vertices, uint32_t vertexCount, const uint32_t * indices,
+               uint32_t indexCount, uint32_t * mesh)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    PRISM_ASSERT(vertices != nullptr && vertexCount > 0);
+    PRISM_ASSERT(indices != nullptr && indexCount > 0);
+    PRISM_ASSERT(mesh != nullptr);
+    PRISM_ASSERT(batcher->context->frameCount == 0);
+    const DRAWConfig * config = &batcher->config;
+
+    if(batcher->meshCount == DRAW_MAX_MESHES ||
+       batcher->vertexCount + vertexCount > config->maxVertexCount ||
+       batcher->indexCount + indexCount > config->maxIndexCount)
+    {
+        return false;
+    }
+
+    // Indices are relative to the mesh's first vertex; vertexOffset rebases them when drawn.
+    if(!gfxUploadBuffer(batcher->context, &batcher->vertexBuffer, batcher->vertexCount * sizeof(GFXVertex), vertices,
+                        vertexCount * sizeof(GFXVertex)) ||
+       !gfxUploadBuffer(batcher->context, &batcher->indexBuffer, batcher->indexCount * sizeof(uint32_t), indices,
+                        indexCount * sizeof(uint32_t)))
+    {
+        return false;
+    }
+
+    *mesh = batcher->meshCount++;
+    DRAWMesh * newMesh = batcher->meshes + *mesh;
+    newMesh->firstIndex = batcher->indexCount;
+    newMesh->indexCount = indexCount;
+    newMesh->vertexOffset = (int32_t)batcher->vertexCount;
+    batcher->vertexCount += vertexCount;
+    batcher->indexCount += indexCount;
+
+    return true;
+}
+
+bool
+drawSubmit(DRAWBatcher * batcher, uint32_t mesh, const GFXInstance * instances, uint32_t instanceCount)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    PRISM_ASSERT(mesh < batcher->meshCount);
+    PRISM_ASSERT(instances != nullptr || instanceCount == 0);
+    DRAWFrame * frame = getCurrentFrame(batcher);
+    const DRAWMesh * drawnMesh = batcher->meshes + mesh;
+
+    if(instanceCount == 0)
+    {
+        return true;
+    }
+
+    if(frame->instanceCount + instanceCount > batcher->config.maxInstanceCount)
+    {
+        return false;
+    }
+
+    // Instances directly following the last command's instances of the same mesh extend it.
+    VkDrawIndexedIndirectCommand * command = nullptr;
+
+    if(frame->commandCount > 0)
+    {
+        command = frame->commands.data + frame->commandCount - 1;
+
+        if(command->firstIndex != drawnMesh->firstIndex || command->vertexOffset != drawnMesh->vertexOffset)
+        {
+            command = nullptr;
+        }
+    }
+
+    if(command == nullptr)
+    {
+        if(frame->commandCount == batcher->config.maxCommandCount)
+        {
+            return false;
+        }
+
+        // typedef struct VkDrawIndexedIndirectCommand {
+        //     uint32_t    indexCount;
+        //     uint32_t    instanceCount;
+        //     uint32_t    firstIndex;
+        //     int32_t     vertexOffset;
+        //     uint32_t    firstInstance;
+        // } VkDrawIndexedIndirectCommand;
+        command = frame->commands.data + frame->commandCount++;
+        command->indexCount = drawnMesh->indexCount;
+        command->instanceCount = 0;
+        command->firstIndex = drawnMesh->firstIndex;
+        command->vertexOffset = drawnMesh->vertexOffset;
+        command->firstInstance = frame->instanceCount;
+    }
+
+    // Instances are written straight into the frame's mapped instance buffer.
+    auto mappedInstances = (GFXInstance *)frame->instanceBuffer.memory.mapped;
+    memcpy(mappedInstances + frame->instanceCount, instances, instanceCount * sizeof(GFXInstance));
+    frame->instanceCount += instanceCount;
+    command->instanceCount += instanceCount;
+
+    return true;
+}
+
+void
+drawFlush(DRAWBatcher * batcher)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    DRAWFrame * frame = getCurrentFrame(batcher);
+
+    memcpy(frame->indirectBuffer.memory.mapped, frame->commands.data,
+           frame->commandCount * sizeof(VkDrawIndexedIndirectCommand));
+}
+
+uint32_t
+drawGetCommandCount(const DRAWBatcher * batcher)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    const GFXContext * context = batcher->context;
+    const DRAWFrame * frame = batcher->frames.data + context->frameIndex;
+
+    // Nothing was submitted this frame.
+    if(frame->frameCount != context->frameCount)
+    {
+        return 0;
+    }
+
+    return frame->commandCount;
+}
+
+void
+drawRecord(const DRAWBatcher * batcher, VkCommandBuffer commandBuffer)
+{
+    drawRecordRange(batcher, commandBuffer, 0, drawGetCommandCount(batcher));
+}
+
+void
+drawRecordRange(const DRAWBatcher * batcher, VkCommandBuffer commandBuffer, uint32_t beginCommand,
+                uint32_t endCommand)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    PRISM_ASSERT(beginCommand <= endCommand);
+    PRISM_ASSERT(endCommand <= drawGetCommandCount(batcher));
+    const GFXContext * context = batcher->context;
+    const DRAWFrame * frame = batcher->frames.data + context->frameIndex;
+
+    if(beginCommand == endCommand)
+    {
+        return;
+    }
+
+    const VkBuffer vertexBuffers[] = { batcher->vertexBuffer.buffer, frame->instanceBuffer.buffer };
+    const VkDeviceSize vertexBufferOffsets[] = { 0, 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, vertexBufferOffsets);
+    vkCmdBindIndexBuffer(commandBuffer, batcher->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+    // Indirect commands with a non-zero firstInstance need drawIndirectFirstInstance; without it, each command is
+    // recorded as a direct draw.
+    if(!context->enabledFeatures.drawIndirectFirstInstance)
+    {
+        for(uint32_t i = beginCommand; i < endCommand; i++)
+        {
+            const VkDrawIndexedIndirectCommand * command = frame->commands.data + i;
+
+            vkCmdDrawIndexed(commandBuffer, command->indexCount, command->instanceCount, command->firstIndex,
+                             command->vertexOffset, command->firstInstance);
+        }
+    }
+    else if(!context->enabledFeatures.multiDrawIndirect)
+    {
+        for(uint32_t i = beginCommand; i < endCommand; i++)
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, frame->indirectBuffer.buffer,
+                                     i * sizeof(VkDrawIndexedIndirectCommand), 1,
+                                     sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+    else
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, frame->indirectBuffer.buffer,
+                                 beginCommand * sizeof(VkDrawIndexedIndirectCommand), endCommand - beginCommand,
+                                 sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+void
+drawDestroy(DRAWBatcher * batcher)
+{
+    PRISM_ASSERT(batcher != nullptr);
+    GFXContext * context = batcher->context;
+
+    // Cleanup
+    for(uint32_t i = 0; i < batcher->frames.count; i++)
+    {
+        DRAWFrame * frame = batcher->frames.data + i;
+        gfxDestroyBuffer(context, &frame->instanceBuffer);
+        gfxDestroyBuffer(context, &frame->indirectBuffer);
+        bufferFree(&frame->commands);
+    }
+
+    bufferFree(&batcher->frames);
+    gfxDestroyBuffer(context, &batcher->indexBuffer);
+    gfxDestroyBuffer(context, &batcher->vertexBuffer);
+}
+
+} // namespace prism
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.h"
+#include "ctk/memory.h"
+#include "prism/graphics.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define DRAW_MAX_MESHES 256
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Range of the batcher's shared vertex and index buffers a mesh occupies.
+struct DRAWMesh
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+};
+
+struct DRAWConfig
+{
+    // Capacity of the vertex and index buffers all meshes share.
+    uint32_t maxVertexCount;
+    uint32_t maxIndexCount;
+
+    // Maximum number of instances, and of indirect draw commands, per frame; at most 65535 commands, the most every
+    // device with multiDrawIndirect can draw at once.
+    uint32_t maxInstanceCount;
+    uint32_t maxCommandCount;
+};
+
+// Instances and indirect draw commands of one frame in flight, written through persistently mapped host-visible
+// buffers. commands holds a copy of the indirect commands for devices that can't draw from the indirect buffer.
+struct DRAWFrame
+{
+    GFXBuffer instanceBuffer;
+    GFXBuffer indirectBuffer;
+    ctk::Buffer<VkDrawIndexedIndirectCommand> commands;
+    uint32_t instanceCount;
+    uint32_t commandCount;
+
+    // Value of GFXContext::frameCount the frame's instances and commands were submitted in.
+    uint64_t frameCount;
+};
+
+// Batches instanced draws of meshes in GPU-resident vertex and index buffers into indirect draw commands; consecutive
+// submissions of the same mesh share one command, and all of a frame's commands are drawn with one indirect draw.
+struct DRAWBatcher
+{
+    GFXContext * context;
+    DRAWConfig config;
+    GFXBuffer vertexBuffer;
+    GFXBuffer indexBuffer;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    DRAWMesh meshes[DRAW_MAX_MESHES];
+    uint32_t meshCount;
+    ctk::Buffer<DRAWFrame> frames;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+drawInit(DRAWBatcher * batcher, GFXContext * context, const DRAWConfig * config);
+
+// Uploads a mesh of indexCount indices into vertexCount vertices to the batcher's vertex and index buffers through
+// gfxUploadBuffer(). Must be called before the first gfxEndFrame(): the buffers are shared by every frame's draws and
+// owned by the graphics queue-family once the first frame is submitted, so they are only written while no frame uses
+// them. Returns false if the buffers or the staging ring are full, in which case nothing is added.
+bool
+drawCreateMesh(DRAWBatcher * batcher, const GFXVertex * vertices, uint32_t vertexCount, const uint32_t * indices,
+               uint32_t indexCount, uint32_t * mesh);
+
+// Adds instanceCount instances of mesh to the current frame's draws. Must be called between gfxBeginFrame() and
+// drawFlush(); submit instances grouped by mesh, as each change of mesh starts a new indirect command. Returns false if
+// the frame's instances or commands are full, in which case nothing is added.
+bool
+drawSubmit(DRAWBatcher * batcher, uint32_t mesh, const GFXInstance * instances, uint32_t instanceCount);
+
+// Writes the current frame's indirect commands; call once after the frame's last drawSubmit() and before drawRecord().
+void
+drawFlush(DRAWBatcher * batcher);
+
+// Returns the number of indirect commands submitted this frame, so recording can be split across threads with
+// drawRecordRange().
+uint32_t
+drawGetCommandCount(const DRAWBatcher * batcher);
+
+// Binds the batcher's buffers and records the current frame's draws into commandBuffer, inside the frame's render pass
+// with a graphics pipeline bound. Safe to call from several recording threads at once.
+void
+drawRecord(const DRAWBatcher * batcher, VkCommandBuffer commandBuffer);
+
+// Like drawRecord(), but only records the frame's indirect commands [beginCommand, endCommand), so each recording
+// thread can record its own slice of the frame's draws.
+void
+drawRecordRange(const DRAWBatcher * batcher, VkCommandBuffer commandBuffer, uint32_t beginCommand,
+                uint32_t endCommand);
+
+// Destroys the batcher's buffers immediately; they must not be in use by frames still in flight.
+void
+drawDestroy(DRAWBatcher * batcher);
+
+} // namespace prism
@@ -0,0 +1,1540 @@
+#include <cstring>
+#include "prism/framegraph.h"
+#include "prism/graphics.h"
+#include "prism/memory.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+#include "prism/vulkan.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every access of every pass can need a barrier, plus the final transition of every resource.
+#define MAX_BARRIERS (FG_MAX_PASSES * FG_MAX_PASS_ACCESSES + FG_MAX_RESOURCES)
+
+// Objects replaced by recompilations and resizes but possibly still in use by frames in flight.
+#define MAX_RETIRED_OBJECTS 1024
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct AccessInfo
+{
+    VkPipelineStageFlags stageMask;
+    VkAccessFlags accessMask;
+
+    // Layout images must be in for the access; unused for buffers.
+    VkImageLayout layout;
+
+    // Whether the access depends on the resource's previous contents, and whether it changes them.
+    bool reads;
+    bool writes;
+
+    // Usage transient images need for the access.
+    VkImageUsageFlags imageUsage;
+};
+
+enum class RetiredType
+{
+    FRAMEBUFFER,
+    RENDER_PASS,
+    IMAGE_VIEW,
+    IMAGE,
+    MEMORY,
+};
+
+struct RetiredObject
+{
+    RetiredType type;
+
+    // Value of GFXContext::frameCount when the object was retired.
+    uint64_t retiredFrameCount;
+
+    union
+    {
+        VkFramebuffer framebuffer;
+        VkRenderPass renderPass;
+        VkImageView imageView;
+        VkImage image;
+        MEMAllocation allocation;
+    };
+};
+
+struct Barrier
+{
+    uint32_t resource;
+    VkAccessFlags srcAccessMask;
+    VkAccessFlags dstAccessMask;
+    VkImageLayout oldLayout;
+    VkImageLayout newLayout;
+};
+
+// Barriers recorded with one vkCmdPipelineBarrier() call.
+struct BarrierBatch
+{
+    VkPipelineStageFlags srcStageMask;
+    VkPipelineStageFlags dstStageMask;
+    uint32_t barrierBegin;
+    uint32_t barrierCount;
+};
+
+// Accesses to a resource since its last write, which barriers before later accesses are built from.
+struct ResourceState
+{
+    VkImageLayout layout;
+
+    // Stages and access of the last write, which the next access must wait on. A layout transition counts as a write
+    // to the stages of the access it was made for, but the barrier making it already made it available.
+    VkPipelineStageFlags writeStageMask;
+    VkAccessFlags writeAccessMask;
+
+    // Stages and accesses the last write is already visible to.
+    VkPipelineStageFlags visibleStageMask;
+    VkAccessFlags visibleAccessMask;
+
+    // Stages of the reads since the last write, which the next write must wait on.
+    VkPipelineStageFlags readStageMask;
+};
+
+struct Resource
+{
+    const char * name;
+    bool isImage;
+    bool imported;
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageAspectFlags aspectMask;
+    VkClearValue clearValue;
+    FGAccess initialAccess;
+    FGAccess finalAccess;
+    VkImage image;
+    VkImageView imageView;
+    VkBuffer buffer;
+
+    // Live passes that first and last access the resource, the usage its accesses need, and for transient images, the
+    // memory slot the image is aliased into.
+    uint32_t firstPass;
+    uint32_t lastPass;
+    VkImageUsageFlags usage;
+    VkMemoryRequirements requirements;
+    uint32_t memorySlot;
+};
+
+struct PassAccess
+{
+    uint32_t resource;
+    FGAccess access;
+};
+
+struct Framebuffer
+{
+    VkImageView views[FG_MAX_ATTACHMENTS];
+    VkFramebuffer framebuffer;
+};
+
+struct Pass
+{
+    const char * name;
+    FGExecuteFn executeFn;
+    void * data;
+    bool sideEffects;
+    PassAccess accesses[FG_MAX_PASS_ACCESSES];
+    uint32_t accessCount;
+
+    // Compilation results.
+    bool live;
+    BarrierBatch barriers;
+    VkRenderPass renderPass;
+    uint32_t attachmentResources[FG_MAX_ATTACHMENTS];
+    VkClearValue clearValues[FG_MAX_ATTACHMENTS];
+    uint32_t attachmentCount;
+    VkExtent2D extent;
+    Framebuffer framebuffers[FG_MAX_FRAMEBUFFERS];
+    uint32_t framebufferCount;
+};
+
+// Memory shared by transient images with disjoint lifetimes.
+struct MemorySlot
+{
+    VkMemoryRequirements requirements;
+    MEMAllocation allocation;
+
+    // Accesses of the slot's last image so far while barriers are planned, which the next image's first access must
+    // wait on.
+    ResourceState lastState;
+};
+
+struct FGGraph
+{
+    GFXContext * context;
+    Resource resources[FG_MAX_RESOURCES];
+    uint32_t resourceCount;
+    Pass passes[FG_MAX_PASSES];
+    uint32_t passCount;
+
+    // Compilation results.
+    bool compiled;
+    bool hasCompiledResources;
+    MemorySlot memorySlots[FG_MAX_RESOURCES];
+    uint32_t memorySlotCount;
+    Barrier barriers[MAX_BARRIERS];
+    uint32_t barrierCount;
+    BarrierBatch finalBarriers;
+
+    // In the order they were retired.
+    RetiredObject retiredObjects[MAX_RETIRED_OBJECTS];
+    uint32_t retiredObjectCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static const VkPipelineStageFlags SHADER_STAGES =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+static const VkPipelineStageFlags FRAGMENT_TEST_STAGES =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+// Indexed by FGAccess.
+static const AccessInfo ACCESS_INFOS[]
+{
+    // COLOR_ATTACHMENT_WRITE
+    {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        true,
+        true,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+    },
+    // DEPTH_ATTACHMENT_WRITE
+    {
+        FRAGMENT_TEST_STAGES,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        true,
+        true,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+    },
+    // DEPTH_ATTACHMENT_READ
+    {
+        FRAGMENT_TEST_STAGES,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+        true,
+        false,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+    },
+    // SAMPLED_READ
+    {
+        SHADER_STAGES,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        true,
+        false,
+        VK_IMAGE_USAGE_SAMPLED_BIT,
+    },
+    // PRESENT
+    {
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        true,
+        false,
+        0,
+    },
+    // STORAGE_READ
+    {
+        SHADER_STAGES,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        true,
+        false,
+        VK_IMAGE_USAGE_STORAGE_BIT,
+    },
+    // STORAGE_WRITE
+    {
+        SHADER_STAGES,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        true,
+        true,
+        VK_IMAGE_USAGE_STORAGE_BIT,
+    },
+    // TRANSFER_READ
+    {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        true,
+        false,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+    },
+    // TRANSFER_WRITE
+    {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        true,
+        true,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+    },
+    // VERTEX_BUFFER_READ
+    {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        true,
+        false,
+        0,
+    },
+    // INDEX_BUFFER_READ
+    {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_INDEX_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        true,
+        false,
+        0,
+    },
+    // INDIRECT_BUFFER_READ
+    {
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        true,
+        false,
+        0,
+    },
+    // UNIFORM_BUFFER_READ
+    {
+        SHADER_STAGES,
+        VK_ACCESS_UNIFORM_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        true,
+        false,
+        0,
+    },
+    // UNDEFINED
+    {
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        0,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        false,
+        false,
+        0,
+    },
+};
+
+static_assert(sizeof(ACCESS_INFOS) / sizeof(AccessInfo) == (size_t)FGAccess::COUNT,
+              "ACCESS_INFOS must have an entry for every FGAccess");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static const AccessInfo *
+getAccessInfo(FGAccess access)
+{
+    return ACCESS_INFOS + (size_t)access;
+}
+
+static bool
+isAttachmentAccess(FGAccess access)
+{
+    return access == FGAccess::COLOR_ATTACHMENT_WRITE ||
+           access == FGAccess::DEPTH_ATTACHMENT_WRITE ||
+           access == FGAccess::DEPTH_ATTACHMENT_READ;
+}
+
+static uint32_t
+addResource(FGGraph * graph, const char * name, bool isImage, bool imported)
+{
+    if(graph->resourceCount == FG_MAX_RESOURCES)
+    {
+        utilErrorExit("FRAMEGRAPH", nullptr, "more than %u resources\n", FG_MAX_RESOURCES);
+    }
+
+    uint32_t resourceIndex = graph->resourceCount++;
+    Resource * resource = graph->resources + resourceIndex;
+    *resource = {};
+    resource->name = name;
+    resource->isImage = isImage;
+    resource->imported = imported;
+    resource->initialAccess = FGAccess::UNDEFINED;
+    resource->finalAccess = FGAccess::UNDEFINED;
+    graph->compiled = false;
+
+    return resourceIndex;
+}
+
+static void
+destroyRetiredObject(FGGraph * graph, RetiredObject * retiredObject)
+{
+    GFXContext * context = graph->context;
+    VkDevice logicalDevice = context->logicalDevice;
+
+    switch(retiredObject->type)
+    {
+        case RetiredType::FRAMEBUFFER:
+            vkDestroyFramebuffer(logicalDevice, retiredObject->framebuffer, nullptr);
+            break;
+
+        case RetiredType::RENDER_PASS:
+            vkDestroyRenderPass(logicalDevice, retiredObject->renderPass, nullptr);
+            break;
+
+        case RetiredType::IMAGE_VIEW:
+            vkDestroyImageView(logicalDevice, retiredObject->imageView, nullptr);
+            break;
+
+        case RetiredType::IMAGE:
+            vkDestroyImage(logicalDevice, retiredObject->image, nullptr);
+            break;
+
+        case RetiredType::MEMORY:
+            memFree(&context->allocator, &retiredObject->allocation);
+            break;
+    }
+}
+
+// Destroys retired objects no frame in flight can still be using; when force is set, the caller guarantees no frames
+// are in flight and all retired objects are destroyed.
+static void
+destroyRetiredObjects(FGGraph * graph, bool force)
+{
+    GFXContext * context = graph->context;
+    uint32_t destroyedCount = 0;
+
+    // Objects are retired in frame order, so stop at the first one that is still in use.
+    for(; destroyedCount < graph->retiredObjectCount; destroyedCount++)
+    {
+        RetiredObject * retiredObject = graph->retiredObjects + destroyedCount;
+
+        if(!force && context->frameCount < retiredObject->retiredFrameCount + context->frames.count)
+        {
+            break;
+        }
+
+        destroyRetiredObject(graph, retiredObject);
+    }
+
+    if(destroyedCount == 0)
+    {
+        return;
+    }
+
+    // Shift remaining retired objects to the front.
+    graph->retiredObjectCount -= destroyedCount;
+    memmove(graph->retiredObjects, graph->retiredObjects + destroyedCount,
+            sizeof(RetiredObject) * graph->retiredObjectCount);
+}
+
+// Returns an entry for an object of type replaced this frame; it's destroyed by destroyRetiredObjects() once the frames
+// in flight have completed.
+static RetiredObject *
+retireObject(FGGraph * graph, RetiredType type)
+{
+    // Only reached when the graph is recompiled or resized faster than frames complete. The current frame may already
+    // be recording, so its fence can't be waited on; wait for the device instead.
+    if(graph->retiredObjectCount == MAX_RETIRED_OBJECTS)
+    {
+        vkDeviceWaitIdle(graph->context->logicalDevice);
+        destroyRetiredObjects(graph, true);
+    }
+
+    RetiredObject * retiredObject = graph->retiredObjects + graph->retiredObjectCount++;
+    retiredObject->type = type;
+    retiredObject->retiredFrameCount = graph->context->frameCount;
+
+    return retiredObject;
+}
+
+static void
+retireFramebuffers(FGGraph * graph, Pass * pass)
+{
+    for(uint32_t i = 0; i < pass->framebufferCount; i++)
+    {
+        retireObject(graph, RetiredType::FRAMEBUFFER)->framebuffer = pass->framebuffers[i].framebuffer;
+    }
+
+    pass->framebufferCount = 0;
+}
+
+// Retires everything the last compilation created, so the graph can be recompiled without waiting for frames still in
+// flight to be done with it.
+static void
+retireCompiledResources(FGGraph * graph)
+{
+    for(uint32_t passIndex = 0; passIndex < graph->passCount; passIndex++)
+    {
+        Pass * pass = graph->passes + passIndex;
+        retireFramebuffers(graph, pass);
+
+        if(pass->renderPass != VK_NULL_HANDLE)
+        {
+            retireObject(graph, RetiredType::RENDER_PASS)->renderPass = pass->renderPass;
+        }
+
+        pass->renderPass = VK_NULL_HANDLE;
+    }
+
+    for(uint32_t resourceIndex = 0; resourceIndex < graph->resourceCount; resourceIndex++)
+    {
+        Resource * resource = graph->resources + resourceIndex;
+
+        if(resource->imported || resource->image == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        retireObject(graph, RetiredType::IMAGE_VIEW)->imageView = resource->imageView;
+        retireObject(graph, RetiredType::IMAGE)->image = resource->image;
+        resource->imageView = VK_NULL_HANDLE;
+        resource->image = VK_NULL_HANDLE;
+    }
+
+    for(uint32_t i = 0; i < graph->memorySlotCount; i++)
+    {
+        retireObject(graph, RetiredType::MEMORY)->allocation = graph->memorySlots[i].allocation;
+    }
+
+    graph->memorySlotCount = 0;
+    graph->hasCompiledResources = false;
+}
+
+// Walks passes backwards from the resources visible outside the graph, keeping passes that write something a later
+// live pass or the outside reads, and passes with side effects.
+static void
+cullPasses(FGGraph * graph)
+{
+    bool needed[FG_MAX_RESOURCES] = {};
+
+    for(uint32_t i = 0; i < graph->resourceCount; i++)
+    {
+        needed[i] = graph->resources[i].imported;
+    }
+
+    for(uint32_t passIndex = graph->passCount; passIndex-- > 0;)
+    {
+        Pass * pass = graph->passes + passIndex;
+        pass->live = pass->sideEffects;
+
+        for(uint32_t i = 0; i < pass->accessCount; i++)
+        {
+            const PassAccess * access = pass->accesses + i;
+
+            if(getAccessInfo(access->access)->writes && needed[access->resource])
+            {
+                pass->live = true;
+            }
+        }
+
+        if(!pass->live)
+        {
+            continue;
+        }
+
+        // Writes that don't depend on previous contents end the need for earlier writes; reads start one.
+        for(uint32_t i = 0; i < pass->accessCount; i++)
+        {
+            const PassAccess * access = pass->accesses + i;
+            const AccessInfo * accessInfo = getAccessInfo(access->access);
+
+            if(accessInfo->reads)
+            {
+                needed[access->resource] = true;
+            }
+            else if(accessInfo->writes)
+            {
+                needed[access->resource] = false;
+            }
+        }
+    }
+}
+
+static void
+findLifetimes(FGGraph * graph)
+{
+    for(uint32_t i = 0; i < graph->resourceCount; i++)
+    {
+        Resource * resource = graph->resources + i;
+        resource->firstPass = FG_INVALID_INDEX;
+        resource->lastPass = FG_INVALID_INDEX;
+        resource->usage = 0;
+    }
+
+    for(uint32_t passIndex = 0; passIndex < graph->passCount; passIndex++)
+    {
+        const Pass * pass = graph->passes + passIndex;
+
+        if(!pass->live)
+        {
+            continue;
+        }
+
+        for(uint32_t i = 0; i < pass->accessCount; i++)
+        {
+            const PassAccess * access = pass->accesses + i;
+            Resource * resource = graph->resources + access->resource;
+
+            if(resource->firstPass == FG_INVALID_INDEX)
+            {
+                resource->firstPass = passIndex;
+            }
+
+            resource->lastPass = passIndex;
+            resource->usage |= getAccessInfo(access->access)->imageUsage;
+        }
+    }
+}
+
+static bool
+lifetimesOverlap(const Resource * a, const Resource * b)
+{
+    return a->firstPass <= b->lastPass && b->firstPass <= a->lastPass;
+}
+
+// Creates the transient images live passes use and binds them to memory slots, largest image first; an image joins
+// the first slot with a compatible memory type whose images' lifetimes it doesn't overlap.
+static void
+createTransientImages(FGGraph * graph)
+{
+    GFXContext * context = graph->context;
+    VkDevice logicalDevice = context->logicalDevice;
+    uint32_t imageOrder[FG_MAX_RESOURCES] = {};
+    uint32_t imageCount = 0;
+
+    for(uint32_t resourceIndex = 0; resourceIndex < graph->resourceCount; resourceIndex++)
+    {
+        Resource * resource = graph->resources + resourceIndex;
+        resource->memorySlot = FG_INVALID_INDEX;
+
+        if(resource->imported || resource->firstPass == FG_INVALID_INDEX)
+        {
+            continue;
+        }
+
+        // typedef struct VkImageCreateInfo {
+        //     VkStructureType          sType;
+        //     const void*              pNext;
+        //     VkImageCreateFlags       flags;
+        //     VkImageType              imageType;
+        //     VkFormat                 format;
+        //     VkExtent3D               extent;
+        //     uint32_t                 mipLevels;
+        //     uint32_t                 arrayLayers;
+        //     VkSampleCountFlagBits    samples;
+        //     VkImageTiling            tiling;
+        //     VkImageUsageFlags        usage;
+        //     VkSharingMode            sharingMode;
+        //     uint32_t                 queueFamilyIndexCount;
+        //     const uint32_t*          pQueueFamilyIndices;
+        //     VkImageLayout            initialLayout;
+        // } VkImageCreateInfo;
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.pNext = nullptr;
+        imageCreateInfo.flags = 0;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = resource->format;
+        imageCreateInfo.extent = { resource->extent.width, resource->extent.height, 1 };
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = resource->usage;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.queueFamilyIndexCount = 0;
+        imageCreateInfo.pQueueFamilyIndices = nullptr;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkResult result = vkCreateImage(logicalDevice, &imageCreateInfo, nullptr, &resource->image);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create transient image \"%s\"\n",
+                          resource->name);
+        }
+
+        vkGetImageMemoryRequirements(logicalDevice, resource->image, &resource->requirements);
+
+        // Insert into imageOrder, keeping it sorted by decreasing size.
+        uint32_t position = imageCount++;
+
+        while(position > 0 &&
+              graph->resources[imageOrder[position - 1]].requirements.size < resource->requirements.size)
+        {
+            imageOrder[position] = imageOrder[position - 1];
+            position--;
+        }
+
+        imageOrder[position] = resourceIndex;
+    }
+
+    for(uint32_t i = 0; i < imageCount; i++)
+    {
+        Resource * resource = graph->resources + imageOrder[i];
+        const VkMemoryRequirements * requirements = &resource->requirements;
+        uint32_t slotIndex = 0;
+
+        for(; slotIndex < graph->memorySlotCount; slotIndex++)
+        {
+            if((graph->memorySlots[slotIndex].requirements.memoryTypeBits & requirements->memoryTypeBits) == 0)
+            {
+                continue;
+            }
+
+            bool overlaps = false;
+
+            for(uint32_t j = 0; j < i && !overlaps; j++)
+            {
+                const Resource * other = graph->resources + imageOrder[j];
+                overlaps = other->memorySlot == slotIndex && lifetimesOverlap(resource, other);
+            }
+
+            if(!overlaps)
+            {
+                break;
+            }
+        }
+
+        MemorySlot * memorySlot = graph->memorySlots + slotIndex;
+
+        if(slotIndex == graph->memorySlotCount)
+        {
+            graph->memorySlotCount++;
+            *memorySlot = {};
+            memorySlot->requirements = *requirements;
+        }
+        else
+        {
+            VkMemoryRequirements * slotRequirements = &memorySlot->requirements;
+
+            if(requirements->size > slotRequirements->size)
+            {
+                slotRequirements->size = requirements->size;
+            }
+
+            if(requirements->alignment > slotRequirements->alignment)
+            {
+                slotRequirements->alignment = requirements->alignment;
+            }
+
+            slotRequirements->memoryTypeBits &= requirements->memoryTypeBits;
+        }
+
+        resource->memorySlot = slotIndex;
+    }
+
+    for(uint32_t slotIndex = 0; slotIndex < graph->memorySlotCount; slotIndex++)
+    {
+        MemorySlot * memorySlot = graph->memorySlots + slotIndex;
+
+        if(!memAllocate(&context->allocator, MEMStrategy::BUDDY, MEMResourceType::OPTIMAL, &memorySlot->requirements,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, &memorySlot->allocation))
+        {
+            utilErrorExit("FRAMEGRAPH", nullptr, "failed to allocate %llu bytes for transient images\n",
+                          (unsigned long long)memorySlot->requirements.size);
+        }
+    }
+
+    for(uint32_t i = 0; i < imageCount; i++)
+    {
+        Resource * resource = graph->resources + imageOrder[i];
+        const MEMAllocation * allocation = &graph->memorySlots[resource->memorySlot].allocation;
+        VkResult result = vkBindImageMemory(logicalDevice, resource->image, allocation->memory, allocation->offset);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to bind transient image memory\n");
+        }
+
+        // typedef struct VkImageViewCreateInfo {
+        //     VkStructureType            sType;
+        //     const void*                pNext;
+        //     VkImageViewCreateFlags     flags;
+        //     VkImage                    image;
+        //     VkImageViewType            viewType;
+        //     VkFormat                   format;
+        //     VkComponentMapping         components;
+        //     VkImageSubresourceRange    subresourceRange;
+        // } VkImageViewCreateInfo;
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.pNext = nullptr;
+        imageViewCreateInfo.flags = 0; // Reserved for future use.
+        imageViewCreateInfo.image = resource->image;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = resource->format;
+
+        imageViewCreateInfo.components =
+        {
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+        };
+
+        imageViewCreateInfo.subresourceRange = { resource->aspectMask, 0, 1, 0, 1 };
+        result = vkCreateImageView(logicalDevice, &imageViewCreateInfo, nullptr, &resource->imageView);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create transient image view\n");
+        }
+    }
+}
+
+// Adds a barrier to batch if accessing the resource in state with accessInfo is a hazard or needs a layout transition,
+// and updates state to include the access. Writes and layout transitions wait on the last write and every read since;
+// reads only wait on the last write, and only if it isn't yet visible to their stages and accesses.
+static void
+planAccess(FGGraph * graph, BarrierBatch * batch, uint32_t resourceIndex, ResourceState * state,
+           const AccessInfo * accessInfo)
+{
+    const Resource * resource = graph->resources + resourceIndex;
+    bool layoutChanges = resource->isImage && state->layout != accessInfo->layout;
+    bool writes = accessInfo->writes || layoutChanges;
+
+    bool visible = (accessInfo->stageMask & ~state->visibleStageMask) == 0 &&
+                   (accessInfo->accessMask & ~state->visibleAccessMask) == 0;
+
+    if(!writes && (visible || state->writeStageMask == 0))
+    {
+        state->readStageMask |= accessInfo->stageMask;
+        return;
+    }
+
+    VkPipelineStageFlags srcStageMask = state->writeStageMask | (writes ? state->readStageMask : 0);
+    Barrier * barrier = graph->barriers + graph->barrierCount++;
+    barrier->resource = resourceIndex;
+    barrier->srcAccessMask = state->writeAccessMask;
+    barrier->dstAccessMask = accessInfo->accessMask;
+    barrier->oldLayout = state->layout;
+    barrier->newLayout = resource->isImage ? accessInfo->layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    batch->srcStageMask |= srcStageMask != 0 ? srcStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    batch->dstStageMask |= accessInfo->stageMask;
+    batch->barrierCount++;
+    state->layout = barrier->newLayout;
+
+    if(writes)
+    {
+        state->writeStageMask = accessInfo->stageMask;
+        state->writeAccessMask = accessInfo->writes ? accessInfo->accessMask : 0;
+        state->visibleStageMask = accessInfo->stageMask;
+        state->visibleAccessMask = accessInfo->accessMask;
+        state->readStageMask = accessInfo->writes ? 0 : accessInfo->stageMask;
+    }
+    else
+    {
+        state->visibleStageMask |= accessInfo->stageMask;
+        state->visibleAccessMask |= accessInfo->accessMask;
+        state->readStageMask |= accessInfo->stageMask;
+    }
+}
+
+// Plans one batch of barriers before each live pass into states, the resources' states when the graph runs. Each memory
+// slot's lastState is where its first image starts, and is left as the slot's state at the end of the graph.
+static void
+planPassBarriers(FGGraph * graph, ResourceState * states)
+{
+    graph->barrierCount = 0;
+
+    for(uint32_t resourceIndex = 0; resourceIndex < graph->resourceCount; resourceIndex++)
+    {
+        const Resource * resource = graph->resources + resourceIndex;
+        const AccessInfo * initialAccessInfo = getAccessInfo(resource->initialAccess);
+        ResourceState * state = states + resourceIndex;
+        *state = {};
+        state->layout = initialAccessInfo->layout;
+
+        // Writes before the graph runs still need to be made visible; reads only need to finish before it writes.
+        if(initialAccessInfo->writes)
+        {
+            state->writeStageMask = initialAccessInfo->stageMask;
+            state->writeAccessMask = initialAccessInfo->accessMask;
+        }
+        else if(initialAccessInfo->reads)
+        {
+            state->readStageMask = initialAccessInfo->stageMask;
+        }
+    }
+
+    for(uint32_t passIndex = 0; passIndex < graph->passCount; passIndex++)
+    {
+        Pass * pass = graph->passes + passIndex;
+        BarrierBatch * batch = &pass->barriers;
+        *batch = {};
+        batch->barrierBegin = graph->barrierCount;
+
+        if(!pass->live)
+        {
+            continue;
+        }
+
+        for(uint32_t i = 0; i < pass->accessCount; i++)
+        {
+            const PassAccess * access = pass->accesses + i;
+            const Resource * resource = graph->resources + access->resource;
+            ResourceState * state = states + access->resource;
+
+            // A transient image's first access discards its contents, but must wait for the image it aliases to be
+            // done with the memory.
+            if(!resource->imported && passIndex == resource->firstPass)
+            {
+                MemorySlot * memorySlot = graph->memorySlots + resource->memorySlot;
+                *state = memorySlot->lastState;
+                state->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+
+            planAccess(graph, batch, access->resource, state, getAccessInfo(access->access));
+
+            if(!resource->imported && passIndex == resource->lastPass)
+            {
+                graph->memorySlots[resource->memorySlot].lastState = *state;
+            }
+        }
+    }
+}
+
+// Plans one batch of barriers before each live pass, and one after the last for the final states of imported
+// resources.
+static void
+planBarriers(FGGraph * graph)
+{
+    ResourceState states[FG_MAX_RESOURCES] = {};
+
+    for(uint32_t i = 0; i < graph->memorySlotCount; i++)
+    {
+        graph->memorySlots[i].lastState = {};
+    }
+
+    // Transient memory is reused by every execution, so a slot's first image must also wait for the previous
+    // execution's last image in the slot to be done with it. Plan once to find each slot's state at the end of the
+    // graph, then plan again starting each slot from it; the barriers of the first run are discarded.
+    planPassBarriers(graph, states);
+    planPassBarriers(graph, states);
+
+    BarrierBatch * finalBarriers = &graph->finalBarriers;
+    *finalBarriers = {};
+    finalBarriers->barrierBegin = graph->barrierCount;
+
+    for(uint32_t resourceIndex = 0; resourceIndex < graph->resourceCount; resourceIndex++)
+    {
+        const Resource * resource = graph->resources + resourceIndex;
+
+        if(resource->imported && resource->finalAccess != FGAccess::UNDEFINED)
+        {
+            planAccess(graph, finalBarriers, resourceIndex, states + resourceIndex,
+                       getAccessInfo(resource->finalAccess));
+        }
+    }
+}
+
+// Creates a render pass for each live pass with attachments. Barriers transition attachments beforehand, so each
+// attachment stays in one layout throughout; transient images are cleared on first use and not stored after last use.
+static void
+createRenderPasses(FGGraph * graph)
+{
+    VkDevice logicalDevice = graph->context->logicalDevice;
+
+    for(uint32_t passIndex = 0; passIndex < graph->passCount; passIndex++)
+    {
+        Pass * pass = graph->passes + passIndex;
+        pass->attachmentCount = 0;
+
+        if(!pass->live)
+        {
+            continue;
+        }
+
+        VkAttachmentDescription attachments[FG_MAX_ATTACHMENTS] = {};
+        VkAttachmentReference colorAttachmentReferences[FG_MAX_ATTACHMENTS] = {};
+        VkAttachmentReference depthAttachmentReference = {};
+        uint32_t colorAttachmentCount = 0;
+        bool hasDepthAttachment = false;
+
+        for(uint32_t i = 0; i < pass->accessCount; i++)
+        {
+            const PassAccess * access = pass->accesses + i;
+
+            if(!isAttachmentAccess(access->access))
+            {
+                continue;
+            }
+
+            if(pass->attachmentCount == FG_MAX_ATTACHMENTS)
+            {
+                utilErrorExit("FRAMEGRAPH", nullptr, "pass \"%s\" has more than %u attachments\n", pass->name,
+                              FG_MAX_ATTACHMENTS);
+            }
+
+            const Resource * resource = graph->resources + access->resource;
+            const AccessInfo * accessInfo = getAccessInfo(access->access);
+            bool transient = !resource->imported;
+            bool clear = transient && passIndex == resource->firstPass;
+            bool store = !transient || passIndex != resource->lastPass;
+            bool stencil = (resource->aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+            uint32_t attachmentIndex = pass->attachmentCount++;
+            pass->attachmentResources[attachmentIndex] = access->resource;
+            pass->clearValues[attachmentIndex] = resource->clearValue;
+
+            // Attachments of a pass must all have the same extent.
+            PRISM_ASSERT(attachmentIndex == 0 ||
+                         (pass->extent.width == resource->extent.width &&
+                          pass->extent.height == resource->extent.height));
+
+            pass->extent = resource->extent;
+
+            // typedef struct VkAttachmentDescription {
+            //     VkAttachmentDescriptionFlags    flags;
+            //     VkFormat                        format;
+            //     VkSampleCountFlagBits           samples;
+            //     VkAttachmentLoadOp              loadOp;
+            //     VkAttachmentStoreOp             storeOp;
+            //     VkAttachmentLoadOp              stencilLoadOp;
+            //     VkAttachmentStoreOp             stencilStoreOp;
+            //     VkImageLayout                   initialLayout;
+            //     VkImageLayout                   finalLayout;
+            // } VkAttachmentDescription;
+            VkAttachmentDescription * attachment = attachments + attachmentIndex;
+            attachment->flags = 0;
+            attachment->format = resource->format;
+            attachment->samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment->loadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment->storeOp = store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment->stencilLoadOp = stencil ? attachment->loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment->stencilStoreOp = stencil ? attachment->storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment->initialLayout = accessInfo->layout;
+            attachment->finalLayout = accessInfo->layout;
+
+            if(access->access == FGAccess::COLOR_ATTACHMENT_WRITE)
+            {
+                colorAttachmentReferences[colorAttachmentCount++] = { attachmentIndex, accessInfo->layout };
+            }
+            else
+            {
+                PRISM_ASSERT(!hasDepthAttachment);
+                depthAttachmentReference = { attachmentIndex, accessInfo->layout };
+                hasDepthAttachment = true;
+            }
+        }
+
+        if(pass->attachmentCount == 0)
+        {
+            continue;
+        }
+
+        // typedef struct VkSubpassDescription {
+        //     VkSubpassDescriptionFlags       flags;
+        //     VkPipelineBindPoint             pipelineBindPoint;
+        //     uint32_t                        inputAttachmentCount;
+        //     const VkAttachmentReference*    pInputAttachments;
+        //     uint32_t                        colorAttachmentCount;
+        //     const VkAttachmentReference*    pColorAttachments;
+        //     const VkAttachmentReference*    pResolveAttachments;
+        //     const VkAttachmentReference*    pDepthStencilAttachment;
+        //     uint32_t                        preserveAttachmentCount;
+        //     const uint32_t*                 pPreserveAttachments;
+        // } VkSubpassDescription;
+        VkSubpassDescription subpass = {};
+        subpass.flags = 0;
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.inputAttachmentCount = 0;
+        subpass.pInputAttachments = nullptr;
+        subpass.colorAttachmentCount = colorAttachmentCount;
+        subpass.pColorAttachments = colorAttachmentReferences;
+        subpass.pResolveAttachments = nullptr;
+        subpass.pDepthStencilAttachment = hasDepthAttachment ? &depthAttachmentReference : nullptr;
+        subpass.preserveAttachmentCount = 0;
+        subpass.pPreserveAttachments = nullptr;
+
+        // typedef struct VkRenderPassCreateInfo {
+        //     VkStructureType                   sType;
+        //     const void*                       pNext;
+        //     VkRenderPassCreateFlags           flags;
+        //     uint32_t                          attachmentCount;
+        //     const VkAttachmentDescription*    pAttachments;
+        //     uint32_t                          subpassCount;
+        //     const VkSubpassDescription*       pSubpasses;
+        //     uint32_t                          dependencyCount;
+        //     const VkSubpassDependency*        pDependencies;
+        // } VkRenderPassCreateInfo;
+        VkRenderPassCreateInfo renderPassCreateInfo = {};
+        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassCreateInfo.pNext = nullptr;
+        renderPassCreateInfo.flags = 0; // Reserved for future use.
+        renderPassCreateInfo.attachmentCount = pass->attachmentCount;
+        renderPassCreateInfo.pAttachments = attachments;
+        renderPassCreateInfo.subpassCount = 1;
+        renderPassCreateInfo.pSubpasses = &subpass;
+        renderPassCreateInfo.dependencyCount = 0;
+        renderPassCreateInfo.pDependencies = nullptr;
+        VkResult result = vkCreateRenderPass(logicalDevice, &renderPassCreateInfo, nullptr, &pass->renderPass);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create render pass for \"%s\"\n", pass->name);
+        }
+    }
+}
+
+// Returns the pass's framebuffer for the current views of its attachments, creating it the first time they're used.
+static VkFramebuffer
+getFramebuffer(FGGraph * graph, Pass * pass)
+{
+    VkImageView views[FG_MAX_ATTACHMENTS] = {};
+
+    for(uint32_t i = 0; i < pass->attachmentCount; i++)
+    {
+        views[i] = graph->resources[pass->attachmentResources[i]].imageView;
+        PRISM_ASSERT(views[i] != VK_NULL_HANDLE);
+    }
+
+    for(uint32_t i = 0; i < pass->framebufferCount; i++)
+    {
+        if(memcmp(pass->framebuffers[i].views, views, sizeof(VkImageView) * pass->attachmentCount) == 0)
+        {
+            return pass->framebuffers[i].framebuffer;
+        }
+    }
+
+    if(pass->framebufferCount == FG_MAX_FRAMEBUFFERS)
+    {
+        utilErrorExit("FRAMEGRAPH", nullptr, "pass \"%s\" used more than %u sets of attachments\n", pass->name,
+                      FG_MAX_FRAMEBUFFERS);
+    }
+
+    Framebuffer * framebuffer = pass->framebuffers + pass->framebufferCount++;
+    memcpy(framebuffer->views, views, sizeof(views));
+
+    // typedef struct VkFramebufferCreateInfo {
+    //     VkStructureType             sType;
+    //     const void*                 pNext;
+    //     VkFramebufferCreateFlags    flags;
+    //     VkRenderPass                renderPass;
+    //     uint32_t                    attachmentCount;
+    //     const VkImageView*          pAttachments;
+    //     uint32_t                    width;
+    //     uint32_t                    height;
+    //     uint32_t                    layers;
+    // } VkFramebufferCreateInfo;
+    VkFramebufferCreateInfo framebufferCreateInfo = {};
+    framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferCreateInfo.pNext = nullptr;
+    framebufferCreateInfo.flags = 0; // Reserved for future use.
+    framebufferCreateInfo.renderPass = pass->renderPass;
+    framebufferCreateInfo.attachmentCount = pass->attachmentCount;
+    framebufferCreateInfo.pAttachments = views;
+    framebufferCreateInfo.width = pass->extent.width;
+    framebufferCreateInfo.height = pass->extent.height;
+    framebufferCreateInfo.layers = 1;
+
+    VkResult result = vkCreateFramebuffer(graph->context->logicalDevice, &framebufferCreateInfo, nullptr,
+                                          &framebuffer->framebuffer);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create framebuffer for \"%s\"\n", pass->name);
+    }
+
+    return framebuffer->framebuffer;
+}
+
+static void
+recordBarriers(const FGGraph * graph, VkCommandBuffer commandBuffer, const BarrierBatch * batch)
+{
+    if(batch->barrierCount == 0)
+    {
+        return;
+    }
+
+    VkImageMemoryBarrier imageBarriers[FG_MAX_RESOURCES] = {};
+    VkBufferMemoryBarrier bufferBarriers[FG_MAX_RESOURCES] = {};
+    uint32_t imageBarrierCount = 0;
+    uint32_t bufferBarrierCount = 0;
+
+    for(uint32_t i = 0; i < batch->barrierCount; i++)
+    {
+        const Barrier * barrier = graph->barriers + batch->barrierBegin + i;
+        const Resource * resource = graph->resources + barrier->resource;
+
+        if(resource->isImage)
+        {
+            PRISM_ASSERT(resource->image != VK_NULL_HANDLE);
+
+            // typedef struct VkImageMemoryBarrier {
+            //     VkStructureType            sType;
+            //     const void*                pNext;
+            //     VkAccessFlags              srcAccessMask;
+            //     VkAccessFlags              dstAccessMask;
+            //     VkImageLayout              oldLayout;
+            //     VkImageLayout              newLayout;
+            //     uint32_t                   srcQueueFamilyIndex;
+            //     uint32_t                   dstQueueFamilyIndex;
+            //     VkImage                    image;
+            //     VkImageSubresourceRange    subresourceRange;
+            // } VkImageMemoryBarrier;
+            VkImageMemoryBarrier * imageBarrier = imageBarriers + imageBarrierCount++;
+            imageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier->pNext = nullptr;
+            imageBarrier->srcAccessMask = barrier->srcAccessMask;
+            imageBarrier->dstAccessMask = barrier->dstAccessMask;
+            imageBarrier->oldLayout = barrier->oldLayout;
+            imageBarrier->newLayout = barrier->newLayout;
+            imageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier->image = resource->image;
+
+            imageBarrier->subresourceRange =
+                { resource->aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+        }
+        else
+        {
+            PRISM_ASSERT(resource->buffer != VK_NULL_HANDLE);
+
+            // typedef struct VkBufferMemoryBarrier {
+            //     VkStructureType    sType;
+            //     const void*        pNext;
+            //     VkAccessFlags      srcAccessMask;
+            //     VkAccessFlags      dstAccessMask;
+            //     uint32_t           srcQueueFamilyIndex;
+            //     uint32_t           dstQueueFamilyIndex;
+            //     VkBuffer           buffer;
+            //     VkDeviceSize       offset;
+            //     VkDeviceSize       size;
+            // } VkBufferMemoryBarrier;
+            VkBufferMemoryBarrier * bufferBarrier = bufferBarriers + bufferBarrierCount++;
+            bufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufferBarrier->pNext = nullptr;
+            bufferBarrier->srcAccessMask = barrier->srcAccessMask;
+            bufferBarrier->dstAccessMask = barrier->dstAccessMask;
+            bufferBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier->buffer = resource->buffer;
+            bufferBarrier->offset = 0;
+            bufferBarrier->size = VK_WHOLE_SIZE;
+        }
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, batch->srcStageMask, batch->dstStageMask, 0, 0, nullptr, bufferBarrierCount,
+                         bufferBarriers, imageBarrierCount, imageBarriers);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+FGGraph *
+fgCreate(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+    auto graph = new FGGraph();
+    graph->context = context;
+
+    return graph;
+}
+
+uint32_t
+fgCreateImage(FGGraph * graph, const char * name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspectMask,
+              VkClearValue clearValue)
+{
+    PRISM_ASSERT(graph != nullptr);
+    uint32_t resourceIndex = addResource(graph, name, true, false);
+    Resource * resource = graph->resources + resourceIndex;
+    resource->format = format;
+    resource->extent = extent;
+    resource->aspectMask = aspectMask;
+    resource->clearValue = clearValue;
+
+    return resourceIndex;
+}
+
+uint32_t
+fgImportImage(FGGraph * graph, const char * name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspectMask,
+              FGAccess initialAccess, FGAccess finalAccess)
+{
+    PRISM_ASSERT(graph != nullptr);
+    uint32_t resourceIndex = addResource(graph, name, true, true);
+    Resource * resource = graph->resources + resourceIndex;
+    resource->format = format;
+    resource->extent = extent;
+    resource->aspectMask = aspectMask;
+    resource->initialAccess = initialAccess;
+    resource->finalAccess = finalAccess;
+
+    return resourceIndex;
+}
+
+uint32_t
+fgImportBuffer(FGGraph * graph, const char * name, FGAccess initialAccess, FGAccess finalAccess)
+{
+    PRISM_ASSERT(graph != nullptr);
+    uint32_t resourceIndex = addResource(graph, name, false, true);
+    Resource * resource = graph->resources + resourceIndex;
+    resource->initialAccess = initialAccess;
+    resource->finalAccess = finalAccess;
+
+    return resourceIndex;
+}
+
+void
+fgSetImage(FGGraph * graph, uint32_t resource, VkImage image, VkImageView imageView)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(resource < graph->resourceCount);
+    PRISM_ASSERT(graph->resources[resource].imported && graph->resources[resource].isImage);
+    graph->resources[resource].image = image;
+    graph->resources[resource].imageView = imageView;
+}
+
+void
+fgSetBuffer(FGGraph * graph, uint32_t resource, VkBuffer buffer)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(resource < graph->resourceCount);
+    PRISM_ASSERT(graph->resources[resource].imported && !graph->resources[resource].isImage);
+    graph->resources[resource].buffer = buffer;
+}
+
+void
+fgResizeImage(FGGraph * graph, uint32_t resource, VkExtent2D extent)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(resource < graph->resourceCount);
+    PRISM_ASSERT(graph->resources[resource].imported && graph->resources[resource].isImage);
+    graph->resources[resource].extent = extent;
+
+    // Only framebuffers depend on the extent, so the graph stays compiled; the framebuffers of passes the image is
+    // attached to are retired and recreated at the new extent when next used.
+    for(uint32_t passIndex = 0; passIndex < graph->passCount; passIndex++)
+    {
+        Pass * pass = graph->passes + passIndex;
+
+        for(uint32_t i = 0; i < pass->attachmentCount; i++)
+        {
+            if(pass->attachmentResources[i] == resource)
+            {
+                retireFramebuffers(graph, pass);
+                pass->extent = extent;
+                break;
+            }
+        }
+    }
+}
+
+uint32_t
+fgAddPass(FGGraph * graph, const char * name, FGExecuteFn executeFn, void * data, bool sideEffects)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(executeFn != nullptr);
+
+    if(graph->passCount == FG_MAX_PASSES)
+    {
+        utilErrorExit("FRAMEGRAPH", nullptr, "more than %u passes\n", FG_MAX_PASSES);
+    }
+
+    uint32_t passIndex = graph->passCount++;
+    Pass * pass = graph->passes + passIndex;
+    *pass = {};
+    pass->name = name;
+    pass->executeFn = executeFn;
+    pass->data = data;
+    pass->sideEffects = sideEffects;
+    graph->compiled = false;
+
+    return passIndex;
+}
+
+void
+fgAddAccess(FGGraph * graph, uint32_t pass, uint32_t resource, FGAccess access)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(pass < graph->passCount);
+    PRISM_ASSERT(resource < graph->resourceCount);
+    PRISM_ASSERT(access != FGAccess::UNDEFINED && access != FGAccess::PRESENT && access != FGAccess::COUNT);
+    PRISM_ASSERT(graph->resources[resource].isImage || !isAttachmentAccess(access));
+    Pass * accessingPass = graph->passes + pass;
+
+    if(accessingPass->accessCount == FG_MAX_PASS_ACCESSES)
+    {
+        utilErrorExit("FRAMEGRAPH", nullptr, "pass \"%s\" accesses more than %u resources\n", accessingPass->name,
+                      FG_MAX_PASS_ACCESSES);
+    }
+
+    for(uint32_t i = 0; i < accessingPass->accessCount; i++)
+    {
+        PRISM_ASSERT(accessingPass->accesses[i].resource != resource);
+    }
+
+    accessingPass->accesses[accessingPass->accessCount++] = { resource, access };
+    graph->compiled = false;
+}
+
+void
+fgCompile(FGGraph * graph)
+{
+    PRISM_ASSERT(graph != nullptr);
+
+    if(graph->hasCompiledResources)
+    {
+        retireCompiledResources(graph);
+    }
+
+    cullPasses(graph);
+    findLifetimes(graph);
+    createTransientImages(graph);
+    planBarriers(graph);
+    createRenderPasses(graph);
+    graph->compiled = true;
+    graph->hasCompiledResources = true;
+
+    // Log how much culling and aliasing saved.
+    uint32_t livePassCount = 0;
+    VkDeviceSize transientSize = 0;
+    VkDeviceSize unaliasedTransientSize = 0;
+
+    for(uint32_t i = 0; i < graph->passCount; i++)
+    {
+        livePassCount += graph->passes[i].live ? 1 : 0;
+    }
+
+    for(uint32_t i = 0; i < graph->memorySlotCount; i++)
+    {
+        transientSize += graph->memorySlots[i].requirements.size;
+    }
+
+    for(uint32_t i = 0; i < graph->resourceCount; i++)
+    {
+        const Resource * resource = graph->resources + i;
+
+        if(resource->memorySlot != FG_INVALID_INDEX)
+        {
+            unaliasedTransientSize += resource->requirements.size;
+        }
+    }
+
+    utilLog("FRAMEGRAPH", "compiled %u of %u passes with %u barriers; transient images use %llu bytes "
+            "(%llu unaliased)\n", livePassCount, graph->passCount, graph->barrierCount,
+            (unsigned long long)transientSize, (unsigned long long)unaliasedTransientSize);
+}
+
+void
+fgExecute(FGGraph * graph, VkCommandBuffer commandBuffer)
+{
+    PRISM_ASSERT(graph != nullptr);
+
+    // Objects retired by a previous recompilation or resize may no longer be in use now that another frame completed.
+    destroyRetiredObjects(graph, false);
+
+    if(!graph->compiled)
+    {
+        fgCompile(graph);
+    }
+
+    GFXContext * context = graph->context;
+
+    for(uint32_t passIndex = 0; passIndex < graph->passCount; passIndex++)
+    {
+        Pass * pass = graph->passes + passIndex;
+
+        if(!pass->live)
+        {
+            continue;
+        }
+
+        recordBarriers(graph, commandBuffer, &pass->barriers);
+        gfxBeginGPUZone(context, commandBuffer, pass->name);
+
+        if(pass->renderPass == VK_NULL_HANDLE)
+        {
+            pass->executeFn(pass->data, commandBuffer);
+            gfxEndGPUZone(context, commandBuffer);
+            continue;
+        }
+
+        // typedef struct VkRenderPassBeginInfo {
+        //     VkStructureType        sType;
+        //     const void*            pNext;
+        //     VkRenderPass           renderPass;
+        //     VkFramebuffer          framebuffer;
+        //     VkRect2D               renderArea;
+        //     uint32_t               clearValueCount;
+        //     const VkClearValue*    pClearValues;
+        // } VkRenderPassBeginInfo;
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.pNext = nullptr;
+        renderPassBeginInfo.renderPass = pass->renderPass;
+        renderPassBeginInfo.framebuffer = getFramebuffer(graph, pass);
+        renderPassBeginInfo.renderArea = { { 0, 0 }, pass->extent };
+        renderPassBeginInfo.clearValueCount = pass->attachmentCount;
+        renderPassBeginInfo.pClearValues = pass->clearValues;
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport = { 0.0f, 0.0f, (float)pass->extent.width, (float)pass->extent.height, 0.0f, 1.0f };
+        VkRect2D scissor = { { 0, 0 }, pass->extent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        pass->executeFn(pass->data, commandBuffer);
+        vkCmdEndRenderPass(commandBuffer);
+        gfxEndGPUZone(context, commandBuffer);
+    }
+
+    recordBarriers(graph, commandBuffer, &graph->finalBarriers);
+}
+
+VkRenderPass
+fgGetRenderPass(const FGGraph * graph, uint32_t pass)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(pass < graph->passCount);
+    return graph->passes[pass].renderPass;
+}
+
+VkImage
+fgGetImage(const FGGraph * graph, uint32_t resource)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(resource < graph->resourceCount);
+    return graph->resources[resource].image;
+}
+
+VkImageView
+fgGetImageView(const FGGraph * graph, uint32_t resource)
+{
+    PRISM_ASSERT(graph != nullptr);
+    PRISM_ASSERT(resource < graph->resourceCount);
+    return graph->resources[resource].imageView;
+}
+
+void
+fgDestroy(FGGraph * graph)
+{
+    PRISM_ASSERT(graph != nullptr);
+
+    // Cleanup
+    if(graph->hasCompiledResources)
+    {
+        retireCompiledResources(graph);
+    }
+
+    destroyRetiredObjects(graph, true);
+    delete graph;
+}
+
+} // namespace prism
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define FG_MAX_PASSES 64
+#define FG_MAX_RESOURCES 64
+
+// Maximum number of resources a pass accesses, and of attachments among them.
+#define FG_MAX_PASS_ACCESSES 16
+#define FG_MAX_ATTACHMENTS 8
+
+// Maximum number of framebuffers per pass; a pass needs one per distinct set of imported attachment views, e.g. per
+// swapchain image.
+#define FG_MAX_FRAMEBUFFERS 8
+
+#define FG_INVALID_INDEX UINT32_MAX
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Typedefs
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Records a pass's commands; attachment passes are called inside their render pass, with viewport and scissor set to
+// the attachments' extent.
+using FGExecuteFn = void (*)(void * data, VkCommandBuffer commandBuffer);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GFXContext;
+struct FGGraph;
+
+// How a pass uses a resource; each maps to the pipeline stages, access flags and image layout barriers are built from.
+// Attachment, storage and transfer writes keep the resource's previous contents, e.g. outside a copied region, so they
+// also depend on earlier writes.
+enum class FGAccess
+{
+    // Images.
+    COLOR_ATTACHMENT_WRITE,
+    DEPTH_ATTACHMENT_WRITE,
+    DEPTH_ATTACHMENT_READ,
+    SAMPLED_READ,
+    PRESENT,
+
+    // Images or buffers.
+    STORAGE_READ,
+    STORAGE_WRITE,
+    TRANSFER_READ,
+    TRANSFER_WRITE,
+
+    // Buffers.
+    VERTEX_BUFFER_READ,
+    INDEX_BUFFER_READ,
+    INDIRECT_BUFFER_READ,
+    UNIFORM_BUFFER_READ,
+
+    // Imported resources only; their contents before the graph runs are undefined, or not needed after it.
+    UNDEFINED,
+
+    COUNT,
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+FGGraph *
+fgCreate(GFXContext * context);
+
+// Adds an image owned by the graph that only lives within it; transient images whose lifetimes don't overlap share
+// memory. Returns its resource index.
+uint32_t
+fgCreateImage(FGGraph * graph, const char * name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspectMask,
+              VkClearValue clearValue);
+
+// Adds an image owned outside the graph, in the state of initialAccess when the graph runs and left in the state of
+// finalAccess. Its handles are set with fgSetImage() before each execution. Returns its resource index.
+uint32_t
+fgImportImage(FGGraph * graph, const char * name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspectMask,
+              FGAccess initialAccess, FGAccess finalAccess);
+
+// Buffer counterpart of fgImportImage(); its handle is set with fgSetBuffer().
+uint32_t
+fgImportBuffer(FGGraph * graph, const char * name, FGAccess initialAccess, FGAccess finalAccess);
+
+void
+fgSetImage(FGGraph * graph, uint32_t resource, VkImage image, VkImageView imageView);
+
+void
+fgSetBuffer(FGGraph * graph, uint32_t resource, VkBuffer buffer);
+
+// Changes an imported image's extent when the image it's set to is recreated, e.g. with the swapchain. The graph isn't
+// recompiled; only the framebuffers of passes the image is attached to are replaced, so ones made from the image's
+// previous views are never reused. Other attachments of those passes must already have the new extent.
+void
+fgResizeImage(FGGraph * graph, uint32_t resource, VkExtent2D extent);
+
+// Adds a pass, executed in the order passes are added. Passes whose results nothing reads are culled unless they have
+// side effects outside the graph. Returns its pass index.
+uint32_t
+fgAddPass(FGGraph * graph, const char * name, FGExecuteFn executeFn, void * data, bool sideEffects);
+
+// Declares that pass accesses resource; each resource can be accessed at most once per pass.
+void
+fgAddAccess(FGGraph * graph, uint32_t pass, uint32_t resource, FGAccess access);
+
+// Culls unused passes, creates and aliases transient images, creates render passes for passes with attachments, and
+// plans the barriers between passes. If the graph was compiled before, the previous compilation's resources are
+// destroyed once the frames in flight that may use them have completed, so recompiling never waits on the device.
+void
+fgCompile(FGGraph * graph);
+
+// Records the graph's passes and barriers into commandBuffer, which must not be inside a render pass; compiles the
+// graph first if passes or resources were added since it was last compiled. commandBuffer must be a frame's command
+// buffer, as objects the graph replaces are destroyed once the frames in flight have completed.
+void
+fgExecute(FGGraph * graph, VkCommandBuffer commandBuffer);
+
+// Valid after compilation; null for culled passes or passes without attachments.
+VkRenderPass
+fgGetRenderPass(const FGGraph * graph, uint32_t pass);
+
+// Valid after compilation for transient images, or after fgSetImage() for imported ones.
+VkImage
+fgGetImage(const FGGraph * graph, uint32_t resource);
+
+VkImageView
+fgGetImageView(const FGGraph * graph, uint32_t resource);
+
+// Destroys the graph's resources immediately; they must not be in use by frames still in flight.
+void
+fgDestroy(FGGraph * graph);
+
+} // namespace prism
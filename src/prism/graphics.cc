@@ -1,9 +1,24 @@
+#include <cerrno>
+#include <cstddef>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/inotify.h>
 #include "prism/graphics.h"
+#include "prism/jobs.h"
+#include "prism/profiler.h"
 #include "prism/utilities.h"
 #include "prism/defines.h"
 #include "prism/vulkan.h"
+#include "ctk/yaml.h"
 
 using namespace ctk;
 
@@ -17,6 +32,23 @@ namespace prism
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #define QUEUE_FAMILY_INDEX(FAMILY) (size_t)QueueInfo::Families::FAMILY
 #define QUEUE_FAMILY_COUNT QUEUE_FAMILY_INDEX(COUNT)
+#define PIPELINE_CACHE_FILE_MAGIC 0x43505250 // "PRPC"
+#define PIPELINE_CACHE_FILE_VERSION 1
+#define MAX_PATH_SIZE 256
+
+// Stages and accesses of a frame's graphics work that may consume the frame's uploads and compute results.
+#define GRAPHICS_CONSUMER_STAGES \
+    (VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT \
+     | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+
+#define GRAPHICS_CONSUMER_ACCESS \
+    (VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT \
+     | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT)
+
+// Staging offsets are aligned to satisfy vkCmdCopyBufferToImage() for every texel size up to 16 bytes.
+#define STAGING_ALIGNMENT 16
+
+#define MAX_PREFERRED_PRESENT_MODE_COUNT 3
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -42,46 +74,92 @@ struct InstanceComponentInfo
     GetComponentNameFn<ComponentProps> getNameFn;
 };
 
-struct SwapchainInfo
+// Written before the pipeline cache data on disk. Vulkan's own cache header doesn't include the driver version, and a
+// cache from another driver version can't be reused, so it is validated here before the data reaches the driver.
+struct PipelineCacheFileHeader
 {
-    // typedef struct VkSurfaceCapabilitiesKHR {
-    //     uint32_t                         minImageCount;
-    //     uint32_t                         maxImageCount;
-    //     VkExtent2D                       currentExtent;
-    //     VkExtent2D                       minImageExtent;
-    //     VkExtent2D                       maxImageExtent;
-    //     uint32_t                         maxImageArrayLayers;
-    //     VkSurfaceTransformFlagsKHR       supportedTransforms;
-    //     VkSurfaceTransformFlagBitsKHR    currentTransform;
-    //     VkCompositeAlphaFlagsKHR         supportedCompositeAlpha;
-    //     VkImageUsageFlags                supportedUsageFlags;
-    // } VkSurfaceCapabilitiesKHR;
-    VkSurfaceCapabilitiesKHR surfaceCapabilities;
-
-    Buffer<VkSurfaceFormatKHR> availableSurfaceFormats;
-    Buffer<VkPresentModeKHR> availableSurfacePresentModes;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint32_t dataChecksum;
 };
 
-struct SwapchainConfig
+// typedef struct VkPipelineCacheHeaderVersionOne {
+//     uint32_t                        headerSize;
+//     VkPipelineCacheHeaderVersion    headerVersion;
+//     uint32_t                        vendorID;
+//     uint32_t                        deviceID;
+//     uint8_t                         pipelineCacheUUID[VK_UUID_SIZE];
+// } VkPipelineCacheHeaderVersionOne;
+struct PipelineCacheHeader
 {
-    VkSurfaceFormatKHR surfaceFormat;
-    VkPresentModeKHR surfacePresentMode;
-    VkExtent2D extent;
-    uint32_t imageCount;
-    VkSurfaceTransformFlagBitsKHR currentTransform;
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
 };
 
-struct QueueInfo
+// Work gfxInit() runs as jobs; each job only writes context fields nothing else touches until the jobs are waited on.
+struct StartupJob
 {
-    enum class Families
-    {
-        GRAPHICS = 0,
-        PRESENT = 1,
-        COUNT = 2,
-    };
+    GFXContext * context;
+    const GFXConfig * config;
+};
+
+// Shader module recompiled on the reloader thread, waiting to be swapped in at the next frame boundary.
+struct ShaderReload
+{
+    size_t shaderIndex;
+    size_t stageIndex;
+    VkShaderModule module;
+};
+
+// Stage files of a shader in the library. The reloader thread matches changed sources against its own copy, as the
+// shader library itself is written by the main thread whenever reloads are applied.
+struct ShaderSource
+{
+    char stageFiles[(size_t)GFXShaderStage::COUNT][GFX_MAX_SHADER_NAME_SIZE];
+};
+
+struct GFXShaderReloader
+{
+    VkLogicalDevice logicalDevice;
+
+    // Indexed like the shader library.
+    Buffer<ShaderSource> shaderSources;
+    char sourceDir[MAX_PATH_SIZE];
+    char binDir[MAX_PATH_SIZE];
+    int inotifyFD;
+    std::thread thread;
+    std::atomic<bool> stop;
+
+    // At most one pending reload per shader stage; a newer reload of the same stage replaces the older one.
+    std::mutex pendingReloadsMutex;
+    Buffer<ShaderReload> pendingReloads;
+    size_t pendingReloadCount;
+};
+
+struct PhysicalDeviceScore
+{
+    bool eligible;
+    uint32_t typeScore;
+    uint32_t memoryScore;
+    uint32_t limitsScore;
+    uint32_t queueScore;
+    uint32_t extensionScore;
+    uint32_t total;
+};
 
-    VkQueue queues[(size_t)Families::COUNT];
-    uint32_t familyIndexes[(size_t)Families::COUNT];
+// Present modes a GFXPresentPolicy prefers, most preferred first.
+struct PreferredPresentModes
+{
+    VkPresentModeKHR modes[MAX_PREFERRED_PRESENT_MODE_COUNT];
+    size_t count;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -110,6 +188,44 @@ getExtensionName(const VkExtensionProperties * extensionProps)
     return extensionProps->extensionName;
 }
 
+// Takes ownership of spareBuffer if it has the requested count, otherwise frees it and creates a new buffer.
+template<typename Type>
+static Buffer<Type>
+takeSpareBuffer(Buffer<Type> * spareBuffer, size_t count)
+{
+    Buffer<Type> buffer = *spareBuffer;
+    *spareBuffer = {};
+
+    if(buffer.count != count)
+    {
+        if(buffer.count > 0)
+        {
+            bufferFree(&buffer);
+        }
+
+        buffer = bufferCreate<Type>(count);
+    }
+
+    return buffer;
+}
+
+// Keeps buffer as spareBuffer for a later takeSpareBuffer() if there isn't one already, otherwise frees it.
+template<typename Type>
+static void
+keepSpareBuffer(Buffer<Type> * spareBuffer, Buffer<Type> * buffer)
+{
+    if(spareBuffer->count == 0)
+    {
+        *spareBuffer = *buffer;
+    }
+    else
+    {
+        bufferFree(buffer);
+    }
+
+    *buffer = {};
+}
+
 template<typename ComponentProps>
 static void
 validateInstanceComponentInfo(const InstanceComponentInfo<ComponentProps> * componentInfo)
@@ -230,30 +346,187 @@ createInstance(const GFXConfig * config)
 }
 
 static bool
-supportsSwapchain(VkPhysicalDevice physicalDevice)
+supportsExtension(const Buffer<VkExtensionProperties> * availableExtensionProps, const char * extensionName)
+{
+    for(size_t i = 0; i < availableExtensionProps->count; i++)
+    {
+        if(strcmp(availableExtensionProps->data[i].extensionName, extensionName) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool
+supportsSurface(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
+{
+    // Only the counts are needed; full swapchain info is queried for the selected physical-device only.
+    uint32_t surfaceFormatCount = 0;
+    uint32_t surfacePresentModeCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, nullptr);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &surfacePresentModeCount, nullptr);
+    return surfaceFormatCount > 0 && surfacePresentModeCount > 0;
+}
+
+static PhysicalDeviceScore
+scorePhysicalDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
 {
-    bool result = false;
+    // Device type dominates the score so a discrete GPU is always preferred over an integrated GPU sharing system
+    // memory, which in turn is preferred over a CPU implementation.
+    static const uint32_t TYPE_SCORES[]
+    {
+        0,     // VK_PHYSICAL_DEVICE_TYPE_OTHER
+        5000,  // VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU
+        10000, // VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU
+        2500,  // VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU
+        500,   // VK_PHYSICAL_DEVICE_TYPE_CPU
+    };
+
+    // Optional extensions that aren't required but let prism take faster paths when present.
+    static const char * OPTIONAL_EXTENSION_NAMES[]
+    {
+        "VK_KHR_dedicated_allocation",
+        "VK_KHR_get_memory_requirements2",
+        "VK_KHR_maintenance1",
+        "VK_EXT_memory_budget",
+    };
+
+    static const size_t OPTIONAL_EXTENSION_COUNT = sizeof(OPTIONAL_EXTENSION_NAMES) / sizeof(void *);
+    static const uint32_t OPTIONAL_EXTENSION_SCORE = 100;
+    static const uint32_t MEMORY_SCORE_PER_GIB = 100;
+    static const uint32_t MAX_MEMORY_SCORE = 2400;
+    static const uint32_t DEDICATED_TRANSFER_QUEUE_SCORE = 300;
+    static const uint32_t ASYNC_COMPUTE_QUEUE_SCORE = 300;
+    static const uint32_t GRAPHICS_PRESENT_QUEUE_SCORE = 200;
+    static const VkDeviceSize GIB = 1024 * 1024 * 1024;
+
+    PhysicalDeviceScore score = {};
+    VkPhysicalDeviceProperties physicalDeviceProps = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProps);
 
     auto availableExtensionProps =
         createVulkanBuffer(vkEnumerateDeviceExtensionProperties, physicalDevice, (const char *)nullptr);
 
-    if(availableExtensionProps.count > 0)
+    auto queueFamilyPropsArray = createVulkanBuffer(vkGetPhysicalDeviceQueueFamilyProperties, physicalDevice);
+
+    // Check queue-family layout; a graphics queue-family is required, and a present-capable queue-family is required
+    // when rendering to a surface.
+    bool hasGraphicsQueueFamily = false;
+    bool hasPresentQueueFamily = false;
+    bool graphicsQueueFamilyPresents = false;
+    bool hasDedicatedTransferQueueFamily = false;
+    bool hasAsyncComputeQueueFamily = false;
+
+    for(uint32_t queueFamilyIndex = 0; queueFamilyIndex < queueFamilyPropsArray.count; queueFamilyIndex++)
     {
-        // Check for swapchain extension.
-        for(size_t i = 0; i < availableExtensionProps.count; i++)
+        const VkQueueFamilyProperties * queueFamilyProps = queueFamilyPropsArray.data + queueFamilyIndex;
+        VkQueueFlags queueFlags = queueFamilyProps->queueFlags;
+
+        if(queueFamilyProps->queueCount == 0)
         {
-            if(strcmp(availableExtensionProps.data[i].extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
-            {
-                result = true;
-                break;
-            }
+            continue;
+        }
+
+        bool isGraphicsQueueFamily = queueFlags & VK_QUEUE_GRAPHICS_BIT;
+        VkBool32 isPresentQueueFamily = VK_FALSE;
+
+        if(surface != VK_NULL_HANDLE)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamilyIndex, surface, &isPresentQueueFamily);
+        }
+
+        hasGraphicsQueueFamily |= isGraphicsQueueFamily;
+        hasPresentQueueFamily |= isPresentQueueFamily == VK_TRUE;
+        graphicsQueueFamilyPresents |= isGraphicsQueueFamily && isPresentQueueFamily == VK_TRUE;
+
+        if(!isGraphicsQueueFamily && (queueFlags & VK_QUEUE_COMPUTE_BIT))
+        {
+            hasAsyncComputeQueueFamily = true;
+        }
+        else if(!isGraphicsQueueFamily && (queueFlags & VK_QUEUE_TRANSFER_BIT))
+        {
+            hasDedicatedTransferQueueFamily = true;
+        }
+    }
+
+    // Check requirements.
+    score.eligible = hasGraphicsQueueFamily;
+
+    if(surface != VK_NULL_HANDLE)
+    {
+        score.eligible = score.eligible
+            && hasPresentQueueFamily
+            && supportsExtension(&availableExtensionProps, VK_KHR_SWAPCHAIN_EXTENSION_NAME)
+            && supportsSurface(physicalDevice, surface);
+    }
+
+    // Score device type.
+    size_t deviceTypeIndex = (size_t)physicalDeviceProps.deviceType;
+    score.typeScore = deviceTypeIndex < sizeof(TYPE_SCORES) / sizeof(uint32_t) ? TYPE_SCORES[deviceTypeIndex] : 0;
+
+    // Score size of largest device-local heap.
+    VkPhysicalDeviceMemoryProperties memoryProps = {};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProps);
+    VkDeviceSize deviceLocalHeapSize = 0;
+
+    for(uint32_t i = 0; i < memoryProps.memoryHeapCount; i++)
+    {
+        const VkMemoryHeap * memoryHeap = memoryProps.memoryHeaps + i;
+
+        if((memoryHeap->flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && memoryHeap->size > deviceLocalHeapSize)
+        {
+            deviceLocalHeapSize = memoryHeap->size;
+        }
+    }
+
+    score.memoryScore = (uint32_t)(deviceLocalHeapSize * MEMORY_SCORE_PER_GIB / GIB);
+
+    if(score.memoryScore > MAX_MEMORY_SCORE)
+    {
+        score.memoryScore = MAX_MEMORY_SCORE;
+    }
+
+    // Score limits; these only break ties between otherwise similar devices.
+    const VkPhysicalDeviceLimits * limits = &physicalDeviceProps.limits;
+    score.limitsScore = limits->maxImageDimension2D / 1024
+                        + limits->maxComputeWorkGroupInvocations / 128
+                        + limits->maxBoundDescriptorSets;
+
+    // Score queue-family layout.
+    if(hasDedicatedTransferQueueFamily)
+    {
+        score.queueScore += DEDICATED_TRANSFER_QUEUE_SCORE;
+    }
+
+    if(hasAsyncComputeQueueFamily)
+    {
+        score.queueScore += ASYNC_COMPUTE_QUEUE_SCORE;
+    }
+
+    // A graphics queue-family that can also present avoids concurrent sharing of swapchain images.
+    if(graphicsQueueFamilyPresents)
+    {
+        score.queueScore += GRAPHICS_PRESENT_QUEUE_SCORE;
+    }
+
+    // Score optional extensions.
+    for(size_t i = 0; i < OPTIONAL_EXTENSION_COUNT; i++)
+    {
+        if(supportsExtension(&availableExtensionProps, OPTIONAL_EXTENSION_NAMES[i]))
+        {
+            score.extensionScore += OPTIONAL_EXTENSION_SCORE;
         }
     }
 
+    score.total = score.typeScore + score.memoryScore + score.limitsScore + score.queueScore + score.extensionScore;
+
     // Cleanup
     bufferFree(&availableExtensionProps);
+    bufferFree(&queueFamilyPropsArray);
 
-    return result;
+    return score;
 }
 
 static void
@@ -276,7 +549,8 @@ getSwapchainInfo(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, Swapchai
 }
 
 static VkPhysicalDevice
-getPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, SwapchainInfo * swapchainInfo)
+getPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, const char * physicalDeviceOverride,
+                  SwapchainInfo * swapchainInfo)
 {
     // Query available physical-devices.
     auto availablePhysicalDevices = createVulkanBuffer(vkEnumeratePhysicalDevices, instance);
@@ -286,49 +560,60 @@ getPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, SwapchainInfo * swa
         utilErrorExit("VULKAN", nullptr, "no physical-devices found\n");
     }
 
-#ifdef PRISM_DEBUG
-    logAvailablePhysicalDevices(&availablePhysicalDevices);
-#endif
-
-    // Find a suitable physical-device for rendering and store handle in context.
-    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    // Score all available physical-devices.
+    auto physicalDeviceScores = bufferCreate<PhysicalDeviceScore>(availablePhysicalDevices.count);
 
     for(size_t i = 0; i < availablePhysicalDevices.count; i++)
     {
-        VkPhysicalDevice availablePhysicalDevice = availablePhysicalDevices.data[i];
-        VkPhysicalDeviceProperties availablePhysicalDeviceProperties = {};
-        vkGetPhysicalDeviceProperties(availablePhysicalDevice, &availablePhysicalDeviceProperties);
+        physicalDeviceScores.data[i] = scorePhysicalDevice(availablePhysicalDevices.data[i], surface);
+    }
 
-        // Not currently needed.
-        // VkPhysicalDeviceFeatures deviceFeatures;
-        // vkGetPhysicalDeviceFeatures(availablePhysicalDevice, &deviceFeatures);
+#ifdef PRISM_DEBUG
+    logAvailablePhysicalDevices(&availablePhysicalDevices, &physicalDeviceScores);
+#endif
 
-        // TODO: implement robust physical-device requirements specification.
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 
-        // Ensure physical-device is a discrete GPUs.
-        if(availablePhysicalDeviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+    // If config overrides selection, use the first eligible physical-device whose name contains the override string.
+    if(physicalDeviceOverride != nullptr && physicalDeviceOverride[0] != '\0')
+    {
+        for(size_t i = 0; i < availablePhysicalDevices.count; i++)
         {
-            continue;
+            VkPhysicalDevice availablePhysicalDevice = availablePhysicalDevices.data[i];
+            VkPhysicalDeviceProperties availablePhysicalDeviceProperties = {};
+            vkGetPhysicalDeviceProperties(availablePhysicalDevice, &availablePhysicalDeviceProperties);
+
+            if(physicalDeviceScores.data[i].eligible
+                && strstr(availablePhysicalDeviceProperties.deviceName, physicalDeviceOverride) != nullptr)
+            {
+                physicalDevice = availablePhysicalDevice;
+                break;
+            }
         }
 
-        // Ensure physical-device supports swapchain.
-        if(!supportsSwapchain(availablePhysicalDevice))
+        if(physicalDevice == VK_NULL_HANDLE)
         {
-            continue;
+            utilWarning("VULKAN", "no eligible physical-device matches override '%s', selecting by score\n",
+                        physicalDeviceOverride);
         }
+    }
 
-        // Ensure physical-device swapchain meets requirements.
-        getSwapchainInfo(availablePhysicalDevice, surface, swapchainInfo);
+    // Otherwise, select the eligible physical-device with the highest score.
+    if(physicalDevice == VK_NULL_HANDLE)
+    {
+        uint32_t highestScore = 0;
 
-        if(swapchainInfo->availableSurfaceFormats.count == 0
-            || swapchainInfo->availableSurfacePresentModes.count == 0)
+        for(size_t i = 0; i < availablePhysicalDevices.count; i++)
         {
-            continue;
-        }
+            const PhysicalDeviceScore * physicalDeviceScore = physicalDeviceScores.data + i;
 
-        // Physical-device meets all requirements.
-        physicalDevice = availablePhysicalDevice;
-        break;
+            if(physicalDeviceScore->eligible
+                && (physicalDevice == VK_NULL_HANDLE || physicalDeviceScore->total > highestScore))
+            {
+                physicalDevice = availablePhysicalDevices.data[i];
+                highestScore = physicalDeviceScore->total;
+            }
+        }
     }
 
     if(physicalDevice == VK_NULL_HANDLE)
@@ -336,8 +621,19 @@ getPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, SwapchainInfo * swa
         utilErrorExit("VULKAN", nullptr, "failed to find a physical-device that meets requirements\n");
     }
 
+#ifdef PRISM_DEBUG
+    logSelectedPhysicalDevice(physicalDevice);
+#endif
+
+    // Get swapchain info for selected physical-device.
+    if(surface != VK_NULL_HANDLE)
+    {
+        getSwapchainInfo(physicalDevice, surface, swapchainInfo);
+    }
+
     // Cleanup
     bufferFree(&availablePhysicalDevices);
+    bufferFree(&physicalDeviceScores);
 
     return physicalDevice;
 }
@@ -369,8 +665,13 @@ getQueueFamilyIndexes(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, Que
             graphicsQueueFamilyIndex = queueFamilyIndex;
         }
 
-        // Check for present-capable queue-family.
-        if(presentQueueFamilyIndex == -1)
+        // Check for present-capable queue-family. Without a surface there is nothing to present to, so the graphics
+        // queue-family is used as the present queue-family.
+        if(surface == VK_NULL_HANDLE)
+        {
+            presentQueueFamilyIndex = graphicsQueueFamilyIndex;
+        }
+        else if(presentQueueFamilyIndex == -1)
         {
             VkBool32 isPresentQueueFamily = VK_FALSE;
             vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamilyIndex, surface, &isPresentQueueFamily);
@@ -398,8 +699,57 @@ getQueueFamilyIndexes(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, Que
         utilErrorExit("VULKAN", nullptr, "failed to find present queue-family for selected physical-device\n");
     }
 
+    // Prefer a transfer-only queue-family (typically a dedicated copy engine) for uploads, then any non-graphics
+    // queue-family that supports transfers. Graphics queue-families always support transfers, so fall back to the
+    // graphics queue-family.
+    int transferQueueFamilyIndex = graphicsQueueFamilyIndex;
+    VkQueueFlags transferQueueFamilyFlags = VK_QUEUE_GRAPHICS_BIT;
+
+    for(size_t queueFamilyIndex = 0; queueFamilyIndex < queueFamilyPropsArray.count; queueFamilyIndex++)
+    {
+        const VkQueueFamilyProperties * queueFamilyProps = queueFamilyPropsArray.data + queueFamilyIndex;
+        VkQueueFlags queueFlags = queueFamilyProps->queueFlags;
+
+        if(queueFamilyProps->queueCount == 0
+            || !(queueFlags & VK_QUEUE_TRANSFER_BIT)
+            || (queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            continue;
+        }
+
+        if(!(queueFlags & VK_QUEUE_COMPUTE_BIT))
+        {
+            transferQueueFamilyIndex = queueFamilyIndex;
+            break;
+        }
+
+        if(transferQueueFamilyFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            transferQueueFamilyIndex = queueFamilyIndex;
+            transferQueueFamilyFlags = queueFlags;
+        }
+    }
+
+    // Prefer a compute queue-family without graphics support for async compute.
+    int computeQueueFamilyIndex = graphicsQueueFamilyIndex;
+
+    for(size_t queueFamilyIndex = 0; queueFamilyIndex < queueFamilyPropsArray.count; queueFamilyIndex++)
+    {
+        const VkQueueFamilyProperties * queueFamilyProps = queueFamilyPropsArray.data + queueFamilyIndex;
+
+        if(queueFamilyProps->queueCount > 0
+            && (queueFamilyProps->queueFlags & VK_QUEUE_COMPUTE_BIT)
+            && !(queueFamilyProps->queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            computeQueueFamilyIndex = queueFamilyIndex;
+            break;
+        }
+    }
+
     queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)] = graphicsQueueFamilyIndex;
     queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(PRESENT)] = presentQueueFamilyIndex;
+    queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(TRANSFER)] = transferQueueFamilyIndex;
+    queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(COMPUTE)] = computeQueueFamilyIndex;
 
 #ifdef PRISM_DEBUG
     logQueueFamilies(&queueFamilyPropsArray);
@@ -410,7 +760,8 @@ getQueueFamilyIndexes(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, Que
 }
 
 static VkLogicalDevice
-createLogicalDevice(VkPhysicalDevice physicalDevice, const QueueInfo * queueInfo)
+createLogicalDevice(VkPhysicalDevice physicalDevice, const QueueInfo * queueInfo, bool enableSwapchain,
+                    VkPhysicalDeviceFeatures * enabledFeatures)
 {
     // Initialize queue creation info for all queueInfo to be used with the logical-device.
     static const uint32_t QUEUE_FAMILY_QUEUE_COUNT = 1; // More than 1 queue is unnecessary per queue-family.
@@ -463,7 +814,8 @@ createLogicalDevice(VkPhysicalDevice physicalDevice, const QueueInfo * queueInfo
         logicalDeviceQueueCreateInfo->pQueuePriorities = &QUEUE_FAMILY_QUEUE_PRIORITY;
     }
 
-    // Set enabled physical-device features (empty for now).
+    // Enable the optional physical-device features that are supported: instanced draws are batched into one indirect
+    // draw when multiDrawIndirect and drawIndirectFirstInstance are available.
 
     // typedef struct VkPhysicalDeviceFeatures {
     //     VkBool32    robustBufferAccess;
@@ -522,16 +874,25 @@ createLogicalDevice(VkPhysicalDevice physicalDevice, const QueueInfo * queueInfo
     //     VkBool32    variableMultisampleRate;
     //     VkBool32    inheritedQueries;
     // } VkPhysicalDeviceFeatures;
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
     VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
+    physicalDeviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    physicalDeviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    *enabledFeatures = physicalDeviceFeatures;
 
     // Initialize logical-device creation info.
 
-    // Must have swapchain extension enabled so swapchains can be created.
+    // Must have swapchain extension enabled so swapchains can be created. Headless devices don't need it, and software
+    // implementations without a window-system may not expose it.
     static const char * LOGICAL_DEVICE_EXTENSION_NAMES[]
     {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
     };
 
+    static const uint32_t LOGICAL_DEVICE_EXTENSION_COUNT = sizeof(LOGICAL_DEVICE_EXTENSION_NAMES) / sizeof(void *);
+    uint32_t logicalDeviceExtensionCount = enableSwapchain ? LOGICAL_DEVICE_EXTENSION_COUNT : 0;
+
     // typedef struct VkDeviceCreateInfo {
     //     VkStructureType                    sType;
     //     const void*                        pNext;
@@ -552,7 +913,7 @@ createLogicalDevice(VkPhysicalDevice physicalDevice, const QueueInfo * queueInfo
     logicalDeviceCreateInfo.pQueueCreateInfos = logicalDeviceQueueCreateInfos;
     logicalDeviceCreateInfo.enabledLayerCount = 0; // DEPRECATED
     logicalDeviceCreateInfo.ppEnabledLayerNames = nullptr; // DEPRECATED
-    logicalDeviceCreateInfo.enabledExtensionCount = sizeof(LOGICAL_DEVICE_EXTENSION_NAMES) / sizeof(void *);
+    logicalDeviceCreateInfo.enabledExtensionCount = logicalDeviceExtensionCount;
     logicalDeviceCreateInfo.ppEnabledExtensionNames = LOGICAL_DEVICE_EXTENSION_NAMES;
     logicalDeviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
 
@@ -582,8 +943,11 @@ getQueues(VkLogicalDevice logicalDevice, QueueInfo * queueInfo)
 }
 
 static void
-createSwapchainConfig(const SwapchainInfo * swapchainInfo, SwapchainConfig * swapchainConfig)
+createSwapchainConfig(const SwapchainInfo * swapchainInfo, GFXPresentPolicy presentPolicy,
+                      uint32_t requestedImageCount, SwapchainConfig * swapchainConfig)
 {
+    PRISM_ASSERT(presentPolicy < GFXPresentPolicy::COUNT);
+
     // Select best surface format for swapchain.
     static const VkSurfaceFormatKHR PREFERRED_SURFACE_FORMAT
     {
@@ -617,28 +981,56 @@ createSwapchainConfig(const SwapchainInfo * swapchainInfo, SwapchainConfig * swa
         }
     }
 
-    // Select best surface present mode for swapchain.
-    static const VkPresentModeKHR PREFERRED_PRESENT_MODE = VK_PRESENT_MODE_MAILBOX_KHR;
+    // Select surface present mode for swapchain by policy. Present modes are listed in order of preference, with
+    // FIFO_RELAXED preferred over FIFO where tearing is acceptable since it avoids a stall when a frame is late.
+    static const PreferredPresentModes POLICY_PRESENT_MODES[(size_t)GFXPresentPolicy::COUNT]
+    {
+        // LOW_LATENCY
+        {
+            {
+                VK_PRESENT_MODE_MAILBOX_KHR,
+                VK_PRESENT_MODE_IMMEDIATE_KHR,
+                VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+            },
+            3,
+        },
+
+        // THROUGHPUT
+        {
+            {
+                VK_PRESENT_MODE_IMMEDIATE_KHR,
+                VK_PRESENT_MODE_MAILBOX_KHR,
+                VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+            },
+            3,
+        },
+
+        // POWER_SAVING
+        {
+            {
+                VK_PRESENT_MODE_FIFO_KHR,
+            },
+            1,
+        },
+    };
+
+    const PreferredPresentModes * preferredPresentModes = POLICY_PRESENT_MODES + (size_t)presentPolicy;
     const Buffer<VkPresentModeKHR> * availableSurfacePresentModes = &swapchainInfo->availableSurfacePresentModes;
 
-    // FIFO is guaranteed to be available, so use it as a fallback in-case the preferred mode isn't found.
+    // FIFO is guaranteed to be available, so use it as a fallback in-case no preferred mode is found.
     VkPresentModeKHR selectedSurfacePresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    bool presentModeFound = false;
 
-    for(size_t i = 0; i < availableSurfacePresentModes->count; i++)
+    for(size_t i = 0; i < preferredPresentModes->count && !presentModeFound; i++)
     {
-        VkPresentModeKHR availableSurfacePresentMode = availableSurfacePresentModes->data[i];
-
-        // Select preferred present mode if available.
-        if(availableSurfacePresentMode == PREFERRED_PRESENT_MODE)
+        for(size_t j = 0; j < availableSurfacePresentModes->count; j++)
         {
-            selectedSurfacePresentMode = PREFERRED_PRESENT_MODE;
-            break;
-        }
-        // Some drivers don't support FIFO properly, so if immediate mode is available, use that as the fallback in-case
-        // the preferred mode isn't found.
-        else if(availableSurfacePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-        {
-            selectedSurfacePresentMode = availableSurfacePresentMode;
+            if(availableSurfacePresentModes->data[j] == preferredPresentModes->modes[i])
+            {
+                selectedSurfacePresentMode = preferredPresentModes->modes[i];
+                presentModeFound = true;
+                break;
+            }
         }
     }
 
@@ -648,22 +1040,43 @@ createSwapchainConfig(const SwapchainInfo * swapchainInfo, SwapchainConfig * swa
 
     // TODO: add support for other extents.
 
-    // Select best image count for swapchain.
-    static const uint32_t MIN_PREFERRED_IMAGE_COUNT = 1;
-    uint32_t selectedImageCount = surfaceCapabilities->minImageCount + MIN_PREFERRED_IMAGE_COUNT;
+    // Select image count for swapchain. By default an extra image is used so rendering never waits on the
+    // presentation engine to release one, except when saving power, where waiting is preferred.
+    uint32_t minImageCount = surfaceCapabilities->minImageCount;
     uint32_t maxImageCount = surfaceCapabilities->maxImageCount;
+    uint32_t selectedImageCount = requestedImageCount;
+
+    if(selectedImageCount == 0)
+    {
+        selectedImageCount = presentPolicy == GFXPresentPolicy::POWER_SAVING ? minImageCount : minImageCount + 1;
+    }
+    else if(selectedImageCount < minImageCount || (maxImageCount > 0 && selectedImageCount > maxImageCount))
+    {
+        utilWarning("VULKAN", "requested swapchain image count %u is outside of supported range %u-%u; clamping\n",
+                    requestedImageCount, minImageCount, maxImageCount);
+    }
+
+    if(selectedImageCount < minImageCount)
+    {
+        selectedImageCount = minImageCount;
+    }
 
+    // A maxImageCount of 0 means there is no limit.
     if(maxImageCount > 0 && selectedImageCount > maxImageCount)
     {
         selectedImageCount = maxImageCount;
     }
 
+    swapchainConfig->presentPolicy = presentPolicy;
     swapchainConfig->surfaceFormat = selectedSurfaceFormat;
     swapchainConfig->surfacePresentMode = selectedSurfacePresentMode;
     swapchainConfig->extent = selectedExtent;
     swapchainConfig->imageCount = selectedImageCount;
     swapchainConfig->currentTransform = surfaceCapabilities->currentTransform;
 
+    VkImageUsageFlags transferUsage = surfaceCapabilities->supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    swapchainConfig->imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | transferUsage;
+
 #ifdef PRISM_DEBUG
     logSelectedSwapchainConfig(swapchainConfig, swapchainInfo);
 #endif
@@ -671,7 +1084,7 @@ createSwapchainConfig(const SwapchainInfo * swapchainInfo, SwapchainConfig * swa
 
 static VkSwapchainKHR
 createSwapchain(VkSurfaceKHR surface, VkLogicalDevice logicalDevice, const QueueInfo * queueInfo,
-                const SwapchainConfig * swapchainConfig)
+                const SwapchainConfig * swapchainConfig, VkSwapchainKHR oldSwapchain)
 {
     // Initialize swapchain creation info.
     const VkSurfaceFormatKHR * surfaceFormat = &swapchainConfig->surfaceFormat;
@@ -706,13 +1119,14 @@ createSwapchain(VkSurfaceKHR surface, VkLogicalDevice logicalDevice, const Queue
     swapchainCreateInfo.imageColorSpace = surfaceFormat->colorSpace;
     swapchainCreateInfo.imageExtent = swapchainConfig->extent;
     swapchainCreateInfo.imageArrayLayers = 1; // Always 1 for non-stereoscopic-3D applications.
-    swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swapchainCreateInfo.imageUsage = swapchainConfig->imageUsage;
 
-    // If queue-family indexes are unique, use concurrent sharing mode. Otherwise, use exclusive sharing mode.
+    // If queue-family indexes are unique, use concurrent sharing mode. Otherwise, use exclusive sharing mode. Only the
+    // graphics and present queue-families (the first two) use swapchain images.
     if(queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)] != queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(PRESENT)])
     {
         swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        swapchainCreateInfo.queueFamilyIndexCount = QUEUE_FAMILY_COUNT;
+        swapchainCreateInfo.queueFamilyIndexCount = QUEUE_FAMILY_INDEX(PRESENT) + 1;
         swapchainCreateInfo.pQueueFamilyIndices = queueInfo->familyIndexes;
     }
     else
@@ -726,7 +1140,10 @@ createSwapchain(VkSurfaceKHR surface, VkLogicalDevice logicalDevice, const Queue
     swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchainCreateInfo.presentMode = swapchainConfig->surfacePresentMode;
     swapchainCreateInfo.clipped = VK_TRUE; // Ignore obscured pixels for better performance.
-    swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+
+    // Handing over the swapchain being replaced lets the driver reuse its resources, and lets presentation continue
+    // from it until the new swapchain's first present.
+    swapchainCreateInfo.oldSwapchain = oldSwapchain;
 
     // Create swapchain.
     VkSwapchainKHR swapchain;
@@ -740,23 +1157,37 @@ createSwapchain(VkSurfaceKHR surface, VkLogicalDevice logicalDevice, const Queue
     return swapchain;
 }
 
-static Buffer<VkImage>
-getSwapchainImages(VkLogicalDevice logicalDevice, VkSwapchainKHR swapchain)
+static void
+getSwapchainImages(VkLogicalDevice logicalDevice, VkSwapchainKHR swapchain, Buffer<VkImage> * swapchainImages)
 {
-    auto swapchainImages = createVulkanBuffer(vkGetSwapchainImagesKHR, logicalDevice, swapchain);
+    uint32_t swapchainImageCount = 0;
+    vkGetSwapchainImagesKHR(logicalDevice, swapchain, &swapchainImageCount, nullptr);
 
-    if(swapchainImages.count == 0)
+    if(swapchainImageCount == 0)
     {
         utilErrorExit("VULKAN", nullptr, "failed to get swapchain images\n");
     }
 
-    return swapchainImages;
+    // When recreating a swapchain the image count rarely changes, so the existing buffer can usually be refilled.
+    if(swapchainImages->count != swapchainImageCount)
+    {
+        if(swapchainImages->count > 0)
+        {
+            bufferFree(swapchainImages);
+        }
+
+        *swapchainImages = bufferCreate<VkImage>(swapchainImageCount);
+    }
+
+    vkGetSwapchainImagesKHR(logicalDevice, swapchain, &swapchainImageCount, swapchainImages->data);
 }
 
-static Buffer<VkImageView>
+static void
 createSwapchainImageViews(VkLogicalDevice logicalDevice, const Buffer<VkImage> * swapchainImages,
-                          const SwapchainConfig * swapchainConfig)
+                          const SwapchainConfig * swapchainConfig, Buffer<VkImageView> * swapchainImageViews)
 {
+    PRISM_ASSERT(swapchainImageViews->count == swapchainImages->count);
+
     // typedef struct VkComponentMapping {
     //     VkComponentSwizzle    r;
     //     VkComponentSwizzle    g;
@@ -787,8 +1218,6 @@ createSwapchainImageViews(VkLogicalDevice logicalDevice, const Buffer<VkImage> *
         1,
     };
 
-    auto swapchainImageViews = bufferCreate<VkImageView>(swapchainImages->count);
-
     for(size_t i = 0; i < swapchainImages->count; i++)
     {
         // typedef struct VkImageViewCreateInfo {
@@ -812,46 +1241,149 @@ createSwapchainImageViews(VkLogicalDevice logicalDevice, const Buffer<VkImage> *
         imageViewCreateInfo.subresourceRange = DEFAULT_IMAGE_SUBRESOURCE_RANGE;
 
         // Create image view from image.
-        VkResult result = vkCreateImageView(logicalDevice, &imageViewCreateInfo, nullptr, swapchainImageViews.data + i);
+        VkResult result =
+            vkCreateImageView(logicalDevice, &imageViewCreateInfo, nullptr, swapchainImageViews->data + i);
 
         if(result != VK_SUCCESS)
         {
             utilErrorExit("VULKAN", getVkResultName(result), "failed to create image view\n");
         }
     }
-
-    return swapchainImageViews;
 }
 
-static Buffer<uint8_t>
-readShader(const char * path)
+static void
+createOffscreenConfig(const GFXConfig * config, uint32_t framesInFlight, SwapchainConfig * swapchainConfig)
 {
-    FILE * file = fopen(path, "rb");
+    // Offscreen images mirror the swapchain's preferred format so everything downstream of image creation is shared.
+    static const VkSurfaceFormatKHR OFFSCREEN_SURFACE_FORMAT
+    {
+        VK_FORMAT_B8G8R8A8_UNORM,
+        VK_COLOR_SPACE_SRGB_NONLINEAR_KHR,
+    };
 
-    if(file == nullptr)
+    // Same count a swapchain would use by default, so frame pacing behaves the same with and without a window.
+    static const uint32_t DEFAULT_OFFSCREEN_IMAGE_COUNT = 3;
+
+    // Every frame in flight needs its own image to render to, since there's no presentation engine to hand them back.
+    uint32_t imageCount = config->swapchainImageCount > 0 ? config->swapchainImageCount : DEFAULT_OFFSCREEN_IMAGE_COUNT;
+
+    if(imageCount < framesInFlight)
     {
-        utilErrorExit("VULKAN", nullptr, "failed to open file '%s'\n", path);
+        imageCount = framesInFlight;
     }
 
-    // Get file length.
-    fseek(file, 0, SEEK_END);
-    size_t fileLength = ftell(file);
-    rewind(file);
+    PRISM_ASSERT(config->headlessExtent.width > 0);
+    PRISM_ASSERT(config->headlessExtent.height > 0);
+    swapchainConfig->surfaceFormat = OFFSCREEN_SURFACE_FORMAT;
+    swapchainConfig->surfacePresentMode = VK_PRESENT_MODE_FIFO_KHR; // Unused without a swapchain.
+    swapchainConfig->extent = config->headlessExtent;
+    swapchainConfig->imageCount = imageCount;
+    swapchainConfig->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    swapchainConfig->imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+#ifdef PRISM_DEBUG
+    logOffscreenConfig(swapchainConfig);
+#endif
+}
+
+static Buffer<VkImage>
+createOffscreenImages(MEMAllocator * allocator, VkLogicalDevice logicalDevice, const SwapchainConfig * swapchainConfig,
+                      Buffer<MEMAllocation> * offscreenImageMemory)
+{
+    auto offscreenImages = bufferCreate<VkImage>(swapchainConfig->imageCount);
+    *offscreenImageMemory = bufferCreate<MEMAllocation>(swapchainConfig->imageCount);
 
-    // Read file into buffer.
-    auto buffer = bufferCreate<uint8_t>(fileLength);
-    fread(buffer.data, fileLength, 1, file);
+    for(size_t i = 0; i < offscreenImages.count; i++)
+    {
+        // typedef struct VkImageCreateInfo {
+        //     VkStructureType          sType;
+        //     const void*              pNext;
+        //     VkImageCreateFlags       flags;
+        //     VkImageType              imageType;
+        //     VkFormat                 format;
+        //     VkExtent3D               extent;
+        //     uint32_t                 mipLevels;
+        //     uint32_t                 arrayLayers;
+        //     VkSampleCountFlagBits    samples;
+        //     VkImageTiling            tiling;
+        //     VkImageUsageFlags        usage;
+        //     VkSharingMode            sharingMode;
+        //     uint32_t                 queueFamilyIndexCount;
+        //     const uint32_t*          pQueueFamilyIndices;
+        //     VkImageLayout            initialLayout;
+        // } VkImageCreateInfo;
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.pNext = nullptr;
+        imageCreateInfo.flags = 0;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = swapchainConfig->surfaceFormat.format;
+        imageCreateInfo.extent = { swapchainConfig->extent.width, swapchainConfig->extent.height, 1 };
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+
+        // Transfer-source usage allows frames to be read back for regression comparisons.
+        imageCreateInfo.usage = swapchainConfig->imageUsage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.queueFamilyIndexCount = 0;
+        imageCreateInfo.pQueueFamilyIndices = nullptr;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkImage * offscreenImage = offscreenImages.data + i;
+        VkResult result = vkCreateImage(logicalDevice, &imageCreateInfo, nullptr, offscreenImage);
 
-    // Cleanup
-    fclose(file);
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create offscreen image\n");
+        }
 
-    return buffer;
+        // Sub-allocate and bind device-local memory for image.
+        VkMemoryRequirements memoryRequirements = {};
+        vkGetImageMemoryRequirements(logicalDevice, *offscreenImage, &memoryRequirements);
+        MEMAllocation * imageMemory = offscreenImageMemory->data + i;
+
+        if(!memAllocate(allocator, MEMStrategy::BUDDY, MEMResourceType::OPTIMAL, &memoryRequirements,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, imageMemory))
+        {
+            utilErrorExit("VULKAN", nullptr, "failed to allocate memory for offscreen image\n");
+        }
+
+        result = vkBindImageMemory(logicalDevice, *offscreenImage, imageMemory->memory, imageMemory->offset);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to bind memory for offscreen image\n");
+        }
+    }
+
+    return offscreenImages;
 }
 
+// Returns VK_NULL_HANDLE with a warning on failure, so hot-reloaded shaders can fail without exiting.
 static VkShaderModule
-createShaderModule(VkLogicalDevice logicalDevice, const char * shaderPath)
+tryCreateShaderModule(VkLogicalDevice logicalDevice, const char * shaderPath)
 {
-    Buffer<uint8_t> shader = readShader(shaderPath);
+    static const uint32_t SPIRV_MAGIC = 0x07230203;
+
+    // SPIR-V is passed to the driver straight from the mapping, which is page-aligned and so satisfies pCode's
+    // alignment.
+    UTILMappedFile shader = {};
+
+    if(!utilMapFile(shaderPath, &shader))
+    {
+        utilWarning("VULKAN", "failed to map shader file '%s'\n", shaderPath);
+        return VK_NULL_HANDLE;
+    }
+
+    if(shader.size % sizeof(uint32_t) != 0 || *(const uint32_t *)shader.data != SPIRV_MAGIC)
+    {
+        utilWarning("VULKAN", "'%s' is not a SPIR-V binary\n", shaderPath);
+        utilUnmapFile(&shader);
+        return VK_NULL_HANDLE;
+    }
 
     // typedef struct VkShaderModuleCreateInfo {
     //     VkStructureType              sType;
@@ -864,7 +1396,7 @@ createShaderModule(VkLogicalDevice logicalDevice, const char * shaderPath)
     shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     shaderModuleCreateInfo.pNext = nullptr;
     shaderModuleCreateInfo.flags = 0; // Reserved for future use.
-    shaderModuleCreateInfo.codeSize = shader.count;
+    shaderModuleCreateInfo.codeSize = shader.size;
     shaderModuleCreateInfo.pCode = (const uint32_t *)shader.data;
 
     VkShaderModule shaderModule = VK_NULL_HANDLE;
@@ -872,125 +1404,3783 @@ createShaderModule(VkLogicalDevice logicalDevice, const char * shaderPath)
 
     if(result != VK_SUCCESS)
     {
-        utilErrorExit("VULKAN", getVkResultName(result), "failed to create shader module from '%s'\n", shaderPath);
+        utilWarning("VULKAN", "vkCreateShaderModule() failed for '%s': %s\n", shaderPath, getVkResultName(result));
+        shaderModule = VK_NULL_HANDLE;
     }
 
     // Cleanup
-    bufferFree(&shader);
+    utilUnmapFile(&shader);
 
     return shaderModule;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//
+static VkShaderModule
+createShaderModule(VkLogicalDevice logicalDevice, const char * shaderPath)
+{
+    VkShaderModule shaderModule = tryCreateShaderModule(logicalDevice, shaderPath);
+
+    if(shaderModule == VK_NULL_HANDLE)
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to create shader module from '%s'\n", shaderPath);
+    }
+
+    return shaderModule;
+}
+
+// FNV-1a; only used to detect truncated or corrupted cache files.
+static uint32_t
+getChecksum(const uint8_t * data, size_t size)
+{
+    uint32_t checksum = 2166136261u;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        checksum = (checksum ^ data[i]) * 16777619u;
+    }
+
+    return checksum;
+}
+
+// Returns the size of file in bytes, or -1 if it can't be determined; the current position is preserved.
+static long
+getFileSize(FILE * file)
+{
+    long position = ftell(file);
+
+    if(position < 0 || fseek(file, 0, SEEK_END) != 0)
+    {
+        return -1;
+    }
+
+    long size = ftell(file);
+
+    if(fseek(file, position, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+
+    return size;
+}
+
+static void
+initPipelineCacheFileHeader(VkPhysicalDevice physicalDevice, PipelineCacheFileHeader * fileHeader)
+{
+    VkPhysicalDeviceProperties physicalDeviceProperties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    memset(fileHeader, 0, sizeof(PipelineCacheFileHeader));
+    fileHeader->magic = PIPELINE_CACHE_FILE_MAGIC;
+    fileHeader->version = PIPELINE_CACHE_FILE_VERSION;
+    fileHeader->vendorID = physicalDeviceProperties.vendorID;
+    fileHeader->deviceID = physicalDeviceProperties.deviceID;
+    fileHeader->driverVersion = physicalDeviceProperties.driverVersion;
+    memcpy(fileHeader->pipelineCacheUUID, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+// Returns the pipeline cache data stored at path, or an empty buffer if there is none or it was created by a different
+// physical-device or driver; a stale cache is never passed to the driver.
+static Buffer<uint8_t>
+loadPipelineCacheData(VkPhysicalDevice physicalDevice, const char * path)
+{
+    Buffer<uint8_t> data = {};
+    FILE * file = fopen(path, "rb");
+
+    // No cache has been saved yet.
+    if(file == nullptr)
+    {
+        return data;
+    }
+
+    PipelineCacheFileHeader expectedFileHeader = {};
+    initPipelineCacheFileHeader(physicalDevice, &expectedFileHeader);
+    PipelineCacheFileHeader fileHeader = {};
+    const char * rejectReason = nullptr;
+    long fileSize = getFileSize(file);
+
+    if(fread(&fileHeader, sizeof(PipelineCacheFileHeader), 1, file) != 1
+        || fileHeader.magic != PIPELINE_CACHE_FILE_MAGIC
+        || fileHeader.version != PIPELINE_CACHE_FILE_VERSION
+        || fileHeader.dataSize < sizeof(PipelineCacheHeader))
+    {
+        rejectReason = "not a valid pipeline cache file";
+    }
+    else if(fileHeader.vendorID != expectedFileHeader.vendorID || fileHeader.deviceID != expectedFileHeader.deviceID)
+    {
+        rejectReason = "created for a different physical-device";
+    }
+    else if(fileHeader.driverVersion != expectedFileHeader.driverVersion
+            || memcmp(fileHeader.pipelineCacheUUID, expectedFileHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        rejectReason = "created by a different driver version";
+    }
+    else if(fileSize < 0 || fileHeader.dataSize > (uint64_t)fileSize - sizeof(PipelineCacheFileHeader))
+    {
+        // Checked before allocating so a corrupted size can't trigger an arbitrarily large allocation.
+        rejectReason = "truncated or corrupted";
+    }
+    else
+    {
+        data = bufferCreate<uint8_t>(fileHeader.dataSize);
+
+        if(fread(data.data, data.count, 1, file) != 1 || getChecksum(data.data, data.count) != fileHeader.dataChecksum)
+        {
+            rejectReason = "truncated or corrupted";
+        }
+        else
+        {
+            // The driver validates its own header too, but reject mismatches before handing it the data.
+            auto cacheHeader = (const PipelineCacheHeader *)data.data;
+
+            if(cacheHeader->headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+                || cacheHeader->vendorID != expectedFileHeader.vendorID
+                || cacheHeader->deviceID != expectedFileHeader.deviceID
+                || memcmp(cacheHeader->pipelineCacheUUID, expectedFileHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+            {
+                rejectReason = "cache data doesn't match file header";
+            }
+        }
+    }
+
+    // Cleanup
+    fclose(file);
+
+    if(rejectReason != nullptr)
+    {
+        utilWarning("VULKAN", "ignoring pipeline cache '%s': %s\n", path, rejectReason);
+
+        if(data.count > 0)
+        {
+            bufferFree(&data);
+        }
+
+        data = {};
+    }
+
+    return data;
+}
+
+static VkPipelineCache
+createPipelineCache(VkLogicalDevice logicalDevice, const Buffer<uint8_t> * initialData)
+{
+    // typedef struct VkPipelineCacheCreateInfo {
+    //     VkStructureType               sType;
+    //     const void*                   pNext;
+    //     VkPipelineCacheCreateFlags    flags;
+    //     size_t                        initialDataSize;
+    //     const void*                   pInitialData;
+    // } VkPipelineCacheCreateInfo;
+    VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+    pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheCreateInfo.pNext = nullptr;
+    pipelineCacheCreateInfo.flags = 0;
+    pipelineCacheCreateInfo.initialDataSize = initialData->count;
+    pipelineCacheCreateInfo.pInitialData = initialData->data;
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    VkResult result = vkCreatePipelineCache(logicalDevice, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+
+    // Initial data is only a hint, so if the driver refuses it fall back to an empty cache.
+    if(result != VK_SUCCESS && initialData->count > 0)
+    {
+        utilWarning("VULKAN", "failed to create pipeline cache from saved data (%s); starting empty\n",
+                    getVkResultName(result));
+
+        pipelineCacheCreateInfo.initialDataSize = 0;
+        pipelineCacheCreateInfo.pInitialData = nullptr;
+        result = vkCreatePipelineCache(logicalDevice, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+    }
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create pipeline cache\n");
+    }
+
+    return pipelineCache;
+}
+
+// Failing to save the cache only costs the next start its warm pipeline compilation, so failures are warnings.
+static void
+savePipelineCache(VkPhysicalDevice physicalDevice, VkLogicalDevice logicalDevice, VkPipelineCache pipelineCache,
+                  const char * path)
+{
+    size_t dataSize = 0;
+    VkResult result = vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, nullptr);
+
+    if(result != VK_SUCCESS || dataSize == 0)
+    {
+        utilWarning("VULKAN", "failed to get pipeline cache data size\n");
+        return;
+    }
+
+    auto data = bufferCreate<uint8_t>(dataSize);
+    result = vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, data.data);
+
+    if(result != VK_SUCCESS)
+    {
+        utilWarning("VULKAN", "failed to get pipeline cache data\n");
+        bufferFree(&data);
+        return;
+    }
+
+    PipelineCacheFileHeader fileHeader = {};
+    initPipelineCacheFileHeader(physicalDevice, &fileHeader);
+    fileHeader.dataSize = dataSize;
+    fileHeader.dataChecksum = getChecksum(data.data, dataSize);
+
+    // Write to a temporary file and rename it over the old cache, so a crash mid-write never leaves a partial cache.
+    static const char TEMP_SUFFIX[] = ".tmp";
+    size_t pathLength = strlen(path);
+    auto tempPath = bufferCreate<char>(pathLength + sizeof(TEMP_SUFFIX));
+    memcpy(tempPath.data, path, pathLength);
+    memcpy(tempPath.data + pathLength, TEMP_SUFFIX, sizeof(TEMP_SUFFIX));
+    FILE * file = fopen(tempPath.data, "wb");
+    bool written = false;
+
+    if(file != nullptr)
+    {
+        written = fwrite(&fileHeader, sizeof(PipelineCacheFileHeader), 1, file) == 1
+                  && fwrite(data.data, dataSize, 1, file) == 1;
+
+        written = fclose(file) == 0 && written;
+    }
+
+    if(!written || rename(tempPath.data, path) != 0)
+    {
+        utilWarning("VULKAN", "failed to save pipeline cache to '%s'\n", path);
+        remove(tempPath.data);
+    }
+
+    // Cleanup
+    bufferFree(&tempPath);
+    bufferFree(&data);
+}
+
+// Indexed by GFXShaderStage; also the file extension of each stage's source and, followed by ".spv", its binary.
+static const char * SHADER_STAGE_NAMES[]
+{
+    "vert",
+    "frag",
+    "comp",
+};
+
+// GFXShader starts with its name, so both shaders and names used as search keys compare as strings.
+static int
+compareShaderNames(const void * a, const void * b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+// Like utilNextListItem(), but copies the item into item as a null-terminated string; items too long for itemSize are
+// fatal.
+static bool
+readListItem(const char ** list, char * item, size_t itemSize, const char * listName)
+{
+    const char * begin = nullptr;
+    size_t size = 0;
+
+    if(!utilNextListItem(list, &begin, &size))
+    {
+        return false;
+    }
+
+    if(size >= itemSize)
+    {
+        utilErrorExit("VULKAN", nullptr, "item \"%.*s\" of %s is too long\n", (int)size, begin, listName);
+    }
+
+    memcpy(item, begin, size);
+    item[size] = '\0';
+
+    return true;
+}
+
+// Creates the modules for every shader listed in the shader library at libraryPath in one pass. The library lists the
+// shaders to create, then each shader's stages as "<stage> <file>" pairs, each stage's SPIR-V binary being
+// "<binDir>/<file>.<stage>.spv":
+//
+//     shaders: tutorial
+//     tutorial: vert tutorial, frag tutorial
+//
+// Shaders are returned sorted by name for gfxGetShader().
+static Buffer<GFXShader>
+createShaderLibrary(VkLogicalDevice logicalDevice, const char * libraryPath, const char * binDir)
+{
+    YAMLNode * library = yamlReadFile(libraryPath);
+    const char * shaderNames = yamlGetString(library, "shaders");
+    char name[GFX_MAX_SHADER_NAME_SIZE] = {};
+    size_t shaderCount = 0;
+
+    for(const char * c = shaderNames; readListItem(&c, name, GFX_MAX_SHADER_NAME_SIZE, "shaders"); )
+    {
+        shaderCount++;
+    }
+
+    auto shaders = bufferCreate<GFXShader>(shaderCount);
+    const char * nextShaderName = shaderNames;
+
+    for(size_t i = 0; i < shaders.count; i++)
+    {
+        GFXShader * shader = shaders.data + i;
+        readListItem(&nextShaderName, shader->name, GFX_MAX_SHADER_NAME_SIZE, "shaders");
+
+        for(size_t stageIndex = 0; stageIndex < (size_t)GFXShaderStage::COUNT; stageIndex++)
+        {
+            shader->modules[stageIndex] = VK_NULL_HANDLE;
+            shader->stageFiles[stageIndex][0] = '\0';
+        }
+
+        // Create a module for each of the shader's stages.
+        const char * stages = yamlGetString(library, shader->name);
+        char stage[GFX_MAX_SHADER_NAME_SIZE + 8] = {};
+
+        while(readListItem(&stages, stage, sizeof(stage), shader->name))
+        {
+            char * stageFile = strchr(stage, ' ');
+
+            if(stageFile == nullptr)
+            {
+                utilErrorExit("VULKAN", nullptr, "stage \"%s\" of shader \"%s\" must be \"<stage> <file>\"\n", stage,
+                              shader->name);
+            }
+
+            *stageFile++ = '\0';
+
+            while(*stageFile == ' ')
+            {
+                stageFile++;
+            }
+
+            size_t stageIndex = 0;
+
+            while(stageIndex < (size_t)GFXShaderStage::COUNT && strcmp(stage, SHADER_STAGE_NAMES[stageIndex]) != 0)
+            {
+                stageIndex++;
+            }
+
+            if(stageIndex == (size_t)GFXShaderStage::COUNT)
+            {
+                utilErrorExit("VULKAN", nullptr, "shader \"%s\" has unknown stage \"%s\"\n", shader->name, stage);
+            }
+
+            if(strlen(stageFile) >= GFX_MAX_SHADER_NAME_SIZE)
+            {
+                utilErrorExit("VULKAN", nullptr, "file name \"%s\" of shader \"%s\" is too long\n", stageFile,
+                              shader->name);
+            }
+
+            strcpy(shader->stageFiles[stageIndex], stageFile);
+            char shaderPath[MAX_PATH_SIZE] = {};
+
+            int shaderPathLength =
+                snprintf(shaderPath, MAX_PATH_SIZE, "%s/%s.%s.spv", binDir, stageFile, stage);
+
+            if(shaderPathLength < 0 || (size_t)shaderPathLength >= MAX_PATH_SIZE)
+            {
+                utilErrorExit("VULKAN", nullptr, "path for stage \"%s\" of shader \"%s\" is too long\n", stage,
+                              shader->name);
+            }
+
+            shader->modules[stageIndex] = createShaderModule(logicalDevice, shaderPath);
+        }
+    }
+
+    // Sort shaders so they can be binary-searched by name.
+    qsort(shaders.data, shaders.count, sizeof(GFXShader), compareShaderNames);
+
+    for(size_t i = 1; i < shaders.count; i++)
+    {
+        if(strcmp(shaders.data[i - 1].name, shaders.data[i].name) == 0)
+        {
+            utilErrorExit("VULKAN", nullptr, "shader \"%s\" is defined more than once\n", shaders.data[i].name);
+        }
+    }
+
+    // Cleanup
+    yamlFree(library);
+
+    return shaders;
+}
+
+// The render target's previous contents are cleared, or with VK_ATTACHMENT_LOAD_OP_LOAD, drawn over; they must then be
+// in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL when the render pass begins.
+static VkRenderPass
+createRenderPass(VkLogicalDevice logicalDevice, const SwapchainConfig * swapchainConfig, VkAttachmentLoadOp loadOp,
+                 VkImageLayout finalLayout)
+{
+    bool load = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+
+    // typedef struct VkAttachmentDescription {
+    //     VkAttachmentDescriptionFlags    flags;
+    //     VkFormat                        format;
+    //     VkSampleCountFlagBits           samples;
+    //     VkAttachmentLoadOp              loadOp;
+    //     VkAttachmentStoreOp             storeOp;
+    //     VkAttachmentLoadOp              stencilLoadOp;
+    //     VkAttachmentStoreOp             stencilStoreOp;
+    //     VkImageLayout                   initialLayout;
+    //     VkImageLayout                   finalLayout;
+    // } VkAttachmentDescription;
+    VkAttachmentDescription colorAttachment = {};
+    colorAttachment.flags = 0;
+    colorAttachment.format = swapchainConfig->surfaceFormat.format;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = loadOp;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = load ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = finalLayout;
+
+    // typedef struct VkAttachmentReference {
+    //     uint32_t         attachment;
+    //     VkImageLayout    layout;
+    // } VkAttachmentReference;
+    VkAttachmentReference colorAttachmentReference = {};
+    colorAttachmentReference.attachment = 0;
+    colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    // typedef struct VkSubpassDescription {
+    //     VkSubpassDescriptionFlags       flags;
+    //     VkPipelineBindPoint             pipelineBindPoint;
+    //     uint32_t                        inputAttachmentCount;
+    //     const VkAttachmentReference*    pInputAttachments;
+    //     uint32_t                        colorAttachmentCount;
+    //     const VkAttachmentReference*    pColorAttachments;
+    //     const VkAttachmentReference*    pResolveAttachments;
+    //     const VkAttachmentReference*    pDepthStencilAttachment;
+    //     uint32_t                        preserveAttachmentCount;
+    //     const uint32_t*                 pPreserveAttachments;
+    // } VkSubpassDescription;
+    VkSubpassDescription subpass = {};
+    subpass.flags = 0;
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = nullptr;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentReference;
+    subpass.pResolveAttachments = nullptr;
+    subpass.pDepthStencilAttachment = nullptr;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = nullptr;
+
+    // The image-acquired semaphore is waited on at the color-attachment-output stage, so the layout transition at the
+    // start of the render pass must wait for that stage too. Loaded contents were written by the frame graph at the
+    // same stage; the dependency is the same for both load ops so the render passes stay compatible.
+
+    // typedef struct VkSubpassDependency {
+    //     uint32_t                srcSubpass;
+    //     uint32_t                dstSubpass;
+    //     VkPipelineStageFlags    srcStageMask;
+    //     VkPipelineStageFlags    dstStageMask;
+    //     VkAccessFlags           srcAccessMask;
+    //     VkAccessFlags           dstAccessMask;
+    //     VkDependencyFlags       dependencyFlags;
+    // } VkSubpassDependency;
+    VkSubpassDependency subpassDependency = {};
+    subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    subpassDependency.dstSubpass = 0;
+    subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependency.dependencyFlags = 0;
+
+    // typedef struct VkRenderPassCreateInfo {
+    //     VkStructureType                   sType;
+    //     const void*                       pNext;
+    //     VkRenderPassCreateFlags           flags;
+    //     uint32_t                          attachmentCount;
+    //     const VkAttachmentDescription*    pAttachments;
+    //     uint32_t                          subpassCount;
+    //     const VkSubpassDescription*       pSubpasses;
+    //     uint32_t                          dependencyCount;
+    //     const VkSubpassDependency*        pDependencies;
+    // } VkRenderPassCreateInfo;
+    VkRenderPassCreateInfo renderPassCreateInfo = {};
+    renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassCreateInfo.pNext = nullptr;
+    renderPassCreateInfo.flags = 0; // Reserved for future use.
+    renderPassCreateInfo.attachmentCount = 1;
+    renderPassCreateInfo.pAttachments = &colorAttachment;
+    renderPassCreateInfo.subpassCount = 1;
+    renderPassCreateInfo.pSubpasses = &subpass;
+    renderPassCreateInfo.dependencyCount = 1;
+    renderPassCreateInfo.pDependencies = &subpassDependency;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkResult result = vkCreateRenderPass(logicalDevice, &renderPassCreateInfo, nullptr, &renderPass);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create render pass\n");
+    }
+
+    return renderPass;
+}
+
+static void
+createFramebuffers(VkLogicalDevice logicalDevice, VkRenderPass renderPass, const Buffer<VkImageView> * imageViews,
+                   const SwapchainConfig * swapchainConfig, Buffer<VkFramebuffer> * framebuffers)
+{
+    PRISM_ASSERT(framebuffers->count == imageViews->count);
+
+    for(size_t i = 0; i < imageViews->count; i++)
+    {
+        // typedef struct VkFramebufferCreateInfo {
+        //     VkStructureType             sType;
+        //     const void*                 pNext;
+        //     VkFramebufferCreateFlags    flags;
+        //     VkRenderPass                renderPass;
+        //     uint32_t                    attachmentCount;
+        //     const VkImageView*          pAttachments;
+        //     uint32_t                    width;
+        //     uint32_t                    height;
+        //     uint32_t                    layers;
+        // } VkFramebufferCreateInfo;
+        VkFramebufferCreateInfo framebufferCreateInfo = {};
+        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferCreateInfo.pNext = nullptr;
+        framebufferCreateInfo.flags = 0; // Reserved for future use.
+        framebufferCreateInfo.renderPass = renderPass;
+        framebufferCreateInfo.attachmentCount = 1;
+        framebufferCreateInfo.pAttachments = imageViews->data + i;
+        framebufferCreateInfo.width = swapchainConfig->extent.width;
+        framebufferCreateInfo.height = swapchainConfig->extent.height;
+        framebufferCreateInfo.layers = 1;
+
+        VkResult result = vkCreateFramebuffer(logicalDevice, &framebufferCreateInfo, nullptr, framebuffers->data + i);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create framebuffer\n");
+        }
+    }
+}
+
+static VkPipelineLayout
+createPipelineLayout(VkLogicalDevice logicalDevice)
+{
+    // typedef struct VkPipelineLayoutCreateInfo {
+    //     VkStructureType                 sType;
+    //     const void*                     pNext;
+    //     VkPipelineLayoutCreateFlags     flags;
+    //     uint32_t                        setLayoutCount;
+    //     const VkDescriptorSetLayout*    pSetLayouts;
+    //     uint32_t                        pushConstantRangeCount;
+    //     const VkPushConstantRange*      pPushConstantRanges;
+    // } VkPipelineLayoutCreateInfo;
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = nullptr;
+    pipelineLayoutCreateInfo.flags = 0; // Reserved for future use.
+    pipelineLayoutCreateInfo.setLayoutCount = 0;
+    pipelineLayoutCreateInfo.pSetLayouts = nullptr;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+    pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkResult result = vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create pipeline layout\n");
+    }
+
+    return pipelineLayout;
+}
+
+// Returns VK_NULL_HANDLE with a warning on failure, so hot-reloaded shaders can fail without exiting.
+static VkPipeline
+tryCreateComputePipeline(VkLogicalDevice logicalDevice, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout,
+                         VkShaderModule module)
+{
+    // typedef struct VkPipelineShaderStageCreateInfo {
+    //     VkStructureType                     sType;
+    //     const void*                         pNext;
+    //     VkPipelineShaderStageCreateFlags    flags;
+    //     VkShaderStageFlagBits               stage;
+    //     VkShaderModule                      module;
+    //     const char*                         pName;
+    //     const VkSpecializationInfo*         pSpecializationInfo;
+    // } VkPipelineShaderStageCreateInfo;
+    VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {};
+    shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageCreateInfo.pNext = nullptr;
+    shaderStageCreateInfo.flags = 0; // Reserved for future use.
+    shaderStageCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageCreateInfo.module = module;
+    shaderStageCreateInfo.pName = "main";
+    shaderStageCreateInfo.pSpecializationInfo = nullptr;
+
+    // typedef struct VkComputePipelineCreateInfo {
+    //     VkStructureType                    sType;
+    //     const void*                        pNext;
+    //     VkPipelineCreateFlags              flags;
+    //     VkPipelineShaderStageCreateInfo    stage;
+    //     VkPipelineLayout                   layout;
+    //     VkPipeline                         basePipelineHandle;
+    //     int32_t                            basePipelineIndex;
+    // } VkComputePipelineCreateInfo;
+    VkComputePipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = nullptr;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stage = shaderStageCreateInfo;
+    pipelineCreateInfo.layout = pipelineLayout;
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result =
+        vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+    if(result != VK_SUCCESS)
+    {
+        utilWarning("VULKAN", "failed to create compute pipeline: %s\n", getVkResultName(result));
+        return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+}
+
+// Returns VK_NULL_HANDLE with a warning on failure, so hot-reloaded shaders can fail without exiting.
+static VkPipeline
+tryCreatePipeline(VkLogicalDevice logicalDevice, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout,
+                  VkRenderPass renderPass, const GFXShader * shader)
+{
+    VkShaderModule vertShaderModule = shader->modules[(size_t)GFXShaderStage::VERTEX];
+    VkShaderModule fragShaderModule = shader->modules[(size_t)GFXShaderStage::FRAGMENT];
+
+    if(vertShaderModule == VK_NULL_HANDLE || fragShaderModule == VK_NULL_HANDLE)
+    {
+        utilWarning("VULKAN", "shader \"%s\" needs vert and frag stages for a graphics pipeline\n", shader->name);
+        return VK_NULL_HANDLE;
+    }
+
+    // typedef struct VkPipelineShaderStageCreateInfo {
+    //     VkStructureType                     sType;
+    //     const void*                         pNext;
+    //     VkPipelineShaderStageCreateFlags    flags;
+    //     VkShaderStageFlagBits               stage;
+    //     VkShaderModule                      module;
+    //     const char*                         pName;
+    //     const VkSpecializationInfo*         pSpecializationInfo;
+    // } VkPipelineShaderStageCreateInfo;
+    VkPipelineShaderStageCreateInfo shaderStageCreateInfos[2] = {};
+    shaderStageCreateInfos[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageCreateInfos[0].pNext = nullptr;
+    shaderStageCreateInfos[0].flags = 0; // Reserved for future use.
+    shaderStageCreateInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStageCreateInfos[0].module = vertShaderModule;
+    shaderStageCreateInfos[0].pName = "main";
+    shaderStageCreateInfos[0].pSpecializationInfo = nullptr;
+    shaderStageCreateInfos[1] = shaderStageCreateInfos[0];
+    shaderStageCreateInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStageCreateInfos[1].module = fragShaderModule;
+
+    // Vertices come from binding 0 and instances from binding 1.
+    static const VkVertexInputBindingDescription VERTEX_BINDING_DESCRIPTIONS[]
+    {
+        { 0, sizeof(GFXVertex), VK_VERTEX_INPUT_RATE_VERTEX },
+        { 1, sizeof(GFXInstance), VK_VERTEX_INPUT_RATE_INSTANCE },
+    };
+
+    static const VkVertexInputAttributeDescription VERTEX_ATTRIBUTE_DESCRIPTIONS[]
+    {
+        { 0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(GFXVertex, position) },
+        { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GFXVertex, color) },
+        { 2, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(GFXInstance, offset) },
+        { 3, 1, VK_FORMAT_R32_SFLOAT, offsetof(GFXInstance, scale) },
+    };
+
+    // typedef struct VkPipelineVertexInputStateCreateInfo {
+    //     VkStructureType                             sType;
+    //     const void*                                 pNext;
+    //     VkPipelineVertexInputStateCreateFlags       flags;
+    //     uint32_t                                    vertexBindingDescriptionCount;
+    //     const VkVertexInputBindingDescription*      pVertexBindingDescriptions;
+    //     uint32_t                                    vertexAttributeDescriptionCount;
+    //     const VkVertexInputAttributeDescription*    pVertexAttributeDescriptions;
+    // } VkPipelineVertexInputStateCreateInfo;
+    VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {};
+    vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputStateCreateInfo.pNext = nullptr;
+    vertexInputStateCreateInfo.flags = 0; // Reserved for future use.
+    vertexInputStateCreateInfo.vertexBindingDescriptionCount =
+        sizeof(VERTEX_BINDING_DESCRIPTIONS) / sizeof(VkVertexInputBindingDescription);
+
+    vertexInputStateCreateInfo.pVertexBindingDescriptions = VERTEX_BINDING_DESCRIPTIONS;
+
+    vertexInputStateCreateInfo.vertexAttributeDescriptionCount =
+        sizeof(VERTEX_ATTRIBUTE_DESCRIPTIONS) / sizeof(VkVertexInputAttributeDescription);
+
+    vertexInputStateCreateInfo.pVertexAttributeDescriptions = VERTEX_ATTRIBUTE_DESCRIPTIONS;
+
+    // typedef struct VkPipelineInputAssemblyStateCreateInfo {
+    //     VkStructureType                            sType;
+    //     const void*                                pNext;
+    //     VkPipelineInputAssemblyStateCreateFlags    flags;
+    //     VkPrimitiveTopology                        topology;
+    //     VkBool32                                   primitiveRestartEnable;
+    // } VkPipelineInputAssemblyStateCreateInfo;
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo = {};
+    inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssemblyStateCreateInfo.pNext = nullptr;
+    inputAssemblyStateCreateInfo.flags = 0; // Reserved for future use.
+    inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are dynamic so the pipeline doesn't depend on the render target extent.
+
+    // typedef struct VkPipelineViewportStateCreateInfo {
+    //     VkStructureType                       sType;
+    //     const void*                           pNext;
+    //     VkPipelineViewportStateCreateFlags    flags;
+    //     uint32_t                              viewportCount;
+    //     const VkViewport*                     pViewports;
+    //     uint32_t                              scissorCount;
+    //     const VkRect2D*                       pScissors;
+    // } VkPipelineViewportStateCreateInfo;
+    VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
+    viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportStateCreateInfo.pNext = nullptr;
+    viewportStateCreateInfo.flags = 0; // Reserved for future use.
+    viewportStateCreateInfo.viewportCount = 1;
+    viewportStateCreateInfo.pViewports = nullptr;
+    viewportStateCreateInfo.scissorCount = 1;
+    viewportStateCreateInfo.pScissors = nullptr;
+
+    // typedef struct VkPipelineRasterizationStateCreateInfo {
+    //     VkStructureType                            sType;
+    //     const void*                                pNext;
+    //     VkPipelineRasterizationStateCreateFlags    flags;
+    //     VkBool32                                   depthClampEnable;
+    //     VkBool32                                   rasterizerDiscardEnable;
+    //     VkPolygonMode                              polygonMode;
+    //     VkCullModeFlags                            cullMode;
+    //     VkFrontFace                                frontFace;
+    //     VkBool32                                   depthBiasEnable;
+    //     float                                      depthBiasConstantFactor;
+    //     float                                      depthBiasClamp;
+    //     float                                      depthBiasSlopeFactor;
+    //     float                                      lineWidth;
+    // } VkPipelineRasterizationStateCreateInfo;
+    VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {};
+    rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizationStateCreateInfo.pNext = nullptr;
+    rasterizationStateCreateInfo.flags = 0; // Reserved for future use.
+    rasterizationStateCreateInfo.depthClampEnable = VK_FALSE;
+    rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+    rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizationStateCreateInfo.depthBiasEnable = VK_FALSE;
+    rasterizationStateCreateInfo.depthBiasConstantFactor = 0.0f;
+    rasterizationStateCreateInfo.depthBiasClamp = 0.0f;
+    rasterizationStateCreateInfo.depthBiasSlopeFactor = 0.0f;
+    rasterizationStateCreateInfo.lineWidth = 1.0f;
+
+    // typedef struct VkPipelineMultisampleStateCreateInfo {
+    //     VkStructureType                          sType;
+    //     const void*                              pNext;
+    //     VkPipelineMultisampleStateCreateFlags    flags;
+    //     VkSampleCountFlagBits                    rasterizationSamples;
+    //     VkBool32                                 sampleShadingEnable;
+    //     float                                    minSampleShading;
+    //     const VkSampleMask*                      pSampleMask;
+    //     VkBool32                                 alphaToCoverageEnable;
+    //     VkBool32                                 alphaToOneEnable;
+    // } VkPipelineMultisampleStateCreateInfo;
+    VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo = {};
+    multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampleStateCreateInfo.pNext = nullptr;
+    multisampleStateCreateInfo.flags = 0; // Reserved for future use.
+    multisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampleStateCreateInfo.sampleShadingEnable = VK_FALSE;
+    multisampleStateCreateInfo.minSampleShading = 1.0f;
+    multisampleStateCreateInfo.pSampleMask = nullptr;
+    multisampleStateCreateInfo.alphaToCoverageEnable = VK_FALSE;
+    multisampleStateCreateInfo.alphaToOneEnable = VK_FALSE;
+
+    // typedef struct VkPipelineColorBlendAttachmentState {
+    //     VkBool32                 blendEnable;
+    //     VkBlendFactor            srcColorBlendFactor;
+    //     VkBlendFactor            dstColorBlendFactor;
+    //     VkBlendOp                colorBlendOp;
+    //     VkBlendFactor            srcAlphaBlendFactor;
+    //     VkBlendFactor            dstAlphaBlendFactor;
+    //     VkBlendOp                alphaBlendOp;
+    //     VkColorComponentFlags    colorWriteMask;
+    // } VkPipelineColorBlendAttachmentState;
+    VkPipelineColorBlendAttachmentState colorBlendAttachmentState = {};
+    colorBlendAttachmentState.blendEnable = VK_FALSE;
+    colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    colorBlendAttachmentState.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    // typedef struct VkPipelineColorBlendStateCreateInfo {
+    //     VkStructureType                               sType;
+    //     const void*                                   pNext;
+    //     VkPipelineColorBlendStateCreateFlags          flags;
+    //     VkBool32                                      logicOpEnable;
+    //     VkLogicOp                                     logicOp;
+    //     uint32_t                                      attachmentCount;
+    //     const VkPipelineColorBlendAttachmentState*    pAttachments;
+    //     float                                         blendConstants[4];
+    // } VkPipelineColorBlendStateCreateInfo;
+    VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo = {};
+    colorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlendStateCreateInfo.pNext = nullptr;
+    colorBlendStateCreateInfo.flags = 0; // Reserved for future use.
+    colorBlendStateCreateInfo.logicOpEnable = VK_FALSE;
+    colorBlendStateCreateInfo.logicOp = VK_LOGIC_OP_COPY;
+    colorBlendStateCreateInfo.attachmentCount = 1;
+    colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
+
+    static const VkDynamicState DYNAMIC_STATES[]
+    {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+
+    // typedef struct VkPipelineDynamicStateCreateInfo {
+    //     VkStructureType                      sType;
+    //     const void*                          pNext;
+    //     VkPipelineDynamicStateCreateFlags    flags;
+    //     uint32_t                             dynamicStateCount;
+    //     const VkDynamicState*                pDynamicStates;
+    // } VkPipelineDynamicStateCreateInfo;
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.pNext = nullptr;
+    dynamicStateCreateInfo.flags = 0; // Reserved for future use.
+    dynamicStateCreateInfo.dynamicStateCount = sizeof(DYNAMIC_STATES) / sizeof(VkDynamicState);
+    dynamicStateCreateInfo.pDynamicStates = DYNAMIC_STATES;
+
+    // typedef struct VkGraphicsPipelineCreateInfo {
+    //     VkStructureType                                  sType;
+    //     const void*                                      pNext;
+    //     VkPipelineCreateFlags                            flags;
+    //     uint32_t                                         stageCount;
+    //     const VkPipelineShaderStageCreateInfo*           pStages;
+    //     const VkPipelineVertexInputStateCreateInfo*      pVertexInputState;
+    //     const VkPipelineInputAssemblyStateCreateInfo*    pInputAssemblyState;
+    //     const VkPipelineTessellationStateCreateInfo*     pTessellationState;
+    //     const VkPipelineViewportStateCreateInfo*         pViewportState;
+    //     const VkPipelineRasterizationStateCreateInfo*    pRasterizationState;
+    //     const VkPipelineMultisampleStateCreateInfo*      pMultisampleState;
+    //     const VkPipelineDepthStencilStateCreateInfo*     pDepthStencilState;
+    //     const VkPipelineColorBlendStateCreateInfo*       pColorBlendState;
+    //     const VkPipelineDynamicStateCreateInfo*          pDynamicState;
+    //     VkPipelineLayout                                 layout;
+    //     VkRenderPass                                     renderPass;
+    //     uint32_t                                         subpass;
+    //     VkPipeline                                       basePipelineHandle;
+    //     int32_t                                          basePipelineIndex;
+    // } VkGraphicsPipelineCreateInfo;
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.pNext = nullptr;
+    pipelineCreateInfo.flags = 0;
+    pipelineCreateInfo.stageCount = sizeof(shaderStageCreateInfos) / sizeof(VkPipelineShaderStageCreateInfo);
+    pipelineCreateInfo.pStages = shaderStageCreateInfos;
+    pipelineCreateInfo.pVertexInputState = &vertexInputStateCreateInfo;
+    pipelineCreateInfo.pInputAssemblyState = &inputAssemblyStateCreateInfo;
+    pipelineCreateInfo.pTessellationState = nullptr;
+    pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+    pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;
+    pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
+    pipelineCreateInfo.pDepthStencilState = nullptr;
+    pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+    pipelineCreateInfo.layout = pipelineLayout;
+    pipelineCreateInfo.renderPass = renderPass;
+    pipelineCreateInfo.subpass = 0;
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    VkResult result =
+        vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+    if(result != VK_SUCCESS)
+    {
+        utilWarning("VULKAN", "vkCreateGraphicsPipelines() failed for shader \"%s\": %s\n", shader->name,
+                    getVkResultName(result));
+
+        pipeline = VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+}
+
+static VkPipeline
+createPipeline(VkLogicalDevice logicalDevice, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout,
+               VkRenderPass renderPass, const GFXShader * shader)
+{
+    VkPipeline pipeline = tryCreatePipeline(logicalDevice, pipelineCache, pipelineLayout, renderPass, shader);
+
+    if(pipeline == VK_NULL_HANDLE)
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to create graphics pipeline\n");
+    }
+
+    return pipeline;
+}
+
+static Buffer<GFXFrame>
+createFrames(VkLogicalDevice logicalDevice, const QueueInfo * queueInfo, uint32_t frameCount)
+{
+    auto frames = bufferCreate<GFXFrame>(frameCount);
+
+    for(size_t i = 0; i < frames.count; i++)
+    {
+        GFXFrame * frame = frames.data + i;
+
+        // Each frame gets its own pool so the whole pool can be reset at once when the frame's fence signals, instead
+        // of resetting individual command buffers.
+
+        // typedef struct VkCommandPoolCreateInfo {
+        //     VkStructureType             sType;
+        //     const void*                 pNext;
+        //     VkCommandPoolCreateFlags    flags;
+        //     uint32_t                    queueFamilyIndex;
+        // } VkCommandPoolCreateInfo;
+        VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+        commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCreateInfo.pNext = nullptr;
+        commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCreateInfo.queueFamilyIndex = queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)];
+        VkResult result = vkCreateCommandPool(logicalDevice, &commandPoolCreateInfo, nullptr, &frame->commandPool);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create frame command pool\n");
+        }
+
+        // typedef struct VkCommandBufferAllocateInfo {
+        //     VkStructureType         sType;
+        //     const void*             pNext;
+        //     VkCommandPool           commandPool;
+        //     VkCommandBufferLevel    level;
+        //     uint32_t                commandBufferCount;
+        // } VkCommandBufferAllocateInfo;
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.pNext = nullptr;
+        commandBufferAllocateInfo.commandPool = frame->commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        result = vkAllocateCommandBuffers(logicalDevice, &commandBufferAllocateInfo, &frame->commandBuffer);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to allocate frame command buffer\n");
+        }
+
+        // typedef struct VkSemaphoreCreateInfo {
+        //     VkStructureType           sType;
+        //     const void*               pNext;
+        //     VkSemaphoreCreateFlags    flags;
+        // } VkSemaphoreCreateInfo;
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreCreateInfo.pNext = nullptr;
+        semaphoreCreateInfo.flags = 0; // Reserved for future use.
+
+        VkSemaphore * semaphores[] { &frame->imageAcquiredSemaphore, &frame->renderFinishedSemaphore };
+
+        for(size_t semaphoreIndex = 0; semaphoreIndex < sizeof(semaphores) / sizeof(void *); semaphoreIndex++)
+        {
+            result = vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, semaphores[semaphoreIndex]);
+
+            if(result != VK_SUCCESS)
+            {
+                utilErrorExit("VULKAN", getVkResultName(result), "failed to create frame semaphore\n");
+            }
+        }
+
+        // Fences start signaled so the first wait on each frame doesn't block.
+
+        // typedef struct VkFenceCreateInfo {
+        //     VkStructureType       sType;
+        //     const void*           pNext;
+        //     VkFenceCreateFlags    flags;
+        // } VkFenceCreateInfo;
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.pNext = nullptr;
+        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        result = vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &frame->inFlightFence);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create frame fence\n");
+        }
+    }
+
+    return frames;
+}
+
+static Buffer<GFXTransferBatch>
+createTransferBatches(VkLogicalDevice logicalDevice, const QueueInfo * queueInfo, const Buffer<GFXFrame> * frames)
+{
+    auto transferBatches = bufferCreate<GFXTransferBatch>(frames->count);
+
+    for(size_t i = 0; i < transferBatches.count; i++)
+    {
+        GFXTransferBatch * transferBatch = transferBatches.data + i;
+        *transferBatch = {};
+
+        // typedef struct VkCommandPoolCreateInfo {
+        //     VkStructureType             sType;
+        //     const void*                 pNext;
+        //     VkCommandPoolCreateFlags    flags;
+        //     uint32_t                    queueFamilyIndex;
+        // } VkCommandPoolCreateInfo;
+        VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+        commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCreateInfo.pNext = nullptr;
+        commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCreateInfo.queueFamilyIndex = queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(TRANSFER)];
+
+        VkResult result =
+            vkCreateCommandPool(logicalDevice, &commandPoolCreateInfo, nullptr, &transferBatch->commandPool);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create transfer command pool\n");
+        }
+
+        // typedef struct VkCommandBufferAllocateInfo {
+        //     VkStructureType         sType;
+        //     const void*             pNext;
+        //     VkCommandPool           commandPool;
+        //     VkCommandBufferLevel    level;
+        //     uint32_t                commandBufferCount;
+        // } VkCommandBufferAllocateInfo;
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.pNext = nullptr;
+        commandBufferAllocateInfo.commandPool = transferBatch->commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        result = vkAllocateCommandBuffers(logicalDevice, &commandBufferAllocateInfo, &transferBatch->commandBuffer);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to allocate transfer command buffer\n");
+        }
+
+        // The acquire command buffer executes on the graphics queue, so it comes from the frame's graphics pool and is
+        // reset along with the frame's other commands.
+        commandBufferAllocateInfo.commandPool = frames->data[i].commandPool;
+
+        result = vkAllocateCommandBuffers(logicalDevice, &commandBufferAllocateInfo,
+                                          &transferBatch->acquireCommandBuffer);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to allocate transfer acquire command buffer\n");
+        }
+
+        // typedef struct VkSemaphoreCreateInfo {
+        //     VkStructureType           sType;
+        //     const void*               pNext;
+        //     VkSemaphoreCreateFlags    flags;
+        // } VkSemaphoreCreateInfo;
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreCreateInfo.pNext = nullptr;
+        semaphoreCreateInfo.flags = 0; // Reserved for future use.
+
+        result = vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr,
+                                   &transferBatch->transferFinishedSemaphore);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create transfer semaphore\n");
+        }
+
+        // typedef struct VkFenceCreateInfo {
+        //     VkStructureType       sType;
+        //     const void*           pNext;
+        //     VkFenceCreateFlags    flags;
+        // } VkFenceCreateInfo;
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.pNext = nullptr;
+        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        result = vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &transferBatch->fence);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create transfer fence\n");
+        }
+
+        transferBatch->bufferAcquireBarriers = bufferCreate<VkBufferMemoryBarrier>(GFX_MAX_UPLOAD_BARRIERS);
+        transferBatch->imageAcquireBarriers = bufferCreate<VkImageMemoryBarrier>(GFX_MAX_UPLOAD_BARRIERS);
+    }
+
+    return transferBatches;
+}
+
+static void
+createStagingRing(MEMAllocator * allocator, VkLogicalDevice logicalDevice, VkDeviceSize size,
+                  GFXStagingRing * stagingRing)
+{
+    // typedef struct VkBufferCreateInfo {
+    //     VkStructureType        sType;
+    //     const void*            pNext;
+    //     VkBufferCreateFlags    flags;
+    //     VkDeviceSize           size;
+    //     VkBufferUsageFlags     usage;
+    //     VkSharingMode          sharingMode;
+    //     uint32_t               queueFamilyIndexCount;
+    //     const uint32_t*        pQueueFamilyIndices;
+    // } VkBufferCreateInfo;
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext = nullptr;
+    bufferCreateInfo.flags = 0;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    // Only ever read by the transfer queue.
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferCreateInfo.queueFamilyIndexCount = 0;
+    bufferCreateInfo.pQueueFamilyIndices = nullptr;
+
+    VkResult result = vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, &stagingRing->buffer);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create staging ring buffer\n");
+    }
+
+    // Host-coherent memory avoids flushing every upload; the GPU reads it over the bus only once per upload.
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(logicalDevice, stagingRing->buffer, &memoryRequirements);
+
+    if(!memAllocate(allocator, MEMStrategy::BUDDY, MEMResourceType::LINEAR, &memoryRequirements,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0,
+                    &stagingRing->memory))
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to allocate memory for staging ring\n");
+    }
+
+    result = vkBindBufferMemory(logicalDevice, stagingRing->buffer, stagingRing->memory.memory,
+                                stagingRing->memory.offset);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to bind memory for staging ring\n");
+    }
+
+    stagingRing->size = size;
+    stagingRing->head = 0;
+    stagingRing->tail = 0;
+}
+
+// Advances the staging ring's tail past every submitted transfer batch that has completed, without blocking.
+static void
+reclaimStagingRing(GFXContext * context)
+{
+    for(size_t i = 0; i < context->transferBatches.count; i++)
+    {
+        GFXTransferBatch * transferBatch = context->transferBatches.data + i;
+
+        if(transferBatch->submitted && vkGetFenceStatus(context->logicalDevice, transferBatch->fence) == VK_SUCCESS)
+        {
+            transferBatch->submitted = false;
+
+            if(transferBatch->stagingEnd > context->stagingRing.tail)
+            {
+                context->stagingRing.tail = transferBatch->stagingEnd;
+            }
+        }
+    }
+}
+
+// Returns the offset of size bytes of staging memory aligned to alignment, or VK_WHOLE_SIZE if the ring is full.
+static VkDeviceSize
+reserveStagingMemory(GFXContext * context, VkDeviceSize size, VkDeviceSize alignment)
+{
+    GFXStagingRing * stagingRing = &context->stagingRing;
+
+    for(uint32_t attempt = 0; attempt < 2; attempt++)
+    {
+        uint64_t head = (stagingRing->head + alignment - 1) & ~(uint64_t)(alignment - 1);
+        VkDeviceSize offset = head % stagingRing->size;
+
+        // Reservations never wrap around the end of the ring; skip to its start instead.
+        if(offset + size > stagingRing->size)
+        {
+            head += stagingRing->size - offset;
+            offset = 0;
+        }
+
+        if(head + size - stagingRing->tail <= stagingRing->size)
+        {
+            stagingRing->head = head + size;
+            return offset;
+        }
+
+        // Ring is full; reclaim memory from completed batches and try again.
+        reclaimStagingRing(context);
+    }
+
+    return VK_WHOLE_SIZE;
+}
+
+// Returns the current frame's transfer batch, ready to record upload commands into.
+static GFXTransferBatch *
+beginTransferBatch(GFXContext * context)
+{
+    GFXTransferBatch * transferBatch = context->transferBatches.data + context->frameIndex;
+
+    if(transferBatch->recording)
+    {
+        return transferBatch;
+    }
+
+    // The batch was last submitted frames.count frames ago, and the frame that waited on it has completed, so this
+    // doesn't block in practice.
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+    vkWaitForFences(logicalDevice, 1, &transferBatch->fence, VK_TRUE, UINT64_MAX);
+    reclaimStagingRing(context);
+    vkResetFences(logicalDevice, 1, &transferBatch->fence);
+    vkResetCommandPool(logicalDevice, transferBatch->commandPool, 0);
+
+    // typedef struct VkCommandBufferBeginInfo {
+    //     VkStructureType                          sType;
+    //     const void*                              pNext;
+    //     VkCommandBufferUsageFlags                flags;
+    //     const VkCommandBufferInheritanceInfo*    pInheritanceInfo;
+    // } VkCommandBufferBeginInfo;
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.pNext = nullptr;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = nullptr;
+    VkResult result = vkBeginCommandBuffer(transferBatch->commandBuffer, &commandBufferBeginInfo);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to begin transfer command buffer\n");
+    }
+
+    transferBatch->bufferAcquireBarrierCount = 0;
+    transferBatch->imageAcquireBarrierCount = 0;
+    transferBatch->recording = true;
+
+    return transferBatch;
+}
+
+// Submits the current frame's transfer batch to the transfer queue, and records the matching ownership acquires into
+// its acquire command buffer. Returns whether the acquire command buffer needs to be submitted to the graphics queue.
+static bool
+submitTransferBatch(GFXContext * context, GFXTransferBatch * transferBatch)
+{
+    VkResult result = vkEndCommandBuffer(transferBatch->commandBuffer);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to end transfer command buffer\n");
+    }
+
+    // typedef struct VkSubmitInfo {
+    //     VkStructureType                sType;
+    //     const void*                    pNext;
+    //     uint32_t                       waitSemaphoreCount;
+    //     const VkSemaphore*             pWaitSemaphores;
+    //     const VkPipelineStageFlags*    pWaitDstStageMask;
+    //     uint32_t                       commandBufferCount;
+    //     const VkCommandBuffer*         pCommandBuffers;
+    //     uint32_t                       signalSemaphoreCount;
+    //     const VkSemaphore*             pSignalSemaphores;
+    // } VkSubmitInfo;
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = nullptr;
+    submitInfo.waitSemaphoreCount = 0;
+    submitInfo.pWaitSemaphores = nullptr;
+    submitInfo.pWaitDstStageMask = nullptr;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &transferBatch->commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &transferBatch->transferFinishedSemaphore;
+
+    result = vkQueueSubmit(context->queueInfo.queues[QUEUE_FAMILY_INDEX(TRANSFER)], 1, &submitInfo,
+                           transferBatch->fence);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to submit transfer batch\n");
+    }
+
+    transferBatch->recording = false;
+    transferBatch->submitted = true;
+    transferBatch->stagingEnd = context->stagingRing.head;
+
+    if(transferBatch->bufferAcquireBarrierCount == 0 && transferBatch->imageAcquireBarrierCount == 0)
+    {
+        return false;
+    }
+
+    // typedef struct VkCommandBufferBeginInfo {
+    //     VkStructureType                          sType;
+    //     const void*                              pNext;
+    //     VkCommandBufferUsageFlags                flags;
+    //     const VkCommandBufferInheritanceInfo*    pInheritanceInfo;
+    // } VkCommandBufferBeginInfo;
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.pNext = nullptr;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = nullptr;
+    result = vkBeginCommandBuffer(transferBatch->acquireCommandBuffer, &commandBufferBeginInfo);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to begin transfer acquire command buffer\n");
+    }
+
+    // The graphics submission waits on the uploads (directly, or through the frame's compute work) at
+    // GRAPHICS_CONSUMER_STAGES, so acquiring at those stages chains onto the wait.
+    vkCmdPipelineBarrier(transferBatch->acquireCommandBuffer, GRAPHICS_CONSUMER_STAGES, GRAPHICS_CONSUMER_STAGES, 0,
+                         0, nullptr,
+                         transferBatch->bufferAcquireBarrierCount, transferBatch->bufferAcquireBarriers.data,
+                         transferBatch->imageAcquireBarrierCount, transferBatch->imageAcquireBarriers.data);
+
+    result = vkEndCommandBuffer(transferBatch->acquireCommandBuffer);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to end transfer acquire command buffer\n");
+    }
+
+    return true;
+}
+
+static void
+destroyTransferBatches(VkLogicalDevice logicalDevice, Buffer<GFXTransferBatch> * transferBatches)
+{
+    for(size_t i = 0; i < transferBatches->count; i++)
+    {
+        GFXTransferBatch * transferBatch = transferBatches->data + i;
+
+        // Command buffers are implicitly freed with their pools, including the acquire command buffer with the frame's
+        // pool.
+        vkDestroyCommandPool(logicalDevice, transferBatch->commandPool, nullptr);
+        vkDestroySemaphore(logicalDevice, transferBatch->transferFinishedSemaphore, nullptr);
+        vkDestroyFence(logicalDevice, transferBatch->fence, nullptr);
+        bufferFree(&transferBatch->bufferAcquireBarriers);
+        bufferFree(&transferBatch->imageAcquireBarriers);
+    }
+
+    bufferFree(transferBatches);
+}
+
+static Buffer<GFXComputeBatch>
+createComputeBatches(VkLogicalDevice logicalDevice, const QueueInfo * queueInfo, uint32_t frameCount)
+{
+    auto computeBatches = bufferCreate<GFXComputeBatch>(frameCount);
+
+    for(size_t i = 0; i < computeBatches.count; i++)
+    {
+        GFXComputeBatch * computeBatch = computeBatches.data + i;
+        *computeBatch = {};
+
+        // typedef struct VkCommandPoolCreateInfo {
+        //     VkStructureType             sType;
+        //     const void*                 pNext;
+        //     VkCommandPoolCreateFlags    flags;
+        //     uint32_t                    queueFamilyIndex;
+        // } VkCommandPoolCreateInfo;
+        VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+        commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCreateInfo.pNext = nullptr;
+        commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCreateInfo.queueFamilyIndex = queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(COMPUTE)];
+        VkResult result =
+            vkCreateCommandPool(logicalDevice, &commandPoolCreateInfo, nullptr, &computeBatch->commandPool);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create compute command pool\n");
+        }
+
+        // typedef struct VkCommandBufferAllocateInfo {
+        //     VkStructureType         sType;
+        //     const void*             pNext;
+        //     VkCommandPool           commandPool;
+        //     VkCommandBufferLevel    level;
+        //     uint32_t                commandBufferCount;
+        // } VkCommandBufferAllocateInfo;
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.pNext = nullptr;
+        commandBufferAllocateInfo.commandPool = computeBatch->commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        result = vkAllocateCommandBuffers(logicalDevice, &commandBufferAllocateInfo, &computeBatch->commandBuffer);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to allocate compute command buffer\n");
+        }
+
+        // typedef struct VkSemaphoreCreateInfo {
+        //     VkStructureType           sType;
+        //     const void*               pNext;
+        //     VkSemaphoreCreateFlags    flags;
+        // } VkSemaphoreCreateInfo;
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreCreateInfo.pNext = nullptr;
+        semaphoreCreateInfo.flags = 0; // Reserved for future use.
+
+        VkSemaphore * semaphores[]
+        {
+            &computeBatch->computeFinishedSemaphore,
+            &computeBatch->graphicsFinishedSemaphore,
+        };
+
+        for(size_t semaphoreIndex = 0; semaphoreIndex < sizeof(semaphores) / sizeof(void *); semaphoreIndex++)
+        {
+            result = vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, semaphores[semaphoreIndex]);
+
+            if(result != VK_SUCCESS)
+            {
+                utilErrorExit("VULKAN", getVkResultName(result), "failed to create compute semaphore\n");
+            }
+        }
+
+        computeBatch->dispatchCount = 0;
+    }
+
+    return computeBatches;
+}
+
+// Submits the current frame's compute batch to the compute queue, after the work signaling waitSemaphores: the
+// frame's uploads and the previous frame's graphics work, when there are any.
+static void
+submitComputeBatch(GFXContext * context, GFXComputeBatch * computeBatch, const VkSemaphore * waitSemaphores,
+                   uint32_t waitSemaphoreCount)
+{
+    VkResult result = vkEndCommandBuffer(computeBatch->commandBuffer);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to end compute command buffer\n");
+    }
+
+    static const VkPipelineStageFlags WAIT_STAGES[]
+    {
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    };
+
+    PRISM_ASSERT(waitSemaphoreCount <= sizeof(WAIT_STAGES) / sizeof(VkPipelineStageFlags));
+
+    // typedef struct VkSubmitInfo {
+    //     VkStructureType                sType;
+    //     const void*                    pNext;
+    //     uint32_t                       waitSemaphoreCount;
+    //     const VkSemaphore*             pWaitSemaphores;
+    //     const VkPipelineStageFlags*    pWaitDstStageMask;
+    //     uint32_t                       commandBufferCount;
+    //     const VkCommandBuffer*         pCommandBuffers;
+    //     uint32_t                       signalSemaphoreCount;
+    //     const VkSemaphore*             pSignalSemaphores;
+    // } VkSubmitInfo;
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = nullptr;
+    submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = WAIT_STAGES;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &computeBatch->commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &computeBatch->computeFinishedSemaphore;
+
+    // No fence; the frame's fence covers the compute work, as the frame's graphics work waits on it.
+    result = vkQueueSubmit(context->queueInfo.queues[QUEUE_FAMILY_INDEX(COMPUTE)], 1, &submitInfo, VK_NULL_HANDLE);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to submit compute batch\n");
+    }
+}
+
+static void
+destroyComputeBatches(VkLogicalDevice logicalDevice, Buffer<GFXComputeBatch> * computeBatches)
+{
+    for(size_t i = 0; i < computeBatches->count; i++)
+    {
+        GFXComputeBatch * computeBatch = computeBatches->data + i;
+        vkDestroyCommandPool(logicalDevice, computeBatch->commandPool, nullptr);
+        vkDestroySemaphore(logicalDevice, computeBatch->computeFinishedSemaphore, nullptr);
+        vkDestroySemaphore(logicalDevice, computeBatch->graphicsFinishedSemaphore, nullptr);
+    }
+
+    bufferFree(computeBatches);
+}
+
+// Returns no recording threads when threadCount is 0.
+static Buffer<GFXRecordingThread>
+createRecordingThreads(VkLogicalDevice logicalDevice, const QueueInfo * queueInfo, uint32_t frameCount,
+                       uint32_t threadCount)
+{
+    if(threadCount == 0)
+    {
+        return {};
+    }
+
+    auto recordingThreads = bufferCreate<GFXRecordingThread>(frameCount * threadCount);
+
+    for(size_t i = 0; i < recordingThreads.count; i++)
+    {
+        GFXRecordingThread * recordingThread = recordingThreads.data + i;
+        *recordingThread = {};
+
+        // typedef struct VkCommandPoolCreateInfo {
+        //     VkStructureType             sType;
+        //     const void*                 pNext;
+        //     VkCommandPoolCreateFlags    flags;
+        //     uint32_t                    queueFamilyIndex;
+        // } VkCommandPoolCreateInfo;
+        VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+        commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolCreateInfo.pNext = nullptr;
+        commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        commandPoolCreateInfo.queueFamilyIndex = queueInfo->familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)];
+
+        VkResult result =
+            vkCreateCommandPool(logicalDevice, &commandPoolCreateInfo, nullptr, &recordingThread->commandPool);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create recording thread command pool\n");
+        }
+    }
+
+    return recordingThreads;
+}
+
+// Resets the current frame's recording threads; the frame's fence must have signaled.
+static void
+resetRecordingThreads(GFXContext * context)
+{
+    uint32_t threadCount = context->recordingThreadCount;
+    GFXRecordingThread * frameRecordingThreads = context->recordingThreads.data + context->frameIndex * threadCount;
+
+    for(uint32_t threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        GFXRecordingThread * recordingThread = frameRecordingThreads + threadIndex;
+        vkResetCommandPool(context->logicalDevice, recordingThread->commandPool, 0);
+        recordingThread->usedCount = 0;
+    }
+}
+
+// Executes the secondary command buffers the current frame's recording threads recorded, in thread order.
+static void
+executeRecordingThreads(GFXContext * context, VkCommandBuffer commandBuffer)
+{
+    uint32_t threadCount = context->recordingThreadCount;
+    GFXRecordingThread * frameRecordingThreads = context->recordingThreads.data + context->frameIndex * threadCount;
+
+    for(uint32_t threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        GFXRecordingThread * recordingThread = frameRecordingThreads + threadIndex;
+
+        if(recordingThread->usedCount > 0)
+        {
+            vkCmdExecuteCommands(commandBuffer, recordingThread->usedCount, recordingThread->commandBuffers);
+        }
+    }
+}
+
+static void
+destroyRecordingThreads(VkLogicalDevice logicalDevice, Buffer<GFXRecordingThread> * recordingThreads)
+{
+    if(recordingThreads->count == 0)
+    {
+        return;
+    }
+
+    // Command buffers are implicitly freed with their pools.
+    for(size_t i = 0; i < recordingThreads->count; i++)
+    {
+        vkDestroyCommandPool(logicalDevice, recordingThreads->data[i].commandPool, nullptr);
+    }
+
+    bufferFree(recordingThreads);
+}
+
+// Creates a timestamp query pool per frame if the graphics queue-family supports timestamps, and gets the timestamp
+// period used to convert them to nanoseconds.
+static void
+createTimestampQueryPools(GFXContext * context)
+{
+    VkPhysicalDeviceProperties physicalDeviceProperties = {};
+    vkGetPhysicalDeviceProperties(context->physicalDevice, &physicalDeviceProperties);
+    context->timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
+    context->profilingGPU = false;
+    context->gpuZoneDepth = 0;
+    auto queueFamilyPropsArray = createVulkanBuffer(vkGetPhysicalDeviceQueueFamilyProperties, context->physicalDevice);
+    uint32_t graphicsQueueFamilyIndex = context->queueInfo.familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)];
+    uint32_t timestampValidBits = queueFamilyPropsArray.data[graphicsQueueFamilyIndex].timestampValidBits;
+    bufferFree(&queueFamilyPropsArray);
+
+    if(timestampValidBits == 0)
+    {
+        context->timestampMask = 0;
+        utilWarning("VULKAN", "graphics queue-family doesn't support timestamps; GPU zones won't be profiled\n");
+    }
+    else
+    {
+        context->timestampMask = timestampValidBits < 64 ? (1ull << timestampValidBits) - 1 : UINT64_MAX;
+    }
+
+    for(size_t i = 0; i < context->frames.count; i++)
+    {
+        GFXFrame * frame = context->frames.data + i;
+        frame->timestampQueryPool = VK_NULL_HANDLE;
+        frame->gpuZoneCount = 0;
+
+        if(context->timestampMask == 0)
+        {
+            continue;
+        }
+
+        // typedef struct VkQueryPoolCreateInfo {
+        //     VkStructureType                  sType;
+        //     const void*                      pNext;
+        //     VkQueryPoolCreateFlags           flags;
+        //     VkQueryType                      queryType;
+        //     uint32_t                         queryCount;
+        //     VkQueryPipelineStatisticFlags    pipelineStatistics;
+        // } VkQueryPoolCreateInfo;
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.pNext = nullptr;
+        queryPoolCreateInfo.flags = 0; // Reserved for future use.
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = GFX_MAX_GPU_ZONES * 2;
+        queryPoolCreateInfo.pipelineStatistics = 0;
+
+        VkResult result =
+            vkCreateQueryPool(context->logicalDevice, &queryPoolCreateInfo, nullptr, &frame->timestampQueryPool);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to create timestamp query pool\n");
+        }
+    }
+}
+
+// Reads back the timestamps of the GPU zones recorded for frame, which must have completed, and records them with the
+// profiler. The GPU and CPU clocks aren't calibrated against each other, so zones are placed relative to the frame's
+// submit time; the first zone can't have started earlier.
+static void
+readGPUZones(GFXContext * context, GFXFrame * frame)
+{
+    uint32_t queryCount = frame->gpuZoneCount * 2;
+    uint64_t timestamps[GFX_MAX_GPU_ZONES * 2] = {};
+    frame->gpuZoneCount = 0;
+
+    VkResult result =
+        vkGetQueryPoolResults(context->logicalDevice, frame->timestampQueryPool, 0, queryCount, sizeof(timestamps),
+                              timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+    if(result != VK_SUCCESS)
+    {
+        utilWarning("VULKAN", "failed to read GPU zone timestamps: %s\n", getVkResultName(result));
+        return;
+    }
+
+    uint64_t baseTimestamp = timestamps[0] & context->timestampMask;
+
+    for(uint32_t zoneIndex = 0; zoneIndex < queryCount / 2; zoneIndex++)
+    {
+        uint64_t beginTicks = ((timestamps[zoneIndex * 2] & context->timestampMask) - baseTimestamp) &
+                              context->timestampMask;
+
+        uint64_t endTicks = ((timestamps[zoneIndex * 2 + 1] & context->timestampMask) - baseTimestamp) &
+                            context->timestampMask;
+
+        profRecordGPUZone(frame->gpuZoneNames[zoneIndex],
+                          frame->submitTime + (uint64_t)(beginTicks * (double)context->timestampPeriod),
+                          frame->submitTime + (uint64_t)(endTicks * (double)context->timestampPeriod));
+    }
+}
+
+static void
+resetImageFences(Buffer<VkFence> * imageFences, size_t imageCount)
+{
+    if(imageFences->count != imageCount)
+    {
+        if(imageFences->count > 0)
+        {
+            bufferFree(imageFences);
+        }
+
+        *imageFences = bufferCreate<VkFence>(imageCount);
+    }
+
+    // No frame has rendered to any of the images yet.
+    for(size_t i = 0; i < imageFences->count; i++)
+    {
+        imageFences->data[i] = VK_NULL_HANDLE;
+    }
+}
+
+static void
+waitForFramesInFlight(GFXContext * context)
+{
+    for(size_t i = 0; i < context->frames.count; i++)
+    {
+        vkWaitForFences(context->logicalDevice, 1, &context->frames.data[i].inFlightFence, VK_TRUE, UINT64_MAX);
+    }
+}
+
+// Destroys retired swapchains no frame in flight can still be using; when force is set, the caller guarantees no frames
+// are in flight and all retired swapchains are destroyed.
+static void
+destroyRetiredSwapchains(GFXContext * context, bool force)
+{
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+    uint32_t destroyedCount = 0;
+
+    // Swapchains are retired in frame order, so stop at the first one that is still in use.
+    for(; destroyedCount < context->retiredSwapchainCount; destroyedCount++)
+    {
+        GFXRetiredSwapchain * retiredSwapchain = context->retiredSwapchains + destroyedCount;
+
+        // Frames are reused in order, so once frames.count frames have begun since the swapchain was retired, every
+        // frame that was in flight at the time has completed.
+        if(!force && context->frameCount < retiredSwapchain->retiredFrameCount + context->frames.count)
+        {
+            break;
+        }
+
+        for(size_t i = 0; i < retiredSwapchain->framebuffers.count; i++)
+        {
+            vkDestroyFramebuffer(logicalDevice, retiredSwapchain->framebuffers.data[i], nullptr);
+        }
+
+        for(size_t i = 0; i < retiredSwapchain->imageViews.count; i++)
+        {
+            vkDestroyImageView(logicalDevice, retiredSwapchain->imageViews.data[i], nullptr);
+        }
+
+        vkDestroySwapchainKHR(logicalDevice, retiredSwapchain->swapchain, nullptr);
+        keepSpareBuffer(&context->spareFramebuffers, &retiredSwapchain->framebuffers);
+        keepSpareBuffer(&context->spareImageViews, &retiredSwapchain->imageViews);
+    }
+
+    // Shift remaining retired swapchains to the front.
+    context->retiredSwapchainCount -= destroyedCount;
+
+    for(uint32_t i = 0; i < context->retiredSwapchainCount; i++)
+    {
+        context->retiredSwapchains[i] = context->retiredSwapchains[i + destroyedCount];
+    }
+}
+
+// Replaces the swapchain with one matching the surface's current state. The old swapchain is handed over to the new
+// one and retired rather than destroyed, so neither the device nor the frames still in flight have to be waited on.
+// Returns false if the surface currently can't be presented to (e.g. the window is minimized).
+static bool
+recreateSwapchain(GFXContext * context)
+{
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+    SwapchainInfo * swapchainInfo = &context->swapchainInfo;
+    SwapchainConfig * swapchainConfig = &context->swapchainConfig;
+    VkSurfaceCapabilitiesKHR * surfaceCapabilities = &swapchainInfo->surfaceCapabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(context->physicalDevice, context->surface, surfaceCapabilities);
+
+    // A swapchain can't have a zero extent, so wait for the surface to be restored before recreating it.
+    if(surfaceCapabilities->currentExtent.width == 0 || surfaceCapabilities->currentExtent.height == 0)
+    {
+        return false;
+    }
+
+    createSwapchainConfig(swapchainInfo, context->presentPolicy, context->requestedSwapchainImageCount,
+                          swapchainConfig);
+
+    // Only reached when the surface changes faster than frames complete; wait for the frames in flight rather than the
+    // whole device.
+    if(context->retiredSwapchainCount == GFX_MAX_RETIRED_SWAPCHAINS)
+    {
+        waitForFramesInFlight(context);
+        destroyRetiredSwapchains(context, true);
+    }
+
+    // Retire current swapchain resources.
+    GFXRetiredSwapchain * retiredSwapchain = context->retiredSwapchains + context->retiredSwapchainCount;
+    retiredSwapchain->swapchain = context->swapchain;
+    retiredSwapchain->imageViews = context->swapchainImageViews;
+    retiredSwapchain->framebuffers = context->framebuffers;
+    retiredSwapchain->retiredFrameCount = context->frameCount;
+    context->retiredSwapchainCount++;
+
+    // Create new swapchain resources, reusing buffers of previously destroyed swapchain resources where possible.
+    context->swapchain =
+        createSwapchain(context->surface, logicalDevice, &context->queueInfo, swapchainConfig,
+                        retiredSwapchain->swapchain);
+
+    getSwapchainImages(logicalDevice, context->swapchain, &context->swapchainImages);
+    size_t imageCount = context->swapchainImages.count;
+    context->swapchainImageViews = takeSpareBuffer(&context->spareImageViews, imageCount);
+    context->framebuffers = takeSpareBuffer(&context->spareFramebuffers, imageCount);
+
+    createSwapchainImageViews(logicalDevice, &context->swapchainImages, swapchainConfig,
+                              &context->swapchainImageViews);
+
+    createFramebuffers(logicalDevice, context->renderPass, &context->swapchainImageViews, swapchainConfig,
+                       &context->framebuffers);
+
+    resetImageFences(&context->imageFences, imageCount);
+    context->swapchainOutOfDate = false;
+    context->frameGraphTargetChanged = true;
+
+    return true;
+}
+
+// Acquires the next swapchain image for frame, recreating the swapchain first if it is out of date. Returns false if no
+// image can be acquired until the surface changes.
+static bool
+acquireSwapchainImage(GFXContext * context, const GFXFrame * frame)
+{
+    for(;;)
+    {
+        if(context->swapchainOutOfDate && !recreateSwapchain(context))
+        {
+            return false;
+        }
+
+        VkResult result = vkAcquireNextImageKHR(context->logicalDevice, context->swapchain, UINT64_MAX,
+                                                frame->imageAcquiredSemaphore, VK_NULL_HANDLE, &context->imageIndex);
+
+        if(result == VK_SUCCESS)
+        {
+            return true;
+        }
+        // The image can still be presented, so render this frame and recreate the swapchain at the start of the next.
+        else if(result == VK_SUBOPTIMAL_KHR)
+        {
+            context->swapchainOutOfDate = true;
+            return true;
+        }
+        // No image was acquired, so recreate the swapchain and try again.
+        else if(result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            context->swapchainOutOfDate = true;
+        }
+        else
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to acquire swapchain image\n");
+        }
+    }
+}
+
+static void
+queueShaderReload(GFXShaderReloader * reloader, size_t shaderIndex, size_t stageIndex, VkShaderModule module)
+{
+    std::lock_guard<std::mutex> lock(reloader->pendingReloadsMutex);
+
+    for(size_t i = 0; i < reloader->pendingReloadCount; i++)
+    {
+        ShaderReload * pendingReload = reloader->pendingReloads.data + i;
+
+        // Replace older reload of the same stage that hasn't been applied yet.
+        if(pendingReload->shaderIndex == shaderIndex && pendingReload->stageIndex == stageIndex)
+        {
+            vkDestroyShaderModule(reloader->logicalDevice, pendingReload->module, nullptr);
+            pendingReload->module = module;
+            return;
+        }
+    }
+
+    ShaderReload * pendingReload = reloader->pendingReloads.data + reloader->pendingReloadCount;
+    pendingReload->shaderIndex = shaderIndex;
+    pendingReload->stageIndex = stageIndex;
+    pendingReload->module = module;
+    reloader->pendingReloadCount++;
+}
+
+// Runs glslangValidator to compile sourcePath to SPIR-V at binaryPath, capturing what it writes to stdout and stderr in
+// output. The compiler is spawned directly with its arguments rather than through a shell, so file names are never
+// interpreted as commands. Returns false if the compiler couldn't be run or compilation failed.
+static bool
+runShaderCompiler(const char * sourcePath, const char * binaryPath, char * output, size_t outputSize)
+{
+    int outputPipe[2] = {};
+
+    // The pipe is close-on-exec; only the compiler's duplicated stdout and stderr outlive the spawn.
+    if(pipe2(outputPipe, O_CLOEXEC) != 0)
+    {
+        return false;
+    }
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(&fileActions, outputPipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&fileActions, outputPipe[1], STDERR_FILENO);
+
+    char * const arguments[] =
+    {
+        (char *)"glslangValidator",
+        (char *)"-V",
+        (char *)sourcePath,
+        (char *)"-o",
+        (char *)binaryPath,
+        nullptr,
+    };
+
+    pid_t compiler = 0;
+    int spawnResult = posix_spawnp(&compiler, arguments[0], &fileActions, nullptr, arguments, environ);
+    posix_spawn_file_actions_destroy(&fileActions);
+    close(outputPipe[1]);
+
+    // Read until the compiler closes its end, keeping as much output as fits.
+    size_t outputLength = 0;
+
+    while(spawnResult == 0)
+    {
+        char discarded[256];
+        bool full = outputLength == outputSize - 1;
+        ssize_t readSize = full ? read(outputPipe[0], discarded, sizeof(discarded))
+                                : read(outputPipe[0], output + outputLength, outputSize - 1 - outputLength);
+
+        if(readSize <= 0)
+        {
+            break;
+        }
+
+        outputLength += full ? 0 : (size_t)readSize;
+    }
+
+    output[outputLength] = '\0';
+    close(outputPipe[0]);
+
+    if(spawnResult != 0)
+    {
+        snprintf(output, outputSize, "failed to run glslangValidator: %s\n", strerror(spawnResult));
+        return false;
+    }
+
+    int status = 0;
+
+    while(waitpid(compiler, &status, 0) == -1 && errno == EINTR)
+    {
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Runs on the reloader thread. Compiles the changed GLSL source sourceFile to a temporary binary first, so the last
+// good binary is kept if compilation fails, then creates new modules for every shader stage built from it.
+static void
+recompileShaderSource(GFXShaderReloader * reloader, const char * sourceFile)
+{
+    static const size_t MAX_COMPILE_OUTPUT_SIZE = 4096;
+
+    // Source files are named "<file>.<stage>"; ignore anything else in the directory (e.g. editor swap files).
+    const char * extension = strrchr(sourceFile, '.');
+    size_t fileLength = extension != nullptr ? (size_t)(extension - sourceFile) : 0;
+    size_t stageIndex = 0;
+
+    if(extension == nullptr || fileLength == 0 || fileLength >= GFX_MAX_SHADER_NAME_SIZE)
+    {
+        return;
+    }
+
+    while(stageIndex < (size_t)GFXShaderStage::COUNT && strcmp(extension + 1, SHADER_STAGE_NAMES[stageIndex]) != 0)
+    {
+        stageIndex++;
+    }
+
+    if(stageIndex == (size_t)GFXShaderStage::COUNT)
+    {
+        return;
+    }
+
+    char sourcePath[MAX_PATH_SIZE] = {};
+    char binaryPath[MAX_PATH_SIZE] = {};
+    char tempBinaryPath[MAX_PATH_SIZE] = {};
+    int sourcePathLength = snprintf(sourcePath, MAX_PATH_SIZE, "%s/%s", reloader->sourceDir, sourceFile);
+    int binaryPathLength = snprintf(binaryPath, MAX_PATH_SIZE, "%s/%s.spv", reloader->binDir, sourceFile);
+    int tempBinaryPathLength = snprintf(tempBinaryPath, MAX_PATH_SIZE, "%s.tmp", binaryPath);
+
+    if(sourcePathLength < 0 || sourcePathLength >= MAX_PATH_SIZE || binaryPathLength < 0 ||
+       binaryPathLength >= MAX_PATH_SIZE || tempBinaryPathLength < 0 || tempBinaryPathLength >= MAX_PATH_SIZE)
+    {
+        utilWarning("VULKAN", "paths for shader source '%s' are too long to recompile\n", sourceFile);
+        return;
+    }
+
+    utilLog("VULKAN", "recompiling shader source '%s'\n", sourceFile);
+
+    // Compile source, capturing compiler output to report errors.
+    char compileOutput[MAX_COMPILE_OUTPUT_SIZE] = {};
+
+    if(!runShaderCompiler(sourcePath, tempBinaryPath, compileOutput, MAX_COMPILE_OUTPUT_SIZE))
+    {
+        utilWarning("VULKAN", "failed to compile '%s', keeping last good version:\n%s", sourceFile, compileOutput);
+        remove(tempBinaryPath);
+        return;
+    }
+
+    if(rename(tempBinaryPath, binaryPath) != 0)
+    {
+        utilWarning("VULKAN", "failed to replace shader binary '%s'\n", binaryPath);
+        remove(tempBinaryPath);
+        return;
+    }
+
+    const Buffer<ShaderSource> * shaderSources = &reloader->shaderSources;
+
+    for(size_t shaderIndex = 0; shaderIndex < shaderSources->count; shaderIndex++)
+    {
+        const char * stageFile = shaderSources->data[shaderIndex].stageFiles[stageIndex];
+
+        if(strlen(stageFile) != fileLength || strncmp(stageFile, sourceFile, fileLength) != 0)
+        {
+            continue;
+        }
+
+        VkShaderModule module = tryCreateShaderModule(reloader->logicalDevice, binaryPath);
+
+        if(module != VK_NULL_HANDLE)
+        {
+            queueShaderReload(reloader, shaderIndex, stageIndex, module);
+        }
+    }
+}
+
+static void
+watchShaderSources(GFXShaderReloader * reloader)
+{
+    static const int POLL_TIMEOUT_MS = 100;
+    alignas(inotify_event) char events[4096];
+
+    while(!reloader->stop)
+    {
+        // Poll with a timeout so the thread notices when it is stopped.
+        pollfd inotifyPollFD = { reloader->inotifyFD, POLLIN, 0 };
+
+        if(poll(&inotifyPollFD, 1, POLL_TIMEOUT_MS) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t eventsSize = read(reloader->inotifyFD, events, sizeof(events));
+        const char * previousSourceFile = "";
+
+        for(ssize_t offset = 0; offset < eventsSize;)
+        {
+            auto event = (const inotify_event *)(events + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            // Editors often write a file several times when saving it, so only recompile once per batch of events.
+            if(event->len > 0 && strcmp(event->name, previousSourceFile) != 0)
+            {
+                recompileShaderSource(reloader, event->name);
+                previousSourceFile = event->name;
+            }
+        }
+    }
+}
+
+static GFXShaderReloader *
+createShaderReloader(VkLogicalDevice logicalDevice, const Buffer<GFXShader> * shaders, const char * sourceDir,
+                     const char * binDir)
+{
+    if(strlen(sourceDir) >= MAX_PATH_SIZE || strlen(binDir) >= MAX_PATH_SIZE)
+    {
+        utilErrorExit("VULKAN", nullptr, "shader directory paths are too long for hot-reload\n");
+    }
+
+    int inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    // Sources are written in place (IN_CLOSE_WRITE) or saved to a temporary file and renamed over (IN_MOVED_TO).
+    if(inotifyFD == -1 || inotify_add_watch(inotifyFD, sourceDir, IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to watch shader source directory '%s'\n", sourceDir);
+    }
+
+    auto reloader = new GFXShaderReloader;
+    reloader->logicalDevice = logicalDevice;
+    reloader->shaderSources = bufferCreate<ShaderSource>(shaders->count);
+
+    for(size_t i = 0; i < shaders->count; i++)
+    {
+        memcpy(reloader->shaderSources.data[i].stageFiles, shaders->data[i].stageFiles, sizeof(ShaderSource));
+    }
+
+    strcpy(reloader->sourceDir, sourceDir);
+    strcpy(reloader->binDir, binDir);
+    reloader->inotifyFD = inotifyFD;
+    reloader->stop = false;
+    reloader->pendingReloads = bufferCreate<ShaderReload>(shaders->count * (size_t)GFXShaderStage::COUNT);
+    reloader->pendingReloadCount = 0;
+    reloader->thread = std::thread(watchShaderSources, reloader);
+    utilLog("VULKAN", "shader hot-reload enabled, watching '%s'\n", sourceDir);
+
+    return reloader;
+}
+
+static void
+destroyShaderReloader(GFXShaderReloader * reloader)
+{
+    reloader->stop = true;
+    reloader->thread.join();
+    close(reloader->inotifyFD);
+
+    // Destroy reloads that were never applied.
+    for(size_t i = 0; i < reloader->pendingReloadCount; i++)
+    {
+        vkDestroyShaderModule(reloader->logicalDevice, reloader->pendingReloads.data[i].module, nullptr);
+    }
+
+    bufferFree(&reloader->pendingReloads);
+    bufferFree(&reloader->shaderSources);
+    delete reloader;
+}
+
+// Destroys retired pipelines no frame in flight can still be using; when force is set, the caller guarantees no frames
+// are in flight and all retired pipelines are destroyed.
+static void
+destroyRetiredPipelines(GFXContext * context, bool force)
+{
+    uint32_t destroyedCount = 0;
+
+    for(; destroyedCount < context->retiredPipelineCount; destroyedCount++)
+    {
+        const GFXRetiredPipeline * retiredPipeline = context->retiredPipelines + destroyedCount;
+
+        if(!force && context->frameCount < retiredPipeline->retiredFrameCount + context->frames.count)
+        {
+            break;
+        }
+
+        vkDestroyPipeline(context->logicalDevice, retiredPipeline->pipeline, nullptr);
+    }
+
+    context->retiredPipelineCount -= destroyedCount;
+
+    for(uint32_t i = 0; i < context->retiredPipelineCount; i++)
+    {
+        context->retiredPipelines[i] = context->retiredPipelines[i + destroyedCount];
+    }
+}
+
+static void
+retirePipeline(GFXContext * context, VkPipeline pipeline)
+{
+    if(context->retiredPipelineCount == GFX_MAX_RETIRED_PIPELINES)
+    {
+        waitForFramesInFlight(context);
+        destroyRetiredPipelines(context, true);
+    }
+
+    GFXRetiredPipeline * retiredPipeline = context->retiredPipelines + context->retiredPipelineCount;
+    retiredPipeline->pipeline = pipeline;
+    retiredPipeline->retiredFrameCount = context->frameCount;
+    context->retiredPipelineCount++;
+}
+
+// Swaps recompiled shader modules into the shader library and rebuilds the graphics and compute pipelines using them.
+// Called between frames, so no command buffer is being recorded with the pipelines being replaced; the replaced
+// pipelines are retired until the frames in flight using them complete. If any of a shader's pipelines can't be
+// rebuilt, the shader and all of its pipelines keep their last good modules.
+static void
+applyShaderReloads(GFXContext * context)
+{
+    GFXShaderReloader * reloader = context->shaderReloader;
+    std::lock_guard<std::mutex> lock(reloader->pendingReloadsMutex);
+
+    for(size_t i = 0; i < reloader->pendingReloadCount; i++)
+    {
+        const ShaderReload * pendingReload = reloader->pendingReloads.data + i;
+        GFXShader * shader = context->shaders.data + pendingReload->shaderIndex;
+        GFXShader reloadedShader = *shader;
+        reloadedShader.modules[pendingReload->stageIndex] = pendingReload->module;
+
+        // Rebuild every pipeline using the shader before replacing any of them.
+        VkPipeline reloadedPipeline = VK_NULL_HANDLE;
+        VkPipeline reloadedComputePipelines[GFX_MAX_COMPUTE_PIPELINES] = {};
+        bool rebuilt = true;
+
+        if(shader == context->pipelineShader)
+        {
+            reloadedPipeline = tryCreatePipeline(context->logicalDevice, context->pipelineCache,
+                                                 context->pipelineLayout, context->renderPass, &reloadedShader);
+
+            rebuilt = reloadedPipeline != VK_NULL_HANDLE;
+        }
+
+        for(uint32_t j = 0; j < context->computePipelineCount && rebuilt; j++)
+        {
+            const GFXComputePipeline * computePipeline = context->computePipelines[j];
+
+            if(strcmp(computePipeline->shaderName, shader->name) == 0)
+            {
+                reloadedComputePipelines[j] =
+                    tryCreateComputePipeline(context->logicalDevice, context->pipelineCache,
+                                             computePipeline->pipelineLayout,
+                                             reloadedShader.modules[(size_t)GFXShaderStage::COMPUTE]);
+
+                rebuilt = reloadedComputePipelines[j] != VK_NULL_HANDLE;
+            }
+        }
+
+        if(!rebuilt)
+        {
+            utilWarning("VULKAN", "keeping last good version of shader \"%s\"\n", shader->name);
+            vkDestroyPipeline(context->logicalDevice, reloadedPipeline, nullptr);
+
+            for(uint32_t j = 0; j < context->computePipelineCount; j++)
+            {
+                vkDestroyPipeline(context->logicalDevice, reloadedComputePipelines[j], nullptr);
+            }
+
+            vkDestroyShaderModule(context->logicalDevice, pendingReload->module, nullptr);
+            continue;
+        }
+
+        if(reloadedPipeline != VK_NULL_HANDLE)
+        {
+            retirePipeline(context, context->pipeline);
+            context->pipeline = reloadedPipeline;
+        }
+
+        for(uint32_t j = 0; j < context->computePipelineCount; j++)
+        {
+            if(reloadedComputePipelines[j] != VK_NULL_HANDLE)
+            {
+                retirePipeline(context, context->computePipelines[j]->pipeline);
+                context->computePipelines[j]->pipeline = reloadedComputePipelines[j];
+            }
+        }
+
+        // Pipelines don't reference shader modules after creation, so the old module can be destroyed immediately.
+        vkDestroyShaderModule(context->logicalDevice, shader->modules[pendingReload->stageIndex], nullptr);
+        *shader = reloadedShader;
+        utilLog("VULKAN", "reloaded %s stage of shader \"%s\"\n", SHADER_STAGE_NAMES[pendingReload->stageIndex],
+                shader->name);
+    }
+
+    reloader->pendingReloadCount = 0;
+}
+
+// Creates the pipeline cache, warmed up with the cache saved by a previous run if it is still valid for this
+// physical-device and driver.
+static void
+loadPipelineCache(void * data)
+{
+    auto job = (const StartupJob *)data;
+    GFXContext * context = job->context;
+    const GFXConfig * config = job->config;
+    double startTime = utilGetTime();
+    Buffer<uint8_t> pipelineCacheData = {};
+    context->pipelineCachePath = {};
+
+    if(config->pipelineCachePath != nullptr && config->pipelineCachePath[0] != '\0')
+    {
+        context->pipelineCachePath =
+            bufferCreate(config->pipelineCachePath, strlen(config->pipelineCachePath) + 1);
+
+        pipelineCacheData = loadPipelineCacheData(context->physicalDevice, context->pipelineCachePath.data);
+    }
+
+#ifdef PRISM_DEBUG
+    logPipelineCache(context->pipelineCachePath.data, pipelineCacheData.count);
+#endif
+
+    context->pipelineCache = createPipelineCache(context->logicalDevice, &pipelineCacheData);
+
+    if(pipelineCacheData.count > 0)
+    {
+        bufferFree(&pipelineCacheData);
+    }
+
+    context->startupTimes.pipelineCacheTime = utilGetTime() - startTime;
+}
+
+static void
+loadShaders(void * data)
+{
+    auto job = (const StartupJob *)data;
+    GFXContext * context = job->context;
+    const GFXConfig * config = job->config;
+    double startTime = utilGetTime();
+    context->shaders = createShaderLibrary(context->logicalDevice, config->shaderLibraryPath, config->shaderBinDir);
+    context->pipelineLayout = createPipelineLayout(context->logicalDevice);
+    context->startupTimes.shaderTime = utilGetTime() - startTime;
+}
+
+// Needs the render pass, pipeline cache and shaders.
+static void
+compilePipelines(void * data)
+{
+    auto job = (const StartupJob *)data;
+    GFXContext * context = job->context;
+    double startTime = utilGetTime();
+    const char * shaderName = job->config->pipelineShaderName;
+    PRISM_ASSERT(shaderName != nullptr);
+    const GFXShader * shader = gfxGetShader(context, shaderName);
+
+    if(shader == nullptr)
+    {
+        utilErrorExit("VULKAN", nullptr, "shader \"%s\" is missing from '%s'\n", shaderName,
+                      job->config->shaderLibraryPath);
+    }
+
+    context->pipeline =
+        createPipeline(context->logicalDevice, context->pipelineCache, context->pipelineLayout, context->renderPass,
+                       shader);
+
+    context->pipelineShader = shader;
+    context->startupTimes.pipelineTime = utilGetTime() - startTime;
+}
+
+// Returns the time since *phaseStartTime, and starts the next phase.
+static double
+endStartupPhase(double * phaseStartTime)
+{
+    double time = utilGetTime();
+    double phaseTime = time - *phaseStartTime;
+    *phaseStartTime = time;
+
+    return phaseTime;
+}
+
+// Runs jobs on scheduler, or one after another on the calling thread if there's no scheduler; jobs time themselves, so
+// running them inline restarts the calling thread's phase.
+static void
+runStartupJobs(JOBScheduler * scheduler, const JOBDecl * jobs, uint32_t jobCount, JOBCounter * counter,
+               double * phaseStartTime)
+{
+    if(scheduler == nullptr)
+    {
+        for(uint32_t i = 0; i < jobCount; i++)
+        {
+            jobs[i].fn(jobs[i].data);
+        }
+
+        *phaseStartTime = utilGetTime();
+        return;
+    }
+
+    jobRun(scheduler, jobs, jobCount, counter);
+}
+
+static void
+waitStartupJobs(JOBScheduler * scheduler, JOBCounter * counter, GFXStartupTimes * startupTimes)
+{
+    if(scheduler != nullptr)
+    {
+        double startTime = utilGetTime();
+        jobWait(scheduler, counter);
+        startupTimes->jobWaitTime += utilGetTime() - startTime;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
 // Interface
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void
-gfxInit(const GFXConfig * config)
+gfxInit(GFXContext * context, const GFXConfig * config)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(config != nullptr);
+    static const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+    static const VkDeviceSize DEFAULT_STAGING_RING_SIZE = 32 * 1024 * 1024;
+    GFXStartupTimes * startupTimes = &context->startupTimes;
+    *startupTimes = {};
+    double startTime = utilGetTime();
+    double phaseStartTime = startTime;
+
+#ifdef PRISM_DEBUG
+    // Add debug extensions and layers for logging.
+    static const char * DEBUG_EXTENSION_NAMES[]
+    {
+        VK_EXT_DEBUG_REPORT_EXTENSION_NAME,
+    };
+
+    static const char * DEBUG_LAYER_NAMES[] =
+    {
+        "VK_LAYER_LUNARG_standard_validation",
+    };
+
+    GFXConfig debugConfig = *config;
+
+    debugConfig.requestedExtensionNames =
+        bufferConcat(&config->requestedExtensionNames, DEBUG_EXTENSION_NAMES,
+                     sizeof(DEBUG_EXTENSION_NAMES) / sizeof(void *));
+
+    debugConfig.requestedLayerNames =
+        bufferConcat(&config->requestedLayerNames, DEBUG_LAYER_NAMES, sizeof(DEBUG_LAYER_NAMES) / sizeof(void *));
+
+    config = &debugConfig;
+#endif
+
+    // Create instance from config.
+    context->instance = createInstance(config);
+
+#ifdef PRISM_DEBUG
+    // In debug mode, create a debug callback for logging.
+    createDebugCallback(context);
+#endif
+
+    // Headless rendering has no surface; every step that follows handles a null surface.
+    context->surface = VK_NULL_HANDLE;
+
+    if(!config->headless)
+    {
+        context->surface = config->createSurfaceFn(config->createSurfaceFnData, context->instance);
+    }
+
+    startupTimes->instanceTime = endStartupPhase(&phaseStartTime);
+
+    // Create devices.
+    context->physicalDevice =
+        getPhysicalDevice(context->instance, context->surface, config->physicalDeviceOverride, &context->swapchainInfo);
+
+    getQueueFamilyIndexes(context->physicalDevice, context->surface, &context->queueInfo);
+
+    context->logicalDevice =
+        createLogicalDevice(context->physicalDevice, &context->queueInfo, context->surface != VK_NULL_HANDLE,
+                            &context->enabledFeatures);
+
+    getQueues(context->logicalDevice, &context->queueInfo);
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+    SwapchainConfig * swapchainConfig = &context->swapchainConfig;
+    startupTimes->deviceTime = endStartupPhase(&phaseStartTime);
+
+    // The pipeline cache and shaders only need the device, so they're loaded while render targets are created.
+    JOBScheduler * scheduler = config->jobScheduler;
+    StartupJob startupJob = { context, config };
+    JOBCounter loadCounter = {};
+    JOBCounter compileCounter = {};
+
+    const JOBDecl loadJobs[] =
+    {
+        { loadPipelineCache, &startupJob },
+        { loadShaders, &startupJob },
+    };
+
+    runStartupJobs(scheduler, loadJobs, sizeof(loadJobs) / sizeof(JOBDecl), &loadCounter, &phaseStartTime);
+
+    // Create device-memory allocator; each frame in flight has its own linear blocks.
+    uint32_t framesInFlight = config->framesInFlight > 0 ? config->framesInFlight : DEFAULT_FRAMES_IN_FLIGHT;
+    MEMConfig memoryConfig = {};
+    memoryConfig.frameCount = framesInFlight;
+    memInit(&context->allocator, context->physicalDevice, logicalDevice, &memoryConfig);
+
+    // Create descriptor allocator; each frame in flight has its own transient descriptor pools.
+    descInit(&context->descriptorAllocator, logicalDevice, framesInFlight);
+    startupTimes->allocatorTime = endStartupPhase(&phaseStartTime);
+
+    // Create render targets: swapchain images when presenting to a surface, offscreen images otherwise.
+    if(config->headless)
+    {
+        createOffscreenConfig(config, framesInFlight, swapchainConfig);
+
+        context->swapchainImages =
+            createOffscreenImages(&context->allocator, logicalDevice, swapchainConfig, &context->offscreenImageMemory);
+    }
+    else
+    {
+        context->presentPolicy = config->presentPolicy;
+        context->requestedSwapchainImageCount = config->swapchainImageCount;
+
+        createSwapchainConfig(&context->swapchainInfo, context->presentPolicy, context->requestedSwapchainImageCount,
+                              swapchainConfig);
+
+        context->swapchain =
+            createSwapchain(context->surface, logicalDevice, &context->queueInfo, swapchainConfig, VK_NULL_HANDLE);
+
+        getSwapchainImages(logicalDevice, context->swapchain, &context->swapchainImages);
+    }
+
+    size_t imageCount = context->swapchainImages.count;
+    context->swapchainImageViews = bufferCreate<VkImageView>(imageCount);
+    createSwapchainImageViews(logicalDevice, &context->swapchainImages, swapchainConfig, &context->swapchainImageViews);
+
+    // Offscreen images are left ready to be copied out for inspection instead of presented.
+    VkImageLayout finalLayout =
+        config->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    context->renderPass = createRenderPass(logicalDevice, swapchainConfig, VK_ATTACHMENT_LOAD_OP_CLEAR, finalLayout);
+    context->loadRenderPass = createRenderPass(logicalDevice, swapchainConfig, VK_ATTACHMENT_LOAD_OP_LOAD, finalLayout);
+
+    context->framebuffers = bufferCreate<VkFramebuffer>(imageCount);
+
+    createFramebuffers(logicalDevice, context->renderPass, &context->swapchainImageViews, swapchainConfig,
+                       &context->framebuffers);
+
+    resetImageFences(&context->imageFences, imageCount);
+    context->swapchainOutOfDate = false;
+    context->retiredSwapchainCount = 0;
+    context->frameGraph = nullptr;
+    context->frameGraphTarget = FG_INVALID_INDEX;
+    context->frameGraphTargetChanged = false;
+    startupTimes->renderTargetTime = endStartupPhase(&phaseStartTime);
+
+    // Pipelines are compiled while per-frame resources are created.
+    waitStartupJobs(scheduler, &loadCounter, startupTimes);
+    phaseStartTime = utilGetTime();
+    const JOBDecl compileJob = { compilePipelines, &startupJob };
+    runStartupJobs(scheduler, &compileJob, 1, &compileCounter, &phaseStartTime);
+    context->retiredPipelineCount = 0;
+    context->computePipelineCount = 0;
+    context->shaderReloader = nullptr;
+
+    if(config->shaderHotReload)
+    {
+        context->shaderReloader =
+            createShaderReloader(logicalDevice, &context->shaders, config->shaderSourceDir, config->shaderBinDir);
+    }
+
+    // Create per-frame resources.
+    context->frames = createFrames(logicalDevice, &context->queueInfo, framesInFlight);
+    createTimestampQueryPools(context);
+    context->transferBatches = createTransferBatches(logicalDevice, &context->queueInfo, &context->frames);
+    context->computeBatches = createComputeBatches(logicalDevice, &context->queueInfo, framesInFlight);
+    context->recordingThreadCount = config->recordingThreadCount;
+
+    context->recordingThreads =
+        createRecordingThreads(logicalDevice, &context->queueInfo, framesInFlight, context->recordingThreadCount);
+
+    createStagingRing(&context->allocator, logicalDevice,
+                      config->stagingRingSize > 0 ? config->stagingRingSize : DEFAULT_STAGING_RING_SIZE,
+                      &context->stagingRing);
+
+    context->frameIndex = 0;
+    context->frameCount = 0;
+    startupTimes->frameResourceTime = endStartupPhase(&phaseStartTime);
+    waitStartupJobs(scheduler, &compileCounter, startupTimes);
+    startupTimes->totalTime = utilGetTime() - startTime;
+
+#ifdef PRISM_DEBUG
+    bufferFree(&config->requestedExtensionNames);
+    bufferFree(&config->requestedLayerNames);
+#endif
+}
+
+VkCommandBuffer
+gfxBeginFrame(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+    GFXFrame * frame = context->frames.data + context->frameIndex;
+    GFXFrameTimes * frameTimes = &context->frameTimes;
+    PROF_ZONE("gfxBeginFrame");
+
+    // Wait until the GPU is done with this frame's resources from frames.count frames ago.
+    double startTime = utilGetTime();
+
+    {
+        PROF_ZONE("wait for frame fence");
+        vkWaitForFences(logicalDevice, 1, &frame->inFlightFence, VK_TRUE, UINT64_MAX);
+    }
+
+    double acquireStartTime = utilGetTime();
+    frameTimes->fenceWaitTime = acquireStartTime - startTime;
+
+    // The GPU is done with the frame's transient memory, compute work and GPU zone timestamps as well.
+    if(frame->gpuZoneCount > 0)
+    {
+        readGPUZones(context, frame);
+    }
+
+    memBeginFrame(&context->allocator, context->frameIndex);
+    descBeginFrame(&context->descriptorAllocator, context->frameIndex);
+    GFXComputeBatch * computeBatch = context->computeBatches.data + context->frameIndex;
+    vkResetCommandPool(logicalDevice, computeBatch->commandPool, 0);
+    computeBatch->dispatchCount = 0;
+    resetRecordingThreads(context);
+
+    // Resources retired by a previous swapchain recreation or shader reload may no longer be in use now that another
+    // frame completed.
+    destroyRetiredSwapchains(context, false);
+    destroyRetiredPipelines(context, false);
+
+    // Between frames is the only point shader modules and pipelines can be swapped without affecting recording.
+    if(context->shaderReloader != nullptr)
+    {
+        applyShaderReloads(context);
+    }
+
+    // Acquire render target for frame. The frame's fence is left signaled if no image can be acquired, so the frame can
+    // be skipped without side effects.
+    if(context->swapchain != VK_NULL_HANDLE)
+    {
+        if(!acquireSwapchainImage(context, frame))
+        {
+            return VK_NULL_HANDLE;
+        }
+    }
+    else
+    {
+        // Offscreen images are used round-robin.
+        context->imageIndex = (uint32_t)(context->frameCount % context->swapchainImages.count);
+    }
+
+    // If a previous frame still in flight is rendering to the acquired image, wait for it as well.
+    VkFence * imageFence = context->imageFences.data + context->imageIndex;
+
+    if(*imageFence != VK_NULL_HANDLE && *imageFence != frame->inFlightFence)
+    {
+        vkWaitForFences(logicalDevice, 1, imageFence, VK_TRUE, UINT64_MAX);
+    }
+
+    *imageFence = frame->inFlightFence;
+    vkResetFences(logicalDevice, 1, &frame->inFlightFence);
+    vkResetCommandPool(logicalDevice, frame->commandPool, 0);
+    context->recordStartTime = utilGetTime();
+    frameTimes->acquireTime = context->recordStartTime - acquireStartTime;
+
+    // Begin recording frame.
+
+    // typedef struct VkCommandBufferBeginInfo {
+    //     VkStructureType                          sType;
+    //     const void*                              pNext;
+    //     VkCommandBufferUsageFlags                flags;
+    //     const VkCommandBufferInheritanceInfo*    pInheritanceInfo;
+    // } VkCommandBufferBeginInfo;
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.pNext = nullptr;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = nullptr;
+    VkResult result = vkBeginCommandBuffer(frame->commandBuffer, &commandBufferBeginInfo);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to begin frame command buffer\n");
+    }
+
+    // Whether GPU zones are recorded is decided once per frame, as their queries must be reset before the first one
+    // is written.
+    context->profilingGPU = frame->timestampQueryPool != VK_NULL_HANDLE && profIsCapturing();
+    context->gpuZoneDepth = 0;
+
+    if(context->profilingGPU)
+    {
+        vkCmdResetQueryPool(frame->commandBuffer, frame->timestampQueryPool, 0, GFX_MAX_GPU_ZONES * 2);
+    }
+
+    gfxBeginGPUZone(context, frame->commandBuffer, "frame");
+
+    static const VkClearValue CLEAR_VALUE = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+    const VkExtent2D * extent = &context->swapchainConfig.extent;
+    bool graphRendersTarget = context->frameGraph != nullptr && context->frameGraphTarget != FG_INVALID_INDEX;
+
+    if(graphRendersTarget)
+    {
+        if(context->frameGraphTargetChanged)
+        {
+            fgResizeImage(context->frameGraph, context->frameGraphTarget, *extent);
+            context->frameGraphTargetChanged = false;
+        }
+
+        fgSetImage(context->frameGraph, context->frameGraphTarget, context->swapchainImages.data[context->imageIndex],
+                   context->swapchainImageViews.data[context->imageIndex]);
+    }
+
+    if(context->frameGraph != nullptr)
+    {
+        fgExecute(context->frameGraph, frame->commandBuffer);
+    }
+
+    // typedef struct VkRenderPassBeginInfo {
+    //     VkStructureType        sType;
+    //     const void*            pNext;
+    //     VkRenderPass           renderPass;
+    //     VkFramebuffer          framebuffer;
+    //     VkRect2D               renderArea;
+    //     uint32_t               clearValueCount;
+    //     const VkClearValue*    pClearValues;
+    // } VkRenderPassBeginInfo;
+    VkRenderPassBeginInfo renderPassBeginInfo = {};
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = nullptr;
+    renderPassBeginInfo.renderPass = graphRendersTarget ? context->loadRenderPass : context->renderPass;
+    renderPassBeginInfo.framebuffer = context->framebuffers.data[context->imageIndex];
+    renderPassBeginInfo.renderArea = { { 0, 0 }, *extent };
+    renderPassBeginInfo.clearValueCount = 1;
+    renderPassBeginInfo.pClearValues = &CLEAR_VALUE;
+    // With recording threads, the render pass only executes the secondary command buffers they record, and each
+    // secondary command buffer sets its own dynamic state.
+    if(context->recordingThreadCount > 0)
+    {
+        vkCmdBeginRenderPass(frame->commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        return frame->commandBuffer;
+    }
+
+    vkCmdBeginRenderPass(frame->commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    // Set dynamic state to cover the whole render target.
+    VkViewport viewport = { 0.0f, 0.0f, (float)extent->width, (float)extent->height, 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, *extent };
+    vkCmdSetViewport(frame->commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(frame->commandBuffer, 0, 1, &scissor);
+
+    return frame->commandBuffer;
+}
+
+void
+gfxEndFrame(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+    GFXFrame * frame = context->frames.data + context->frameIndex;
+    GFXFrameTimes * frameTimes = &context->frameTimes;
+    PROF_ZONE("gfxEndFrame");
+    double submitStartTime = utilGetTime();
+    frameTimes->recordTime = submitStartTime - context->recordStartTime;
+
+    // End recording frame.
+    if(context->recordingThreadCount > 0)
+    {
+        executeRecordingThreads(context, frame->commandBuffer);
+    }
+
+    vkCmdEndRenderPass(frame->commandBuffer);
+    gfxEndGPUZone(context, frame->commandBuffer);
+    PRISM_ASSERT(context->gpuZoneDepth == 0);
+    VkResult result = vkEndCommandBuffer(frame->commandBuffer);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to end frame command buffer\n");
+    }
+
+    // Submit the frame's uploads, then its compute work, so each can wait on the work before it; the frame's graphics
+    // work waits on the last of them, which transitively covers the rest.
+    GFXTransferBatch * transferBatch = context->transferBatches.data + context->frameIndex;
+    GFXComputeBatch * computeBatch = context->computeBatches.data + context->frameIndex;
+    VkSemaphore dependencySemaphore = VK_NULL_HANDLE;
+    VkSemaphore waitSemaphores[3] = {};
+    VkPipelineStageFlags waitStages[3] = {};
+    VkCommandBuffer commandBuffers[2] = {};
+    uint32_t waitSemaphoreCount = 0;
+    uint32_t commandBufferCount = 0;
+
+    // Every frame's graphics work signals its compute batch's graphicsFinishedSemaphore, so all but the first frame
+    // have the previous frame's to wait on.
+    uint32_t previousFrameIndex = (context->frameIndex + context->frames.count - 1) % context->frames.count;
+
+    VkSemaphore previousGraphicsSemaphore =
+        context->frameCount > 0 ? context->computeBatches.data[previousFrameIndex].graphicsFinishedSemaphore
+                                : VK_NULL_HANDLE;
+
+    if(transferBatch->recording)
+    {
+        if(submitTransferBatch(context, transferBatch))
+        {
+            commandBuffers[commandBufferCount++] = transferBatch->acquireCommandBuffer;
+        }
+
+        dependencySemaphore = transferBatch->transferFinishedSemaphore;
+    }
+
+    if(computeBatch->dispatchCount > 0)
+    {
+        VkSemaphore computeWaitSemaphores[2] = {};
+        uint32_t computeWaitSemaphoreCount = 0;
+
+        if(dependencySemaphore != VK_NULL_HANDLE)
+        {
+            computeWaitSemaphores[computeWaitSemaphoreCount++] = dependencySemaphore;
+        }
+
+        // Compute writes to buffers the previous frame's graphics work reads wait for it on the compute queue.
+        if(previousGraphicsSemaphore != VK_NULL_HANDLE)
+        {
+            computeWaitSemaphores[computeWaitSemaphoreCount++] = previousGraphicsSemaphore;
+            previousGraphicsSemaphore = VK_NULL_HANDLE;
+        }
+
+        submitComputeBatch(context, computeBatch, computeWaitSemaphores, computeWaitSemaphoreCount);
+        dependencySemaphore = computeBatch->computeFinishedSemaphore;
+    }
+
+    if(dependencySemaphore != VK_NULL_HANDLE)
+    {
+        waitSemaphores[waitSemaphoreCount] = dependencySemaphore;
+        waitStages[waitSemaphoreCount] = GRAPHICS_CONSUMER_STAGES;
+        waitSemaphoreCount++;
+    }
+
+    // Without compute work to wait on it, the previous frame's signal is consumed here so the semaphore is unsignaled
+    // before its frame signals it again; the graphics queue already runs the previous frame's work first.
+    if(previousGraphicsSemaphore != VK_NULL_HANDLE)
+    {
+        waitSemaphores[waitSemaphoreCount] = previousGraphicsSemaphore;
+        waitStages[waitSemaphoreCount] = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        waitSemaphoreCount++;
+    }
+
+    commandBuffers[commandBufferCount++] = frame->commandBuffer;
+
+    // Submit frame; without a swapchain there is nothing to wait on or signal besides the frame's fence, its uploads
+    // and compute work, and the semaphores ordering it against the next frame's compute work.
+    bool presenting = context->swapchain != VK_NULL_HANDLE;
+    VkSemaphore signalSemaphores[2] = {};
+    uint32_t signalSemaphoreCount = 0;
+    signalSemaphores[signalSemaphoreCount++] = computeBatch->graphicsFinishedSemaphore;
+
+    if(presenting)
+    {
+        signalSemaphores[signalSemaphoreCount++] = frame->renderFinishedSemaphore;
+
+        // A frame graph rendering to the image transitions it from whatever stage its first access is in, so all of the
+        // frame's commands wait for the image then.
+        bool graphRendersTarget = context->frameGraph != nullptr && context->frameGraphTarget != FG_INVALID_INDEX;
+        waitSemaphores[waitSemaphoreCount] = frame->imageAcquiredSemaphore;
+
+        waitStages[waitSemaphoreCount] =
+            graphRendersTarget ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+        waitSemaphoreCount++;
+    }
+
+    // typedef struct VkSubmitInfo {
+    //     VkStructureType                sType;
+    //     const void*                    pNext;
+    //     uint32_t                       waitSemaphoreCount;
+    //     const VkSemaphore*             pWaitSemaphores;
+    //     const VkPipelineStageFlags*    pWaitDstStageMask;
+    //     uint32_t                       commandBufferCount;
+    //     const VkCommandBuffer*         pCommandBuffers;
+    //     uint32_t                       signalSemaphoreCount;
+    //     const VkSemaphore*             pSignalSemaphores;
+    // } VkSubmitInfo;
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = nullptr;
+    submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = commandBufferCount;
+    submitInfo.pCommandBuffers = commandBuffers;
+    submitInfo.signalSemaphoreCount = signalSemaphoreCount;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+
+    if(frame->gpuZoneCount > 0)
+    {
+        frame->submitTime = profGetTime();
+    }
+
+    result = vkQueueSubmit(context->queueInfo.queues[QUEUE_FAMILY_INDEX(GRAPHICS)], 1, &submitInfo,
+                           frame->inFlightFence);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to submit frame\n");
+    }
+
+    // Present frame.
+    if(presenting)
+    {
+        // typedef struct VkPresentInfoKHR {
+        //     VkStructureType          sType;
+        //     const void*              pNext;
+        //     uint32_t                 waitSemaphoreCount;
+        //     const VkSemaphore*       pWaitSemaphores;
+        //     uint32_t                 swapchainCount;
+        //     const VkSwapchainKHR*    pSwapchains;
+        //     const uint32_t*          pImageIndices;
+        //     VkResult*                pResults;
+        // } VkPresentInfoKHR;
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.pNext = nullptr;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &frame->renderFinishedSemaphore;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &context->swapchain;
+        presentInfo.pImageIndices = &context->imageIndex;
+        presentInfo.pResults = nullptr;
+        result = vkQueuePresentKHR(context->queueInfo.queues[QUEUE_FAMILY_INDEX(PRESENT)], &presentInfo);
+
+        // The swapchain no longer matches the surface, so recreate it at the start of the next frame.
+        if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        {
+            context->swapchainOutOfDate = true;
+        }
+        else if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to present frame\n");
+        }
+    }
+
+    frameTimes->submitTime = utilGetTime() - submitStartTime;
+
+#ifdef PRISM_DEBUG
+    logDebugMessageSummary(context->debugMessageLog, false);
+#endif
+
+    // Advance to next frame's resources.
+    context->frameIndex = (context->frameIndex + 1) % context->frames.count;
+    context->frameCount++;
+}
+
+VkCommandBuffer
+gfxBeginSecondary(GFXContext * context, uint32_t threadIndex)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(threadIndex < context->recordingThreadCount);
+    GFXRecordingThread * recordingThread =
+        context->recordingThreads.data + context->frameIndex * context->recordingThreadCount + threadIndex;
+
+    if(recordingThread->usedCount == GFX_MAX_SECONDARY_COMMAND_BUFFERS)
+    {
+        utilErrorExit("VULKAN", nullptr, "recording thread %u recorded more than %u secondary command buffers\n",
+                      threadIndex, GFX_MAX_SECONDARY_COMMAND_BUFFERS);
+    }
+
+    // Allocate another secondary command buffer the first time a frame needs this many; they are reused afterwards.
+    if(recordingThread->usedCount == recordingThread->allocatedCount)
+    {
+        // typedef struct VkCommandBufferAllocateInfo {
+        //     VkStructureType         sType;
+        //     const void*             pNext;
+        //     VkCommandPool           commandPool;
+        //     VkCommandBufferLevel    level;
+        //     uint32_t                commandBufferCount;
+        // } VkCommandBufferAllocateInfo;
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.pNext = nullptr;
+        commandBufferAllocateInfo.commandPool = recordingThread->commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+
+        VkResult result =
+            vkAllocateCommandBuffers(context->logicalDevice, &commandBufferAllocateInfo,
+                                     recordingThread->commandBuffers + recordingThread->allocatedCount);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to allocate secondary command buffer\n");
+        }
+
+        recordingThread->allocatedCount++;
+    }
+
+    VkCommandBuffer commandBuffer = recordingThread->commandBuffers[recordingThread->usedCount];
+    recordingThread->usedCount++;
+
+    // typedef struct VkCommandBufferInheritanceInfo {
+    //     VkStructureType                  sType;
+    //     const void*                      pNext;
+    //     VkRenderPass                     renderPass;
+    //     uint32_t                         subpass;
+    //     VkFramebuffer                    framebuffer;
+    //     VkBool32                         occlusionQueryEnable;
+    //     VkQueryControlFlags              queryFlags;
+    //     VkQueryPipelineStatisticFlags    pipelineStatistics;
+    // } VkCommandBufferInheritanceInfo;
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = nullptr;
+    inheritanceInfo.renderPass = context->renderPass;
+    inheritanceInfo.subpass = 0;
+
+    // Specifying the framebuffer is optional, but lets the driver optimize for it.
+    inheritanceInfo.framebuffer = context->framebuffers.data[context->imageIndex];
+
+    inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+    inheritanceInfo.queryFlags = 0;
+    inheritanceInfo.pipelineStatistics = 0;
+
+    // typedef struct VkCommandBufferBeginInfo {
+    //     VkStructureType                          sType;
+    //     const void*                              pNext;
+    //     VkCommandBufferUsageFlags                flags;
+    //     const VkCommandBufferInheritanceInfo*    pInheritanceInfo;
+    // } VkCommandBufferBeginInfo;
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.pNext = nullptr;
+
+    commandBufferBeginInfo.flags =
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+
+    commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+    VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to begin secondary command buffer\n");
+    }
+
+    // Dynamic state isn't inherited from the primary command buffer.
+    const VkExtent2D * extent = &context->swapchainConfig.extent;
+    VkViewport viewport = { 0.0f, 0.0f, (float)extent->width, (float)extent->height, 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, *extent };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    return commandBuffer;
+}
+
+void
+gfxCreateBuffer(GFXContext * context, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags,
+                bool computeShared, GFXBuffer * buffer)
 {
-    PRISM_ASSERT(config != nullptr);
-    QueueInfo queueInfo = {};
-    SwapchainInfo swapchainInfo = {};
-    SwapchainConfig swapchainConfig = {};
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(size > 0);
+    PRISM_ASSERT(buffer != nullptr);
+    VkLogicalDevice logicalDevice = context->logicalDevice;
 
-#ifdef PRISM_DEBUG
-    // Add debug extensions and layers for logging.
-    static const char * DEBUG_EXTENSION_NAMES[]
+    // Compute-shared buffers are shared concurrently by every queue-family that may access them.
+    const uint32_t * familyIndexes = context->queueInfo.familyIndexes;
+    uint32_t sharingFamilyIndexes[3] = {};
+    uint32_t sharingFamilyIndexCount = 0;
+
+    if(computeShared)
     {
-        VK_EXT_DEBUG_REPORT_EXTENSION_NAME,
-    };
+        static const size_t SHARING_FAMILIES[]
+        {
+            QUEUE_FAMILY_INDEX(GRAPHICS),
+            QUEUE_FAMILY_INDEX(TRANSFER),
+            QUEUE_FAMILY_INDEX(COMPUTE),
+        };
 
-    static const char * DEBUG_LAYER_NAMES[] =
+        for(size_t i = 0; i < sizeof(SHARING_FAMILIES) / sizeof(size_t); i++)
+        {
+            uint32_t familyIndex = familyIndexes[SHARING_FAMILIES[i]];
+            uint32_t sharingIndex = 0;
+
+            while(sharingIndex < sharingFamilyIndexCount && sharingFamilyIndexes[sharingIndex] != familyIndex)
+            {
+                sharingIndex++;
+            }
+
+            if(sharingIndex == sharingFamilyIndexCount)
+            {
+                sharingFamilyIndexes[sharingFamilyIndexCount++] = familyIndex;
+            }
+        }
+    }
+
+    // typedef struct VkBufferCreateInfo {
+    //     VkStructureType        sType;
+    //     const void*            pNext;
+    //     VkBufferCreateFlags    flags;
+    //     VkDeviceSize           size;
+    //     VkBufferUsageFlags     usage;
+    //     VkSharingMode          sharingMode;
+    //     uint32_t               queueFamilyIndexCount;
+    //     const uint32_t*        pQueueFamilyIndices;
+    // } VkBufferCreateInfo;
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext = nullptr;
+    bufferCreateInfo.flags = 0;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    if(sharingFamilyIndexCount > 1)
     {
-        "VK_LAYER_LUNARG_standard_validation",
-    };
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferCreateInfo.queueFamilyIndexCount = sharingFamilyIndexCount;
+        bufferCreateInfo.pQueueFamilyIndices = sharingFamilyIndexes;
+    }
+    else
+    {
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bufferCreateInfo.queueFamilyIndexCount = 0;
+        bufferCreateInfo.pQueueFamilyIndices = nullptr;
+    }
 
-    GFXConfig debugConfig =
+    VkResult result = vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, &buffer->buffer);
+
+    if(result != VK_SUCCESS)
     {
-        bufferConcat(&config->requestedExtensionNames, DEBUG_EXTENSION_NAMES,
-                     sizeof(DEBUG_EXTENSION_NAMES) / sizeof(void *)),
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create buffer\n");
+    }
 
-        bufferConcat(&config->requestedLayerNames, DEBUG_LAYER_NAMES, sizeof(DEBUG_LAYER_NAMES) / sizeof(void *)),
-        config->createSurfaceFnData,
-        config->createSurfaceFn,
-    };
+    // Small buffers are pooled; the pool strategy falls back to buddy allocation for large ones.
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(logicalDevice, buffer->buffer, &memoryRequirements);
 
-    config = &debugConfig;
-#endif
+    if(!memAllocate(&context->allocator, MEMStrategy::POOL, MEMResourceType::LINEAR, &memoryRequirements, memoryFlags,
+                    0, &buffer->memory))
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to allocate memory for buffer\n");
+    }
 
-    // Create instance from config.
-    VkInstance instance = createInstance(config);
+    result = vkBindBufferMemory(logicalDevice, buffer->buffer, buffer->memory.memory, buffer->memory.offset);
 
-#ifdef PRISM_DEBUG
-    // In debug mode, create a debug callback for logging.
-    /*VkDebugReportCallbackEXT debugCallbackHandle = */createDebugCallback(instance);
-#endif
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to bind memory for buffer\n");
+    }
 
-    VkSurfaceKHR surface = config->createSurfaceFn(config->createSurfaceFnData, instance);
+    buffer->size = size;
+    buffer->concurrent = sharingFamilyIndexCount > 1;
+}
 
-    // Create devices.
-    VkPhysicalDevice physicalDevice = getPhysicalDevice(instance, surface, &swapchainInfo);
-    getQueueFamilyIndexes(physicalDevice, surface, &queueInfo);
-    VkLogicalDevice logicalDevice = createLogicalDevice(physicalDevice, &queueInfo);
-    getQueues(logicalDevice, &queueInfo);
+void
+gfxDestroyBuffer(GFXContext * context, GFXBuffer * buffer)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(buffer != nullptr);
+    vkDestroyBuffer(context->logicalDevice, buffer->buffer, nullptr);
+    memFree(&context->allocator, &buffer->memory);
+    *buffer = {};
+}
 
-    // Create swapchain.
-    createSwapchainConfig(&swapchainInfo, &swapchainConfig);
-    VkSwapchainKHR swapchain = createSwapchain(surface, logicalDevice, &queueInfo, &swapchainConfig);
-    Buffer<VkImage> swapchainImages = getSwapchainImages(logicalDevice, swapchain);
+bool
+gfxUploadBuffer(GFXContext * context, const GFXBuffer * buffer, VkDeviceSize offset, const void * data,
+                VkDeviceSize size)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(buffer != nullptr);
+    PRISM_ASSERT(data != nullptr);
+    PRISM_ASSERT(size > 0);
+    PRISM_ASSERT(offset + size <= buffer->size);
+    const uint32_t * familyIndexes = context->queueInfo.familyIndexes;
+    uint32_t graphicsFamilyIndex = familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)];
+    uint32_t transferFamilyIndex = familyIndexes[QUEUE_FAMILY_INDEX(TRANSFER)];
+    bool transferOwnership = graphicsFamilyIndex != transferFamilyIndex && !buffer->concurrent;
+    GFXTransferBatch * transferBatch = beginTransferBatch(context);
+
+    if(transferOwnership && transferBatch->bufferAcquireBarrierCount == GFX_MAX_UPLOAD_BARRIERS)
+    {
+        return false;
+    }
 
-    Buffer<VkImageView> swapchainImageViews =
-        createSwapchainImageViews(logicalDevice, &swapchainImages, &swapchainConfig);
+    VkDeviceSize stagingOffset = reserveStagingMemory(context, size, STAGING_ALIGNMENT);
 
-    // Shader Pipeline
-    VkShaderModule vertShaderModule = createShaderModule(logicalDevice, "./data/shaders/bin/tutorial.vert.spv");
-    VkShaderModule fragShaderModule = createShaderModule(logicalDevice, "./data/shaders/bin/tutorial.frag.spv");
+    if(stagingOffset == VK_WHOLE_SIZE)
+    {
+        return false;
+    }
 
-    // Cleanup.
-    // bufferFree(&swapchainImages);
+    memcpy((uint8_t *)context->stagingRing.memory.mapped + stagingOffset, data, size);
+    VkBufferCopy region = { stagingOffset, offset, size };
+    vkCmdCopyBuffer(transferBatch->commandBuffer, context->stagingRing.buffer, buffer->buffer, 1, &region);
 
-#ifdef PRISM_DEBUG
-    bufferFree(&config->requestedExtensionNames);
-    bufferFree(&config->requestedLayerNames);
-#endif
+    // Without an ownership transfer, the semaphore the frame's work waits on makes the copy visible.
+    if(!transferOwnership)
+    {
+        return true;
+    }
+
+    // Release ownership to the graphics queue-family; the matching acquire is recorded at submission.
+
+    // typedef struct VkBufferMemoryBarrier {
+    //     VkStructureType    sType;
+    //     const void*        pNext;
+    //     VkAccessFlags      srcAccessMask;
+    //     VkAccessFlags      dstAccessMask;
+    //     uint32_t           srcQueueFamilyIndex;
+    //     uint32_t           dstQueueFamilyIndex;
+    //     VkBuffer           buffer;
+    //     VkDeviceSize       offset;
+    //     VkDeviceSize       size;
+    // } VkBufferMemoryBarrier;
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0; // Ignored by releases.
+    barrier.srcQueueFamilyIndex = transferFamilyIndex;
+    barrier.dstQueueFamilyIndex = graphicsFamilyIndex;
+    barrier.buffer = buffer->buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    vkCmdPipelineBarrier(transferBatch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    barrier.srcAccessMask = 0; // Ignored by acquires.
+    barrier.dstAccessMask = GRAPHICS_CONSUMER_ACCESS;
+    transferBatch->bufferAcquireBarriers.data[transferBatch->bufferAcquireBarrierCount] = barrier;
+    transferBatch->bufferAcquireBarrierCount++;
+
+    return true;
+}
+
+uint32_t
+gfxGetTexelSize(VkFormat format)
+{
+    switch(format)
+    {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R16_SFLOAT:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+bool
+gfxUploadImage(GFXContext * context, VkImage image, VkFormat format, uint32_t mipLevel, VkExtent3D extent,
+               const void * data, VkDeviceSize size)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(image != VK_NULL_HANDLE);
+    PRISM_ASSERT(gfxGetTexelSize(format) > 0);
+    PRISM_ASSERT(data != nullptr);
+    PRISM_ASSERT(size >= (VkDeviceSize)extent.width * extent.height * extent.depth * gfxGetTexelSize(format));
+    const uint32_t * familyIndexes = context->queueInfo.familyIndexes;
+    uint32_t graphicsFamilyIndex = familyIndexes[QUEUE_FAMILY_INDEX(GRAPHICS)];
+    uint32_t transferFamilyIndex = familyIndexes[QUEUE_FAMILY_INDEX(TRANSFER)];
+    bool transferOwnership = graphicsFamilyIndex != transferFamilyIndex;
+    GFXTransferBatch * transferBatch = beginTransferBatch(context);
+
+    if(transferOwnership && transferBatch->imageAcquireBarrierCount == GFX_MAX_UPLOAD_BARRIERS)
+    {
+        return false;
+    }
+
+    VkDeviceSize stagingOffset = reserveStagingMemory(context, size, STAGING_ALIGNMENT);
+
+    if(stagingOffset == VK_WHOLE_SIZE)
+    {
+        return false;
+    }
+
+    memcpy((uint8_t *)context->stagingRing.memory.mapped + stagingOffset, data, size);
+
+    // Transition mip level for copying; its previous contents are discarded.
+
+    // typedef struct VkImageMemoryBarrier {
+    //     VkStructureType            sType;
+    //     const void*                pNext;
+    //     VkAccessFlags              srcAccessMask;
+    //     VkAccessFlags              dstAccessMask;
+    //     VkImageLayout              oldLayout;
+    //     VkImageLayout              newLayout;
+    //     uint32_t                   srcQueueFamilyIndex;
+    //     uint32_t                   dstQueueFamilyIndex;
+    //     VkImage                    image;
+    //     VkImageSubresourceRange    subresourceRange;
+    // } VkImageMemoryBarrier;
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mipLevel, 1, 0, 1 };
+
+    vkCmdPipelineBarrier(transferBatch->commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    // typedef struct VkBufferImageCopy {
+    //     VkDeviceSize                bufferOffset;
+    //     uint32_t                    bufferRowLength;
+    //     uint32_t                    bufferImageHeight;
+    //     VkImageSubresourceLayers    imageSubresource;
+    //     VkOffset3D                  imageOffset;
+    //     VkExtent3D                  imageExtent;
+    // } VkBufferImageCopy;
+    VkBufferImageCopy region = {};
+    region.bufferOffset = stagingOffset;
+    region.bufferRowLength = 0; // Tightly packed.
+    region.bufferImageHeight = 0;
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mipLevel, 0, 1 };
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = extent;
+
+    vkCmdCopyBufferToImage(transferBatch->commandBuffer, context->stagingRing.buffer, image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // Transition mip level for sampling; with an ownership transfer, this releases it to the graphics queue-family and
+    // the matching acquire (with the same transition) is recorded at submission.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0; // Made visible by the graphics queue's semaphore wait or acquire.
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    if(transferOwnership)
+    {
+        barrier.srcQueueFamilyIndex = transferFamilyIndex;
+        barrier.dstQueueFamilyIndex = graphicsFamilyIndex;
+    }
+
+    vkCmdPipelineBarrier(transferBatch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    if(transferOwnership)
+    {
+        barrier.srcAccessMask = 0; // Ignored by acquires.
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        transferBatch->imageAcquireBarriers.data[transferBatch->imageAcquireBarrierCount] = barrier;
+        transferBatch->imageAcquireBarrierCount++;
+    }
+
+    return true;
+}
+
+void
+gfxCreateComputePipeline(GFXContext * context, const GFXShader * shader, uint32_t storageBufferCount,
+                         uint32_t pushConstantSize, GFXComputePipeline * computePipeline)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(shader != nullptr);
+    PRISM_ASSERT(shader->modules[(size_t)GFXShaderStage::COMPUTE] != VK_NULL_HANDLE);
+    PRISM_ASSERT(storageBufferCount <= GFX_MAX_COMPUTE_BUFFERS);
+    PRISM_ASSERT(computePipeline != nullptr);
+    PRISM_ASSERT(context->computePipelineCount < GFX_MAX_COMPUTE_PIPELINES);
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+
+    // Storage buffers are bound in order, starting at binding 0.
+    VkDescriptorSetLayoutBinding bindings[GFX_MAX_COMPUTE_BUFFERS] = {};
+
+    for(uint32_t i = 0; i < storageBufferCount; i++)
+    {
+        // typedef struct VkDescriptorSetLayoutBinding {
+        //     uint32_t              binding;
+        //     VkDescriptorType      descriptorType;
+        //     uint32_t              descriptorCount;
+        //     VkShaderStageFlags    stageFlags;
+        //     const VkSampler*      pImmutableSamplers;
+        // } VkDescriptorSetLayoutBinding;
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = nullptr;
+    }
+
+    // typedef struct VkDescriptorSetLayoutCreateInfo {
+    //     VkStructureType                        sType;
+    //     const void*                            pNext;
+    //     VkDescriptorSetLayoutCreateFlags       flags;
+    //     uint32_t                               bindingCount;
+    //     const VkDescriptorSetLayoutBinding*    pBindings;
+    // } VkDescriptorSetLayoutCreateInfo;
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+    descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.pNext = nullptr;
+    descriptorSetLayoutCreateInfo.flags = 0;
+    descriptorSetLayoutCreateInfo.bindingCount = storageBufferCount;
+    descriptorSetLayoutCreateInfo.pBindings = bindings;
+
+    VkResult result = vkCreateDescriptorSetLayout(logicalDevice, &descriptorSetLayoutCreateInfo, nullptr,
+                                                  &computePipeline->descriptorSetLayout);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create compute descriptor set layout\n");
+    }
+
+    // typedef struct VkPushConstantRange {
+    //     VkShaderStageFlags    stageFlags;
+    //     uint32_t              offset;
+    //     uint32_t              size;
+    // } VkPushConstantRange;
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+
+    // typedef struct VkPipelineLayoutCreateInfo {
+    //     VkStructureType                 sType;
+    //     const void*                     pNext;
+    //     VkPipelineLayoutCreateFlags     flags;
+    //     uint32_t                        setLayoutCount;
+    //     const VkDescriptorSetLayout*    pSetLayouts;
+    //     uint32_t                        pushConstantRangeCount;
+    //     const VkPushConstantRange*      pPushConstantRanges;
+    // } VkPipelineLayoutCreateInfo;
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = nullptr;
+    pipelineLayoutCreateInfo.flags = 0; // Reserved for future use.
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &computePipeline->descriptorSetLayout;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    result = vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr,
+                                    &computePipeline->pipelineLayout);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create compute pipeline layout\n");
+    }
+
+    computePipeline->pipeline =
+        tryCreateComputePipeline(logicalDevice, context->pipelineCache, computePipeline->pipelineLayout,
+                                 shader->modules[(size_t)GFXShaderStage::COMPUTE]);
+
+    if(computePipeline->pipeline == VK_NULL_HANDLE)
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to create compute pipeline for shader \"%s\"\n", shader->name);
+    }
+
+    computePipeline->storageBufferCount = storageBufferCount;
+    computePipeline->pushConstantSize = pushConstantSize;
+    strcpy(computePipeline->shaderName, shader->name);
+    context->computePipelines[context->computePipelineCount++] = computePipeline;
 }
 
-// void
-// gfxDestroy(GFXContext * context)
-// {
-//     PRISM_ASSERT(context != nullptr);
-//     PRISM_ASSERT(context->instance != VK_NULL_HANDLE);
-//     PRISM_ASSERT(context->surface != VK_NULL_HANDLE);
-//     PRISM_ASSERT(context->logicalDevice != VK_NULL_HANDLE);
-//     VkInstance instance = context->instance;
-//     VkLogicalDevice logicalDevice = context->logicalDevice;
-//     SwapchainInfo * swapchainInfo = &context->swapchainInfo;
+void
+gfxDestroyComputePipeline(GFXContext * context, GFXComputePipeline * computePipeline)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(computePipeline != nullptr);
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+
+    // Stop rebuilding the pipeline on reloads; the last pipeline takes its place.
+    for(uint32_t i = 0; i < context->computePipelineCount; i++)
+    {
+        if(context->computePipelines[i] == computePipeline)
+        {
+            context->computePipelines[i] = context->computePipelines[--context->computePipelineCount];
+            break;
+        }
+    }
+
+    vkDestroyPipeline(logicalDevice, computePipeline->pipeline, nullptr);
+    vkDestroyPipelineLayout(logicalDevice, computePipeline->pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(logicalDevice, computePipeline->descriptorSetLayout, nullptr);
+    *computePipeline = {};
+}
+
+void
+gfxDispatch(GFXContext * context, const GFXComputePipeline * computePipeline, const GFXBuffer * const * storageBuffers,
+            const void * pushConstants, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(computePipeline != nullptr);
+    PRISM_ASSERT(storageBuffers != nullptr || computePipeline->storageBufferCount == 0);
+    PRISM_ASSERT(pushConstants != nullptr || computePipeline->pushConstantSize == 0);
+    PROF_ZONE("gfxDispatch");
+    GFXComputeBatch * computeBatch = context->computeBatches.data + context->frameIndex;
+
+    if(computeBatch->dispatchCount == GFX_MAX_DISPATCHES)
+    {
+        utilErrorExit("VULKAN", nullptr, "more than %u dispatches in one frame\n", GFX_MAX_DISPATCHES);
+    }
+
+    VkCommandBuffer commandBuffer = computeBatch->commandBuffer;
+
+    if(computeBatch->dispatchCount == 0)
+    {
+        // typedef struct VkCommandBufferBeginInfo {
+        //     VkStructureType                          sType;
+        //     const void*                              pNext;
+        //     VkCommandBufferUsageFlags                flags;
+        //     const VkCommandBufferInheritanceInfo*    pInheritanceInfo;
+        // } VkCommandBufferBeginInfo;
+        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        commandBufferBeginInfo.pNext = nullptr;
+        commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        commandBufferBeginInfo.pInheritanceInfo = nullptr;
+        VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to begin compute command buffer\n");
+        }
+    }
+    else
+    {
+        // Make previous dispatches' writes visible to this one.
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.pNext = nullptr;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    // Bind storage buffers through a transient descriptor set; dispatches with the same pipeline and buffers share one.
+    DESCBinding bindings[GFX_MAX_COMPUTE_BUFFERS] = {};
+
+    for(uint32_t i = 0; i < computePipeline->storageBufferCount; i++)
+    {
+        bindings[i].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].bufferInfo = { storageBuffers[i]->buffer, 0, VK_WHOLE_SIZE };
+    }
+
+    VkDescriptorSet descriptorSet =
+        descGetTransientSet(&context->descriptorAllocator, computePipeline->descriptorSetLayout, bindings,
+                            computePipeline->storageBufferCount);
+
+    // Record dispatch.
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline->pipeline);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline->pipelineLayout, 0, 1,
+                            &descriptorSet, 0, nullptr);
+
+    if(computePipeline->pushConstantSize > 0)
+    {
+        vkCmdPushConstants(commandBuffer, computePipeline->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           computePipeline->pushConstantSize, pushConstants);
+    }
+
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+    computeBatch->dispatchCount++;
+}
+
+const GFXShader *
+gfxGetShader(const GFXContext * context, const char * name)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(name != nullptr);
+    const Buffer<GFXShader> * shaders = &context->shaders;
+    return (const GFXShader *)bsearch(name, shaders->data, shaders->count, sizeof(GFXShader), compareShaderNames);
+}
+
+void
+gfxBeginGPUZone(GFXContext * context, VkCommandBuffer commandBuffer, const char * name)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(context->gpuZoneDepth < GFX_MAX_GPU_ZONE_DEPTH);
+    GFXFrame * frame = context->frames.data + context->frameIndex;
+    uint32_t zoneIndex = UINT32_MAX;
+
+    if(context->profilingGPU && frame->gpuZoneCount < GFX_MAX_GPU_ZONES)
+    {
+        zoneIndex = frame->gpuZoneCount++;
+        frame->gpuZoneNames[zoneIndex] = name;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->timestampQueryPool, zoneIndex * 2);
+    }
+
+    context->gpuZoneStack[context->gpuZoneDepth++] = zoneIndex;
+}
+
+void
+gfxEndGPUZone(GFXContext * context, VkCommandBuffer commandBuffer)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(context->gpuZoneDepth > 0);
+    GFXFrame * frame = context->frames.data + context->frameIndex;
+    uint32_t zoneIndex = context->gpuZoneStack[--context->gpuZoneDepth];
+
+    if(zoneIndex != UINT32_MAX)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame->timestampQueryPool,
+                            zoneIndex * 2 + 1);
+    }
+}
+
+void
+gfxSetFrameGraph(GFXContext * context, FGGraph * frameGraph, uint32_t renderTarget)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(frameGraph != nullptr || renderTarget == FG_INVALID_INDEX);
+    context->frameGraph = frameGraph;
+    context->frameGraphTarget = renderTarget;
+    context->frameGraphTargetChanged = true;
+}
+
+void
+gfxInvalidateSwapchain(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+
+    // Offscreen images don't depend on a surface.
+    if(context->swapchain != VK_NULL_HANDLE)
+    {
+        context->swapchainOutOfDate = true;
+    }
+}
+
+void
+gfxWaitIdle(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+    vkDeviceWaitIdle(context->logicalDevice);
+}
+
+void
+gfxDestroy(GFXContext * context)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(context->instance != VK_NULL_HANDLE);
+    PRISM_ASSERT(context->logicalDevice != VK_NULL_HANDLE);
+    VkInstance instance = context->instance;
+    VkLogicalDevice logicalDevice = context->logicalDevice;
+    SwapchainInfo * swapchainInfo = &context->swapchainInfo;
+
+    // Ensure no frames are still in flight before destroying their resources.
+    vkDeviceWaitIdle(logicalDevice);
+    destroyRetiredSwapchains(context, true);
+    destroyRetiredPipelines(context, true);
+
+    // Stop shader hot-reload before destroying the shader library it reloads into.
+    if(context->shaderReloader != nullptr)
+    {
+        destroyShaderReloader(context->shaderReloader);
+    }
+
+    // Destroy uploads and per-frame resources. Command buffers are implicitly freed with their pools.
+    destroyTransferBatches(logicalDevice, &context->transferBatches);
+    destroyComputeBatches(logicalDevice, &context->computeBatches);
+    destroyRecordingThreads(logicalDevice, &context->recordingThreads);
+    vkDestroyBuffer(logicalDevice, context->stagingRing.buffer, nullptr);
+    memFree(&context->allocator, &context->stagingRing.memory);
+
+    for(size_t i = 0; i < context->frames.count; i++)
+    {
+        GFXFrame * frame = context->frames.data + i;
+        vkDestroyFence(logicalDevice, frame->inFlightFence, nullptr);
+        vkDestroySemaphore(logicalDevice, frame->renderFinishedSemaphore, nullptr);
+        vkDestroySemaphore(logicalDevice, frame->imageAcquiredSemaphore, nullptr);
+        vkDestroyCommandPool(logicalDevice, frame->commandPool, nullptr);
+
+        if(frame->timestampQueryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(logicalDevice, frame->timestampQueryPool, nullptr);
+        }
+    }
+
+    bufferFree(&context->frames);
+    bufferFree(&context->imageFences);
+
+    // Destroy shader pipeline.
+    vkDestroyPipeline(logicalDevice, context->pipeline, nullptr);
+    vkDestroyPipelineLayout(logicalDevice, context->pipelineLayout, nullptr);
+
+    for(size_t i = 0; i < context->shaders.count; i++)
+    {
+        for(size_t stageIndex = 0; stageIndex < (size_t)GFXShaderStage::COUNT; stageIndex++)
+        {
+            VkShaderModule shaderModule = context->shaders.data[i].modules[stageIndex];
+
+            if(shaderModule != VK_NULL_HANDLE)
+            {
+                vkDestroyShaderModule(logicalDevice, shaderModule, nullptr);
+            }
+        }
+    }
+
+    bufferFree(&context->shaders);
+
+    // Save pipeline cache for the next run before destroying it.
+    if(context->pipelineCachePath.count > 0)
+    {
+        savePipelineCache(context->physicalDevice, logicalDevice, context->pipelineCache,
+                          context->pipelineCachePath.data);
 
-//     // Free array of swapchain image handles.
-//     free(context->swapchainImages);
+        bufferFree(&context->pipelineCachePath);
+    }
+
+    vkDestroyPipelineCache(logicalDevice, context->pipelineCache, nullptr);
+
+    // Destroy render targets.
+    for(size_t i = 0; i < context->framebuffers.count; i++)
+    {
+        vkDestroyFramebuffer(logicalDevice, context->framebuffers.data[i], nullptr);
+    }
+
+    for(size_t i = 0; i < context->swapchainImageViews.count; i++)
+    {
+        vkDestroyImageView(logicalDevice, context->swapchainImageViews.data[i], nullptr);
+    }
+
+    vkDestroyRenderPass(logicalDevice, context->renderPass, nullptr);
+    vkDestroyRenderPass(logicalDevice, context->loadRenderPass, nullptr);
+
+    // Swapchain images are implicitly destroyed with the swapchain, but offscreen images are owned by prism.
+    for(size_t i = 0; i < context->offscreenImageMemory.count; i++)
+    {
+        vkDestroyImage(logicalDevice, context->swapchainImages.data[i], nullptr);
+        memFree(&context->allocator, context->offscreenImageMemory.data + i);
+    }
+
+    bufferFree(&context->framebuffers);
+    bufferFree(&context->swapchainImageViews);
+
+    if(context->spareFramebuffers.count > 0)
+    {
+        bufferFree(&context->spareFramebuffers);
+    }
 
-//     // Free swapchain info.
-//     free(swapchainInfo->availableSurfaceFormats);
-//     free(swapchainInfo->availableSurfacePresentModes);
+    if(context->spareImageViews.count > 0)
+    {
+        bufferFree(&context->spareImageViews);
+    }
+
+    bufferFree(&context->swapchainImages);
+    bufferFree(&context->offscreenImageMemory);
+
+    // Free swapchain info.
+    bufferFree(&swapchainInfo->availableSurfaceFormats);
+    bufferFree(&swapchainInfo->availableSurfacePresentModes);
+
+    // Destroy swapchain before destroying logical-device.
+    if(context->swapchain != VK_NULL_HANDLE)
+    {
+        vkDestroySwapchainKHR(logicalDevice, context->swapchain, nullptr);
+    }
+
+    // Free descriptor pools and device memory before destroying logical-device.
+#ifdef PRISM_DEBUG
+    descLogStats(&context->descriptorAllocator);
+    memLogStats(&context->allocator);
+#endif
 
-//     // Images created for swapchain will be implicitly destroyed.
-//     // Destroy swapchain before destroying logical-device.
-//     vkDestroySwapchainKHR(logicalDevice, context->swapchain, nullptr);
+    descDestroy(&context->descriptorAllocator);
 
-//     // Graphics-queue will be implicitly destroyed when logical-device is destroyed.
-//     vkDestroyDevice(logicalDevice, nullptr);
+    memDestroy(&context->allocator);
 
-//     // Surface must be destroyed before instance.
-//     vkDestroySurfaceKHR(instance, context->surface, nullptr);
+    // Queues will be implicitly destroyed when logical-device is destroyed.
+    vkDestroyDevice(logicalDevice, nullptr);
+
+    // Surface must be destroyed before instance.
+    if(context->surface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(instance, context->surface, nullptr);
+    }
 
-// #ifdef PRISM_DEBUG
-//     // Destroy debug callback before destroying instance.
-//     destroyDebugCallback(context);
-// #endif
+#ifdef PRISM_DEBUG
+    // Destroy debug callback before destroying instance.
+    destroyDebugCallback(context);
+#endif
 
-//     // Physical-device will be implicitly destroyed when instance is destroyed.
-//     vkDestroyInstance(instance, nullptr);
-// }
+    // Physical-device will be implicitly destroyed when instance is destroyed.
+    vkDestroyInstance(instance, nullptr);
+}
 
 } // namespace prism
@@ -3,10 +3,39 @@
 #include <cstdint>
 #include "vulkan/vulkan.h"
 #include "ctk/memory.h"
+#include "prism/memory.h"
+#include "prism/descriptors.h"
+#include "prism/framegraph.h"
 
 namespace prism
 {
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define GFX_MAX_RETIRED_SWAPCHAINS 4
+#define GFX_MAX_SHADER_NAME_SIZE 64
+#define GFX_MAX_RETIRED_PIPELINES 16
+
+// Maximum number of buffer and image uploads per frame that need a queue-family ownership transfer.
+#define GFX_MAX_UPLOAD_BARRIERS 256
+
+// Maximum number of compute dispatches per frame, and of storage buffers per compute pipeline.
+#define GFX_MAX_DISPATCHES 256
+#define GFX_MAX_COMPUTE_BUFFERS DESC_MAX_BINDINGS
+
+// Maximum number of compute pipelines that exist at once.
+#define GFX_MAX_COMPUTE_PIPELINES 32
+
+// Maximum number of secondary command buffers each recording thread can record per frame.
+#define GFX_MAX_SECONDARY_COMMAND_BUFFERS 64
+
+// Maximum number of GPU profiler zones per frame, and how deeply they can nest.
+#define GFX_MAX_GPU_ZONES 64
+#define GFX_MAX_GPU_ZONE_DEPTH 16
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Typedefs
@@ -19,12 +48,449 @@ using GFXCreateSurfaceFn = VkSurfaceKHR (*)(const void *, VkInstance);
 // Data Structures
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Tradeoff between tearing, latency and GPU idle time used to select the swapchain's present-mode and image count.
+enum class GFXPresentPolicy
+{
+    // No tearing if MAILBOX is available, otherwise tearing; the newest frame is always presented next.
+    LOW_LATENCY = 0,
+
+    // Never blocks rendering on presentation, at the cost of tearing.
+    THROUGHPUT = 1,
+
+    // Frames are presented in order at the display's refresh rate with as few images as possible, so the GPU idles
+    // once it is ahead.
+    POWER_SAVING = 2,
+
+    COUNT = 3,
+};
+
+enum class GFXShaderStage
+{
+    VERTEX = 0,
+    FRAGMENT = 1,
+    COMPUTE = 2,
+    COUNT = 3,
+};
+
+// A shader from the shader library; modules for stages the shader doesn't have are VK_NULL_HANDLE.
+struct GFXShader
+{
+    char name[GFX_MAX_SHADER_NAME_SIZE];
+    VkShaderModule modules[(size_t)GFXShaderStage::COUNT];
+
+    // Name of the source/binary file each stage was built from, without extensions.
+    char stageFiles[(size_t)GFXShaderStage::COUNT][GFX_MAX_SHADER_NAME_SIZE];
+};
+
+// Background shader recompilation state; only exists when shader hot-reload is enabled.
+struct GFXShaderReloader;
+
+struct JOBScheduler;
+
+// Aggregated validation-layer messages; only exists in debug builds.
+struct GFXDebugMessageLog;
+
 struct GFXConfig
 {
     ctk::Buffer<const char *> requestedExtensionNames;
     ctk::Buffer<const char *> requestedLayerNames;
     const void * createSurfaceFnData;
     GFXCreateSurfaceFn createSurfaceFn;
+
+    // When headless is set, no surface or swapchain is created and rendering targets offscreen images of
+    // headlessExtent instead; createSurfaceFn and createSurfaceFnData are ignored.
+    bool headless;
+    VkExtent2D headlessExtent;
+
+    // Name (or part of a name) of the physical-device to use instead of the highest scoring one; null or empty to
+    // select by score.
+    const char * physicalDeviceOverride;
+
+    // Number of frames the CPU can record ahead of the GPU; 0 uses the default.
+    uint32_t framesInFlight;
+
+    // Policy for selecting the swapchain's present-mode, and an explicit swapchain image count (clamped to what the
+    // surface supports) or 0 to use the policy's default. Headless contexts use the image count for their offscreen
+    // images, raised to at least framesInFlight.
+    GFXPresentPolicy presentPolicy;
+    uint32_t swapchainImageCount;
+
+    // File the pipeline cache is loaded from by gfxInit() and saved to by gfxDestroy(); null or empty to not persist
+    // the pipeline cache.
+    const char * pipelineCachePath;
+
+    // YAML file listing every shader and its stages, and the directory the stages' SPIR-V binaries are in.
+    const char * shaderLibraryPath;
+    const char * shaderBinDir;
+
+    // Name of the shader in the library the context's pipeline is created with.
+    const char * pipelineShaderName;
+
+    // Development mode: when set, GLSL sources in shaderSourceDir are watched and recompiled into shaderBinDir on a
+    // background thread when changed, and the affected shader modules and pipelines are replaced between frames.
+    bool shaderHotReload;
+    const char * shaderSourceDir;
+
+    // Size of the persistently mapped staging buffer uploads are copied through; 0 uses the default.
+    VkDeviceSize stagingRingSize;
+
+    // Number of threads that record the frame's render pass into secondary command buffers with gfxBeginSecondary(); 0
+    // to record it inline into the command buffer returned by gfxBeginFrame() instead.
+    uint32_t recordingThreadCount;
+
+    // Scheduler gfxInit() loads shaders and the pipeline cache and compiles pipelines on, while the calling thread
+    // creates render targets and per-frame resources; gfxInit() must then be called from one of its threads. Null to
+    // do everything on the calling thread.
+    JOBScheduler * jobScheduler;
+};
+
+struct SwapchainInfo
+{
+    // typedef struct VkSurfaceCapabilitiesKHR {
+    //     uint32_t                         minImageCount;
+    //     uint32_t                         maxImageCount;
+    //     VkExtent2D                       currentExtent;
+    //     VkExtent2D                       minImageExtent;
+    //     VkExtent2D                       maxImageExtent;
+    //     uint32_t                         maxImageArrayLayers;
+    //     VkSurfaceTransformFlagsKHR       supportedTransforms;
+    //     VkSurfaceTransformFlagBitsKHR    currentTransform;
+    //     VkCompositeAlphaFlagsKHR         supportedCompositeAlpha;
+    //     VkImageUsageFlags                supportedUsageFlags;
+    // } VkSurfaceCapabilitiesKHR;
+    VkSurfaceCapabilitiesKHR surfaceCapabilities;
+
+    ctk::Buffer<VkSurfaceFormatKHR> availableSurfaceFormats;
+    ctk::Buffer<VkPresentModeKHR> availableSurfacePresentModes;
+};
+
+struct SwapchainConfig
+{
+    GFXPresentPolicy presentPolicy;
+    VkSurfaceFormatKHR surfaceFormat;
+    VkPresentModeKHR surfacePresentMode;
+    VkExtent2D extent;
+    uint32_t imageCount;
+    VkSurfaceTransformFlagBitsKHR currentTransform;
+
+    // Render targets are always color attachments, and transfer destinations where the surface allows it, so frame
+    // graph passes can blit into them.
+    VkImageUsageFlags imageUsage;
+};
+
+struct QueueInfo
+{
+    enum class Families
+    {
+        GRAPHICS = 0,
+        PRESENT = 1,
+
+        // A transfer-only queue-family when the device has one, so uploads run on its copy engine alongside graphics
+        // work; otherwise the graphics queue-family.
+        TRANSFER = 2,
+
+        // A compute queue-family without graphics support when the device has one, so dispatches run asynchronously
+        // alongside graphics work; otherwise the graphics queue-family.
+        COMPUTE = 3,
+
+        COUNT = 4,
+    };
+
+    VkQueue queues[(size_t)Families::COUNT];
+    uint32_t familyIndexes[(size_t)Families::COUNT];
+};
+
+// Per-frame resources; one set exists for each frame in flight so the CPU can record a frame while the GPU is still
+// executing previous ones.
+struct GFXFrame
+{
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    VkSemaphore imageAcquiredSemaphore;
+    VkSemaphore renderFinishedSemaphore;
+    VkFence inFlightFence;
+
+    // GPU profiler zones recorded into the frame's command buffer while a capture runs; zone i writes its begin and
+    // end timestamps to queries 2i and 2i + 1, and is read back when the frame's fence is next waited on. The query
+    // pool is null if the graphics queue doesn't support timestamps.
+    VkQueryPool timestampQueryPool;
+    const char * gpuZoneNames[GFX_MAX_GPU_ZONES];
+    uint32_t gpuZoneCount;
+
+    // profGetTime() when the frame was submitted; GPU zones are placed on the profiler's clock relative to it.
+    uint64_t submitTime;
+};
+
+// Upload commands recorded on the transfer queue for a frame, submitted by gfxEndFrame() before the frame's graphics
+// work, which waits on transferFinishedSemaphore.
+struct GFXTransferBatch
+{
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    VkSemaphore transferFinishedSemaphore;
+
+    // Signaled when the batch's copies complete, after which its staging memory and command buffer can be reused.
+    VkFence fence;
+
+    // Recorded on the graphics queue at submission to acquire ownership of uploaded resources from the transfer
+    // queue-family; allocated from the frame's command pool and only used when the queue-families differ.
+    VkCommandBuffer acquireCommandBuffer;
+    ctk::Buffer<VkBufferMemoryBarrier> bufferAcquireBarriers;
+    ctk::Buffer<VkImageMemoryBarrier> imageAcquireBarriers;
+    uint32_t bufferAcquireBarrierCount;
+    uint32_t imageAcquireBarrierCount;
+
+    // Set while commands are being recorded, and from submission until the batch's fence is known to be signaled.
+    bool recording;
+    bool submitted;
+
+    // Staging ring head when the batch was submitted; the ring's tail once the batch completes.
+    uint64_t stagingEnd;
+};
+
+// Compute dispatches recorded on the compute queue for a frame, submitted by gfxEndFrame() after the frame's uploads
+// and before its graphics work, which waits on computeFinishedSemaphore. Reset when the frame begins, as the frame's
+// fence signaling implies the compute work it waited on completed too.
+//
+// The frame's graphics work signals graphicsFinishedSemaphore, and the next frame's compute work waits on it, so
+// dispatches never overwrite shared buffers the previous frame's graphics work is still reading. A next frame without
+// dispatches has its graphics work wait on it instead, so every signal is waited on.
+struct GFXComputeBatch
+{
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    VkSemaphore computeFinishedSemaphore;
+    VkSemaphore graphicsFinishedSemaphore;
+    uint32_t dispatchCount;
+};
+
+// Persistently mapped host-visible buffer uploads are staged in; allocated front to back and reclaimed in submission
+// order as transfer batches complete. head and tail increase monotonically and wrap by modulo size.
+struct GFXStagingRing
+{
+    VkBuffer buffer;
+    MEMAllocation memory;
+    VkDeviceSize size;
+    uint64_t head;
+    uint64_t tail;
+};
+
+// Secondary command buffers one recording thread records for one frame in flight. Each thread has its own pool per
+// frame, so threads never synchronize to record and a frame's pools can be reset at once when its fence signals.
+struct GFXRecordingThread
+{
+    VkCommandPool commandPool;
+
+    // Allocated from commandPool on first use and reused every time the frame comes around; the first usedCount were
+    // recorded for the current frame.
+    VkCommandBuffer commandBuffers[GFX_MAX_SECONDARY_COMMAND_BUFFERS];
+    uint32_t allocatedCount;
+    uint32_t usedCount;
+};
+
+struct GFXBuffer
+{
+    VkBuffer buffer;
+    MEMAllocation memory;
+    VkDeviceSize size;
+
+    // Set for buffers shared between the compute queue and other queues; such buffers are created with concurrent
+    // sharing, so never need queue-family ownership transfers.
+    bool concurrent;
+};
+
+// Per-vertex and per-instance attributes of the graphics pipeline, read from vertex buffer bindings 0 and 1; see
+// tutorial.vert.
+struct GFXVertex
+{
+    float position[2];
+    float color[3];
+};
+
+struct GFXInstance
+{
+    float offset[2];
+    float scale;
+};
+
+// Compute pipeline reading and writing storageBufferCount storage buffers, bound at bindings 0 to
+// storageBufferCount - 1 of set 0, with pushConstantSize bytes of push constants.
+struct GFXComputePipeline
+{
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+    uint32_t storageBufferCount;
+    uint32_t pushConstantSize;
+
+    // Shader the pipeline is rebuilt from when the shader is hot-reloaded.
+    char shaderName[GFX_MAX_SHADER_NAME_SIZE];
+};
+
+// Timings for the most recent frame, in seconds.
+struct GFXFrameTimes
+{
+    // Time blocked in gfxBeginFrame() waiting for the GPU to finish with the frame's resources; non-zero wait times
+    // mean the GPU is the bottleneck.
+    double fenceWaitTime;
+
+    double acquireTime;
+
+    // Time between gfxBeginFrame() returning and gfxEndFrame() being called.
+    double recordTime;
+
+    double submitTime;
+};
+
+// Timings of gfxInit()'s phases, in seconds. Phases run as jobs overlap those on the calling thread, so all phases can
+// add up to more than totalTime.
+struct GFXStartupTimes
+{
+    // Instance, debug callback and surface creation.
+    double instanceTime;
+
+    // Physical-device selection, and logical-device and queue creation.
+    double deviceTime;
+
+    // Device-memory and descriptor allocator creation.
+    double allocatorTime;
+
+    // Swapchain or offscreen images, their views, the render pass and framebuffers.
+    double renderTargetTime;
+
+    // The shader hot-reloader, command pools, query pools, batches, recording threads and the staging ring.
+    double frameResourceTime;
+
+    // Run as jobs: loading the pipeline cache; parsing the shader library and creating its modules and the pipeline
+    // layout; and compiling pipelines.
+    double pipelineCacheTime;
+    double shaderTime;
+    double pipelineTime;
+
+    // Time the calling thread spent waiting on jobs after running out of work of its own.
+    double jobWaitTime;
+
+    double totalTime;
+};
+
+// Pipeline replaced by a shader hot-reload, kept alive until no frame in flight can still be using it.
+struct GFXRetiredPipeline
+{
+    VkPipeline pipeline;
+    uint64_t retiredFrameCount;
+};
+
+// Swapchain resources replaced by a recreation, kept alive until no frame in flight can still be using them.
+struct GFXRetiredSwapchain
+{
+    VkSwapchainKHR swapchain;
+    ctk::Buffer<VkImageView> imageViews;
+    ctk::Buffer<VkFramebuffer> framebuffers;
+
+    // Value of GFXContext::frameCount when the swapchain was retired.
+    uint64_t retiredFrameCount;
+};
+
+struct GFXContext
+{
+    VkInstance instance;
+    VkDebugReportCallbackEXT debugCallback;
+    GFXDebugMessageLog * debugMessageLog;
+    VkSurfaceKHR surface;
+    VkPhysicalDevice physicalDevice;
+    VkDevice logicalDevice;
+
+    // Optional physical-device features enabled on the logical-device because the physical-device supports them.
+    VkPhysicalDeviceFeatures enabledFeatures;
+
+    QueueInfo queueInfo;
+    MEMAllocator allocator;
+    DESCAllocator descriptorAllocator;
+
+    // Offscreen passes recorded before the frame's render pass, or null. frameGraphTarget is the graph's imported
+    // image set to each frame's render target, or FG_INVALID_INDEX; frameGraphTargetChanged is set when the render
+    // targets are recreated, so the graph is resized before its next execution.
+    FGGraph * frameGraph;
+    uint32_t frameGraphTarget;
+    bool frameGraphTargetChanged;
+
+    // Render targets; swapchain images when presenting to a surface, offscreen images when headless.
+    GFXPresentPolicy presentPolicy;
+    uint32_t requestedSwapchainImageCount;
+    SwapchainInfo swapchainInfo;
+    SwapchainConfig swapchainConfig;
+    VkSwapchainKHR swapchain;
+    ctk::Buffer<VkImage> swapchainImages;
+    ctk::Buffer<MEMAllocation> offscreenImageMemory;
+    ctk::Buffer<VkImageView> swapchainImageViews;
+    ctk::Buffer<VkFramebuffer> framebuffers;
+
+    // Fence of the frame that last rendered to each swapchain image, so an image is never rendered to by two frames
+    // at once when the image count and frames in flight differ.
+    ctk::Buffer<VkFence> imageFences;
+
+    // Set when the swapchain no longer matches its surface; the swapchain is recreated when the next frame begins.
+    bool swapchainOutOfDate;
+
+    GFXRetiredSwapchain retiredSwapchains[GFX_MAX_RETIRED_SWAPCHAINS];
+    uint32_t retiredSwapchainCount;
+
+    // Buffers of destroyed retired swapchains, reused by the next recreation if the image count still matches.
+    ctk::Buffer<VkImageView> spareImageViews;
+    ctk::Buffer<VkFramebuffer> spareFramebuffers;
+
+    // The frame's render pass clears the render target, unless the frame graph renders to it first, in which case
+    // loadRenderPass draws over its contents instead. The two are compatible, so pipelines, framebuffers and secondary
+    // command buffers made for renderPass work with either.
+    VkRenderPass renderPass;
+    VkRenderPass loadRenderPass;
+    VkPipelineCache pipelineCache;
+    ctk::Buffer<char> pipelineCachePath;
+
+    // Shader library, sorted by name.
+    ctk::Buffer<GFXShader> shaders;
+    GFXShaderReloader * shaderReloader;
+    GFXRetiredPipeline retiredPipelines[GFX_MAX_RETIRED_PIPELINES];
+    uint32_t retiredPipelineCount;
+
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+    const GFXShader * pipelineShader;
+
+    // Every compute pipeline that hasn't been destroyed, so shader hot-reloads can rebuild them.
+    GFXComputePipeline * computePipelines[GFX_MAX_COMPUTE_PIPELINES];
+    uint32_t computePipelineCount;
+
+    ctk::Buffer<GFXFrame> frames;
+
+    // Uploads; one transfer batch per frame in flight.
+    GFXStagingRing stagingRing;
+    ctk::Buffer<GFXTransferBatch> transferBatches;
+
+    // Compute dispatches; one compute batch per frame in flight.
+    ctk::Buffer<GFXComputeBatch> computeBatches;
+
+    // Parallel recording; recordingThreadCount threads per frame in flight, indexed by
+    // frameIndex * recordingThreadCount + threadIndex.
+    uint32_t recordingThreadCount;
+    ctk::Buffer<GFXRecordingThread> recordingThreads;
+
+    // GPU profiling; nanoseconds per timestamp tick, the mask of valid timestamp bits on the graphics queue, and
+    // whether the current frame records GPU zones. The stack holds the zone index of each open GPU zone, or UINT32_MAX
+    // for zones that aren't recorded.
+    float timestampPeriod;
+    uint64_t timestampMask;
+    bool profilingGPU;
+    uint32_t gpuZoneStack[GFX_MAX_GPU_ZONE_DEPTH];
+    uint32_t gpuZoneDepth;
+
+    uint32_t frameIndex;
+    uint32_t imageIndex;
+    uint64_t frameCount;
+    GFXFrameTimes frameTimes;
+    double recordStartTime;
+    GFXStartupTimes startupTimes;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -32,10 +498,113 @@ struct GFXConfig
 // Interface
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Creates the context from config, recording how long each phase took in context->startupTimes.
+void
+gfxInit(GFXContext * context, const GFXConfig * config);
+
+// Waits for the current frame's resources to be free, acquires the next render target and begins its render pass.
+// Returns the command buffer to record the frame's commands into, or VK_NULL_HANDLE if there is nothing to render to
+// (e.g. the window is minimized), in which case the frame is skipped and gfxEndFrame() must not be called. With
+// recording threads, the render pass's commands must be recorded with gfxBeginSecondary() instead.
+VkCommandBuffer
+gfxBeginFrame(GFXContext * context);
+
+// Executes the frame's secondary command buffers in thread order, then ends the current frame's render pass, submits
+// its command buffer and presents the result.
+void
+gfxEndFrame(GFXContext * context);
+
+// Begins a secondary command buffer for recording thread threadIndex, inheriting the current frame's render pass and
+// with dynamic state set to cover the whole render target. Safe to call from each recording thread concurrently
+// between gfxBeginFrame() and gfxEndFrame(), as long as every thread uses its own threadIndex; the buffer must be ended
+// with vkEndCommandBuffer() before gfxEndFrame() is called.
+VkCommandBuffer
+gfxBeginSecondary(GFXContext * context, uint32_t threadIndex);
+
+// Creates a buffer of size bytes with memory that has memoryFlags. Buffers are always transfer destinations so they can
+// be filled with gfxUploadBuffer(); set computeShared for buffers the compute queue accesses along with other queues.
+void
+gfxCreateBuffer(GFXContext * context, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags,
+                bool computeShared, GFXBuffer * buffer);
+
+// Destroys buffer immediately; it must not be in use by frames still in flight.
+void
+gfxDestroyBuffer(GFXContext * context, GFXBuffer * buffer);
+
+// Copies size bytes of data into buffer at offset through the staging ring and transfer queue. The copy is complete
+// before the current frame's compute and graphics work begins (or the next frame's, if called between frames), and
+// buffer must not be in use by frames still in flight. Returns false if the staging ring or the frame's upload
+// barriers are full, in which case nothing is uploaded and the upload can be retried next frame.
+bool
+gfxUploadBuffer(GFXContext * context, const GFXBuffer * buffer, VkDeviceSize offset, const void * data,
+                VkDeviceSize size);
+
+// Returns the size in bytes of one texel of an uncompressed color format, or 0 for formats images can't be uploaded in
+// (e.g. block-compressed ones).
+uint32_t
+gfxGetTexelSize(VkFormat format);
+
+// Like gfxUploadBuffer(), but copies tightly packed texels into mipLevel of a 2D color image of format and transitions
+// that level from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. size must cover every texel of
+// extent.
+bool
+gfxUploadImage(GFXContext * context, VkImage image, VkFormat format, uint32_t mipLevel, VkExtent3D extent,
+               const void * data, VkDeviceSize size);
+
+// Creates a compute pipeline from shader's compute stage. computePipeline is rebuilt in place whenever the shader is
+// hot-reloaded, so it must stay at the same address until it's destroyed.
+void
+gfxCreateComputePipeline(GFXContext * context, const GFXShader * shader, uint32_t storageBufferCount,
+                         uint32_t pushConstantSize, GFXComputePipeline * computePipeline);
+
+// Destroys computePipeline immediately; it must not be in use by frames still in flight.
+void
+gfxDestroyComputePipeline(GFXContext * context, GFXComputePipeline * computePipeline);
+
+// Records a dispatch of computePipeline over groupCountX * groupCountY * groupCountZ workgroups into the current
+// frame's compute batch, with storageBuffers bound in binding order and pushConstants (if the pipeline has any). Must
+// be called between gfxBeginFrame() and gfxEndFrame(). Dispatches run in order, each seeing the writes of the
+// previous ones, and their results are visible to the frame's graphics work. They start once the previous frame's
+// graphics work has finished, so they may overwrite buffers it read. Storage buffers must be created with computeShared
+// set if graphics work accesses them.
+void
+gfxDispatch(GFXContext * context, const GFXComputePipeline * computePipeline, const GFXBuffer * const * storageBuffers,
+            const void * pushConstants, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
+// Returns the shader named name from the shader library, or null if there is no such shader.
+const GFXShader *
+gfxGetShader(const GFXContext * context, const char * name);
+
+// Begins a GPU profiler zone named name (which must outlive the capture) by writing a timestamp into commandBuffer,
+// which must be the frame command buffer returned by gfxBeginFrame(); zones nest and must be ended with
+// gfxEndGPUZone() before gfxEndFrame(). With recording threads, the render pass can't be profiled this way, as the
+// frame command buffer only executes secondary command buffers there. Only tracks nesting while no profiler capture is
+// running.
+void
+gfxBeginGPUZone(GFXContext * context, VkCommandBuffer commandBuffer, const char * name);
+
+void
+gfxEndGPUZone(GFXContext * context, VkCommandBuffer commandBuffer);
+
+// Sets the frame graph executed by gfxBeginFrame() before the frame's render pass begins, so the render pass can sample
+// its imported images; null disables it. If renderTarget isn't FG_INVALID_INDEX, it's an imported image of the graph
+// that is set to the frame's render target before each execution and resized with it; the graph must leave it in the
+// FGAccess::COLOR_ATTACHMENT_WRITE state, and the frame's render pass draws over it instead of clearing it. The graph
+// is owned by the caller and must be destroyed with fgDestroy() before gfxDestroy().
 void
-gfxInit(const GFXConfig * config);
+gfxSetFrameGraph(GFXContext * context, FGGraph * frameGraph, uint32_t renderTarget);
 
-// void
-// gfxDestroy(GFXContext * context);
+// Marks the swapchain as out of date so it is recreated when the next frame begins; call when the window's framebuffer
+// is resized, as not every platform reports a resize through the swapchain itself.
+void
+gfxInvalidateSwapchain(GFXContext * context);
+
+// Waits for all submitted GPU work to complete, e.g. before destroying resources at shutdown that frames may still be
+// using.
+void
+gfxWaitIdle(GFXContext * context);
+
+void
+gfxDestroy(GFXContext * context);
 
 } // namespace prism
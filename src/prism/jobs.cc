@@ -0,0 +1,455 @@
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include "prism/jobs.h"
+#include "prism/profiler.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+#include "ctk/memory.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define DEQUE_MASK (JOB_DEQUE_SIZE - 1)
+#define CACHE_LINE_SIZE 64
+
+// Number of failed attempts to find a job before an idle worker goes to sleep.
+#define IDLE_SPIN_COUNT 64
+
+// Number of chunks per thread jobParallelFor() aims for when no grain size is given, so threads that finish early can
+// steal from threads that don't.
+#define PARALLEL_FOR_CHUNKS_PER_THREAD 4
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fields are atomic because a thief reads a slot before it knows whether the steal succeeded, which can race with the
+// owner reusing the slot; a thief that loses the race discards what it read.
+struct JobSlot
+{
+    std::atomic<JOBFn> fn;
+    std::atomic<void *> data;
+    std::atomic<JOBCounter *> counter;
+};
+
+struct Job
+{
+    JOBFn fn;
+    void * data;
+    JOBCounter * counter;
+};
+
+// Chase-Lev work-stealing deque: the owning thread pushes and pops at the bottom, other threads steal from the top.
+// top and bottom are on separate cache lines so thieves don't contend with the owner.
+struct JobDeque
+{
+    std::atomic<int64_t> top;
+    char topPadding[CACHE_LINE_SIZE - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> bottom;
+    char bottomPadding[CACHE_LINE_SIZE - sizeof(std::atomic<int64_t>)];
+    JobSlot slots[JOB_DEQUE_SIZE];
+};
+
+struct JOBScheduler
+{
+    uint32_t threadCount;
+    JobDeque * deques[JOB_MAX_THREADS];
+
+    // workers[i] runs jobs as thread i + 1.
+    std::thread workers[JOB_MAX_THREADS - 1];
+    std::atomic<bool> stop;
+
+    // Jobs sitting in deques; may briefly be negative while a job is stolen before its push is counted.
+    std::atomic<int64_t> queuedJobCount;
+
+    // Idle workers sleep on wakeCondition until jobs are queued or the scheduler stops.
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<uint32_t> sleepingWorkerCount;
+};
+
+struct ParallelForChunk
+{
+    JOBRangeFn fn;
+    void * data;
+    size_t begin;
+    size_t end;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static thread_local uint32_t threadIndex = UINT32_MAX;
+
+// xorshift state for picking steal victims; seeded per thread.
+static thread_local uint32_t victimSeed = 0;
+
+static bool
+pushJob(JobDeque * deque, const JOBDecl * decl, JOBCounter * counter)
+{
+    int64_t bottom = deque->bottom.load(std::memory_order_relaxed);
+    int64_t top = deque->top.load(std::memory_order_acquire);
+
+    if(bottom - top >= JOB_DEQUE_SIZE)
+    {
+        return false;
+    }
+
+    JobSlot * slot = deque->slots + (bottom & DEQUE_MASK);
+    slot->fn.store(decl->fn, std::memory_order_relaxed);
+    slot->data.store(decl->data, std::memory_order_relaxed);
+    slot->counter.store(counter, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+static void
+readSlot(const JobSlot * slot, Job * job)
+{
+    job->fn = slot->fn.load(std::memory_order_relaxed);
+    job->data = slot->data.load(std::memory_order_relaxed);
+    job->counter = slot->counter.load(std::memory_order_relaxed);
+}
+
+static bool
+popJob(JobDeque * deque, Job * job)
+{
+    int64_t bottom = deque->bottom.load(std::memory_order_relaxed) - 1;
+    deque->bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = deque->top.load(std::memory_order_relaxed);
+
+    // Deque was empty.
+    if(top > bottom)
+    {
+        deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    readSlot(deque->slots + (bottom & DEQUE_MASK), job);
+
+    if(top < bottom)
+    {
+        return true;
+    }
+
+    // Popping the last job races with thieves; whoever advances top first gets it.
+    bool popped =
+        deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+    return popped;
+}
+
+static bool
+stealJob(JobDeque * deque, Job * job)
+{
+    int64_t top = deque->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = deque->bottom.load(std::memory_order_acquire);
+
+    if(top >= bottom)
+    {
+        return false;
+    }
+
+    readSlot(deque->slots + (top & DEQUE_MASK), job);
+
+    return deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+static void
+executeJob(const Job * job)
+{
+    job->fn(job->data);
+
+    if(job->counter != nullptr)
+    {
+        job->counter->count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+// Pops a job from the calling thread's deque, or steals one from another thread's deque starting at a random victim,
+// and runs it. Returns false if no job was found.
+static bool
+runNextJob(JOBScheduler * scheduler)
+{
+    Job job;
+    bool found = popJob(scheduler->deques[threadIndex], &job);
+
+    if(!found && scheduler->threadCount > 1)
+    {
+        victimSeed ^= victimSeed << 13;
+        victimSeed ^= victimSeed >> 17;
+        victimSeed ^= victimSeed << 5;
+        uint32_t firstVictim = victimSeed % scheduler->threadCount;
+
+        for(uint32_t i = 0; i < scheduler->threadCount && !found; i++)
+        {
+            uint32_t victim = (firstVictim + i) % scheduler->threadCount;
+
+            if(victim != threadIndex)
+            {
+                found = stealJob(scheduler->deques[victim], &job);
+            }
+        }
+    }
+
+    if(!found)
+    {
+        return false;
+    }
+
+    scheduler->queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+    executeJob(&job);
+
+    return true;
+}
+
+static void
+runWorker(JOBScheduler * scheduler, uint32_t index)
+{
+    threadIndex = index;
+    victimSeed = index * 2654435761u + 1;
+    uint32_t idleCount = 0;
+    char threadName[PROF_MAX_THREAD_NAME_SIZE] = {};
+    snprintf(threadName, sizeof(threadName), "job worker %u", index);
+    profSetThreadName(threadName);
+
+    while(!scheduler->stop.load(std::memory_order_acquire))
+    {
+        if(runNextJob(scheduler))
+        {
+            idleCount = 0;
+            continue;
+        }
+
+        if(++idleCount < IDLE_SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // queuedJobCount and sleepingWorkerCount are both sequentially consistent, so either jobRun() sees this worker
+        // sleeping and wakes it, or this worker sees the queued jobs and doesn't sleep.
+        std::unique_lock<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->sleepingWorkerCount.fetch_add(1);
+
+        scheduler->wakeCondition.wait(lock, [scheduler]()
+        {
+            return scheduler->stop.load() || scheduler->queuedJobCount.load() > 0;
+        });
+
+        scheduler->sleepingWorkerCount.fetch_sub(1);
+        idleCount = 0;
+    }
+}
+
+static void
+runParallelForChunk(void * data)
+{
+    auto chunk = (ParallelForChunk *)data;
+    chunk->fn(chunk->data, chunk->begin, chunk->end);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+JOBScheduler *
+jobCreateScheduler(uint32_t threadCount)
+{
+    PRISM_ASSERT(threadIndex == UINT32_MAX);
+
+    if(threadCount == 0)
+    {
+        // hardware_concurrency() returns 0 if the core count can't be determined.
+        threadCount = std::thread::hardware_concurrency();
+
+        if(threadCount == 0)
+        {
+            threadCount = 1;
+        }
+    }
+
+    if(threadCount > JOB_MAX_THREADS)
+    {
+        threadCount = JOB_MAX_THREADS;
+    }
+
+    auto scheduler = new JOBScheduler;
+    scheduler->threadCount = threadCount;
+    scheduler->stop = false;
+    scheduler->queuedJobCount = 0;
+    scheduler->sleepingWorkerCount = 0;
+
+    for(uint32_t i = 0; i < threadCount; i++)
+    {
+        JobDeque * deque = new JobDeque;
+        deque->top = 0;
+        deque->bottom = 0;
+        scheduler->deques[i] = deque;
+    }
+
+    threadIndex = 0;
+    victimSeed = 1;
+
+    for(uint32_t i = 1; i < threadCount; i++)
+    {
+        scheduler->workers[i - 1] = std::thread(runWorker, scheduler, i);
+    }
+
+    utilLog("JOBS", "started scheduler with %u threads\n", threadCount);
+
+    return scheduler;
+}
+
+uint32_t
+jobGetThreadCount(const JOBScheduler * scheduler)
+{
+    return scheduler->threadCount;
+}
+
+uint32_t
+jobGetThreadIndex()
+{
+    return threadIndex;
+}
+
+void
+jobRun(JOBScheduler * scheduler, const JOBDecl * jobs, uint32_t jobCount, JOBCounter * counter)
+{
+    PRISM_ASSERT(threadIndex < scheduler->threadCount);
+
+    if(counter != nullptr)
+    {
+        counter->count.fetch_add(jobCount, std::memory_order_relaxed);
+    }
+
+    JobDeque * deque = scheduler->deques[threadIndex];
+
+    for(uint32_t i = 0; i < jobCount; i++)
+    {
+        scheduler->queuedJobCount.fetch_add(1);
+
+        if(!pushJob(deque, jobs + i, counter))
+        {
+            // Deque is full; run the job here rather than block.
+            scheduler->queuedJobCount.fetch_sub(1);
+            Job job = { jobs[i].fn, jobs[i].data, counter };
+            executeJob(&job);
+        }
+    }
+
+    if(scheduler->sleepingWorkerCount.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->wakeCondition.notify_all();
+    }
+}
+
+void
+jobWait(JOBScheduler * scheduler, JOBCounter * counter)
+{
+    PRISM_ASSERT(threadIndex < scheduler->threadCount);
+
+    // Help with queued jobs instead of blocking; the jobs being waited on may be sitting in this thread's own deque.
+    while(counter->count.load(std::memory_order_acquire) > 0)
+    {
+        if(!runNextJob(scheduler))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void
+jobParallelFor(JOBScheduler * scheduler, size_t count, size_t grainSize, JOBRangeFn fn, void * data)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    if(grainSize == 0)
+    {
+        size_t targetChunkCount = (size_t)scheduler->threadCount * PARALLEL_FOR_CHUNKS_PER_THREAD;
+        grainSize = (count + targetChunkCount - 1) / targetChunkCount;
+    }
+
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+    // A single chunk gains nothing from being queued.
+    if(chunkCount == 1)
+    {
+        fn(data, 0, count);
+        return;
+    }
+
+    auto chunks = bufferCreate<ParallelForChunk>(chunkCount);
+    auto jobs = bufferCreate<JOBDecl>(chunkCount);
+
+    for(size_t i = 0; i < chunkCount; i++)
+    {
+        ParallelForChunk * chunk = chunks.data + i;
+        chunk->fn = fn;
+        chunk->data = data;
+        chunk->begin = i * grainSize;
+        chunk->end = chunk->begin + grainSize < count ? chunk->begin + grainSize : count;
+        jobs.data[i] = { runParallelForChunk, chunk };
+    }
+
+    JOBCounter counter = {};
+    jobRun(scheduler, jobs.data, (uint32_t)chunkCount, &counter);
+    jobWait(scheduler, &counter);
+
+    // Cleanup
+    bufferFree(&jobs);
+    bufferFree(&chunks);
+}
+
+void
+jobDestroyScheduler(JOBScheduler * scheduler)
+{
+    PRISM_ASSERT(threadIndex == 0);
+
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->stop = true;
+    }
+
+    scheduler->wakeCondition.notify_all();
+
+    for(uint32_t i = 1; i < scheduler->threadCount; i++)
+    {
+        scheduler->workers[i - 1].join();
+    }
+
+    // Cleanup
+    for(uint32_t i = 0; i < scheduler->threadCount; i++)
+    {
+        delete scheduler->deques[i];
+    }
+
+    delete scheduler;
+    threadIndex = UINT32_MAX;
+}
+
+} // namespace prism
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maximum number of threads a scheduler runs jobs on, including the thread that created it.
+#define JOB_MAX_THREADS 64
+
+// Capacity of each thread's job deque; must be a power of two. Jobs queued on a thread with a full deque run
+// immediately on that thread instead.
+#define JOB_DEQUE_SIZE 4096
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Typedefs
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+using JOBFn = void (*)(void * data);
+
+// Called with the half-open index range [begin, end) of a parallel-for chunk.
+using JOBRangeFn = void (*)(void * data, size_t begin, size_t end);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct JOBScheduler;
+
+struct JOBDecl
+{
+    JOBFn fn;
+    void * data;
+};
+
+// Number of unfinished jobs that were run with the counter; a job that depends on others waits for their counter to
+// reach 0 with jobWait(). Must be zero-initialized and must outlive the jobs run with it.
+struct JOBCounter
+{
+    std::atomic<uint32_t> count;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Starts threadCount - 1 worker threads, or one per remaining core if threadCount is 0; the calling thread is thread 0
+// and runs jobs while waiting in jobWait().
+JOBScheduler *
+jobCreateScheduler(uint32_t threadCount);
+
+// Number of threads jobs run on, including the thread that created the scheduler.
+uint32_t
+jobGetThreadCount(const JOBScheduler * scheduler);
+
+// Index of the calling thread in [0, jobGetThreadCount()), or UINT32_MAX if it isn't one of the scheduler's threads.
+// Lets jobs use per-thread resources without locking.
+uint32_t
+jobGetThreadIndex();
+
+// Queues jobs on the calling thread's deque, from which idle threads steal them. counter (may be null) is incremented
+// by jobCount before the jobs are queued and decremented as each one finishes. Must be called from one of the
+// scheduler's threads.
+void
+jobRun(JOBScheduler * scheduler, const JOBDecl * jobs, uint32_t jobCount, JOBCounter * counter);
+
+// Runs queued jobs on the calling thread until counter reaches 0.
+void
+jobWait(JOBScheduler * scheduler, JOBCounter * counter);
+
+// Splits [0, count) into chunks of at most grainSize indexes (0 picks a size giving each thread a few chunks), calls
+// fn on each chunk from any of the scheduler's threads, and returns once all chunks have finished.
+void
+jobParallelFor(JOBScheduler * scheduler, size_t count, size_t grainSize, JOBRangeFn fn, void * data);
+
+// Stops the worker threads; every job run on the scheduler must have finished.
+void
+jobDestroyScheduler(JOBScheduler * scheduler);
+
+} // namespace prism
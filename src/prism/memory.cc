@@ -0,0 +1,833 @@
+#include "prism/memory.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+#include "prism/vulkan.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define STRATEGY_INDEX(STRATEGY) (size_t)MEMStrategy::STRATEGY
+#define MEBIBYTE(COUNT) ((VkDeviceSize)(COUNT) * 1024 * 1024)
+#define MAX_POOL_SLOT_SIZE ((VkDeviceSize)MEM_MIN_ALLOCATION_SIZE << (MEM_POOL_SIZE_CLASS_COUNT - 1))
+#define INVALID_INDEX UINT32_MAX
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Vulkan alignments are always powers of two.
+static VkDeviceSize
+alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static VkDeviceSize
+nextPowerOfTwo(VkDeviceSize value)
+{
+    VkDeviceSize powerOfTwo = 1;
+
+    while(powerOfTwo < value)
+    {
+        powerOfTwo <<= 1;
+    }
+
+    return powerOfTwo;
+}
+
+static uint32_t
+log2PowerOfTwo(VkDeviceSize powerOfTwo)
+{
+    uint32_t exponent = 0;
+
+    while(((VkDeviceSize)1 << exponent) < powerOfTwo)
+    {
+        exponent++;
+    }
+
+    return exponent;
+}
+
+// Size of pool and buddy allocations; a power of two at least as large as the requested size and alignment, so that
+// allocations placed at multiples of their size are aligned.
+static VkDeviceSize
+getPowerOfTwoSize(const VkMemoryRequirements * requirements)
+{
+    VkDeviceSize size = requirements->size > requirements->alignment ? requirements->size : requirements->alignment;
+    return nextPowerOfTwo(size > MEM_MIN_ALLOCATION_SIZE ? size : MEM_MIN_ALLOCATION_SIZE);
+}
+
+// Pool and buddy allocations are aligned to their size, which is at least MEM_MIN_ALLOCATION_SIZE, so no two of them
+// share a bufferImageGranularity page unless the granularity is larger than that; only then do linear and optimal
+// resources need separate blocks.
+static bool
+isResourceTypeCompatible(const MEMAllocator * allocator, const MEMBlock * block, MEMResourceType resourceType)
+{
+    return allocator->bufferImageGranularity <= MEM_MIN_ALLOCATION_SIZE || block->resourceType == resourceType;
+}
+
+static MEMBlockList *
+getBlockList(MEMAllocator * allocator, MEMStrategy strategy, uint32_t memoryTypeIndex)
+{
+    MEMBlockList * blockList = &allocator->blockLists[(size_t)strategy][memoryTypeIndex];
+
+    if(blockList->blocks.count == 0)
+    {
+        blockList->blocks = bufferCreate<MEMBlock>(MEM_MAX_BLOCKS);
+        blockList->count = 0;
+    }
+
+    return blockList;
+}
+
+// Returns the index of the new block in its block list, or INVALID_INDEX if it couldn't be allocated.
+static uint32_t
+createBlock(MEMAllocator * allocator, MEMStrategy strategy, uint32_t memoryTypeIndex, VkDeviceSize size,
+            MEMResourceType resourceType)
+{
+    MEMBlockList * blockList = getBlockList(allocator, strategy, memoryTypeIndex);
+    uint32_t blockIndex = 0;
+
+    // Reuse block slot freed by a destroyed block if there is one.
+    while(blockIndex < blockList->count && blockList->blocks.data[blockIndex].memory != VK_NULL_HANDLE)
+    {
+        blockIndex++;
+    }
+
+    if(blockIndex == MEM_MAX_BLOCKS)
+    {
+        utilWarning("MEMORY", "out of blocks for memory type %u\n", memoryTypeIndex);
+        return INVALID_INDEX;
+    }
+
+    // Device-memory allocations are limited per device, not per allocator, but the allocator is meant to be the only
+    // source of them.
+    uint32_t totalBlockCount = 0;
+
+    for(size_t i = 0; i < (size_t)MEMStrategy::COUNT; i++)
+    {
+        totalBlockCount += allocator->stats[i].blockCount;
+    }
+
+    if(totalBlockCount >= allocator->maxMemoryAllocationCount)
+    {
+        utilWarning("MEMORY", "maxMemoryAllocationCount (%u) reached\n", allocator->maxMemoryAllocationCount);
+        return INVALID_INDEX;
+    }
+
+    // typedef struct VkMemoryAllocateInfo {
+    //     VkStructureType    sType;
+    //     const void*        pNext;
+    //     VkDeviceSize       allocationSize;
+    //     uint32_t           memoryTypeIndex;
+    // } VkMemoryAllocateInfo;
+    VkMemoryAllocateInfo memoryAllocateInfo = {};
+    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryAllocateInfo.pNext = nullptr;
+    memoryAllocateInfo.allocationSize = size;
+    memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    MEMBlock * block = blockList->blocks.data + blockIndex;
+    *block = {};
+    VkResult result = vkAllocateMemory(allocator->logicalDevice, &memoryAllocateInfo, nullptr, &block->memory);
+
+    if(result != VK_SUCCESS)
+    {
+        utilWarning("MEMORY", "failed to allocate %llu byte block from memory type %u: %s\n", (unsigned long long)size,
+                    memoryTypeIndex, getVkResultName(result));
+
+        block->memory = VK_NULL_HANDLE;
+        return INVALID_INDEX;
+    }
+
+    // Host-visible blocks are mapped for their whole lifetime, so allocations never need to be mapped individually.
+    VkMemoryPropertyFlags propertyFlags = allocator->memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+    if(propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        void * mapped = nullptr;
+        result = vkMapMemory(allocator->logicalDevice, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+
+        if(result != VK_SUCCESS)
+        {
+            utilErrorExit("VULKAN", getVkResultName(result), "failed to map memory block\n");
+        }
+
+        block->mapped = (uint8_t *)mapped;
+    }
+
+    block->size = size;
+    block->resourceType = resourceType;
+    block->frameIndex = allocator->frameIndex;
+
+    if(blockIndex == blockList->count)
+    {
+        blockList->count++;
+    }
+
+    MEMStats * stats = allocator->stats + (size_t)strategy;
+    stats->blockCount++;
+    stats->blockBytes += size;
+
+    return blockIndex;
+}
+
+static void
+destroyBlock(MEMAllocator * allocator, MEMStrategy strategy, uint32_t memoryTypeIndex, uint32_t blockIndex)
+{
+    MEMBlock * block = allocator->blockLists[(size_t)strategy][memoryTypeIndex].blocks.data + blockIndex;
+
+    // Freeing memory implicitly unmaps it.
+    vkFreeMemory(allocator->logicalDevice, block->memory, nullptr);
+
+    if(block->freeSlots.count > 0)
+    {
+        bufferFree(&block->freeSlots);
+    }
+
+    if(block->buddyLongest.count > 0)
+    {
+        bufferFree(&block->buddyLongest);
+    }
+
+    MEMStats * stats = allocator->stats + (size_t)strategy;
+    stats->blockCount--;
+    stats->blockBytes -= block->size;
+    *block = {};
+}
+
+static void
+addAllocationStats(MEMAllocator * allocator, const MEMAllocation * allocation)
+{
+    MEMStats * stats = allocator->stats + (size_t)allocation->strategy;
+    stats->allocationCount++;
+    stats->usedBytes += allocation->size;
+    stats->paddingBytes += allocation->reservedSize - allocation->size;
+}
+
+static void
+removeAllocationStats(MEMAllocator * allocator, const MEMAllocation * allocation)
+{
+    MEMStats * stats = allocator->stats + (size_t)allocation->strategy;
+    stats->allocationCount--;
+    stats->usedBytes -= allocation->size;
+    stats->paddingBytes -= allocation->reservedSize - allocation->size;
+}
+
+static void
+initAllocation(const MEMBlock * block, uint32_t blockIndex, VkDeviceSize offset, MEMAllocation * allocation)
+{
+    allocation->memory = block->memory;
+    allocation->offset = offset;
+    allocation->mapped = block->mapped != nullptr ? block->mapped + offset : nullptr;
+    allocation->blockIndex = blockIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Linear Strategy
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the offset of an allocation in block after its current allocations, or block->size if it doesn't fit.
+static VkDeviceSize
+getLinearOffset(const MEMAllocator * allocator, const MEMBlock * block, MEMResourceType resourceType,
+                const VkMemoryRequirements * requirements)
+{
+    VkDeviceSize offset = alignUp(block->linearOffset, requirements->alignment);
+    VkDeviceSize granularity = allocator->bufferImageGranularity;
+
+    // A linear and an optimal resource can't share a bufferImageGranularity page, so if the previous allocation was of
+    // the other type and ends on the page this one starts on, move this one to the next page.
+    if(block->allocationCount > 0
+        && block->linearResourceType != resourceType
+        && (block->linearOffset - 1) / granularity == offset / granularity)
+    {
+        offset = alignUp(offset, granularity);
+    }
+
+    return offset + requirements->size <= block->size ? offset : block->size;
+}
+
+static bool
+allocateLinear(MEMAllocator * allocator, uint32_t memoryTypeIndex, MEMResourceType resourceType,
+               const VkMemoryRequirements * requirements, MEMAllocation * allocation)
+{
+    MEMBlockList * blockList = getBlockList(allocator, MEMStrategy::LINEAR, memoryTypeIndex);
+    uint32_t blockIndex = INVALID_INDEX;
+    VkDeviceSize offset = 0;
+
+    // Find a block of the current frame with enough space left.
+    for(uint32_t i = 0; i < blockList->count; i++)
+    {
+        const MEMBlock * block = blockList->blocks.data + i;
+
+        if(block->memory == VK_NULL_HANDLE || block->frameIndex != allocator->frameIndex)
+        {
+            continue;
+        }
+
+        offset = getLinearOffset(allocator, block, resourceType, requirements);
+
+        if(offset < block->size)
+        {
+            blockIndex = i;
+            break;
+        }
+    }
+
+    if(blockIndex == INVALID_INDEX)
+    {
+        VkDeviceSize blockSize = allocator->config.linearBlockSize;
+
+        blockIndex = createBlock(allocator, MEMStrategy::LINEAR, memoryTypeIndex,
+                                 requirements->size > blockSize ? requirements->size : blockSize, resourceType);
+
+        if(blockIndex == INVALID_INDEX)
+        {
+            return false;
+        }
+
+        offset = 0;
+    }
+
+    MEMBlock * block = blockList->blocks.data + blockIndex;
+    initAllocation(block, blockIndex, offset, allocation);
+    allocation->reservedSize = offset + requirements->size - block->linearOffset;
+    block->linearOffset = offset + requirements->size;
+    block->linearResourceType = resourceType;
+    block->usedBytes += requirements->size;
+    block->allocationCount++;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Pool Strategy
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static bool
+allocatePool(MEMAllocator * allocator, uint32_t memoryTypeIndex, MEMResourceType resourceType,
+             VkDeviceSize slotSize, MEMAllocation * allocation)
+{
+    MEMBlockList * blockList = getBlockList(allocator, MEMStrategy::POOL, memoryTypeIndex);
+    uint32_t sizeClass = log2PowerOfTwo(slotSize / MEM_MIN_ALLOCATION_SIZE);
+    uint32_t blockIndex = INVALID_INDEX;
+
+    // Find a block of the size class with a free slot.
+    for(uint32_t i = 0; i < blockList->count; i++)
+    {
+        const MEMBlock * block = blockList->blocks.data + i;
+
+        if(block->memory != VK_NULL_HANDLE
+            && block->sizeClass == sizeClass
+            && block->freeSlotCount > 0
+            && isResourceTypeCompatible(allocator, block, resourceType))
+        {
+            blockIndex = i;
+            break;
+        }
+    }
+
+    if(blockIndex == INVALID_INDEX)
+    {
+        blockIndex =
+            createBlock(allocator, MEMStrategy::POOL, memoryTypeIndex, allocator->config.poolBlockSize, resourceType);
+
+        if(blockIndex == INVALID_INDEX)
+        {
+            return false;
+        }
+
+        // Push slots in reverse, so they are allocated from the start of the block.
+        MEMBlock * block = blockList->blocks.data + blockIndex;
+        auto slotCount = (uint32_t)(block->size / slotSize);
+        block->sizeClass = sizeClass;
+        block->freeSlots = bufferCreate<uint32_t>(slotCount);
+        block->freeSlotCount = slotCount;
+
+        for(uint32_t slot = 0; slot < slotCount; slot++)
+        {
+            block->freeSlots.data[slot] = slotCount - 1 - slot;
+        }
+    }
+
+    MEMBlock * block = blockList->blocks.data + blockIndex;
+    block->freeSlotCount--;
+    initAllocation(block, blockIndex, block->freeSlots.data[block->freeSlotCount] * slotSize, allocation);
+    allocation->reservedSize = slotSize;
+    block->allocationCount++;
+
+    return true;
+}
+
+static void
+freePool(MEMAllocator * allocator, const MEMAllocation * allocation)
+{
+    MEMBlock * block =
+        allocator->blockLists[STRATEGY_INDEX(POOL)][allocation->memoryTypeIndex].blocks.data + allocation->blockIndex;
+
+    // Empty blocks are kept for reuse.
+    block->freeSlots.data[block->freeSlotCount] = (uint32_t)(allocation->offset / allocation->reservedSize);
+    block->freeSlotCount++;
+    block->allocationCount--;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Buddy Strategy
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Nodes of a block's buddy tree are stored breadth-first; the root has order maxOrder and covers the whole block, and
+// each node of order n covers MEM_MIN_ALLOCATION_SIZE << n bytes.
+static void
+initBuddyTree(MEMBlock * block, uint32_t maxOrder)
+{
+    block->buddyLongest = bufferCreate<uint8_t>(((size_t)2 << maxOrder) - 1);
+    size_t node = 0;
+
+    // Every node starts out fully free.
+    for(uint32_t depth = 0; depth <= maxOrder; depth++)
+    {
+        for(size_t levelNode = 0; levelNode < ((size_t)1 << depth); levelNode++)
+        {
+            block->buddyLongest.data[node] = (uint8_t)(maxOrder - depth + 1);
+            node++;
+        }
+    }
+}
+
+// Recomputes the largest free node below each ancestor of node, merging buddies that are both fully free.
+static void
+updateBuddyAncestors(uint8_t * longest, size_t node, uint32_t order)
+{
+    while(node != 0)
+    {
+        node = (node - 1) / 2;
+        order++;
+        uint8_t leftLongest = longest[node * 2 + 1];
+        uint8_t rightLongest = longest[node * 2 + 2];
+
+        // A child's longest value is its own order + 1, i.e. order, when it is fully free.
+        if(leftLongest == order && rightLongest == order)
+        {
+            longest[node] = (uint8_t)(order + 1);
+        }
+        else
+        {
+            longest[node] = leftLongest > rightLongest ? leftLongest : rightLongest;
+        }
+    }
+}
+
+// Returns the offset of a free node of order in block, or VK_WHOLE_SIZE if there is none.
+static VkDeviceSize
+allocateBuddyNode(MEMBlock * block, uint32_t maxOrder, uint32_t order)
+{
+    uint8_t * longest = block->buddyLongest.data;
+
+    if(longest[0] < order + 1)
+    {
+        return VK_WHOLE_SIZE;
+    }
+
+    // Descend to a node of the requested order, preferring lower offsets.
+    size_t node = 0;
+
+    for(uint32_t nodeOrder = maxOrder; nodeOrder > order; nodeOrder--)
+    {
+        size_t leftChild = node * 2 + 1;
+        node = longest[leftChild] >= order + 1 ? leftChild : leftChild + 1;
+    }
+
+    longest[node] = 0;
+    updateBuddyAncestors(longest, node, order);
+    size_t levelStart = ((size_t)1 << (maxOrder - order)) - 1;
+
+    return (VkDeviceSize)(node - levelStart) * ((VkDeviceSize)MEM_MIN_ALLOCATION_SIZE << order);
+}
+
+static void
+freeBuddyNode(MEMBlock * block, uint32_t maxOrder, uint32_t order, VkDeviceSize offset)
+{
+    size_t levelStart = ((size_t)1 << (maxOrder - order)) - 1;
+    size_t node = levelStart + (size_t)(offset / ((VkDeviceSize)MEM_MIN_ALLOCATION_SIZE << order));
+    block->buddyLongest.data[node] = (uint8_t)(order + 1);
+    updateBuddyAncestors(block->buddyLongest.data, node, order);
+}
+
+static bool
+allocateBuddy(MEMAllocator * allocator, uint32_t memoryTypeIndex, MEMResourceType resourceType,
+              const VkMemoryRequirements * requirements, MEMAllocation * allocation)
+{
+    MEMBlockList * blockList = getBlockList(allocator, MEMStrategy::BUDDY, memoryTypeIndex);
+    VkDeviceSize size = getPowerOfTwoSize(requirements);
+    VkDeviceSize blockSize = allocator->config.buddyBlockSize;
+
+    // Allocations larger than a block get a dedicated block of exactly their size.
+    if(size > blockSize)
+    {
+        uint32_t blockIndex =
+            createBlock(allocator, MEMStrategy::BUDDY, memoryTypeIndex, requirements->size, resourceType);
+
+        if(blockIndex == INVALID_INDEX)
+        {
+            return false;
+        }
+
+        initAllocation(blockList->blocks.data + blockIndex, blockIndex, 0, allocation);
+        allocation->reservedSize = requirements->size;
+        blockList->blocks.data[blockIndex].allocationCount++;
+
+        return true;
+    }
+
+    uint32_t maxOrder = allocator->buddyMaxOrder;
+    uint32_t order = log2PowerOfTwo(size / MEM_MIN_ALLOCATION_SIZE);
+
+    for(uint32_t blockIndex = 0; blockIndex < blockList->count; blockIndex++)
+    {
+        MEMBlock * block = blockList->blocks.data + blockIndex;
+
+        if(block->memory == VK_NULL_HANDLE
+            || block->buddyLongest.count == 0
+            || !isResourceTypeCompatible(allocator, block, resourceType))
+        {
+            continue;
+        }
+
+        VkDeviceSize offset = allocateBuddyNode(block, maxOrder, order);
+
+        if(offset != VK_WHOLE_SIZE)
+        {
+            initAllocation(block, blockIndex, offset, allocation);
+            allocation->reservedSize = size;
+            block->allocationCount++;
+
+            return true;
+        }
+    }
+
+    // No block has a free node large enough, so create another.
+    uint32_t blockIndex = createBlock(allocator, MEMStrategy::BUDDY, memoryTypeIndex, blockSize, resourceType);
+
+    if(blockIndex == INVALID_INDEX)
+    {
+        return false;
+    }
+
+    MEMBlock * block = blockList->blocks.data + blockIndex;
+    initBuddyTree(block, maxOrder);
+    initAllocation(block, blockIndex, allocateBuddyNode(block, maxOrder, order), allocation);
+    allocation->reservedSize = size;
+    block->allocationCount++;
+
+    return true;
+}
+
+static void
+freeBuddy(MEMAllocator * allocator, const MEMAllocation * allocation)
+{
+    MEMBlock * block =
+        allocator->blockLists[STRATEGY_INDEX(BUDDY)][allocation->memoryTypeIndex].blocks.data + allocation->blockIndex;
+
+    // Dedicated blocks are destroyed with their allocation; other empty blocks are kept for reuse.
+    if(block->buddyLongest.count == 0)
+    {
+        destroyBlock(allocator, MEMStrategy::BUDDY, allocation->memoryTypeIndex, allocation->blockIndex);
+        return;
+    }
+
+    uint32_t order = log2PowerOfTwo(allocation->reservedSize / MEM_MIN_ALLOCATION_SIZE);
+    freeBuddyNode(block, allocator->buddyMaxOrder, order, allocation->offset);
+    block->allocationCount--;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+memInit(MEMAllocator * allocator, VkPhysicalDevice physicalDevice, VkDevice logicalDevice, const MEMConfig * config)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(config != nullptr);
+    PRISM_ASSERT(config->frameCount > 0);
+    static const VkDeviceSize DEFAULT_LINEAR_BLOCK_SIZE = MEBIBYTE(16);
+    static const VkDeviceSize DEFAULT_POOL_BLOCK_SIZE = MEBIBYTE(4);
+    static const VkDeviceSize DEFAULT_BUDDY_BLOCK_SIZE = MEBIBYTE(64);
+    *allocator = {};
+    allocator->logicalDevice = logicalDevice;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &allocator->memoryProperties);
+    VkPhysicalDeviceProperties physicalDeviceProperties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    allocator->bufferImageGranularity = physicalDeviceProperties.limits.bufferImageGranularity;
+    allocator->maxMemoryAllocationCount = physicalDeviceProperties.limits.maxMemoryAllocationCount;
+
+    // Apply defaults; pool blocks must hold at least one slot of the largest size class, and buddy blocks must be a
+    // power of two of at least the minimum allocation size.
+    MEMConfig * allocatorConfig = &allocator->config;
+    *allocatorConfig = *config;
+
+    if(allocatorConfig->linearBlockSize == 0)
+    {
+        allocatorConfig->linearBlockSize = DEFAULT_LINEAR_BLOCK_SIZE;
+    }
+
+    if(allocatorConfig->poolBlockSize < MAX_POOL_SLOT_SIZE)
+    {
+        allocatorConfig->poolBlockSize = allocatorConfig->poolBlockSize == 0 ? DEFAULT_POOL_BLOCK_SIZE
+                                                                           : MAX_POOL_SLOT_SIZE;
+    }
+
+    if(allocatorConfig->buddyBlockSize == 0)
+    {
+        allocatorConfig->buddyBlockSize = DEFAULT_BUDDY_BLOCK_SIZE;
+    }
+
+    allocatorConfig->buddyBlockSize = nextPowerOfTwo(allocatorConfig->buddyBlockSize);
+
+    if(allocatorConfig->buddyBlockSize < MEM_MIN_ALLOCATION_SIZE)
+    {
+        allocatorConfig->buddyBlockSize = MEM_MIN_ALLOCATION_SIZE;
+    }
+
+    allocator->buddyMaxOrder = log2PowerOfTwo(allocatorConfig->buddyBlockSize / MEM_MIN_ALLOCATION_SIZE);
+    allocator->frameIndex = 0;
+}
+
+uint32_t
+memFindMemoryType(const MEMAllocator * allocator, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags,
+                  VkMemoryPropertyFlags preferredFlags)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    const VkPhysicalDeviceMemoryProperties * memoryProperties = &allocator->memoryProperties;
+    uint32_t requiredTypeIndex = INVALID_INDEX;
+
+    for(uint32_t i = 0; i < memoryProperties->memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags propertyFlags = memoryProperties->memoryTypes[i].propertyFlags;
+
+        if(!(memoryTypeBits & (1u << i)) || (propertyFlags & requiredFlags) != requiredFlags)
+        {
+            continue;
+        }
+
+        if((propertyFlags & preferredFlags) == preferredFlags)
+        {
+            return i;
+        }
+
+        // Keep looking for a type with the preferred flags, but remember the first type with the required flags.
+        if(requiredTypeIndex == INVALID_INDEX)
+        {
+            requiredTypeIndex = i;
+        }
+    }
+
+    return requiredTypeIndex;
+}
+
+bool
+memAllocate(MEMAllocator * allocator, MEMStrategy strategy, MEMResourceType resourceType,
+            const VkMemoryRequirements * requirements, VkMemoryPropertyFlags requiredFlags,
+            VkMemoryPropertyFlags preferredFlags, MEMAllocation * allocation)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(strategy < MEMStrategy::COUNT);
+    PRISM_ASSERT(resourceType < MEMResourceType::COUNT);
+    PRISM_ASSERT(requirements != nullptr);
+    PRISM_ASSERT(requirements->size > 0);
+    PRISM_ASSERT(allocation != nullptr);
+
+    uint32_t memoryTypeIndex =
+        memFindMemoryType(allocator, requirements->memoryTypeBits, requiredFlags, requiredFlags | preferredFlags);
+
+    if(memoryTypeIndex == INVALID_INDEX)
+    {
+        utilWarning("MEMORY", "no memory type with property flags %#010x\n", requiredFlags);
+        return false;
+    }
+
+    *allocation = {};
+    allocation->size = requirements->size;
+    allocation->memoryTypeIndex = memoryTypeIndex;
+    bool allocated = false;
+
+    if(strategy == MEMStrategy::LINEAR)
+    {
+        allocation->strategy = MEMStrategy::LINEAR;
+        allocated = allocateLinear(allocator, memoryTypeIndex, resourceType, requirements, allocation);
+    }
+    else if(strategy == MEMStrategy::POOL && getPowerOfTwoSize(requirements) <= MAX_POOL_SLOT_SIZE)
+    {
+        allocation->strategy = MEMStrategy::POOL;
+
+        allocated =
+            allocatePool(allocator, memoryTypeIndex, resourceType, getPowerOfTwoSize(requirements), allocation);
+    }
+    // Buddy, or pool allocations too large for any size class.
+    else
+    {
+        allocation->strategy = MEMStrategy::BUDDY;
+        allocated = allocateBuddy(allocator, memoryTypeIndex, resourceType, requirements, allocation);
+    }
+
+    if(allocated)
+    {
+        addAllocationStats(allocator, allocation);
+    }
+
+    return allocated;
+}
+
+VkDeviceSize
+memGetReservedSize(const MEMAllocator * allocator, MEMStrategy strategy, const VkMemoryRequirements * requirements)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(strategy < MEMStrategy::COUNT);
+    PRISM_ASSERT(requirements != nullptr);
+
+    // Alignment padding of linear allocations depends on the allocations before them.
+    if(strategy == MEMStrategy::LINEAR)
+    {
+        return requirements->size + requirements->alignment - 1;
+    }
+
+    VkDeviceSize size = getPowerOfTwoSize(requirements);
+
+    // Buddy allocations larger than a block get a dedicated block of exactly their size.
+    if(strategy == MEMStrategy::BUDDY || size > MAX_POOL_SLOT_SIZE)
+    {
+        return size > allocator->config.buddyBlockSize ? requirements->size : size;
+    }
+
+    return size;
+}
+
+void
+memFree(MEMAllocator * allocator, const MEMAllocation * allocation)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(allocation != nullptr);
+    PRISM_ASSERT(allocation->strategy != MEMStrategy::LINEAR);
+    removeAllocationStats(allocator, allocation);
+
+    if(allocation->strategy == MEMStrategy::POOL)
+    {
+        freePool(allocator, allocation);
+    }
+    else
+    {
+        freeBuddy(allocator, allocation);
+    }
+}
+
+void
+memBeginFrame(MEMAllocator * allocator, uint32_t frameIndex)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(frameIndex < allocator->config.frameCount);
+    MEMStats * stats = allocator->stats + STRATEGY_INDEX(LINEAR);
+    allocator->frameIndex = frameIndex;
+
+    // Reset frame's linear blocks; their memory is kept for the frame's next use.
+    for(uint32_t memoryTypeIndex = 0; memoryTypeIndex < VK_MAX_MEMORY_TYPES; memoryTypeIndex++)
+    {
+        MEMBlockList * blockList = &allocator->blockLists[STRATEGY_INDEX(LINEAR)][memoryTypeIndex];
+
+        for(uint32_t i = 0; i < blockList->count; i++)
+        {
+            MEMBlock * block = blockList->blocks.data + i;
+
+            if(block->memory == VK_NULL_HANDLE || block->frameIndex != frameIndex)
+            {
+                continue;
+            }
+
+            stats->allocationCount -= block->allocationCount;
+            stats->usedBytes -= block->usedBytes;
+            stats->paddingBytes -= block->linearOffset - block->usedBytes;
+            block->allocationCount = 0;
+            block->usedBytes = 0;
+            block->linearOffset = 0;
+        }
+    }
+}
+
+const MEMStats *
+memGetStats(const MEMAllocator * allocator, MEMStrategy strategy)
+{
+    PRISM_ASSERT(allocator != nullptr);
+    PRISM_ASSERT(strategy < MEMStrategy::COUNT);
+    return allocator->stats + (size_t)strategy;
+}
+
+void
+memLogStats(const MEMAllocator * allocator)
+{
+    PRISM_ASSERT(allocator != nullptr);
+
+    static const char * STRATEGY_NAMES[]
+    {
+        "linear",
+        "pool",
+        "buddy",
+    };
+
+    utilLog("MEMORY", "device-memory allocator stats:\n");
+
+    for(size_t i = 0; i < (size_t)MEMStrategy::COUNT; i++)
+    {
+        const MEMStats * stats = allocator->stats + i;
+        utilLog("MEMORY", "    %s:\n", STRATEGY_NAMES[i]);
+        utilLog("MEMORY", "        blocks:      %u (%llu bytes)\n", stats->blockCount,
+                (unsigned long long)stats->blockBytes);
+        utilLog("MEMORY", "        allocations: %u\n", stats->allocationCount);
+        utilLog("MEMORY", "        used:        %llu bytes\n", (unsigned long long)stats->usedBytes);
+        utilLog("MEMORY", "        padding:     %llu bytes\n", (unsigned long long)stats->paddingBytes);
+    }
+}
+
+void
+memDestroy(MEMAllocator * allocator)
+{
+    PRISM_ASSERT(allocator != nullptr);
+
+    for(size_t strategyIndex = 0; strategyIndex < (size_t)MEMStrategy::COUNT; strategyIndex++)
+    {
+        for(uint32_t memoryTypeIndex = 0; memoryTypeIndex < VK_MAX_MEMORY_TYPES; memoryTypeIndex++)
+        {
+            MEMBlockList * blockList = &allocator->blockLists[strategyIndex][memoryTypeIndex];
+
+            for(uint32_t i = 0; i < blockList->count; i++)
+            {
+                if(blockList->blocks.data[i].memory != VK_NULL_HANDLE)
+                {
+                    destroyBlock(allocator, (MEMStrategy)strategyIndex, memoryTypeIndex, i);
+                }
+            }
+
+            if(blockList->blocks.count > 0)
+            {
+                bufferFree(&blockList->blocks);
+            }
+
+            *blockList = {};
+        }
+    }
+}
+
+} // namespace prism
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.h"
+#include "ctk/memory.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maximum number of device-memory blocks per strategy and memory type.
+#define MEM_MAX_BLOCKS 256
+
+// Smallest allocation size of the pool and buddy strategies; smaller allocations are rounded up to this size.
+#define MEM_MIN_ALLOCATION_SIZE 256
+
+// Number of pool size classes; pool slot sizes are powers of two from MEM_MIN_ALLOCATION_SIZE up to 64 KiB.
+#define MEM_POOL_SIZE_CLASS_COUNT 9
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum class MEMStrategy
+{
+    // Bump allocation from blocks owned by a frame in flight; everything allocated during a frame is freed at once when
+    // the frame's resources are reused (see memBeginFrame()). For per-frame transient data.
+    LINEAR = 0,
+
+    // Fixed-size slots per power-of-two size class; for many small resources of similar size. Allocations larger than
+    // the largest size class use the buddy strategy instead.
+    POOL = 1,
+
+    // Power-of-two buddy allocation within large blocks; general purpose. Allocations larger than a block get a
+    // dedicated block.
+    BUDDY = 2,
+
+    COUNT = 3,
+};
+
+// Resources that must be kept bufferImageGranularity apart when they share a block.
+enum class MEMResourceType
+{
+    // Buffers and linear-tiling images.
+    LINEAR = 0,
+
+    // Optimal-tiling images.
+    OPTIMAL = 1,
+
+    COUNT = 2,
+};
+
+struct MEMConfig
+{
+    // Sizes of the device-memory blocks each strategy sub-allocates from; 0 uses the default size. The buddy block
+    // size is rounded up to a power of two.
+    VkDeviceSize linearBlockSize;
+    VkDeviceSize poolBlockSize;
+    VkDeviceSize buddyBlockSize;
+
+    // Number of frames in flight; each has its own linear blocks.
+    uint32_t frameCount;
+};
+
+struct MEMBlock
+{
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+
+    // Persistently mapped base address if the block's memory type is host-visible, otherwise null.
+    uint8_t * mapped;
+
+    MEMResourceType resourceType;
+    uint32_t allocationCount;
+
+    // LINEAR: frame the block belongs to, the offset of the next allocation, the resource type of the previous
+    // allocation, and the size requested by the block's allocations.
+    uint32_t frameIndex;
+    VkDeviceSize linearOffset;
+    MEMResourceType linearResourceType;
+    VkDeviceSize usedBytes;
+
+    // POOL: size class of the block's slots, and a stack of free slot indexes.
+    uint32_t sizeClass;
+    ctk::Buffer<uint32_t> freeSlots;
+    uint32_t freeSlotCount;
+
+    // BUDDY: for each node of the block's buddy tree, the order + 1 of the largest free node in its subtree (0 if the
+    // subtree is fully allocated); empty for dedicated blocks.
+    ctk::Buffer<uint8_t> buddyLongest;
+};
+
+struct MEMBlockList
+{
+    // Allocated with capacity MEM_MAX_BLOCKS on first use; blocks with memory VK_NULL_HANDLE are unused.
+    ctk::Buffer<MEMBlock> blocks;
+    uint32_t count;
+};
+
+struct MEMStats
+{
+    // Device-memory allocations, and their total size.
+    uint32_t blockCount;
+    VkDeviceSize blockBytes;
+
+    // Sub-allocations, the size requested for them and the size lost to alignment, rounding and
+    // bufferImageGranularity.
+    uint32_t allocationCount;
+    VkDeviceSize usedBytes;
+    VkDeviceSize paddingBytes;
+};
+
+struct MEMAllocation
+{
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+
+    // Mapped address of the allocation if its memory type is host-visible, otherwise null.
+    void * mapped;
+
+    // Used to free the allocation.
+    MEMStrategy strategy;
+    uint32_t memoryTypeIndex;
+    uint32_t blockIndex;
+    VkDeviceSize reservedSize;
+};
+
+struct MEMAllocator
+{
+    VkDevice logicalDevice;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize bufferImageGranularity;
+    uint32_t maxMemoryAllocationCount;
+    MEMConfig config;
+    uint32_t buddyMaxOrder;
+    uint32_t frameIndex;
+    MEMBlockList blockLists[(size_t)MEMStrategy::COUNT][VK_MAX_MEMORY_TYPES];
+    MEMStats stats[(size_t)MEMStrategy::COUNT];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+memInit(MEMAllocator * allocator, VkPhysicalDevice physicalDevice, VkDevice logicalDevice, const MEMConfig * config);
+
+// Returns the index of a memory type allowed by memoryTypeBits that has requiredFlags, preferring one that also has
+// preferredFlags, or UINT32_MAX if there is none.
+uint32_t
+memFindMemoryType(const MEMAllocator * allocator, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags,
+                  VkMemoryPropertyFlags preferredFlags);
+
+// Sub-allocates memory satisfying requirements from a memory type with requiredFlags (preferring preferredFlags).
+// Returns false if no such memory type exists or device memory is exhausted.
+bool
+memAllocate(MEMAllocator * allocator, MEMStrategy strategy, MEMResourceType resourceType,
+            const VkMemoryRequirements * requirements, VkMemoryPropertyFlags requiredFlags,
+            VkMemoryPropertyFlags preferredFlags, MEMAllocation * allocation);
+
+// Returns the size memAllocate() would reserve for requirements with strategy, so budgets can be checked before
+// allocating; an upper bound for linear allocations.
+VkDeviceSize
+memGetReservedSize(const MEMAllocator * allocator, MEMStrategy strategy, const VkMemoryRequirements * requirements);
+
+// Frees a pool or buddy allocation; linear allocations are freed by memBeginFrame().
+void
+memFree(MEMAllocator * allocator, const MEMAllocation * allocation);
+
+// Frees all linear allocations made while frameIndex was last the current frame, and makes it the current frame. Call
+// once the GPU has finished with the frame's resources.
+void
+memBeginFrame(MEMAllocator * allocator, uint32_t frameIndex);
+
+const MEMStats *
+memGetStats(const MEMAllocator * allocator, MEMStrategy strategy);
+
+void
+memLogStats(const MEMAllocator * allocator);
+
+void
+memDestroy(MEMAllocator * allocator);
+
+} // namespace prism
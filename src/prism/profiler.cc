@@ -0,0 +1,344 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include "prism/profiler.h"
+#include "prism/utilities.h"
+#include "ctk/memory.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Track id of the GPU in exported traces; thread tracks use their index.
+#define GPU_TRACK_ID PROF_MAX_THREADS
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct Zone
+{
+    const char * name;
+    uint64_t startTime;
+    uint64_t endTime;
+};
+
+// Zones of one track; only the owning thread appends, and zoneCount is published with release ordering so the thread
+// ending the capture sees complete zones. Zone storage is allocated by the first zone recorded during a capture, so
+// threads that are only named, or never record while capturing, don't hold it.
+struct Track
+{
+    char name[PROF_MAX_THREAD_NAME_SIZE];
+    Buffer<Zone> zones;
+    std::atomic<uint32_t> zoneCount;
+    std::atomic<uint32_t> droppedZoneCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+std::atomic<bool> profCapturing(false);
+
+// Threads' tracks are created on their first zone and kept until profShutdown(), even after the thread exits.
+static std::mutex tracksMutex;
+static Track * threadTracks[PROF_MAX_THREADS];
+static uint32_t threadTrackCount;
+static Track * gpuTrack;
+static thread_local Track * currentThreadTrack;
+static uint64_t captureStartTime;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static Track *
+createTrack(const char * name)
+{
+    auto track = new Track;
+    strncpy(track->name, name, PROF_MAX_THREAD_NAME_SIZE - 1);
+    track->name[PROF_MAX_THREAD_NAME_SIZE - 1] = '\0';
+    track->zones = {};
+    track->zoneCount = 0;
+    track->droppedZoneCount = 0;
+
+    return track;
+}
+
+static void
+destroyTrack(Track * track)
+{
+    if(track->zones.data != nullptr)
+    {
+        bufferFree(&track->zones);
+    }
+
+    delete track;
+}
+
+// Returns null if PROF_MAX_THREADS threads already have tracks.
+static Track *
+getThreadTrack()
+{
+    if(currentThreadTrack != nullptr)
+    {
+        return currentThreadTrack;
+    }
+
+    std::lock_guard<std::mutex> lock(tracksMutex);
+
+    if(threadTrackCount == PROF_MAX_THREADS)
+    {
+        return nullptr;
+    }
+
+    char name[PROF_MAX_THREAD_NAME_SIZE] = {};
+    snprintf(name, sizeof(name), "thread %u", threadTrackCount);
+    currentThreadTrack = createTrack(name);
+    threadTracks[threadTrackCount++] = currentThreadTrack;
+
+    return currentThreadTrack;
+}
+
+static void
+appendZone(Track * track, const char * name, uint64_t startTime, uint64_t endTime)
+{
+    uint32_t zoneIndex = track->zoneCount.load(std::memory_order_relaxed);
+
+    if(zoneIndex == PROF_MAX_ZONES_PER_THREAD)
+    {
+        track->droppedZoneCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if(track->zones.data == nullptr)
+    {
+        track->zones = bufferCreate<Zone>(PROF_MAX_ZONES_PER_THREAD);
+    }
+
+    track->zones.data[zoneIndex] = { name, startTime, endTime };
+    track->zoneCount.store(zoneIndex + 1, std::memory_order_release);
+}
+
+static void
+resetTrack(Track * track)
+{
+    track->zoneCount.store(0, std::memory_order_relaxed);
+    track->droppedZoneCount.store(0, std::memory_order_relaxed);
+}
+
+// Zone names are string literals from code, so only quotes and backslashes need escaping.
+static void
+writeJSONString(FILE * file, const char * string)
+{
+    fputc('"', file);
+
+    for(const char * c = string; *c != '\0'; c++)
+    {
+        if(*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+        }
+
+        fputc(*c, file);
+    }
+
+    fputc('"', file);
+}
+
+// Writes a track's name as a metadata event, then its zones as complete events with times in microseconds from the
+// start of the capture. Returns the number of zones dropped because the track was full.
+static uint32_t
+writeTrack(FILE * file, const Track * track, uint32_t trackID, bool * firstEvent)
+{
+    fprintf(file, "%s\n    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, \"args\": { \"name\": ",
+            *firstEvent ? "" : ",", trackID);
+
+    writeJSONString(file, track->name);
+    fprintf(file, " } }");
+    *firstEvent = false;
+    uint32_t zoneCount = track->zoneCount.load(std::memory_order_acquire);
+
+    for(uint32_t i = 0; i < zoneCount; i++)
+    {
+        const Zone * zone = track->zones.data + i;
+
+        // Zones that began before the capture started are cut off, as their start wasn't captured.
+        if(zone->startTime < captureStartTime)
+        {
+            continue;
+        }
+
+        fprintf(file, ",\n    { \"name\": ");
+        writeJSONString(file, zone->name);
+
+        fprintf(file, ", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f }", trackID,
+                (zone->startTime - captureStartTime) / 1000.0, (zone->endTime - zone->startTime) / 1000.0);
+    }
+
+    return track->droppedZoneCount.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint64_t
+profGetTime()
+{
+    timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+void
+profSetThreadName(const char * name)
+{
+    Track * track = getThreadTrack();
+
+    if(track != nullptr)
+    {
+        strncpy(track->name, name, PROF_MAX_THREAD_NAME_SIZE - 1);
+    }
+}
+
+void
+profRecordZone(const char * name, uint64_t startTime, uint64_t endTime)
+{
+    if(!profIsCapturing())
+    {
+        return;
+    }
+
+    Track * track = getThreadTrack();
+
+    if(track != nullptr)
+    {
+        appendZone(track, name, startTime, endTime);
+    }
+}
+
+void
+profRecordGPUZone(const char * name, uint64_t startTime, uint64_t endTime)
+{
+    if(!profIsCapturing())
+    {
+        return;
+    }
+
+    if(gpuTrack == nullptr)
+    {
+        gpuTrack = createTrack("GPU");
+    }
+
+    appendZone(gpuTrack, name, startTime, endTime);
+}
+
+void
+profBeginCapture()
+{
+    {
+        std::lock_guard<std::mutex> lock(tracksMutex);
+
+        for(uint32_t i = 0; i < threadTrackCount; i++)
+        {
+            resetTrack(threadTracks[i]);
+        }
+    }
+
+    if(gpuTrack != nullptr)
+    {
+        resetTrack(gpuTrack);
+    }
+
+    captureStartTime = profGetTime();
+    profCapturing.store(true, std::memory_order_release);
+    utilLog("PROFILER", "capture started\n");
+}
+
+bool
+profEndCapture(const char * path)
+{
+    profCapturing.store(false, std::memory_order_release);
+    FILE * file = fopen(path, "w");
+
+    if(file == nullptr)
+    {
+        utilWarning("PROFILER", "failed to open '%s' to write capture\n", path);
+        return false;
+    }
+
+    fprintf(file, "{ \"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    bool firstEvent = true;
+    uint32_t droppedZoneCount = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(tracksMutex);
+
+        for(uint32_t i = 0; i < threadTrackCount; i++)
+        {
+            droppedZoneCount += writeTrack(file, threadTracks[i], i, &firstEvent);
+        }
+    }
+
+    if(gpuTrack != nullptr)
+    {
+        droppedZoneCount += writeTrack(file, gpuTrack, GPU_TRACK_ID, &firstEvent);
+    }
+
+    fprintf(file, "\n] }\n");
+    bool written = ferror(file) == 0;
+    fclose(file);
+
+    if(!written)
+    {
+        utilWarning("PROFILER", "failed to write capture to '%s'\n", path);
+        return false;
+    }
+
+    if(droppedZoneCount > 0)
+    {
+        utilWarning("PROFILER", "%u zones were dropped; tracks hold at most %u zones per capture\n", droppedZoneCount,
+                    PROF_MAX_ZONES_PER_THREAD);
+    }
+
+    utilLog("PROFILER", "capture written to '%s'\n", path);
+    return true;
+}
+
+void
+profShutdown()
+{
+    profCapturing.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(tracksMutex);
+
+    // Cleanup
+    for(uint32_t i = 0; i < threadTrackCount; i++)
+    {
+        destroyTrack(threadTracks[i]);
+    }
+
+    if(gpuTrack != nullptr)
+    {
+        destroyTrack(gpuTrack);
+    }
+
+    threadTrackCount = 0;
+    gpuTrack = nullptr;
+    currentThreadTrack = nullptr;
+}
+
+} // namespace prism
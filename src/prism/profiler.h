@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maximum number of threads that can record zones, not counting the GPU track.
+#define PROF_MAX_THREADS 64
+
+// Zones recorded per thread per capture; later zones are dropped and counted.
+#define PROF_MAX_ZONES_PER_THREAD 65536
+
+#define PROF_MAX_THREAD_NAME_SIZE 32
+
+#define PROF_CONCAT_(A, B) A ## B
+#define PROF_CONCAT(A, B) PROF_CONCAT_(A, B)
+
+// Records a CPU zone from this point to the end of the enclosing scope on the calling thread's track. NAME must be a
+// string that outlives the capture, e.g. a literal.
+#define PROF_ZONE(NAME) prism::PROFScopedZone PROF_CONCAT(profZone, __LINE__)(NAME)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// See PROF_ZONE().
+struct PROFScopedZone
+{
+    const char * name;
+
+    // 0 if no capture was running when the zone began.
+    uint64_t startTime;
+
+    PROFScopedZone(const char * name);
+    ~PROFScopedZone();
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Set between profBeginCapture() and profEndCapture(); zones are only recorded while it is set, so instrumentation
+// costs a relaxed load and a branch per zone when no capture is running.
+extern std::atomic<bool> profCapturing;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline bool
+profIsCapturing()
+{
+    return profCapturing.load(std::memory_order_relaxed);
+}
+
+// Nanoseconds on the monotonic clock zones are recorded with.
+uint64_t
+profGetTime();
+
+// Names the calling thread's track in captures; threads are named "thread <index>" by default.
+void
+profSetThreadName(const char * name);
+
+// Records a zone on the calling thread's track; times are from profGetTime(). Does nothing if no capture is running.
+void
+profRecordZone(const char * name, uint64_t startTime, uint64_t endTime);
+
+// Records a zone on the GPU track; times are GPU timestamps already converted to the profGetTime() clock. Must only be
+// called from one thread at a time.
+void
+profRecordGPUZone(const char * name, uint64_t startTime, uint64_t endTime);
+
+// Starts a capture, discarding zones from any previous capture. Call between frames, while no zones are being recorded.
+void
+profBeginCapture();
+
+// Stops the capture and writes its zones to path as Chrome trace JSON, which chrome://tracing and Perfetto load.
+// Returns false if the file can't be written.
+bool
+profEndCapture(const char * path);
+
+// Frees every thread's zone storage; no zones may be recorded afterwards.
+void
+profShutdown();
+
+inline
+PROFScopedZone::PROFScopedZone(const char * name)
+    : name(name)
+    , startTime(profIsCapturing() ? profGetTime() : 0)
+{
+}
+
+inline
+PROFScopedZone::~PROFScopedZone()
+{
+    if(startTime != 0)
+    {
+        profRecordZone(name, startTime, profGetTime());
+    }
+}
+
+} // namespace prism
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include "prism/jobs.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Alignment of every column; a cache line, which also covers aligned loads of AVX2 and AVX-512 vectors.
+#define SOA_COLUMN_ALIGNMENT 64
+
+// Capacity is always a multiple of this many rows, so vector loops may run past the last row up to the next multiple
+// of their lane count (see soaGetPaddedCount()) without a scalar tail.
+#define SOA_CAPACITY_GRANULARITY 64
+
+#define SOA_INVALID_ROW UINT32_MAX
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Typedefs
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<size_t COLUMN, typename ...Columns>
+using SOAColumnType = typename std::tuple_element<COLUMN, std::tuple<Columns...>>::type;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Identifies a row across swap-removes of other rows; goes stale when its own row is removed. A zero-initialized
+// handle is never valid.
+struct SOAHandle
+{
+    uint32_t slot;
+    uint32_t generation;
+};
+
+// Structure-of-arrays table with one aligned, contiguous column per type in Columns; rows [0, count) are live and
+// densely packed. Column types must be trivially copyable, as rows are moved with memcpy().
+template<typename ...Columns>
+struct SOATable
+{
+    void * columns[sizeof...(Columns)];
+    uint32_t count;
+    uint32_t capacity;
+
+    // Handle indirection: slotRows maps a live slot to its row (or a free slot to the next free slot), rowSlots maps
+    // a row back to its slot, and slotGenerations is bumped whenever a slot's row is removed.
+    uint32_t * slotRows;
+    uint32_t * slotGenerations;
+    uint32_t * rowSlots;
+    uint32_t slotCount;
+    uint32_t freeSlot;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+constexpr bool
+soaAllTrue(const bool * values, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!values[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline void *
+soaAllocateAligned(size_t size)
+{
+    void * memory = nullptr;
+
+    if(posix_memalign(&memory, SOA_COLUMN_ALIGNMENT, size) != 0)
+    {
+        utilErrorExit("SOA", nullptr, "failed to allocate %zu bytes\n", size);
+    }
+
+    return memory;
+}
+
+template<typename ...Columns>
+void
+soaCheckColumnTypes()
+{
+    static constexpr bool TRIVIALLY_COPYABLE[] = { std::is_trivially_copyable<Columns>::value... };
+    static_assert(sizeof...(Columns) > 0, "SOATable needs at least one column");
+    static_assert(soaAllTrue(TRIVIALLY_COPYABLE, sizeof...(Columns)), "SOATable columns must be trivially copyable");
+}
+
+template<typename ...Columns>
+struct SOAChunkJob
+{
+    const SOATable<Columns...> * table;
+    uint32_t chunkSize;
+    void * fn;
+};
+
+// Called by jobParallelFor() with a range of chunk indexes.
+template<typename Fn, typename ...Columns>
+void
+soaRunChunks(void * data, size_t beginChunk, size_t endChunk)
+{
+    auto job = (const SOAChunkJob<Columns...> *)data;
+    auto fn = (Fn *)job->fn;
+    uint32_t paddedCount = soaGetPaddedCount(job->table, job->chunkSize);
+
+    for(size_t chunk = beginChunk; chunk < endChunk; chunk++)
+    {
+        uint32_t begin = (uint32_t)chunk * job->chunkSize;
+        uint32_t end = begin + job->chunkSize < paddedCount ? begin + job->chunkSize : paddedCount;
+        (*fn)(begin, end);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Grows every column to hold at least capacity rows, keeping existing rows and handles; column pointers change.
+template<typename ...Columns>
+void
+soaReserve(SOATable<Columns...> * table, uint32_t capacity)
+{
+    if(capacity <= table->capacity)
+    {
+        return;
+    }
+
+    const size_t COLUMN_SIZES[] = { sizeof(Columns)... };
+    capacity = (capacity + SOA_CAPACITY_GRANULARITY - 1) / SOA_CAPACITY_GRANULARITY * SOA_CAPACITY_GRANULARITY;
+
+    for(size_t column = 0; column < sizeof...(Columns); column++)
+    {
+        // Padding rows are zeroed so vector loops reading past the last row never read uninitialized memory.
+        auto newColumn = (uint8_t *)soaAllocateAligned(COLUMN_SIZES[column] * capacity);
+        size_t usedSize = COLUMN_SIZES[column] * table->count;
+        memset(newColumn + usedSize, 0, COLUMN_SIZES[column] * capacity - usedSize);
+
+        if(table->columns[column] != nullptr)
+        {
+            memcpy(newColumn, table->columns[column], usedSize);
+            free(table->columns[column]);
+        }
+
+        table->columns[column] = newColumn;
+    }
+
+    uint32_t ** indexArrays[] = { &table->slotRows, &table->slotGenerations, &table->rowSlots };
+
+    for(uint32_t ** indexArray : indexArrays)
+    {
+        auto newIndexArray = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+
+        if(*indexArray != nullptr)
+        {
+            memcpy(newIndexArray, *indexArray, sizeof(uint32_t) * table->capacity);
+            free(*indexArray);
+        }
+
+        *indexArray = newIndexArray;
+    }
+
+    // Generations start at 1 so zero-initialized handles are never valid.
+    for(uint32_t slot = table->capacity; slot < capacity; slot++)
+    {
+        table->slotGenerations[slot] = 1;
+    }
+
+    table->capacity = capacity;
+}
+
+template<typename ...Columns>
+void
+soaCreate(SOATable<Columns...> * table, uint32_t capacity)
+{
+    soaCheckColumnTypes<Columns...>();
+    *table = {};
+    table->freeSlot = SOA_INVALID_ROW;
+    soaReserve(table, capacity > 0 ? capacity : SOA_CAPACITY_GRANULARITY);
+}
+
+template<typename ...Columns>
+void
+soaDestroy(SOATable<Columns...> * table)
+{
+    for(size_t column = 0; column < sizeof...(Columns); column++)
+    {
+        free(table->columns[column]);
+    }
+
+    free(table->slotRows);
+    free(table->slotGenerations);
+    free(table->rowSlots);
+    *table = {};
+}
+
+template<size_t COLUMN, typename ...Columns>
+SOAColumnType<COLUMN, Columns...> *
+soaGetColumn(const SOATable<Columns...> * table)
+{
+    return (SOAColumnType<COLUMN, Columns...> *)table->columns[COLUMN];
+}
+
+// Appends a zero-initialized row, growing the table if it is full, and returns its handle.
+template<typename ...Columns>
+SOAHandle
+soaAdd(SOATable<Columns...> * table)
+{
+    if(table->count == table->capacity)
+    {
+        soaReserve(table, table->capacity * 2);
+    }
+
+    const size_t COLUMN_SIZES[] = { sizeof(Columns)... };
+    uint32_t row = table->count++;
+
+    for(size_t column = 0; column < sizeof...(Columns); column++)
+    {
+        memset((uint8_t *)table->columns[column] + COLUMN_SIZES[column] * row, 0, COLUMN_SIZES[column]);
+    }
+
+    // Reuse a free slot if there is one; otherwise every slot is live, so slotCount < capacity.
+    uint32_t slot = table->freeSlot;
+
+    if(slot != SOA_INVALID_ROW)
+    {
+        table->freeSlot = table->slotRows[slot];
+    }
+    else
+    {
+        slot = table->slotCount++;
+    }
+
+    table->slotRows[slot] = row;
+    table->rowSlots[row] = slot;
+
+    return { slot, table->slotGenerations[slot] };
+}
+
+// Returns the row of handle's entity, or SOA_INVALID_ROW if the handle is stale.
+template<typename ...Columns>
+uint32_t
+soaGetRow(const SOATable<Columns...> * table, SOAHandle handle)
+{
+    if(handle.slot >= table->slotCount || table->slotGenerations[handle.slot] != handle.generation)
+    {
+        return SOA_INVALID_ROW;
+    }
+
+    return table->slotRows[handle.slot];
+}
+
+template<typename ...Columns>
+SOAHandle
+soaGetHandle(const SOATable<Columns...> * table, uint32_t row)
+{
+    PRISM_ASSERT(row < table->count);
+    uint32_t slot = table->rowSlots[row];
+
+    return { slot, table->slotGenerations[slot] };
+}
+
+// Removes handle's row by moving the last row into its place, which keeps rows densely packed; handles of the moved
+// row stay valid. Returns false if the handle is stale.
+template<typename ...Columns>
+bool
+soaRemove(SOATable<Columns...> * table, SOAHandle handle)
+{
+    uint32_t row = soaGetRow(table, handle);
+
+    if(row == SOA_INVALID_ROW)
+    {
+        return false;
+    }
+
+    const size_t COLUMN_SIZES[] = { sizeof(Columns)... };
+    uint32_t lastRow = --table->count;
+
+    if(row != lastRow)
+    {
+        for(size_t column = 0; column < sizeof...(Columns); column++)
+        {
+            auto columnData = (uint8_t *)table->columns[column];
+            size_t size = COLUMN_SIZES[column];
+            memcpy(columnData + size * row, columnData + size * lastRow, size);
+        }
+
+        uint32_t movedSlot = table->rowSlots[lastRow];
+        table->slotRows[movedSlot] = row;
+        table->rowSlots[row] = movedSlot;
+    }
+
+    table->slotGenerations[handle.slot]++;
+    table->slotRows[handle.slot] = table->freeSlot;
+    table->freeSlot = handle.slot;
+
+    return true;
+}
+
+// Returns count rounded up to a multiple of laneCount, which must divide SOA_CAPACITY_GRANULARITY. Every column can be
+// read and written up to the padded count; rows past count hold no entity.
+template<typename ...Columns>
+uint32_t
+soaGetPaddedCount(const SOATable<Columns...> * table, uint32_t laneCount)
+{
+    PRISM_ASSERT(laneCount > 0 && SOA_CAPACITY_GRANULARITY % laneCount == 0);
+
+    return (table->count + laneCount - 1) / laneCount * laneCount;
+}
+
+// Calls fn(begin, end) for consecutive row ranges of chunkSize rows, the last one ending at the padded count for
+// chunkSize, so each chunk can be processed with whole vectors. With a chunkSize whose rows fill a multiple of 32 bytes
+// in every column, every chunk starts on an AVX2-aligned address.
+template<typename Fn, typename ...Columns>
+void
+soaForEachChunk(const SOATable<Columns...> * table, uint32_t chunkSize, Fn fn)
+{
+    uint32_t paddedCount = soaGetPaddedCount(table, chunkSize);
+
+    for(uint32_t begin = 0; begin < paddedCount; begin += chunkSize)
+    {
+        fn(begin, begin + chunkSize < paddedCount ? begin + chunkSize : paddedCount);
+    }
+}
+
+// soaForEachChunk() with chunks spread over the scheduler's threads; fn must be safe to call concurrently for
+// different chunks.
+template<typename Fn, typename ...Columns>
+void
+soaParallelForEachChunk(JOBScheduler * scheduler, const SOATable<Columns...> * table, uint32_t chunkSize, Fn fn)
+{
+    uint32_t chunkCount = soaGetPaddedCount(table, chunkSize) / chunkSize;
+    SOAChunkJob<Columns...> job = { table, chunkSize, &fn };
+    jobParallelFor(scheduler, chunkCount, 0, soaRunChunks<Fn, Columns...>, &job);
+}
+
+} // namespace prism
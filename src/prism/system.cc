@@ -27,6 +27,13 @@ keyCallback(GLFWwindow * window, int key, int scancode, int action, int mods)
     }
 }
 
+static void
+framebufferSizeCallback(GLFWwindow * window, int, int)
+{
+    auto context = (SYSContext *)glfwGetWindowUserPointer(window);
+    context->framebufferResized = true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Interface
@@ -53,7 +60,7 @@ sysCreateWindow(SYSContext * context, int width, int height, const char * title)
     PRISM_ASSERT(width > 0);
     PRISM_ASSERT(height > 0);
     PRISM_ASSERT(title != nullptr);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     GLFWwindow ** window = &context->window;
     *window = glfwCreateWindow(width, height, title, nullptr, nullptr);
 
@@ -62,7 +69,10 @@ sysCreateWindow(SYSContext * context, int width, int height, const char * title)
         utilErrorExit("GLFW", nullptr, "failed to create window\n");
     }
 
+    context->framebufferResized = false;
+    glfwSetWindowUserPointer(*window, context);
     glfwSetKeyCallback(*window, keyCallback);
+    glfwSetFramebufferSizeCallback(*window, framebufferSizeCallback);
 }
 
 Buffer<const char *>
@@ -90,13 +100,27 @@ sysCreateSurface(const void * data, VkInstance instance)
 }
 
 void
-sysRun(SYSContext * context)
+sysRun(SYSContext * context, SYSFrameFn frameFn, void * frameFnData)
 {
     PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(frameFn != nullptr);
 
     while(!glfwWindowShouldClose(context->window))
     {
         glfwPollEvents();
+        int width = 0;
+        int height = 0;
+        glfwGetFramebufferSize(context->window, &width, &height);
+
+        // There is nothing to render to while the window is minimized, so sleep until an event changes that instead of
+        // spinning on frames that are skipped.
+        while((width == 0 || height == 0) && !glfwWindowShouldClose(context->window))
+        {
+            glfwWaitEvents();
+            glfwGetFramebufferSize(context->window, &width, &height);
+        }
+
+        frameFn(frameFnData);
     }
 }
 
@@ -10,6 +10,13 @@
 namespace prism
 {
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Typedefs
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+using SYSFrameFn = void (*)(void *);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Data Structures
@@ -18,6 +25,9 @@ namespace prism
 struct SYSContext
 {
     GLFWwindow * window;
+
+    // Set when the window's framebuffer is resized; cleared by whoever handles the resize.
+    bool framebufferResized;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -37,8 +47,10 @@ sysGetRequiredExtensions();
 VkSurfaceKHR
 sysCreateSurface(const void * data, VkInstance instance);
 
+// Polls window events and calls frameFn with frameFnData once per loop until the window is closed. While the window's
+// framebuffer is empty, e.g. it is minimized, waits for events without calling frameFn.
 void
-sysRun(SYSContext * context);
+sysRun(SYSContext * context, SYSFrameFn frameFn, void * frameFnData);
 
 void
 sysDestroy(SYSContext * context);
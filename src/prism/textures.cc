@@ -0,0 +1,764 @@
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "prism/textures.h"
+#include "prism/graphics.h"
+#include "prism/memory.h"
+#include "prism/profiler.h"
+#include "prism/utilities.h"
+#include "prism/defines.h"
+#include "prism/vulkan.h"
+
+using namespace ctk;
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// An image holding a texture's mips from baseMip to its last; image mip i is the entry's mip baseMip + i.
+struct MipImage
+{
+    VkImage image;
+    VkImageView imageView;
+    MEMAllocation memory;
+    uint32_t baseMip;
+    uint32_t uploadedMipCount;
+};
+
+enum class StreamState
+{
+    IDLE,
+
+    // streamingImage was created and its mips are being paged in by the reader thread.
+    READING,
+
+    // streamingImage's mips are paged in and being uploaded.
+    UPLOADING,
+};
+
+struct Texture
+{
+    const ASSETFile * file;
+    const ASSETEntry * entry;
+    MipImage residentImage;
+
+    // streamedImage holds the finest mips uploaded so far, if any; streamingImage replaces it once all of its mips are
+    // uploaded.
+    MipImage streamedImage;
+    MipImage streamingImage;
+    StreamState state;
+
+    // Finest mip requested in requestFrameCount, the last frame the texture was requested in.
+    uint32_t requestedMip;
+    uint64_t requestFrameCount;
+};
+
+struct RetiredImage
+{
+    MipImage image;
+
+    // Value of GFXContext::frameCount when the image was retired.
+    uint64_t retiredFrameCount;
+};
+
+struct TEXStreamer
+{
+    GFXContext * context;
+    TEXConfig config;
+    Buffer<Texture> textures;
+    uint32_t textureCount;
+    RetiredImage retiredImages[TEX_MAX_RETIRED_IMAGES];
+    uint32_t retiredImageCount;
+    TEXStats stats;
+
+    // Textures are queued for the reader thread in readQueue and handed back in completedReads; pendingReadCount counts
+    // textures in either or being read, and is only accessed by the streamer's thread.
+    std::thread readerThread;
+    std::mutex readMutex;
+    std::condition_variable readCondition;
+    bool readerStopping;
+    uint32_t readQueue[TEX_MAX_PENDING_READS];
+    uint32_t readQueueCount;
+    uint32_t completedReads[TEX_MAX_PENDING_READS];
+    uint32_t completedReadCount;
+    uint32_t pendingReadCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static uint32_t
+getMipSize(uint32_t size, uint32_t mip)
+{
+    return size >> mip > 0 ? size >> mip : 1;
+}
+
+static uint32_t
+getMipCount(const ASSETEntry * entry, uint32_t baseMip)
+{
+    return entry->payloadCount - baseMip;
+}
+
+// Pages a texture's mips from baseMip on in from its mapping, so copying them into staging memory doesn't fault.
+static void
+readMips(const ASSETFile * file, const ASSETEntry * entry, uint32_t baseMip)
+{
+    PROF_ZONE("readMips");
+    static const uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+
+    for(uint32_t mip = baseMip; mip < entry->payloadCount; mip++)
+    {
+        const ASSETPayload * payload = entry->payloads + mip;
+        uint64_t begin = payload->offset / pageSize * pageSize;
+        uint64_t end = payload->offset + payload->size;
+        madvise((void *)(file->mapping.data + begin), end - begin, MADV_WILLNEED);
+
+        // Touching a byte of every page blocks this thread, not the streamer's, until the page is read.
+        volatile uint8_t sink = 0;
+
+        for(uint64_t offset = begin; offset < end; offset += pageSize)
+        {
+            sink = sink + file->mapping.data[offset];
+        }
+    }
+}
+
+static void
+runReader(TEXStreamer * streamer)
+{
+    profSetThreadName("texture reader");
+    std::unique_lock<std::mutex> lock(streamer->readMutex);
+
+    for(;;)
+    {
+        streamer->readCondition.wait(lock, [streamer]()
+        {
+            return streamer->readerStopping || streamer->readQueueCount > 0;
+        });
+
+        if(streamer->readerStopping)
+        {
+            return;
+        }
+
+        // Read in request order.
+        uint32_t textureIndex = streamer->readQueue[0];
+        streamer->readQueueCount--;
+
+        for(uint32_t i = 0; i < streamer->readQueueCount; i++)
+        {
+            streamer->readQueue[i] = streamer->readQueue[i + 1];
+        }
+
+        // A texture's file, entry and streaming image's base mip don't change while it's being read.
+        const Texture * texture = streamer->textures.data + textureIndex;
+        lock.unlock();
+        readMips(texture->file, texture->entry, texture->streamingImage.baseMip);
+        lock.lock();
+        streamer->completedReads[streamer->completedReadCount++] = textureIndex;
+    }
+}
+
+static VkDeviceSize
+getImageSize(const MipImage * image)
+{
+    return image->image != VK_NULL_HANDLE ? image->memory.reservedSize : 0;
+}
+
+// Creates an image for entry's mips from baseMip on without binding memory, returning its memory requirements.
+static VkImage
+createImage(VkDevice logicalDevice, const ASSETEntry * entry, uint32_t baseMip, VkMemoryRequirements * requirements)
+{
+    // typedef struct VkImageCreateInfo {
+    //     VkStructureType          sType;
+    //     const void*              pNext;
+    //     VkImageCreateFlags       flags;
+    //     VkImageType              imageType;
+    //     VkFormat                 format;
+    //     VkExtent3D               extent;
+    //     uint32_t                 mipLevels;
+    //     uint32_t                 arrayLayers;
+    //     VkSampleCountFlagBits    samples;
+    //     VkImageTiling            tiling;
+    //     VkImageUsageFlags        usage;
+    //     VkSharingMode            sharingMode;
+    //     uint32_t                 queueFamilyIndexCount;
+    //     const uint32_t*          pQueueFamilyIndices;
+    //     VkImageLayout            initialLayout;
+    // } VkImageCreateInfo;
+    VkImageCreateInfo imageCreateInfo = {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = nullptr;
+    imageCreateInfo.flags = 0;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = entry->format;
+    imageCreateInfo.extent = { getMipSize(entry->width, baseMip), getMipSize(entry->height, baseMip), 1 };
+    imageCreateInfo.mipLevels = getMipCount(entry, baseMip);
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.queueFamilyIndexCount = 0;
+    imageCreateInfo.pQueueFamilyIndices = nullptr;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    VkResult result = vkCreateImage(logicalDevice, &imageCreateInfo, nullptr, &image);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create texture image \"%s\"\n", entry->name);
+    }
+
+    vkGetImageMemoryRequirements(logicalDevice, image, requirements);
+
+    return image;
+}
+
+// Binds memory to image and creates its view.
+static void
+bindImage(VkDevice logicalDevice, const ASSETEntry * entry, MipImage * image)
+{
+    VkResult result = vkBindImageMemory(logicalDevice, image->image, image->memory.memory, image->memory.offset);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to bind texture image memory\n");
+    }
+
+    // typedef struct VkImageViewCreateInfo {
+    //     VkStructureType            sType;
+    //     const void*                pNext;
+    //     VkImageViewCreateFlags     flags;
+    //     VkImage                    image;
+    //     VkImageViewType            viewType;
+    //     VkFormat                   format;
+    //     VkComponentMapping         components;
+    //     VkImageSubresourceRange    subresourceRange;
+    // } VkImageViewCreateInfo;
+    VkImageViewCreateInfo imageViewCreateInfo = {};
+    imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    imageViewCreateInfo.pNext = nullptr;
+    imageViewCreateInfo.flags = 0; // Reserved for future use.
+    imageViewCreateInfo.image = image->image;
+    imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    imageViewCreateInfo.format = entry->format;
+
+    imageViewCreateInfo.components =
+    {
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+    };
+
+    imageViewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, getMipCount(entry, image->baseMip), 0, 1 };
+    result = vkCreateImageView(logicalDevice, &imageViewCreateInfo, nullptr, &image->imageView);
+
+    if(result != VK_SUCCESS)
+    {
+        utilErrorExit("VULKAN", getVkResultName(result), "failed to create texture image view\n");
+    }
+}
+
+static void
+destroyImage(GFXContext * context, MipImage * image)
+{
+    vkDestroyImageView(context->logicalDevice, image->imageView, nullptr);
+    vkDestroyImage(context->logicalDevice, image->image, nullptr);
+    memFree(&context->allocator, &image->memory);
+    *image = {};
+}
+
+// Uploads image's mips that haven't been uploaded yet, coarsest first. Returns false if the staging ring fills before
+// all of them are uploaded, in which case the rest are uploaded by a later call.
+static bool
+uploadMips(GFXContext * context, const Texture * texture, MipImage * image)
+{
+    const ASSETEntry * entry = texture->entry;
+    uint32_t mipCount = getMipCount(entry, image->baseMip);
+
+    while(image->uploadedMipCount < mipCount)
+    {
+        uint32_t imageMip = mipCount - 1 - image->uploadedMipCount;
+        uint32_t mip = image->baseMip + imageMip;
+        VkExtent3D extent = { getMipSize(entry->width, mip), getMipSize(entry->height, mip), 1 };
+
+        if(!gfxUploadImage(context, image->image, entry->format, imageMip, extent,
+                           assetGetPayload(texture->file, entry, mip), entry->payloads[mip].size))
+        {
+            return false;
+        }
+
+        image->uploadedMipCount++;
+    }
+
+    return true;
+}
+
+// Retires image so it's destroyed once no frame in flight can be using it. Returns false if too many images are
+// already retired, in which case image is left as it is.
+static bool
+retireImage(TEXStreamer * streamer, MipImage * image)
+{
+    if(streamer->retiredImageCount == TEX_MAX_RETIRED_IMAGES)
+    {
+        return false;
+    }
+
+    RetiredImage * retiredImage = streamer->retiredImages + streamer->retiredImageCount++;
+    retiredImage->image = *image;
+    retiredImage->retiredFrameCount = streamer->context->frameCount;
+    streamer->stats.retiredSize += getImageSize(image);
+    *image = {};
+
+    return true;
+}
+
+// Destroys retired images no frame in flight can still be using; when force is set, the caller guarantees no frames are
+// in flight and all retired images are destroyed.
+static void
+destroyRetiredImages(TEXStreamer * streamer, bool force)
+{
+    GFXContext * context = streamer->context;
+    uint32_t destroyedCount = 0;
+
+    // Images are retired in frame order, so stop at the first one that is still in use.
+    for(; destroyedCount < streamer->retiredImageCount; destroyedCount++)
+    {
+        RetiredImage * retiredImage = streamer->retiredImages + destroyedCount;
+
+        // Frames are reused in order, so once frames.count frames have begun since the image was retired, every frame
+        // that could have sampled it has completed.
+        if(!force && context->frameCount < retiredImage->retiredFrameCount + context->frames.count)
+        {
+            break;
+        }
+
+        streamer->stats.retiredSize -= getImageSize(&retiredImage->image);
+        destroyImage(context, &retiredImage->image);
+    }
+
+    // Shift remaining retired images to the front.
+    streamer->retiredImageCount -= destroyedCount;
+
+    for(uint32_t i = 0; i < streamer->retiredImageCount; i++)
+    {
+        streamer->retiredImages[i] = streamer->retiredImages[i + destroyedCount];
+    }
+}
+
+// Retires the streamed mips of the least recently requested texture not requested this frame. Returns false if there's
+// no such texture.
+static bool
+evictLeastRecentlyRequested(TEXStreamer * streamer)
+{
+    uint64_t frameCount = streamer->context->frameCount;
+    Texture * leastRecent = nullptr;
+
+    for(uint32_t i = 0; i < streamer->textureCount; i++)
+    {
+        Texture * texture = streamer->textures.data + i;
+
+        if(texture->streamedImage.image == VK_NULL_HANDLE || texture->requestFrameCount == frameCount ||
+           (leastRecent != nullptr && leastRecent->requestFrameCount <= texture->requestFrameCount))
+        {
+            continue;
+        }
+
+        leastRecent = texture;
+    }
+
+    if(leastRecent == nullptr)
+    {
+        return false;
+    }
+
+    VkDeviceSize size = getImageSize(&leastRecent->streamedImage);
+
+    if(!retireImage(streamer, &leastRecent->streamedImage))
+    {
+        return false;
+    }
+
+    streamer->stats.streamedSize -= size;
+    streamer->stats.streamedTextureCount--;
+    streamer->stats.evictionCount++;
+
+    return true;
+}
+
+// Creates a streaming image for texture's requested mips within the budget, evicting other textures' streamed mips if
+// needed. Returns false if the image doesn't fit in the budget this frame.
+static bool
+startStream(TEXStreamer * streamer, uint32_t textureIndex)
+{
+    GFXContext * context = streamer->context;
+    TEXStats * stats = &streamer->stats;
+    Texture * texture = streamer->textures.data + textureIndex;
+    VkMemoryRequirements requirements = {};
+    VkImage streamingImage = createImage(context->logicalDevice, texture->entry, texture->requestedMip, &requirements);
+
+    // The budget counts the memory allocations reserve rather than the size requested, including that of retired
+    // images, which hold their memory until the frames in flight are done with them. Evicting only retires images, so
+    // it can't make room this frame: the stream is deferred, and only the streamed mips that would still be in its way
+    // once the retired images are destroyed are evicted. If the retired images alone are in its way, none are.
+    VkDeviceSize size = memGetReservedSize(&context->allocator, MEMStrategy::BUDDY, &requirements);
+    VkDeviceSize budgetSize = streamer->config.budgetSize;
+
+    if(stats->streamedSize + stats->retiredSize + size > budgetSize)
+    {
+        while(stats->streamedSize + size > budgetSize && evictLeastRecentlyRequested(streamer))
+        {
+        }
+
+        vkDestroyImage(context->logicalDevice, streamingImage, nullptr);
+        return false;
+    }
+
+    MipImage * image = &texture->streamingImage;
+    image->image = streamingImage;
+    image->baseMip = texture->requestedMip;
+    image->uploadedMipCount = 0;
+
+    if(!memAllocate(&context->allocator, MEMStrategy::BUDDY, MEMResourceType::OPTIMAL, &requirements,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, &image->memory))
+    {
+        vkDestroyImage(context->logicalDevice, image->image, nullptr);
+        *image = {};
+        return false;
+    }
+
+    PRISM_ASSERT(getImageSize(image) == size);
+    bindImage(context->logicalDevice, texture->entry, image);
+    stats->streamedSize += size;
+    texture->state = StreamState::READING;
+
+    return true;
+}
+
+// Swaps texture's uploaded streaming image in for its streamed image. Returns false if the streamed image can't be
+// retired this frame.
+static bool
+finishStream(TEXStreamer * streamer, Texture * texture)
+{
+    TEXStats * stats = &streamer->stats;
+
+    if(texture->streamedImage.image != VK_NULL_HANDLE)
+    {
+        VkDeviceSize size = getImageSize(&texture->streamedImage);
+
+        if(!retireImage(streamer, &texture->streamedImage))
+        {
+            return false;
+        }
+
+        stats->streamedSize -= size;
+        stats->streamedTextureCount--;
+    }
+
+    texture->streamedImage = texture->streamingImage;
+    texture->streamingImage = {};
+    texture->state = StreamState::IDLE;
+    stats->streamedTextureCount++;
+    stats->streamCount++;
+
+    return true;
+}
+
+static uint32_t
+getFinestUploadedMip(const Texture * texture)
+{
+    return texture->streamedImage.image != VK_NULL_HANDLE ? texture->streamedImage.baseMip
+                                                          : texture->residentImage.baseMip;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEXStreamer *
+texCreateStreamer(GFXContext * context, const TEXConfig * config)
+{
+    PRISM_ASSERT(context != nullptr);
+    PRISM_ASSERT(config != nullptr);
+    PRISM_ASSERT(config->maxTextureCount > 0);
+    auto streamer = new TEXStreamer();
+    streamer->context = context;
+    streamer->config = *config;
+    streamer->textures = bufferCreate<Texture>(config->maxTextureCount);
+    streamer->textureCount = 0;
+    streamer->retiredImageCount = 0;
+    streamer->stats = {};
+    streamer->readerStopping = false;
+    streamer->readQueueCount = 0;
+    streamer->completedReadCount = 0;
+    streamer->pendingReadCount = 0;
+    streamer->readerThread = std::thread(runReader, streamer);
+    utilLog("TEXTURES", "streaming into a %llu byte budget\n", (unsigned long long)config->budgetSize);
+
+    return streamer;
+}
+
+bool
+texCreate(TEXStreamer * streamer, const ASSETFile * file, const ASSETEntry * entry, uint32_t * texture)
+{
+    PRISM_ASSERT(streamer != nullptr);
+    PRISM_ASSERT(file != nullptr);
+    PRISM_ASSERT(entry != nullptr && entry->type == ASSETType::TEXTURE);
+    PRISM_ASSERT(texture != nullptr);
+    GFXContext * context = streamer->context;
+
+    if(streamer->textureCount == streamer->config.maxTextureCount)
+    {
+        return false;
+    }
+
+    // Each mip must halve the previous one's extent, down to no smaller than 1x1.
+    uint32_t largestSize = entry->width > entry->height ? entry->width : entry->height;
+
+    if(entry->format == VK_FORMAT_UNDEFINED || entry->payloadCount > (uint32_t)std::log2(largestSize) + 1)
+    {
+        utilWarning("TEXTURES", "texture \"%s\" has no format or more mips than its extent allows\n", entry->name);
+        return false;
+    }
+
+    // The coarsest mips, from the first no larger than TEX_RESIDENT_MIP_SIZE on, are resident; if even the last mip is
+    // larger, it's resident alone.
+    uint32_t residentMip = 0;
+
+    while(residentMip < entry->payloadCount - 1 && getMipSize(largestSize, residentMip) > TEX_RESIDENT_MIP_SIZE)
+    {
+        residentMip++;
+    }
+
+    *texture = streamer->textureCount++;
+    Texture * newTexture = streamer->textures.data + *texture;
+    *newTexture = {};
+    newTexture->file = file;
+    newTexture->entry = entry;
+    newTexture->state = StreamState::IDLE;
+    newTexture->requestedMip = residentMip;
+    newTexture->requestFrameCount = UINT64_MAX;
+
+    // Resident images are allocated outside the budget, as they're never evicted.
+    MipImage * residentImage = &newTexture->residentImage;
+    VkMemoryRequirements requirements = {};
+    residentImage->image = createImage(context->logicalDevice, entry, residentMip, &requirements);
+    residentImage->baseMip = residentMip;
+
+    if(!memAllocate(&context->allocator, MEMStrategy::BUDDY, MEMResourceType::OPTIMAL, &requirements,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, &residentImage->memory))
+    {
+        utilErrorExit("VULKAN", nullptr, "failed to allocate memory for texture image \"%s\"\n", entry->name);
+    }
+
+    bindImage(context->logicalDevice, entry, residentImage);
+    streamer->stats.textureCount++;
+    streamer->stats.residentSize += getImageSize(residentImage);
+    uploadMips(context, newTexture, residentImage);
+
+    return true;
+}
+
+void
+texRequest(TEXStreamer * streamer, uint32_t texture, float screenSize)
+{
+    PRISM_ASSERT(streamer != nullptr);
+    PRISM_ASSERT(texture < streamer->textureCount);
+    Texture * requestedTexture = streamer->textures.data + texture;
+    const ASSETEntry * entry = requestedTexture->entry;
+    uint64_t frameCount = streamer->context->frameCount;
+
+    // Each mip finer than the screen size needs would be minified by another factor of 2.
+    uint32_t largestSize = entry->width > entry->height ? entry->width : entry->height;
+    float minification = (float)largestSize / (screenSize > 1.0f ? screenSize : 1.0f);
+    uint32_t mip = minification > 1.0f ? (uint32_t)std::log2(minification) : 0;
+
+    if(mip > requestedTexture->residentImage.baseMip)
+    {
+        mip = requestedTexture->residentImage.baseMip;
+    }
+
+    if(requestedTexture->requestFrameCount != frameCount || mip < requestedTexture->requestedMip)
+    {
+        requestedTexture->requestedMip = mip;
+    }
+
+    requestedTexture->requestFrameCount = frameCount;
+}
+
+void
+texUpdate(TEXStreamer * streamer)
+{
+    PRISM_ASSERT(streamer != nullptr);
+    PROF_ZONE("texUpdate");
+    GFXContext * context = streamer->context;
+    uint64_t frameCount = context->frameCount;
+    destroyRetiredImages(streamer, false);
+
+    // Resident mips left over from texCreate() are uploaded first, as nothing can be drawn with their textures until
+    // they are.
+    bool stagingFull = false;
+
+    for(uint32_t i = 0; i < streamer->textureCount && !stagingFull; i++)
+    {
+        Texture * texture = streamer->textures.data + i;
+        stagingFull = !uploadMips(context, texture, &texture->residentImage);
+    }
+
+    // Collect the reader thread's completed reads.
+    {
+        std::lock_guard<std::mutex> lock(streamer->readMutex);
+
+        for(uint32_t i = 0; i < streamer->completedReadCount; i++)
+        {
+            streamer->textures.data[streamer->completedReads[i]].state = StreamState::UPLOADING;
+        }
+
+        streamer->pendingReadCount -= streamer->completedReadCount;
+        streamer->completedReadCount = 0;
+    }
+
+    // Upload streams whose mips are paged in, swapping in each one as it completes.
+    for(uint32_t i = 0; i < streamer->textureCount && !stagingFull; i++)
+    {
+        Texture * texture = streamer->textures.data + i;
+
+        if(texture->state != StreamState::UPLOADING)
+        {
+            continue;
+        }
+
+        stagingFull = !uploadMips(context, texture, &texture->streamingImage);
+
+        // Once every mip is uploaded, a stream whose texture's streamed image can't be retired stays UPLOADING, and is
+        // swapped in by a later frame once destroyRetiredImages() has made room; its upload is already complete.
+        if(!stagingFull && !finishStream(streamer, texture))
+        {
+            utilWarning("TEXTURES", "more than %u images retired; retrying stream next frame\n",
+                        TEX_MAX_RETIRED_IMAGES);
+        }
+    }
+
+    // Start streams for textures requested this frame with finer mips than they have, or will have once their current
+    // streams finish, in texture order.
+    uint32_t queuedTextures[TEX_MAX_PENDING_READS] = {};
+    uint32_t queuedCount = 0;
+
+    for(uint32_t i = 0; i < streamer->textureCount && streamer->pendingReadCount < TEX_MAX_PENDING_READS; i++)
+    {
+        Texture * texture = streamer->textures.data + i;
+
+        if(texture->requestFrameCount != frameCount || texture->state != StreamState::IDLE ||
+           texture->residentImage.uploadedMipCount < getMipCount(texture->entry, texture->residentImage.baseMip) ||
+           texture->requestedMip >= getFinestUploadedMip(texture))
+        {
+            continue;
+        }
+
+        // Once the budget is full of textures requested this frame, later requests wait for a frame with room.
+        if(!startStream(streamer, i))
+        {
+            break;
+        }
+
+        queuedTextures[queuedCount++] = i;
+        streamer->pendingReadCount++;
+    }
+
+    // pendingReadCount includes every queued read, so the queue has room for these.
+    if(queuedCount > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(streamer->readMutex);
+
+            for(uint32_t i = 0; i < queuedCount; i++)
+            {
+                streamer->readQueue[streamer->readQueueCount++] = queuedTextures[i];
+            }
+        }
+
+        streamer->readCondition.notify_one();
+    }
+
+    streamer->stats.pendingReadCount = streamer->pendingReadCount;
+}
+
+VkImageView
+texGetImageView(const TEXStreamer * streamer, uint32_t texture)
+{
+    PRISM_ASSERT(streamer != nullptr);
+    PRISM_ASSERT(texture < streamer->textureCount);
+    const Texture * viewedTexture = streamer->textures.data + texture;
+
+    if(viewedTexture->streamedImage.image != VK_NULL_HANDLE)
+    {
+        return viewedTexture->streamedImage.imageView;
+    }
+
+    const MipImage * residentImage = &viewedTexture->residentImage;
+
+    return residentImage->uploadedMipCount == getMipCount(viewedTexture->entry, residentImage->baseMip)
+           ? residentImage->imageView
+           : VK_NULL_HANDLE;
+}
+
+void
+texGetStats(const TEXStreamer * streamer, TEXStats * stats)
+{
+    PRISM_ASSERT(streamer != nullptr);
+    PRISM_ASSERT(stats != nullptr);
+    *stats = streamer->stats;
+}
+
+void
+texDestroyStreamer(TEXStreamer * streamer)
+{
+    PRISM_ASSERT(streamer != nullptr);
+    GFXContext * context = streamer->context;
+
+    {
+        std::lock_guard<std::mutex> lock(streamer->readMutex);
+        streamer->readerStopping = true;
+    }
+
+    streamer->readCondition.notify_one();
+    streamer->readerThread.join();
+
+    // Cleanup
+    destroyRetiredImages(streamer, true);
+
+    for(uint32_t i = 0; i < streamer->textureCount; i++)
+    {
+        Texture * texture = streamer->textures.data + i;
+        destroyImage(context, &texture->residentImage);
+
+        if(texture->streamedImage.image != VK_NULL_HANDLE)
+        {
+            destroyImage(context, &texture->streamedImage);
+        }
+
+        if(texture->streamingImage.image != VK_NULL_HANDLE)
+        {
+            destroyImage(context, &texture->streamingImage);
+        }
+    }
+
+    bufferFree(&streamer->textures);
+    delete streamer;
+}
+
+} // namespace prism
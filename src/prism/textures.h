@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.h"
+#include "prism/assets.h"
+
+namespace prism
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Mips at most this many texels wide and high stay resident for as long as their texture exists; finer mips are
+// streamed in when requested.
+#define TEX_RESIDENT_MIP_SIZE 64
+
+// Streams read by the background reader thread at once, including those read but not yet uploaded.
+#define TEX_MAX_PENDING_READS 16
+
+// Images replaced or evicted but possibly still in use by frames in flight.
+#define TEX_MAX_RETIRED_IMAGES 64
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GFXContext;
+struct TEXStreamer;
+
+struct TEXConfig
+{
+    uint32_t maxTextureCount;
+
+    // Device memory all streamed mips share, including images retired but not yet destroyed. Resident mips are
+    // allocated separately, so device memory is bounded by budgetSize and maxTextureCount whatever the size of the
+    // textures streamed from.
+    VkDeviceSize budgetSize;
+};
+
+struct TEXStats
+{
+    uint32_t textureCount;
+    uint32_t streamedTextureCount;
+    uint32_t pendingReadCount;
+    VkDeviceSize residentSize;
+    VkDeviceSize streamedSize;
+    VkDeviceSize retiredSize;
+
+    // Totals since the streamer was created.
+    uint64_t streamCount;
+    uint64_t evictionCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Interface
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates a streamer and starts its reader thread, which pages the mips of requested textures in from their asset
+// files so uploading them never waits on disk.
+TEXStreamer *
+texCreateStreamer(GFXContext * context, const TEXConfig * config);
+
+// Adds a texture entry of file, creating an image for its resident mips and uploading them through gfxUploadImage();
+// uploads that don't fit in the staging ring are retried by texUpdate(). file must stay open until the streamer is
+// destroyed. Returns false if the streamer already has maxTextureCount textures or the entry's mips don't form a
+// chain, in which case nothing is added.
+bool
+texCreate(TEXStreamer * streamer, const ASSETFile * file, const ASSETEntry * entry, uint32_t * texture);
+
+// Requests the mip of texture that matches screenSize, the number of pixels its larger dimension covers on screen, and
+// marks it as used this frame. Requests last for the frame they're made in; the finest one made is streamed.
+void
+texRequest(TEXStreamer * streamer, uint32_t texture, float screenSize);
+
+// Destroys images no frame in flight can still use, uploads mips the reader thread has paged in, and starts reading
+// this frame's requests, evicting the least recently requested textures' streamed mips to fit them in the budget.
+// Call once per frame after gfxBeginFrame() and the frame's texRequest() calls, and before recording draws that
+// sample streamed textures.
+void
+texUpdate(TEXStreamer * streamer);
+
+// Returns a view of texture's finest uploaded mips, or VK_NULL_HANDLE if its resident mips aren't uploaded yet. The
+// view changes as mips are streamed in and evicted, so it must be fetched every frame it's used.
+VkImageView
+texGetImageView(const TEXStreamer * streamer, uint32_t texture);
+
+void
+texGetStats(const TEXStreamer * streamer, TEXStats * stats);
+
+// Stops the reader thread and destroys every image immediately; they must not be in use by frames still in flight.
+void
+texDestroyStreamer(TEXStreamer * streamer);
+
+} // namespace prism
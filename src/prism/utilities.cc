@@ -1,7 +1,19 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstdio>
 #include <cstdarg>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "prism/utilities.h"
+#include "prism/defines.h"
 
 namespace prism
 {
@@ -23,6 +35,356 @@ namespace prism
     vfprintf(OUTPUT, message, args); \
     va_end(args);
 
+#define CACHE_LINE_SIZE 64
+
+// Maximum number of threads with their own ring; messages from further threads are dropped and counted.
+#define LOG_MAX_THREADS 64
+
+// Messages each thread's ring holds; a power of 2.
+#define LOG_RING_SIZE 128
+
+// Formatted messages are truncated to fit.
+#define LOG_MAX_MESSAGE_SIZE 1024
+
+#define LOG_MAX_SUBSYSTEM_SIZE 32
+#define LOG_MAX_SUBSYSTEM_FILTERS 32
+
+// The background thread writes messages at least this often; it is woken earlier when a ring is half full.
+#define LOG_FLUSH_INTERVAL_MS 10
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct LogRecord
+{
+    // Order of the message across all threads.
+    uint64_t sequence;
+
+    UTILLogLevel level;
+    char subsystem[LOG_MAX_SUBSYSTEM_SIZE];
+    char message[LOG_MAX_MESSAGE_SIZE];
+};
+
+// Single-producer single-consumer ring; only the owning thread advances head, and only the thread holding drainMutex
+// advances tail.
+struct LogRing
+{
+    LogRecord records[LOG_RING_SIZE];
+    std::atomic<uint32_t> head;
+    char headPadding[CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> droppedMessageCount;
+};
+
+struct LogSubsystemFilter
+{
+    char subsystem[LOG_MAX_SUBSYSTEM_SIZE];
+    std::atomic<bool> enabled;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static std::atomic<bool> loggingStarted(false);
+static std::atomic<UTILLogLevel> logMinLevel(UTILLogLevel::LOG);
+
+// Filters are only ever added, so readers can scan the first subsystemFilterCount without locking.
+static std::mutex subsystemFiltersMutex;
+static LogSubsystemFilter subsystemFilters[LOG_MAX_SUBSYSTEM_FILTERS];
+static std::atomic<uint32_t> subsystemFilterCount(0);
+
+// Rings are registered by their thread's first message after logging starts. ringEpoch is bumped whenever rings are
+// freed, so threads holding a ring from an earlier epoch register a new one.
+static std::mutex ringsMutex;
+static LogRing * rings[LOG_MAX_THREADS];
+static std::atomic<uint32_t> ringCount(0);
+static std::atomic<uint32_t> ringEpoch(0);
+static std::atomic<uint32_t> unregisteredDroppedMessageCount(0);
+static std::atomic<uint64_t> nextSequence(0);
+static thread_local LogRing * currentThreadRing;
+static thread_local uint32_t currentThreadRingEpoch;
+
+static std::mutex drainMutex;
+static FILE * logOutput;
+
+static std::thread flushThread;
+static std::mutex flushMutex;
+static std::condition_variable flushCondition;
+static bool flushThreadStopping;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Utilities
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void
+writeMessagePrefix(FILE * output, UTILLogLevel level, const char * subsystem)
+{
+    // Colors are only written to the terminal.
+    bool colored = output == stdout;
+
+    if(level == UTILLogLevel::WARNING)
+    {
+        fprintf(output, colored ? ANSI_BOLD ANSI_COLOR_PURPLE "%s WARNING" ANSI_RESET ": " : "%s WARNING: ", subsystem);
+    }
+    else
+    {
+        fprintf(output, colored ? ANSI_BOLD ANSI_COLOR_GREEN "%s LOG" ANSI_RESET ": " : "%s LOG: ", subsystem);
+    }
+}
+
+static void
+addSubsystemFilter(const char * subsystem, size_t size, bool enabled)
+{
+    if(size == 0 || size >= LOG_MAX_SUBSYSTEM_SIZE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(subsystemFiltersMutex);
+    uint32_t filterCount = subsystemFilterCount.load(std::memory_order_relaxed);
+
+    for(uint32_t i = 0; i < filterCount; i++)
+    {
+        LogSubsystemFilter * filter = subsystemFilters + i;
+
+        if(strncmp(filter->subsystem, subsystem, size) == 0 && filter->subsystem[size] == '\0')
+        {
+            filter->enabled.store(enabled, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if(filterCount == LOG_MAX_SUBSYSTEM_FILTERS)
+    {
+        return;
+    }
+
+    LogSubsystemFilter * filter = subsystemFilters + filterCount;
+    memcpy(filter->subsystem, subsystem, size);
+    filter->subsystem[size] = '\0';
+    filter->enabled.store(enabled, std::memory_order_relaxed);
+    subsystemFilterCount.store(filterCount + 1, std::memory_order_release);
+}
+
+// Adds a filter for each name in a comma-separated list; spaces around names are ignored.
+static void
+addSubsystemFilters(const char * subsystems, bool enabled)
+{
+    const char * subsystem = nullptr;
+    size_t size = 0;
+
+    while(utilNextListItem(&subsystems, &subsystem, &size))
+    {
+        addSubsystemFilter(subsystem, size, enabled);
+    }
+}
+
+// Applies UTIL_LOG_DISABLED_SUBSYSTEMS before main() runs; the filters' mutex and atomics are constant-initialized.
+static const bool COMPILED_SUBSYSTEM_FILTERS_ADDED = (addSubsystemFilters(UTIL_LOG_DISABLED_SUBSYSTEMS, false), true);
+
+static bool
+subsystemEnabled(const char * subsystem)
+{
+    uint32_t filterCount = subsystemFilterCount.load(std::memory_order_acquire);
+
+    for(uint32_t i = 0; i < filterCount; i++)
+    {
+        const LogSubsystemFilter * filter = subsystemFilters + i;
+
+        if(strcmp(filter->subsystem, subsystem) == 0)
+        {
+            return filter->enabled.load(std::memory_order_relaxed);
+        }
+    }
+
+    return true;
+}
+
+// Returns null if LOG_MAX_THREADS threads already have rings.
+static LogRing *
+getThreadRing()
+{
+    uint32_t epoch = ringEpoch.load(std::memory_order_acquire);
+
+    if(currentThreadRing != nullptr && currentThreadRingEpoch == epoch)
+    {
+        return currentThreadRing;
+    }
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    uint32_t ringIndex = ringCount.load(std::memory_order_relaxed);
+
+    if(ringIndex == LOG_MAX_THREADS)
+    {
+        return nullptr;
+    }
+
+    auto ring = new LogRing;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->droppedMessageCount.store(0, std::memory_order_relaxed);
+    rings[ringIndex] = ring;
+    ringCount.store(ringIndex + 1, std::memory_order_release);
+    currentThreadRing = ring;
+    currentThreadRingEpoch = epoch;
+
+    return ring;
+}
+
+static void
+wakeFlushThread()
+{
+    flushCondition.notify_one();
+}
+
+static void
+writeMessage(UTILLogLevel level, const char * subsystem, const char * message, va_list args)
+{
+    if(level < logMinLevel.load(std::memory_order_relaxed) || !subsystemEnabled(subsystem))
+    {
+        return;
+    }
+
+    if(!loggingStarted.load(std::memory_order_acquire))
+    {
+        writeMessagePrefix(stdout, level, subsystem);
+        vfprintf(stdout, message, args);
+        return;
+    }
+
+    LogRing * ring = getThreadRing();
+
+    if(ring == nullptr)
+    {
+        unregisteredDroppedMessageCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t queuedCount = head - ring->tail.load(std::memory_order_acquire);
+
+    if(queuedCount == LOG_RING_SIZE)
+    {
+        ring->droppedMessageCount.fetch_add(1, std::memory_order_relaxed);
+        wakeFlushThread();
+        return;
+    }
+
+    LogRecord * record = ring->records + (head & (LOG_RING_SIZE - 1));
+    record->sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+    record->level = level;
+    strncpy(record->subsystem, subsystem, LOG_MAX_SUBSYSTEM_SIZE - 1);
+    record->subsystem[LOG_MAX_SUBSYSTEM_SIZE - 1] = '\0';
+    vsnprintf(record->message, LOG_MAX_MESSAGE_SIZE, message, args);
+    ring->head.store(head + 1, std::memory_order_release);
+
+    if(queuedCount + 1 == LOG_RING_SIZE / 2)
+    {
+        wakeFlushThread();
+    }
+}
+
+// Writes queued messages of every ring in sequence order; drainMutex must be held.
+static void
+drainRings()
+{
+    uint32_t currentRingCount = ringCount.load(std::memory_order_acquire);
+    uint32_t droppedMessageCount = unregisteredDroppedMessageCount.exchange(0, std::memory_order_relaxed);
+
+    for(;;)
+    {
+        LogRing * nextRing = nullptr;
+        const LogRecord * nextRecord = nullptr;
+
+        for(uint32_t i = 0; i < currentRingCount; i++)
+        {
+            LogRing * ring = rings[i];
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+
+            if(tail == ring->head.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+
+            const LogRecord * record = ring->records + (tail & (LOG_RING_SIZE - 1));
+
+            if(nextRecord == nullptr || record->sequence < nextRecord->sequence)
+            {
+                nextRing = ring;
+                nextRecord = record;
+            }
+        }
+
+        if(nextRecord == nullptr)
+        {
+            break;
+        }
+
+        writeMessagePrefix(logOutput, nextRecord->level, nextRecord->subsystem);
+        fputs(nextRecord->message, logOutput);
+        nextRing->tail.store(nextRing->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    for(uint32_t i = 0; i < currentRingCount; i++)
+    {
+        droppedMessageCount += rings[i]->droppedMessageCount.exchange(0, std::memory_order_relaxed);
+    }
+
+    if(droppedMessageCount > 0)
+    {
+        writeMessagePrefix(logOutput, UTILLogLevel::WARNING, "PRISM");
+        fprintf(logOutput, "%u log messages were dropped\n", droppedMessageCount);
+    }
+
+    fflush(logOutput);
+}
+
+static void
+runFlushThread()
+{
+    std::unique_lock<std::mutex> lock(flushMutex);
+
+    while(!flushThreadStopping)
+    {
+        flushCondition.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> drainLock(drainMutex);
+            drainRings();
+        }
+
+        lock.lock();
+    }
+}
+
+// A thread can't join itself, so when called from the flush thread it's detached instead; it exits on its own once it
+// sees flushThreadStopping.
+static void
+stopFlushThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(flushMutex);
+        flushThreadStopping = true;
+    }
+
+    flushCondition.notify_one();
+
+    if(flushThread.get_id() == std::this_thread::get_id())
+    {
+        flushThread.detach();
+    }
+    else
+    {
+        flushThread.join();
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Interface
@@ -33,6 +395,15 @@ utilErrorExit(const char * subsystem, const char * errorName, const char * messa
 {
     const char * system = subsystem != nullptr ? subsystem : "PRISM";
 
+    // exit() destroys flushThread, which terminates the process if the thread is still joinable. Messages logged by
+    // other threads from here on are written directly to stdout.
+    if(loggingStarted.exchange(false, std::memory_order_acq_rel))
+    {
+        stopFlushThread();
+    }
+
+    utilFlushLog();
+
     if(errorName)
     {
         fprintf(stderr, ANSI_BOLD ANSI_COLOR_RED "%s ERROR -> %s" ANSI_RESET ": ", system, errorName);
@@ -49,15 +420,192 @@ utilErrorExit(const char * subsystem, const char * errorName, const char * messa
 void
 utilLog(const char * subsystem, const char * message, ...)
 {
-    fprintf(stdout, ANSI_BOLD ANSI_COLOR_GREEN "%s LOG" ANSI_RESET ": ", subsystem ? subsystem : "PRISM");
-    OUTPUT_MESSAGE(stdout)
+#if UTIL_LOG_MIN_LEVEL <= 0
+    va_list args;
+    va_start(args, message);
+    writeMessage(UTILLogLevel::LOG, subsystem ? subsystem : "PRISM", message, args);
+    va_end(args);
+#endif
 }
 
 void
 utilWarning(const char * subsystem, const char * message, ...)
 {
-    fprintf(stdout, ANSI_BOLD ANSI_COLOR_PURPLE "%s WARNING" ANSI_RESET ": ", subsystem ? subsystem : "PRISM");
-    OUTPUT_MESSAGE(stdout)
+#if UTIL_LOG_MIN_LEVEL <= 1
+    va_list args;
+    va_start(args, message);
+    writeMessage(UTILLogLevel::WARNING, subsystem ? subsystem : "PRISM", message, args);
+    va_end(args);
+#endif
+}
+
+void
+utilStartLogging(const UTILLogConfig * config)
+{
+    PRISM_ASSERT(!loggingStarted.load(std::memory_order_relaxed));
+    logOutput = stdout;
+
+    if(config->path != nullptr && config->path[0] != '\0')
+    {
+        logOutput = fopen(config->path, "w");
+
+        if(logOutput == nullptr)
+        {
+            logOutput = stdout;
+            utilWarning("PRISM", "failed to open log file '%s'; logging to stdout\n", config->path);
+        }
+    }
+
+    utilSetLogLevel(config->minLevel);
+
+    if(config->disabledSubsystems != nullptr)
+    {
+        addSubsystemFilters(config->disabledSubsystems, false);
+    }
+
+    flushThreadStopping = false;
+    flushThread = std::thread(runFlushThread);
+    loggingStarted.store(true, std::memory_order_release);
+}
+
+void
+utilStopLogging()
+{
+    if(!loggingStarted.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    loggingStarted.store(false, std::memory_order_release);
+    stopFlushThread();
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+    drainRings();
+
+    // Cleanup
+    if(logOutput != stdout)
+    {
+        fclose(logOutput);
+    }
+
+    logOutput = nullptr;
+    std::lock_guard<std::mutex> ringsLock(ringsMutex);
+
+    for(uint32_t i = 0; i < ringCount.load(std::memory_order_relaxed); i++)
+    {
+        delete rings[i];
+    }
+
+    ringCount.store(0, std::memory_order_relaxed);
+    ringEpoch.fetch_add(1, std::memory_order_release);
+}
+
+void
+utilFlushLog()
+{
+    std::lock_guard<std::mutex> lock(drainMutex);
+
+    if(logOutput != nullptr)
+    {
+        drainRings();
+    }
+}
+
+void
+utilSetLogLevel(UTILLogLevel minLevel)
+{
+    logMinLevel.store(minLevel, std::memory_order_relaxed);
+}
+
+void
+utilSetLogSubsystemEnabled(const char * subsystem, bool enabled)
+{
+    addSubsystemFilter(subsystem, strlen(subsystem), enabled);
+}
+
+double
+utilGetTime()
+{
+    timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1000000000.0;
+}
+
+bool
+utilMapFile(const char * path, UTILMappedFile * mappedFile)
+{
+    int file = open(path, O_RDONLY);
+
+    if(file == -1)
+    {
+        return false;
+    }
+
+    struct stat fileStatus = {};
+    void * data = MAP_FAILED;
+
+    // Empty files can't be mapped.
+    if(fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0)
+    {
+        data = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+
+    // The mapping stays valid after the file is closed.
+    close(file);
+
+    if(data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    mappedFile->data = (const uint8_t *)data;
+    mappedFile->size = (size_t)fileStatus.st_size;
+
+    return true;
+}
+
+void
+utilUnmapFile(UTILMappedFile * mappedFile)
+{
+    munmap((void *)mappedFile->data, mappedFile->size);
+    mappedFile->data = nullptr;
+    mappedFile->size = 0;
+}
+
+bool
+utilNextListItem(const char ** list, const char ** item, size_t * itemSize)
+{
+    const char * c = *list;
+
+    while(*c == ' ' || *c == ',')
+    {
+        c++;
+    }
+
+    if(*c == '\0')
+    {
+        *list = c;
+        return false;
+    }
+
+    const char * begin = c;
+
+    while(*c != '\0' && *c != ',')
+    {
+        c++;
+    }
+
+    const char * end = c;
+
+    while(end > begin && end[-1] == ' ')
+    {
+        end--;
+    }
+
+    *item = begin;
+    *itemSize = end - begin;
+    *list = c;
+
+    return true;
 }
 
 } // namespace prism
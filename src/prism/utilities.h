@@ -1,20 +1,109 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace prism
 {
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Macros
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Messages below this UTILLogLevel are compiled out of utilLog() and utilWarning(); e.g. 1 keeps only warnings and 2
+// removes both.
+#ifndef UTIL_LOG_MIN_LEVEL
+#define UTIL_LOG_MIN_LEVEL 0
+#endif
+
+// Comma-separated subsystems whose messages are discarded from the start, before any runtime filters are applied.
+#ifndef UTIL_LOG_DISABLED_SUBSYSTEMS
+#define UTIL_LOG_DISABLED_SUBSYSTEMS ""
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Data Structures
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum class UTILLogLevel
+{
+    LOG,
+    WARNING,
+    COUNT,
+};
+
+struct UTILLogConfig
+{
+    // File messages are written to, or nullptr to write them to stdout.
+    const char * path;
+
+    UTILLogLevel minLevel;
+
+    // Comma-separated subsystems whose messages are discarded, or nullptr.
+    const char * disabledSubsystems;
+};
+
+struct UTILMappedFile
+{
+    const uint8_t * data;
+    size_t size;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Interface
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Writes any buffered messages before the error, so it is the last thing logged.
 void
 utilErrorExit(const char * subsystem, const char * error_name, const char * message, ...);
 
+// Between utilStartLogging() and utilStopLogging(), messages are formatted into a ring buffer of the calling thread
+// and written by a background thread, so logging never waits on output; messages that don't fit in a full ring are
+// dropped and counted. Otherwise they are written to stdout directly.
 void
 utilLog(const char * subsystem, const char * message, ...);
 
 void
 utilWarning(const char * subsystem, const char * message, ...);
 
+// Starts writing messages from a background thread. Call before other threads start logging.
+void
+utilStartLogging(const UTILLogConfig * config);
+
+// Writes remaining messages and stops the background thread; later messages are written directly again. No other
+// thread may log until it returns.
+void
+utilStopLogging();
+
+// Writes buffered messages now, on the calling thread.
+void
+utilFlushLog();
+
+void
+utilSetLogLevel(UTILLogLevel minLevel);
+
+void
+utilSetLogSubsystemEnabled(const char * subsystem, bool enabled);
+
+// Seconds from an arbitrary fixed point on a monotonic clock, for measuring intervals.
+double
+utilGetTime();
+
+// Maps the file at path read-only into memory; the mapping is page-aligned. Returns false if the file can't be opened
+// or mapped.
+bool
+utilMapFile(const char * path, UTILMappedFile * mappedFile);
+
+void
+utilUnmapFile(UTILMappedFile * mappedFile);
+
+// Finds the next item of the comma-separated list at *list, ignoring spaces around items and empty items, and advances
+// *list past it. Returns false once there are no items left; the item is not null-terminated.
+bool
+utilNextListItem(const char ** list, const char ** item, size_t * itemSize);
+
 } // namespace prism
@@ -1,43 +1,875 @@
+#include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include "prism/system.h"
 #include "prism/graphics.h"
+#include "prism/framegraph.h"
+#include "prism/draw.h"
+#include "prism/assets.h"
+#include "prism/textures.h"
+#include "prism/jobs.h"
+#include "prism/profiler.h"
+#include "prism/utilities.h"
 #include "ctk/yaml.h"
 #include "ctk/memory.h"
 
 using namespace prism;
 using namespace ctk;
 
+// Per-entity columns summed on the GPU by the entity_sum compute shader: zs = vs + ws + xs + ys.
+static const uint32_t ENTITY_COUNT = 65536;
+static const uint32_t ENTITY_COLUMN_COUNT = 5;
+static const uint32_t ENTITY_SUM_GROUP_SIZE = 64;
+static const size_t MAX_CAPTURE_PATH_SIZE = 256;
+
+// Instances are laid out on a square grid covering the render target, alternating between the triangle and quad
+// meshes by row.
+static const uint32_t INSTANCE_GRID_SIZE = 64;
+
+// The frame graph renders the background the grid is drawn over: a vertical gradient of this many bands, one texel
+// each, stretched over the render target and reflected below the horizon, and a star field of STAR_COUNT stars
+// stretched over the top of it. Both are transient images with disjoint lifetimes, so they share memory.
+static const uint32_t BACKGROUND_BAND_COUNT = 16;
+static const uint32_t STAR_FIELD_SIZE = 64;
+static const uint32_t STAR_COUNT = 48;
+static const VkFormat BACKGROUND_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+// A checkerboard texture with a full mip chain is streamed at a screen size that sweeps between its finest resident
+// mip and its full size every CHECKER_SWEEP_FRAMES frames, so its finer mips are repeatedly streamed in and evicted.
+static const uint32_t CHECKER_SIZE = 512;
+static const uint32_t CHECKER_CELL_COUNT = 8;
+static const uint32_t CHECKER_SWEEP_FRAMES = 240;
+
+struct App
+{
+    SYSContext sysContext;
+    GFXContext gfxContext;
+    JOBScheduler * jobScheduler;
+    GFXComputePipeline entitySumPipeline;
+    GFXBuffer entityColumns[ENTITY_COLUMN_COUNT];
+    DRAWBatcher drawBatcher;
+    ASSETFile assetFile;
+    TEXStreamer * textureStreamer;
+    uint32_t checkerTexture;
+    uint32_t triangleMesh;
+    uint32_t quadMesh;
+    ctk::Buffer<GFXInstance> gridInstances;
+    FGGraph * frameGraph;
+    uint32_t gradientImage;
+    uint32_t starImage;
+    uint32_t renderTarget;
+
+    // Frames [captureStartFrame, captureStartFrame + captureFrameCount) are captured to capturePath; a count of 0
+    // disables capturing.
+    uint32_t frameNumber;
+    uint32_t captureStartFrame;
+    uint32_t captureFrameCount;
+    char capturePath[MAX_CAPTURE_PATH_SIZE];
+
+    // Startup timings in seconds, reported once the first frame is submitted; graphics startup is timed by gfxInit().
+    double startTime;
+    double configTime;
+    double windowTime;
+    double contentTime;
+    double mainLoopStartTime;
+};
+
+// Config file read by a job; configs other than the ones needed to start logging and the scheduler are read in
+// parallel.
+struct ConfigFile
+{
+    const char * path;
+    YAMLNode * node;
+};
+
+static GFXPresentPolicy
+getPresentPolicy(const char * name)
+{
+    static const char * PRESENT_POLICY_NAMES[]
+    {
+        "low-latency",
+        "throughput",
+        "power-saving",
+    };
+
+    for(size_t i = 0; i < (size_t)GFXPresentPolicy::COUNT; i++)
+    {
+        if(strcmp(name, PRESENT_POLICY_NAMES[i]) == 0)
+        {
+            return (GFXPresentPolicy)i;
+        }
+    }
+
+    utilErrorExit("CONFIG", nullptr, "unknown present policy \"%s\"\n", name);
+    return GFXPresentPolicy::LOW_LATENCY;
+}
+
+static void
+createEntities(App * app)
+{
+    GFXContext * gfxContext = &app->gfxContext;
+    const GFXShader * entitySumShader = gfxGetShader(gfxContext, "entity_sum");
+
+    if(entitySumShader == nullptr)
+    {
+        utilErrorExit("CONFIG", nullptr, "shader \"entity_sum\" is missing from the shader library\n");
+    }
+
+    gfxCreateComputePipeline(gfxContext, entitySumShader, ENTITY_COLUMN_COUNT, sizeof(uint32_t),
+                             &app->entitySumPipeline);
+
+    // Initialize input columns with random values; the output column is written by the first dispatch.
+    auto columnData = bufferCreate<int32_t>(ENTITY_COUNT);
+    VkDeviceSize columnSize = ENTITY_COUNT * sizeof(int32_t);
+    srand(time(nullptr));
+
+    for(uint32_t column = 0; column < ENTITY_COLUMN_COUNT; column++)
+    {
+        GFXBuffer * entityColumn = app->entityColumns + column;
+
+        gfxCreateBuffer(gfxContext, columnSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        true, entityColumn);
+
+        if(column == ENTITY_COLUMN_COUNT - 1)
+        {
+            break;
+        }
+
+        for(uint32_t i = 0; i < ENTITY_COUNT; i++)
+        {
+            columnData.data[i] = rand() % 100;
+        }
+
+        if(!gfxUploadBuffer(gfxContext, entityColumn, 0, columnData.data, columnSize))
+        {
+            utilErrorExit("CONFIG", nullptr, "staging ring is too small for entity data\n");
+        }
+    }
+
+    bufferFree(&columnData);
+}
+
+static void
+destroyEntities(App * app)
+{
+    GFXContext * gfxContext = &app->gfxContext;
+    gfxDestroyComputePipeline(gfxContext, &app->entitySumPipeline);
+
+    for(uint32_t column = 0; column < ENTITY_COLUMN_COUNT; column++)
+    {
+        gfxDestroyBuffer(gfxContext, app->entityColumns + column);
+    }
+}
+
+// Fills texels with every mip of the checkerboard texture, tightly packed one after another, and points source's
+// payloads at them.
+static void
+createCheckerTexels(ctk::Buffer<uint8_t> * texels, ASSETSource * source)
+{
+    source->name = "checker";
+    source->type = ASSETType::TEXTURE;
+    source->format = VK_FORMAT_R8G8B8A8_UNORM;
+    source->width = CHECKER_SIZE;
+    source->height = CHECKER_SIZE;
+    source->payloadCount = (uint32_t)std::log2(CHECKER_SIZE) + 1;
+    uint64_t texelsSize = 0;
+
+    for(uint32_t mip = 0; mip < source->payloadCount; mip++)
+    {
+        uint64_t mipSize = CHECKER_SIZE >> mip;
+        source->payloadSizes[mip] = mipSize * mipSize * 4;
+        texelsSize += source->payloadSizes[mip];
+    }
+
+    *texels = bufferCreate<uint8_t>(texelsSize);
+    uint8_t * texel = texels->data;
+
+    for(uint32_t mip = 0; mip < source->payloadCount; mip++)
+    {
+        uint32_t mipSize = CHECKER_SIZE >> mip;
+        source->payloads[mip] = texel;
+
+        for(uint32_t y = 0; y < mipSize; y++)
+        {
+            for(uint32_t x = 0; x < mipSize; x++)
+            {
+                bool light = ((x * CHECKER_CELL_COUNT / mipSize) + (y * CHECKER_CELL_COUNT / mipSize)) % 2 == 0;
+                uint8_t value = light ? 224 : 32;
+                texel[0] = value;
+                texel[1] = value;
+                texel[2] = value;
+                texel[3] = 255;
+                texel += 4;
+            }
+        }
+    }
+}
+
+// Writes the app's asset file, standing in for an asset-building tool.
+static void
+writeAssetFile(const char * path)
+{
+    static const GFXVertex TRIANGLE_VERTICES[]
+    {
+        { { 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
+        { { 0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f } },
+        { { -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f } },
+    };
+
+    static const uint32_t TRIANGLE_INDICES[] { 0, 1, 2 };
+
+    static const GFXVertex QUAD_VERTICES[]
+    {
+        { { -0.5f, -0.5f }, { 1.0f, 1.0f, 0.0f } },
+        { { 0.5f, -0.5f }, { 0.0f, 1.0f, 1.0f } },
+        { { 0.5f, 0.5f }, { 1.0f, 0.0f, 1.0f } },
+        { { -0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f } },
+    };
+
+    static const uint32_t QUAD_INDICES[] { 0, 1, 2, 2, 3, 0 };
+    ASSETSource sources[3] = {};
+    ASSETSource * triangle = sources + 0;
+    triangle->name = "triangle";
+    triangle->type = ASSETType::MESH;
+    triangle->payloadCount = 2;
+    triangle->payloads[0] = TRIANGLE_VERTICES;
+    triangle->payloadSizes[0] = sizeof(TRIANGLE_VERTICES);
+    triangle->payloads[1] = TRIANGLE_INDICES;
+    triangle->payloadSizes[1] = sizeof(TRIANGLE_INDICES);
+    ASSETSource * quad = sources + 1;
+    quad->name = "quad";
+    quad->type = ASSETType::MESH;
+    quad->payloadCount = 2;
+    quad->payloads[0] = QUAD_VERTICES;
+    quad->payloadSizes[0] = sizeof(QUAD_VERTICES);
+    quad->payloads[1] = QUAD_INDICES;
+    quad->payloadSizes[1] = sizeof(QUAD_INDICES);
+    Buffer<uint8_t> checkerTexels = {};
+    createCheckerTexels(&checkerTexels, sources + 2);
+
+    if(!assetWriteFile(path, sources, sizeof(sources) / sizeof(ASSETSource)))
+    {
+        utilErrorExit("CONFIG", nullptr, "failed to write asset file '%s'\n", path);
+    }
+
+    bufferFree(&checkerTexels);
+}
+
+// Uploads mesh entry name of the app's asset file into the draw batcher.
+static uint32_t
+loadMesh(App * app, const char * name)
+{
+    const ASSETEntry * entry = assetFind(&app->assetFile, name);
+    uint32_t mesh = 0;
+
+    if(entry == nullptr || entry->type != ASSETType::MESH)
+    {
+        utilErrorExit("CONFIG", nullptr, "mesh \"%s\" is missing from the asset file\n", name);
+    }
+
+    if(!assetUploadMesh(&app->assetFile, entry, &app->drawBatcher, &mesh))
+    {
+        utilErrorExit("CONFIG", nullptr, "staging ring is too small for mesh data\n");
+    }
+
+    return mesh;
+}
+
+static void
+createMeshes(App * app, const char * assetPath)
+{
+    static const uint32_t INSTANCE_COUNT = INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE;
+    DRAWConfig config = {};
+    config.maxVertexCount = 1024;
+    config.maxIndexCount = 4096;
+    config.maxInstanceCount = INSTANCE_COUNT;
+    config.maxCommandCount = 64;
+    drawInit(&app->drawBatcher, &app->gfxContext, &config);
+
+    // Meshes are loaded from an asset file, which stays mapped until the app exits so textures can be streamed from it.
+    writeAssetFile(assetPath);
+
+    if(!assetOpen(assetPath, &app->assetFile))
+    {
+        utilErrorExit("CONFIG", nullptr, "failed to open asset file '%s'\n", assetPath);
+    }
+
+    app->triangleMesh = loadMesh(app, "triangle");
+    app->quadMesh = loadMesh(app, "quad");
+
+    // Grid cells span [-1, 1] in clip space; each instance fills most of its cell.
+    float cellSize = 2.0f / INSTANCE_GRID_SIZE;
+    app->gridInstances = bufferCreate<GFXInstance>(INSTANCE_COUNT);
+
+    for(uint32_t row = 0; row < INSTANCE_GRID_SIZE; row++)
+    {
+        for(uint32_t column = 0; column < INSTANCE_GRID_SIZE; column++)
+        {
+            GFXInstance * instance = app->gridInstances.data + row * INSTANCE_GRID_SIZE + column;
+            instance->offset[0] = -1.0f + (column + 0.5f) * cellSize;
+            instance->offset[1] = -1.0f + (row + 0.5f) * cellSize;
+            instance->scale = cellSize * 0.8f;
+        }
+    }
+}
+
+static void
+createTextures(App * app, const TEXConfig * config)
+{
+    const ASSETEntry * entry = assetFind(&app->assetFile, "checker");
+
+    if(entry == nullptr || entry->type != ASSETType::TEXTURE)
+    {
+        utilErrorExit("CONFIG", nullptr, "texture \"checker\" is missing from the asset file\n");
+    }
+
+    app->textureStreamer = texCreateStreamer(&app->gfxContext, config);
+
+    if(!texCreate(app->textureStreamer, &app->assetFile, entry, &app->checkerTexture))
+    {
+        utilErrorExit("CONFIG", nullptr, "failed to create texture \"checker\"\n");
+    }
+}
+
+static void
+destroyTextures(App * app)
+{
+    TEXStats stats = {};
+    texGetStats(app->textureStreamer, &stats);
+
+    utilLog("TEXTURES", "streamed %llu mips and evicted %llu over the run\n", (unsigned long long)stats.streamCount,
+            (unsigned long long)stats.evictionCount);
+
+    texDestroyStreamer(app->textureStreamer);
+}
+
+// Requests the checkerboard at this frame's point in its sweep and streams in the mips requested.
+static void
+updateTextures(App * app)
+{
+    float sweep = 0.5f - 0.5f * cosf(2.0f * 3.14159265f * (app->frameNumber % CHECKER_SWEEP_FRAMES) /
+                                     CHECKER_SWEEP_FRAMES);
+
+    float screenSize = TEX_RESIDENT_MIP_SIZE + sweep * (CHECKER_SIZE - TEX_RESIDENT_MIP_SIZE);
+    texRequest(app->textureStreamer, app->checkerTexture, screenSize);
+    texUpdate(app->textureStreamer);
+}
+
+static void
+destroyMeshes(App * app)
+{
+    drawDestroy(&app->drawBatcher);
+    assetClose(&app->assetFile);
+    bufferFree(&app->gridInstances);
+}
+
+// Submits the grid's even rows as triangles and odd rows as quads, grouped by mesh so each mesh is drawn by one
+// indirect command.
+static void
+submitDraws(App * app)
+{
+    DRAWBatcher * drawBatcher = &app->drawBatcher;
+
+    for(uint32_t pass = 0; pass < 2; pass++)
+    {
+        uint32_t mesh = pass == 0 ? app->triangleMesh : app->quadMesh;
+
+        for(uint32_t row = pass; row < INSTANCE_GRID_SIZE; row += 2)
+        {
+            drawSubmit(drawBatcher, mesh, app->gridInstances.data + row * INSTANCE_GRID_SIZE, INSTANCE_GRID_SIZE);
+        }
+    }
+
+    drawFlush(drawBatcher);
+}
+
+// Records the frame's indirect commands [beginCommand, endCommand).
+static void
+recordDraws(const App * app, VkCommandBuffer commandBuffer, uint32_t beginCommand, uint32_t endCommand)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app->gfxContext.pipeline);
+    drawRecordRange(&app->drawBatcher, commandBuffer, beginCommand, endCommand);
+}
+
+static VkClearColorValue
+getBandColor(uint32_t band)
+{
+    float shade = (band + 0.5f) / BACKGROUND_BAND_COUNT;
+
+    return { { 0.02f, 0.02f + 0.08f * shade, 0.05f + 0.2f * shade, 1.0f } };
+}
+
+// Frame graph pass; clears each texel row of the gradient image to its band's shade.
+static void
+drawGradient(void *, VkCommandBuffer commandBuffer)
+{
+    for(uint32_t band = 0; band < BACKGROUND_BAND_COUNT; band++)
+    {
+        // typedef struct VkClearAttachment {
+        //     VkImageAspectFlags    aspectMask;
+        //     uint32_t              colorAttachment;
+        //     VkClearValue          clearValue;
+        // } VkClearAttachment;
+        VkClearAttachment clearAttachment = {};
+        clearAttachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        clearAttachment.colorAttachment = 0;
+        clearAttachment.clearValue.color = getBandColor(band);
+
+        // typedef struct VkClearRect {
+        //     VkRect2D    rect;
+        //     uint32_t    baseArrayLayer;
+        //     uint32_t    layerCount;
+        // } VkClearRect;
+        VkClearRect clearRect = {};
+        clearRect.rect = { { 0, (int32_t)band }, { 1, 1 } };
+        clearRect.baseArrayLayer = 0;
+        clearRect.layerCount = 1;
+        vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
+    }
+}
+
+// Frame graph pass; clears the star field image to the top band's shade, with a scattered texel per star.
+static void
+drawStars(void *, VkCommandBuffer commandBuffer)
+{
+    VkClearAttachment skyAttachment = {};
+    skyAttachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    skyAttachment.colorAttachment = 0;
+    skyAttachment.clearValue.color = getBandColor(0);
+    VkClearRect skyRect = { { { 0, 0 }, { STAR_FIELD_SIZE, STAR_FIELD_SIZE } }, 0, 1 };
+    vkCmdClearAttachments(commandBuffer, 1, &skyAttachment, 1, &skyRect);
+
+    VkClearAttachment starAttachment = skyAttachment;
+    starAttachment.clearValue.color = { { 0.9f, 0.9f, 0.8f, 1.0f } };
+    VkClearRect starRects[STAR_COUNT] = {};
+
+    // Coprime strides scatter the stars without repeating a texel.
+    for(uint32_t i = 0; i < STAR_COUNT; i++)
+    {
+        int32_t x = (int32_t)((i * 37 + 11) % STAR_FIELD_SIZE);
+        int32_t y = (int32_t)((i * 23 + 5) % STAR_FIELD_SIZE);
+        starRects[i] = { { { x, y }, { 1, 1 } }, 0, 1 };
+    }
+
+    vkCmdClearAttachments(commandBuffer, 1, &starAttachment, STAR_COUNT, starRects);
+}
+
+// Blits region srcOffsets of image src to region dstOffsets of the render target, both in transfer layouts.
+static void
+blitToRenderTarget(const App * app, VkCommandBuffer commandBuffer, uint32_t src, const VkOffset3D * srcOffsets,
+                   const VkOffset3D * dstOffsets, VkFilter filter)
+{
+    // typedef struct VkImageBlit {
+    //     VkImageSubresourceLayers    srcSubresource;
+    //     VkOffset3D                  srcOffsets[2];
+    //     VkImageSubresourceLayers    dstSubresource;
+    //     VkOffset3D                  dstOffsets[2];
+    // } VkImageBlit;
+    VkImageBlit blit = {};
+    blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.srcOffsets[0] = srcOffsets[0];
+    blit.srcOffsets[1] = srcOffsets[1];
+    blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.dstOffsets[0] = dstOffsets[0];
+    blit.dstOffsets[1] = dstOffsets[1];
+
+    vkCmdBlitImage(commandBuffer, fgGetImage(app->frameGraph, src), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   fgGetImage(app->frameGraph, app->renderTarget), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                   filter);
+}
+
+// Frame graph pass; stretches the gradient over the whole render target.
+static void
+drawSky(void * data, VkCommandBuffer commandBuffer)
+{
+    auto app = (const App *)data;
+    VkExtent2D extent = app->gfxContext.swapchainConfig.extent;
+    const VkOffset3D srcOffsets[] = { { 0, 0, 0 }, { 1, (int32_t)BACKGROUND_BAND_COUNT, 1 } };
+    const VkOffset3D dstOffsets[] = { { 0, 0, 0 }, { (int32_t)extent.width, (int32_t)extent.height, 1 } };
+    blitToRenderTarget(app, commandBuffer, app->gradientImage, srcOffsets, dstOffsets, VK_FILTER_LINEAR);
+}
+
+// Frame graph pass; reflects the gradient upside down over the bottom quarter of the render target.
+static void
+drawHorizon(void * data, VkCommandBuffer commandBuffer)
+{
+    auto app = (const App *)data;
+    VkExtent2D extent = app->gfxContext.swapchainConfig.extent;
+    const VkOffset3D srcOffsets[] = { { 0, (int32_t)BACKGROUND_BAND_COUNT, 0 }, { 1, 0, 1 } };
+
+    const VkOffset3D dstOffsets[] =
+        { { 0, (int32_t)(extent.height * 3 / 4), 0 }, { (int32_t)extent.width, (int32_t)extent.height, 1 } };
+
+    blitToRenderTarget(app, commandBuffer, app->gradientImage, srcOffsets, dstOffsets, VK_FILTER_LINEAR);
+}
+
+// Frame graph pass; stretches the star field over the top quarter of the render target.
+static void
+drawStarField(void * data, VkCommandBuffer commandBuffer)
+{
+    auto app = (const App *)data;
+    VkExtent2D extent = app->gfxContext.swapchainConfig.extent;
+    const VkOffset3D srcOffsets[] = { { 0, 0, 0 }, { (int32_t)STAR_FIELD_SIZE, (int32_t)STAR_FIELD_SIZE, 1 } };
+    const VkOffset3D dstOffsets[] = { { 0, 0, 0 }, { (int32_t)extent.width, (int32_t)(extent.height / 4), 1 } };
+    blitToRenderTarget(app, commandBuffer, app->starImage, srcOffsets, dstOffsets, VK_FILTER_NEAREST);
+}
+
+// Frame graph pass; nothing reads its output yet, so the graph culls it and never creates its image.
+static void
+drawDebugOverlay(void *, VkCommandBuffer)
+{
+    utilErrorExit("TEST", nullptr, "debug overlay pass should have been culled\n");
+}
+
+// The frame's render pass draws the grid over the background the graph renders into the render target. The gradient
+// is read by two passes, and its memory is reused by the star field once both are done with it.
+static void
+createFrameGraph(App * app)
+{
+    GFXContext * gfxContext = &app->gfxContext;
+    const SwapchainConfig * swapchainConfig = &gfxContext->swapchainConfig;
+    FGGraph * graph = fgCreate(gfxContext);
+    VkClearValue clearValue = {};
+    app->frameGraph = graph;
+
+    // Render targets are only blitted into where the surface allows them to be transfer destinations.
+    if((swapchainConfig->imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0)
+    {
+        utilErrorExit("TEST", nullptr, "render targets can't be transfer destinations\n");
+    }
+
+    app->renderTarget =
+        fgImportImage(graph, "render target", swapchainConfig->surfaceFormat.format, swapchainConfig->extent,
+                      VK_IMAGE_ASPECT_COLOR_BIT, FGAccess::UNDEFINED, FGAccess::COLOR_ATTACHMENT_WRITE);
+
+    app->gradientImage = fgCreateImage(graph, "gradient", BACKGROUND_FORMAT, { 1, BACKGROUND_BAND_COUNT },
+                                       VK_IMAGE_ASPECT_COLOR_BIT, clearValue);
+
+    app->starImage = fgCreateImage(graph, "stars", BACKGROUND_FORMAT, { STAR_FIELD_SIZE, STAR_FIELD_SIZE },
+                                   VK_IMAGE_ASPECT_COLOR_BIT, clearValue);
+
+    uint32_t overlayImage = fgCreateImage(graph, "debug overlay", BACKGROUND_FORMAT, swapchainConfig->extent,
+                                          VK_IMAGE_ASPECT_COLOR_BIT, clearValue);
+
+    uint32_t gradientPass = fgAddPass(graph, "gradient", drawGradient, app, false);
+    fgAddAccess(graph, gradientPass, app->gradientImage, FGAccess::COLOR_ATTACHMENT_WRITE);
+
+    uint32_t skyPass = fgAddPass(graph, "sky", drawSky, app, false);
+    fgAddAccess(graph, skyPass, app->gradientImage, FGAccess::TRANSFER_READ);
+    fgAddAccess(graph, skyPass, app->renderTarget, FGAccess::TRANSFER_WRITE);
+
+    uint32_t horizonPass = fgAddPass(graph, "horizon", drawHorizon, app, false);
+    fgAddAccess(graph, horizonPass, app->gradientImage, FGAccess::TRANSFER_READ);
+    fgAddAccess(graph, horizonPass, app->renderTarget, FGAccess::TRANSFER_WRITE);
+
+    uint32_t starsPass = fgAddPass(graph, "stars", drawStars, app, false);
+    fgAddAccess(graph, starsPass, app->starImage, FGAccess::COLOR_ATTACHMENT_WRITE);
+
+    uint32_t starFieldPass = fgAddPass(graph, "star field", drawStarField, app, false);
+    fgAddAccess(graph, starFieldPass, app->starImage, FGAccess::TRANSFER_READ);
+    fgAddAccess(graph, starFieldPass, app->renderTarget, FGAccess::TRANSFER_WRITE);
+
+    uint32_t overlayPass = fgAddPass(graph, "debug overlay", drawDebugOverlay, app, false);
+    fgAddAccess(graph, overlayPass, overlayImage, FGAccess::COLOR_ATTACHMENT_WRITE);
+
+    gfxSetFrameGraph(gfxContext, graph, app->renderTarget);
+}
+
+static void
+destroyFrameGraph(App * app)
+{
+    gfxSetFrameGraph(&app->gfxContext, nullptr, FG_INVALID_INDEX);
+    fgDestroy(app->frameGraph);
+}
+
+// Runs as a job; reads each config file of the range.
+static void
+readConfigFiles(void * data, size_t begin, size_t end)
+{
+    auto configFiles = (ConfigFile *)data;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        configFiles[i].node = yamlReadFile(configFiles[i].path);
+    }
+}
+
+static void
+logStartupTimes(const App * app)
+{
+    static const double MS = 1000.0;
+    const GFXStartupTimes * graphicsTimes = &app->gfxContext.startupTimes;
+    double endTime = utilGetTime();
+
+    utilLog("STARTUP", "time to first frame: %.1f ms\n", (endTime - app->startTime) * MS);
+    utilLog("STARTUP", "    configs, logging and scheduler: %.1f ms\n", app->configTime * MS);
+    utilLog("STARTUP", "    window: %.1f ms\n", app->windowTime * MS);
+    utilLog("STARTUP", "    graphics: %.1f ms\n", graphicsTimes->totalTime * MS);
+
+    utilLog("STARTUP", "        instance %.1f, device %.1f, allocators %.1f, render targets %.1f, "
+            "frame resources %.1f, waiting on jobs %.1f ms\n", graphicsTimes->instanceTime * MS,
+            graphicsTimes->deviceTime * MS, graphicsTimes->allocatorTime * MS, graphicsTimes->renderTargetTime * MS,
+            graphicsTimes->frameResourceTime * MS, graphicsTimes->jobWaitTime * MS);
+
+    utilLog("STARTUP", "        jobs: pipeline cache %.1f, shaders %.1f, pipelines %.1f ms\n",
+            graphicsTimes->pipelineCacheTime * MS, graphicsTimes->shaderTime * MS, graphicsTimes->pipelineTime * MS);
+
+    utilLog("STARTUP", "    content: %.1f ms\n", app->contentTime * MS);
+    utilLog("STARTUP", "    first frame: %.1f ms\n", (endTime - app->mainLoopStartTime) * MS);
+}
+
+// Runs as a job; records each index of the range into a secondary command buffer of the scheduler thread it runs on.
+// The frame's indirect commands are split evenly across the jobs, so each secondary command buffer records its own
+// slice; slices may execute out of submission order, which is fine as grid instances don't overlap.
+static void
+recordSecondaries(void * data, size_t begin, size_t end)
+{
+    auto app = (App *)data;
+    uint64_t commandCount = drawGetCommandCount(&app->drawBatcher);
+    uint64_t secondaryCount = app->gfxContext.recordingThreadCount;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        auto beginCommand = (uint32_t)(i * commandCount / secondaryCount);
+        auto endCommand = (uint32_t)((i + 1) * commandCount / secondaryCount);
+
+        // Nothing to record for this slice when there are fewer commands than secondary command buffers.
+        if(beginCommand == endCommand)
+        {
+            continue;
+        }
+
+        VkCommandBuffer commandBuffer = gfxBeginSecondary(&app->gfxContext, jobGetThreadIndex());
+        recordDraws(app, commandBuffer, beginCommand, endCommand);
+        vkEndCommandBuffer(commandBuffer);
+    }
+}
+
+static void
+renderFrame(void * data)
+{
+    auto app = (App *)data;
+    GFXContext * gfxContext = &app->gfxContext;
+
+    // Captures begin and end between frames. GPU zones of a frame are read frames_in_flight frames later, so the last
+    // frames of a capture only have CPU zones.
+    if(app->captureFrameCount > 0)
+    {
+        if(app->frameNumber == app->captureStartFrame)
+        {
+            profBeginCapture();
+        }
+        else if(app->frameNumber == app->captureStartFrame + app->captureFrameCount)
+        {
+            profEndCapture(app->capturePath);
+        }
+    }
+
+    app->frameNumber++;
+    PROF_ZONE("renderFrame");
+
+    if(app->sysContext.framebufferResized)
+    {
+        gfxInvalidateSwapchain(gfxContext);
+        app->sysContext.framebufferResized = false;
+    }
+
+    VkCommandBuffer commandBuffer = gfxBeginFrame(gfxContext);
+
+    // Nothing to render to, e.g. the window is minimized.
+    if(commandBuffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    updateTextures(app);
+
+    // Update entities on the compute queue alongside the frame's graphics work.
+    const GFXBuffer * entityColumns[ENTITY_COLUMN_COUNT] = {};
+
+    for(uint32_t column = 0; column < ENTITY_COLUMN_COUNT; column++)
+    {
+        entityColumns[column] = app->entityColumns + column;
+    }
+
+    gfxDispatch(gfxContext, &app->entitySumPipeline, entityColumns, &ENTITY_COUNT,
+                (ENTITY_COUNT + ENTITY_SUM_GROUP_SIZE - 1) / ENTITY_SUM_GROUP_SIZE, 1, 1);
+
+    // Record draws as one job per scheduler thread if recording in parallel, otherwise inline.
+    submitDraws(app);
+    uint32_t recordingThreadCount = gfxContext->recordingThreadCount;
+
+    if(recordingThreadCount > 0)
+    {
+        jobParallelFor(app->jobScheduler, recordingThreadCount, 1, recordSecondaries, app);
+    }
+    else
+    {
+        recordDraws(app, commandBuffer, 0, drawGetCommandCount(&app->drawBatcher));
+    }
+
+    gfxEndFrame(gfxContext);
+
+    if(gfxContext->frameCount == 1)
+    {
+        logStartupTimes(app);
+    }
+}
+
 int
 main()
 {
-    // Initialize system module.
-    sysInit();
+    App app = {};
+    app.startTime = utilGetTime();
+    SYSContext * sysContext = &app.sysContext;
+    GFXContext * gfxContext = &app.gfxContext;
+    YAMLNode * logConfig = yamlReadFile("data/log.yaml");
 
-    // Create window for new system context.
-    SYSContext sysContext = {};
-    YAMLNode * windowConfig = yamlReadFile("data/window.yaml");
+    // Write log messages from a background thread.
+    UTILLogConfig logging = {};
+    logging.path = yamlGetString(logConfig, "path");
+    logging.minLevel = (UTILLogLevel)yamlGetInt(logConfig, "min_level");
+    logging.disabledSubsystems = yamlGetString(logConfig, "disabled_subsystems");
+    utilStartLogging(&logging);
+    yamlFree(logConfig);
+    profSetThreadName("main");
 
-    sysCreateWindow(&sysContext, yamlGetInt(windowConfig, "width"), yamlGetInt(windowConfig, "height"),
-                    yamlGetString(windowConfig, "title"));
+    // Start job scheduler; this thread is its thread 0.
+    YAMLNode * jobsConfig = yamlReadFile("data/jobs.yaml");
+    app.jobScheduler = jobCreateScheduler((uint32_t)yamlGetInt(jobsConfig, "thread_count"));
+    yamlFree(jobsConfig);
 
-    yamlFree(windowConfig);
+    // Read the remaining configs on the scheduler.
+    ConfigFile configFiles[] =
+    {
+        { "data/window.yaml", nullptr },
+        { "data/graphics.yaml", nullptr },
+        { "data/profiler.yaml", nullptr },
+        { "data/assets.yaml", nullptr },
+    };
 
-    // Initialize graphics context.
+    jobParallelFor(app.jobScheduler, sizeof(configFiles) / sizeof(ConfigFile), 1, readConfigFiles, configFiles);
+    YAMLNode * windowConfig = configFiles[0].node;
+    YAMLNode * graphicsConfig = configFiles[1].node;
+    YAMLNode * profilerConfig = configFiles[2].node;
+    YAMLNode * assetsConfig = configFiles[3].node;
+    bool headless = yamlGetInt(windowConfig, "headless") != 0;
+    int headlessFrameCount = yamlGetInt(windowConfig, "headless_frame_count");
+
+    // Initialize frame capture.
+    app.captureStartFrame = (uint32_t)yamlGetInt(profilerConfig, "capture_start_frame");
+    app.captureFrameCount = (uint32_t)yamlGetInt(profilerConfig, "capture_frame_count");
+    snprintf(app.capturePath, MAX_CAPTURE_PATH_SIZE, "%s", yamlGetString(profilerConfig, "capture_path"));
+    yamlFree(profilerConfig);
+    app.configTime = utilGetTime() - app.startTime;
+
+    // Initialize graphics config.
     GFXConfig config = {};
-    config.requestedExtensionNames = sysGetRequiredExtensions();
     config.requestedLayerNames = {};
-    config.createSurfaceFnData = &sysContext;
-    config.createSurfaceFn = sysCreateSurface;
-    gfxInit(&config);
+    config.physicalDeviceOverride = yamlGetString(graphicsConfig, "physical_device");
+    config.framesInFlight = (uint32_t)yamlGetInt(graphicsConfig, "frames_in_flight");
+    config.pipelineCachePath = yamlGetString(graphicsConfig, "pipeline_cache_path");
+    config.shaderLibraryPath = yamlGetString(graphicsConfig, "shader_library");
+    config.shaderBinDir = yamlGetString(graphicsConfig, "shader_bin_dir");
+    config.pipelineShaderName = yamlGetString(graphicsConfig, "pipeline_shader");
+    config.shaderHotReload = yamlGetInt(graphicsConfig, "shader_hot_reload") != 0;
+    config.shaderSourceDir = yamlGetString(graphicsConfig, "shader_source_dir");
+    config.stagingRingSize = (VkDeviceSize)yamlGetInt(graphicsConfig, "staging_ring_size");
+
+    // Secondary command buffers are recorded by scheduler threads, so each needs its own recording resources.
+    config.recordingThreadCount =
+        yamlGetInt(graphicsConfig, "parallel_recording") != 0 ? jobGetThreadCount(app.jobScheduler) : 0;
+
+    // Shaders, the pipeline cache and pipelines are loaded on the scheduler during gfxInit().
+    config.jobScheduler = app.jobScheduler;
+
+    if(headless)
+    {
+        // No window-system is needed to render offscreen.
+        config.requestedExtensionNames = {};
+        config.headless = true;
+
+        config.headlessExtent =
+        {
+            (uint32_t)yamlGetInt(windowConfig, "width"),
+            (uint32_t)yamlGetInt(windowConfig, "height"),
+        };
+    }
+    else
+    {
+        // Initialize system module.
+        double windowStartTime = utilGetTime();
+        sysInit();
+
+        // Create window for new system context.
+        sysCreateWindow(sysContext, yamlGetInt(windowConfig, "width"), yamlGetInt(windowConfig, "height"),
+                        yamlGetString(windowConfig, "title"));
+
+        config.presentPolicy = getPresentPolicy(yamlGetString(windowConfig, "present_policy"));
+        config.swapchainImageCount = (uint32_t)yamlGetInt(windowConfig, "swapchain_image_count");
+        config.requestedExtensionNames = sysGetRequiredExtensions();
+        config.createSurfaceFnData = sysContext;
+        config.createSurfaceFn = sysCreateSurface;
+        app.windowTime = utilGetTime() - windowStartTime;
+    }
+
+    // Initialize graphics context.
+    gfxInit(gfxContext, &config);
     bufferFree(&config.requestedExtensionNames);
+    yamlFree(windowConfig);
+    yamlFree(graphicsConfig);
+    double contentStartTime = utilGetTime();
+    createEntities(&app);
+    createMeshes(&app, yamlGetString(assetsConfig, "path"));
+    TEXConfig textureConfig = {};
+    textureConfig.maxTextureCount = (uint32_t)yamlGetInt(assetsConfig, "max_texture_count");
+    textureConfig.budgetSize = (VkDeviceSize)yamlGetInt(assetsConfig, "texture_budget_size");
+    createTextures(&app, &textureConfig);
+    yamlFree(assetsConfig);
+    createFrameGraph(&app);
+    app.contentTime = utilGetTime() - contentStartTime;
+    app.mainLoopStartTime = utilGetTime();
+
+    if(headless)
+    {
+        // Render a fixed number of frames, as there is no window to close.
+        for(int i = 0; i < headlessFrameCount; i++)
+        {
+            renderFrame(&app);
+        }
+    }
+    else
+    {
+        // Run main loop.
+        sysRun(sysContext, renderFrame, &app);
+    }
+
+    // Write a capture cut short by the app exiting.
+    if(profIsCapturing())
+    {
+        profEndCapture(app.capturePath);
+    }
+
+    // Destroy app resources once frames in flight are done with them, then the graphics context before the window its
+    // surface was created for.
+    gfxWaitIdle(gfxContext);
+    destroyFrameGraph(&app);
+    destroyTextures(&app);
+    destroyMeshes(&app);
+    destroyEntities(&app);
+    gfxDestroy(gfxContext);
 
-    // Run main loop.
-    sysRun(&sysContext);
+    if(!headless)
+    {
+        // Destroy system context.
+        sysDestroy(sysContext);
+    }
 
-    // Destroy system context.
-    sysDestroy(&sysContext);
+    jobDestroyScheduler(app.jobScheduler);
+    profShutdown();
+    utilStopLogging();
 
     return EXIT_SUCCESS;
 }